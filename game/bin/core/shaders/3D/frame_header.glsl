@@ -0,0 +1,43 @@
+#version 450
+#extension GL_ARB_shader_viewport_layer_array : enable // gl_Layer in vertex shaders (shadow_omni_layered_header.vsd)
+#extension GL_AMD_vertex_shader_layer : enable
+// ! THIS FILE MUST COME FIRST WHEN COMBINING SHADER FILES THAT USE THE PER FRAME UNIFORMS
+
+///
+/// per frame uniforms, uploaded once per frame by se_render3d_update_frame_uniforms
+/// ! THE LAYOUT MUST MATCH WITH SE_Frame_Uniforms IN serenderer.h
+///
+
+#define MAX_NUM_POINT_LIGHTS 4 // must match with SERENDERER3D_MAX_POINT_LIGHTS
+#define MAX_NUM_SHADOW_CASCADES 4 // must match with SERENDERER3D_MAX_SHADOW_CASCADES
+
+struct Dir_Light {
+    vec3 direction;
+    float intensity;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct Point_Light {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    float far_plane; // of the shadow cube map
+};
+
+layout (std140, binding = 0) uniform Frame_Uniforms {
+    mat4 projection_view;
+    mat4 shadow_cascade_matrices[MAX_NUM_SHADOW_CASCADES]; // directional shadow map, nearest cascade first
+    mat4 point_light_shadow_matrices[MAX_NUM_POINT_LIGHTS * 6]; // one per cube map face
+    Dir_Light dir_light;
+    Point_Light point_lights[MAX_NUM_POINT_LIGHTS];
+    vec3 camera_pos;
+    float time;
+    int num_of_point_lights;
+    int num_of_shadow_cascades;
+};
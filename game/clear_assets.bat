@@ -12,4 +12,6 @@ PUSHD .\bin
     @REM DEL /s *.assets
     @REM DEL /s *.level
     @REM DEL /s *.mesh
+    echo deleting the asset cache
+    RMDIR /S /Q cache
 POPD
\ No newline at end of file
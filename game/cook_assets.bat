@@ -0,0 +1,3 @@
+PUSHD ..\game\bin
+CALL game.exe --cook-assets
+POPD
\ No newline at end of file
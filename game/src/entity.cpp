@@ -1,22 +1,21 @@
 #include "entity.hpp"
 
-static AABB3D transform_aabb3d(AABB3D aabb, Vec3 pos, Vec3 scale) {
-    aabb.min = vec3_mul(aabb.min, scale);
-    aabb.max = vec3_mul(aabb.max, scale);
-    aabb.min = vec3_add(aabb.min, pos);
-    aabb.max = vec3_add(aabb.max, pos);
-    return aabb;
-}
-
 Entities::Entities() {
+    se_bvh_init(&this->bvh, 0.1f);
     this->set_to_default();
 }
 
 Entities::~Entities() {
     this->clear();
+    se_bvh_deinit(&this->bvh);
 }
 
 void Entities::update(SE_Renderer3D *renderer, f32 delta_time) {
+    if (this->invalidate_all_shadows) {
+        se_render3d_invalidate_all_shadows(renderer);
+        this->invalidate_all_shadows = false;
+    }
+
     for (u32 i = 0; i < this->count; ++i) {
             // @temp
         // if (this->has_shader[i]) {
@@ -25,6 +24,8 @@ void Entities::update(SE_Renderer3D *renderer, f32 delta_time) {
         //     this->position[i].y = 0.5f * se_math_sin(time) + 1;
         // }
             //- Transforms
+        Mat4 previous_transform = this->transform[i];
+        AABB3D previous_aabb_transformed = this->aabb_transformed[i];
         this->transform[i] = mat4_identity();
         Vec3 pos   = this->position[i];
         Vec3 rot   = this->oriantation[i];
@@ -35,11 +36,41 @@ void Entities::update(SE_Renderer3D *renderer, f32 delta_time) {
         this->transform[i] = mat4_mul(this->transform[i], mat4_translation(pos));
 
             //- AABB
+        // covers the meshes linked to the entity's mesh as well, they are culled together
         if (this->has_mesh[i]) {
-            this->aabb[i] = renderer->user_meshes[this->mesh_index[i]]->aabb;
+            SE_Mesh *mesh = renderer->user_meshes[this->mesh_index[i]];
+            AABB3D aabb = mesh->aabb;
+            for (i32 next = mesh->next_mesh_index; next > -1; next = renderer->user_meshes[next]->next_mesh_index) {
+                AABB3D next_aabb = renderer->user_meshes[next]->aabb;
+                aabb.min = v3f(se_math_min(aabb.min.x, next_aabb.min.x), se_math_min(aabb.min.y, next_aabb.min.y), se_math_min(aabb.min.z, next_aabb.min.z));
+                aabb.max = v3f(se_math_max(aabb.max.x, next_aabb.max.x), se_math_max(aabb.max.y, next_aabb.max.y), se_math_max(aabb.max.z, next_aabb.max.z));
+            }
+            this->aabb[i] = aabb;
         }
 
-        this->aabb_transformed[i] = transform_aabb3d(this->aabb[i], this->position[i], this->scale[i]);
+        this->aabb_transformed[i] = aabb3d_transform(this->aabb[i], this->transform[i]);
+
+            //- Shadows
+        // the cached shadows that can see where a static caster was and where it is now are re-rendered.
+        // swapping or hiding the mesh changes the shadow even if the entity didn't move.
+        // dynamic casters (skinned meshes) aren't in the cache, they're drawn every frame, so they never invalidate it
+        u32 previous_shadow_mesh_index = this->shadow_mesh_index[i];
+        this->shadow_mesh_index[i] = this->has_mesh[i] && this->should_render_mesh[i] ? this->mesh_index[i] : (u32)-1;
+        bool was_static_caster = previous_shadow_mesh_index < renderer->user_meshes_count
+            && !se_render3d_mesh_is_dynamic_shadow_caster(renderer, previous_shadow_mesh_index);
+        bool is_static_caster = this->shadow_mesh_index[i] < renderer->user_meshes_count
+            && !se_render3d_mesh_is_dynamic_shadow_caster(renderer, this->shadow_mesh_index[i]);
+        if (this->bvh_proxy[i] == SE_BVH_NULL) {
+            this->bvh_proxy[i] = se_bvh_insert(&this->bvh, this->aabb_transformed[i], i);
+            if (is_static_caster) se_render3d_invalidate_shadows(renderer, this->aabb_transformed[i]);
+        } else if (memcmp(&previous_transform, &this->transform[i], sizeof(Mat4)) != 0
+                || memcmp(&previous_aabb_transformed, &this->aabb_transformed[i], sizeof(AABB3D)) != 0) {
+            se_bvh_move(&this->bvh, this->bvh_proxy[i], this->aabb_transformed[i]);
+            if (was_static_caster) se_render3d_invalidate_shadows(renderer, previous_aabb_transformed);
+            if (is_static_caster)  se_render3d_invalidate_shadows(renderer, this->aabb_transformed[i]);
+        } else if (previous_shadow_mesh_index != this->shadow_mesh_index[i] && (was_static_caster || is_static_caster)) {
+            se_render3d_invalidate_shadows(renderer, this->aabb_transformed[i]);
+        }
 
             //- Update Point Light Pos
         if (this->has_light[i]) {
@@ -55,23 +86,34 @@ void Entities::update(SE_Renderer3D *renderer, f32 delta_time) {
         //     se_shader_set_uniform_f32(shader, "time", time);
         // }
     }
-}
 
-void Entities::render(SE_Renderer3D *renderer) {
-    // opaque pass
-    for (u32 i = 0; i < this->count; ++i) {
-        if (this->has_mesh[i] && this->should_render_mesh[i]) {
-            if (renderer->user_materials[renderer->user_meshes[this->mesh_index[i]]->material_index]->type == SE_MATERIAL_TYPE_TRANSPARENT) continue;
-            se_render_mesh_index(renderer, this->mesh_index[i], this->transform[i], false);
+        //- BVH
+    // the count can drop without going through clear() (eg when loading a level)
+    for (u32 i = this->count; i < ENTITIES_MAX; ++i) {
+        if (this->bvh_proxy[i] != SE_BVH_NULL) {
+            se_render3d_invalidate_shadows(renderer, se_bvh_get_fat_aabb(&this->bvh, this->bvh_proxy[i]));
+            se_bvh_remove(&this->bvh, this->bvh_proxy[i]);
+            this->bvh_proxy[i] = SE_BVH_NULL;
         }
     }
-    // transparent pass
-    for (u32 i = 0; i < this->count; ++i) {
+}
+
+void Entities::render(SE_Renderer3D *renderer) {
+    // only the entities inside of the camera's frustum are submitted
+    SE_Camera3D *camera = renderer->current_camera;
+    SE_Frustum frustum = se_frustum_from_matrix(mat4_mul(camera->view, camera->projection));
+    u32 visible[ENTITIES_MAX];
+    u32 visible_count = se_bvh_query_frustum(&this->bvh, &frustum, visible, ENTITIES_MAX);
+
+    // the renderer sorts the meshes into the opaque and transparent passes and batches the ones that share a mesh
+    for (u32 v = 0; v < visible_count; ++v) {
+        u32 i = visible[v];
+        if (i >= this->count) continue;
         if (this->has_mesh[i] && this->should_render_mesh[i]) {
-            if (renderer->user_materials[renderer->user_meshes[this->mesh_index[i]]->material_index]->type != SE_MATERIAL_TYPE_TRANSPARENT) continue;
-            se_render_mesh_index(renderer, this->mesh_index[i], this->transform[i], true);
+            se_render3d_submit_animated_mesh(renderer, this->mesh_index[i], this->animator_index[i], this->transform[i]);
         }
     }
+    se_render3d_execute_queue(renderer);
 }
 
 void Entities::clear() {
@@ -86,10 +128,14 @@ void Entities::clear() {
 
 void Entities::set_to_default() {
     this->count = 0;
+    se_bvh_clear(&this->bvh);
+    this->invalidate_all_shadows = true;
     for (u32 i = 0; i < ENTITIES_MAX; ++i) {
         this->has_mesh           [i] = false;
         this->should_render_mesh [i] = true;
         this->mesh_index         [i] = -1;  // ! this must be default to -1. We rely on it @se_render_directional_shadow_map()
+        this->shadow_mesh_index  [i] = -1;
+        this->animator_index     [i] = SE_RENDER_NO_ANIMATOR;
         this->oriantation        [i] = v3f(0,0,0);
         this->position           [i] = v3f(0,0,0);
         this->scale              [i] = v3f(1,1,1);
@@ -97,6 +143,7 @@ void Entities::set_to_default() {
         this->has_name           [i] = false;
         this->has_light          [i] = false;
         this->light_index        [i] = -1;
+        this->bvh_proxy          [i] = SE_BVH_NULL;
     }
 }
 
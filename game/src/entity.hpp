@@ -17,11 +17,16 @@ public:
         //- AABB
     AABB3D aabb[ENTITIES_MAX];
     AABB3D aabb_transformed[ENTITIES_MAX];
+    SE_BVH bvh;                     // aabb_transformed of every entity, the user data is the entity index
+    i32 bvh_proxy[ENTITIES_MAX];    // SE_BVH_NULL if the entity is not in the bvh
+    bool invalidate_all_shadows;    // every entity was removed at once, the cached shadow maps are re-rendered on the next update
 
         //- Mesh
     bool has_mesh[ENTITIES_MAX];
     bool should_render_mesh[ENTITIES_MAX];
     u32 mesh_index[ENTITIES_MAX];
+    u32 shadow_mesh_index[ENTITIES_MAX]; // mesh_index, or -1 if the entity has no mesh or it's hidden. What the shadow passes draw
+    u32 animator_index[ENTITIES_MAX];    // ! not saved. The animator posing a skinned mesh, SE_RENDER_NO_ANIMATOR for the mesh's own
 
         //- Name
     bool has_name[ENTITIES_MAX];
@@ -38,7 +43,8 @@ public:
     Entities();
     ~Entities();
 
-        /// Update all of the components data if they require it
+        /// Update all of the components data if they require it. Also keeps "bvh" in sync with "aabb_transformed" and
+        /// invalidates the cached shadows where entities moved or their mesh changed (see se_render3d_invalidate_shadows).
     void update(SE_Renderer3D *renderer, f32 delta_time);
         /// Render entities' user_meshes or other renderable components
     void render(SE_Renderer3D *renderer);
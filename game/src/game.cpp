@@ -8,6 +8,12 @@
 #define SAVE_FILE_ASSETS_NAME "test_save_assets.assets"
 #define ASSETS_SAVE_DATA_VERSION 1
 
+SE_Mesh_Import_Settings App::mesh_import_settings() {
+    SE_Mesh_Import_Settings settings = se_mesh_import_settings_default();
+    settings.pack_vertices = true; // import meshes with compressed vertices
+    return settings;
+}
+
 App::App(SDL_Window *window) {
     se_grid_init(&grid, 10, 10);
     value_mappings[0] = {0, 0, 0, 0};
@@ -29,14 +35,8 @@ App::App(SDL_Window *window) {
     should_quit = false;
 
         //- Render Targets
-    Vec2 render_target_size = {(f32)window_w, (f32)window_h};
-    se_render_target_init_hdr(&m_render_target_scene, render_target_size, 2, true);
-    se_render_target_init_hdr(&m_render_target_blur, render_target_size, 2, false);
-    se_render_target_init_hdr(&m_render_target_bloom, render_target_size, 2, false);
-    se_render_target_init_hdr(&m_render_target_gaussian_blur_h, render_target_size, 2, false);
-    se_render_target_init_hdr(&m_render_target_gaussian_blur_v, render_target_size, 2, false);
-    // se_render_target_init_hdr(&m_render_target_downsample, render_target_size, 2, true);
-    // se_render_target_init_hdr(&m_render_target_upsample, render_target_size, 2, true);
+    se_render_graph_init(&m_render_graph, {(f32)window_w, (f32)window_h});
+    build_render_graph();
 
         // entity widget
     // m_selected_entity = -1; // no entity has been selected
@@ -54,6 +54,7 @@ App::App(SDL_Window *window) {
     vec3_normalise(&m_renderer.light_directional.direction);
     m_renderer.light_directional.ambient   = {10, 10, 10};
     m_renderer.light_directional.diffuse   = {255, 255, 255};
+    m_renderer.import_settings = App::mesh_import_settings();
 
         //- Gizmo Renderer
     se_gizmo_renderer_init(&m_gizmo_renderer, &m_cameras[main_camera]);
@@ -85,13 +86,53 @@ App::~App() {
     se_render3d_deinit(&m_renderer);
     se_gizmo_renderer_deinit(&m_gizmo_renderer);
     // se_texture_unload(&debug_screen_quad_texture);
-    serender_target_deinit(&m_render_target_blur);
-    serender_target_deinit(&m_render_target_bloom);
-    serender_target_deinit(&m_render_target_scene);
-    serender_target_deinit(&m_render_target_gaussian_blur_h);
-    serender_target_deinit(&m_render_target_gaussian_blur_v);
-    // serender_target_deinit(&m_render_target_downsample);
-    // serender_target_deinit(&m_render_target_upsample);
+    se_render_graph_deinit(&m_render_graph);
+}
+
+void App::build_render_graph() {
+    SE_Render_Target_Config hdr;
+    hdr.internal_format = GL_RGBA16F;
+    hdr.format = GL_RGBA;
+    hdr.type = GL_FLOAT;
+    hdr.filter = GL_NEAREST;
+    hdr.wrap = GL_CLAMP_TO_EDGE;
+    SE_Render_Graph_Target_Desc desc = {1.0f, 1, true, hdr};
+
+    se_render_graph_clear(&m_render_graph);
+    m_render_graph_scene = se_render_graph_add_target(&m_render_graph, "scene", desc);
+    desc.has_depth = false;
+    m_render_graph_bloom = se_render_graph_add_target(&m_render_graph, "bloom", desc);
+    u32 backbuffer = se_render_graph_import_target(&m_render_graph, "backbuffer", NULL);
+
+    se_render_graph_add_pass(&m_render_graph, "scene", m_render_graph_scene, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT,
+        render_pass_scene, this);
+    u32 bloom = se_render_graph_add_pass(&m_render_graph, "bloom", m_render_graph_bloom, GL_COLOR_BUFFER_BIT,
+        render_pass_bloom, this);
+    se_render_graph_read(&m_render_graph, bloom, m_render_graph_scene, 1);
+    u32 tonemap = se_render_graph_add_pass(&m_render_graph, "tonemap", backbuffer, 0, render_pass_tonemap, this);
+    se_render_graph_read(&m_render_graph, tonemap, m_render_graph_bloom, 1);
+
+    se_render_graph_compile(&m_render_graph); // "print render graph" in the menu bar shows the result
+}
+
+void App::render_pass_scene(SE_Render_Graph *graph, u32 pass, void *user_data) {
+    App *app = (App*)user_data;
+    app->m_level.entities.render(&app->m_renderer);
+}
+
+void App::render_pass_bloom(SE_Render_Graph *graph, u32 pass, void *user_data) {
+    App *app = (App*)user_data;
+    se_render_bloom(&app->m_renderer, se_render_graph_get_target(graph, app->m_render_graph_scene));
+}
+
+void App::render_pass_tonemap(SE_Render_Graph *graph, u32 pass, void *user_data) {
+    App *app = (App*)user_data;
+    glClearColor(app->m_renderer.light_directional.ambient.r / 255.0f,
+                 app->m_renderer.light_directional.ambient.g / 255.0f,
+                 app->m_renderer.light_directional.ambient.b / 255.0f,
+                 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    se_render_post_process(&app->m_renderer, SE_RENDER_POSTPROCESS_TONEMAP, se_render_graph_get_target(graph, app->m_render_graph_bloom));
 }
 
 void App::init_engine() {
@@ -134,26 +175,32 @@ void App::update(f32 delta_time) {
 }
 
 void App::render() {
+    se_render3d_reset_stats(&m_renderer);
+
         //- Default GL Mode
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glLineWidth(1.0f);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+    se_gl_enable(GL_DEPTH_TEST);
+    se_gl_depth_func(GL_LESS);
+    se_gl_disable(GL_BLEND);
+    se_gl_enable(GL_CULL_FACE);
+    se_gl_line_width(1.0f);
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
 
         //- 3D Renderer
     i32 window_w, window_h;
     SDL_GetWindowSize(m_window, &window_w, &window_h);
     se_camera3d_update_projection(&m_cameras[main_camera], window_w, window_h);
+    // after update() has moved the camera and the lights, before anything reads them
+    se_render3d_update_frame_uniforms(&m_renderer);
 
         //- Shadows
     {
-        AABB3D world_aabb = aabb3d_calculate_from_array(m_level.entities.aabb_transformed, m_level.entities.count);
+        AABB3D world_aabb = se_bvh_get_bounds(&m_level.entities.bvh);
         se_mesh_generate_gizmos_aabb(m_renderer.user_meshes[world_aabb_mesh], world_aabb.min, world_aabb.max, 2);
-        se_render_directional_shadow_map(&m_renderer, m_level.entities.mesh_index, m_level.entities.transform, m_level.entities.count, world_aabb);
+        se_render_directional_shadow_map(&m_renderer, m_level.entities.shadow_mesh_index, m_level.entities.transform,
+            m_level.entities.animator_index, &m_level.entities.bvh, m_level.entities.count, world_aabb);
     }
-    se_render_omnidirectional_shadow_map(&m_renderer, m_level.entities.mesh_index, m_level.entities.transform, m_level.entities.count);
+    se_render_omnidirectional_shadow_map(&m_renderer, m_level.entities.shadow_mesh_index, m_level.entities.transform,
+        m_level.entities.animator_index, &m_level.entities.bvh, m_level.entities.count);
 
         //- Clear Previous Frame
     glClearColor(m_renderer.light_directional.ambient.r / 255.0f,
@@ -168,53 +215,10 @@ void App::render() {
     // glClearColor(0.2, 0.1, 0.1, 1);
     // glClearColor(0, 0, 0, 1.0f);
 
-        //- Render Scene
-    serender_target_use(&m_render_target_scene);
-        glViewport(0, 0, m_render_target_scene.texture_size.x, m_render_target_scene.texture_size.y);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        m_level.entities.render(&m_renderer);
-    serender_target_use(NULL);
-
-        //- Use Gaussian Blur to blur BrightColour channel of scene
-    serender_target_use(&m_render_target_gaussian_blur_h);
-        glViewport(0, 0, m_render_target_gaussian_blur_h.texture_size.x, m_render_target_gaussian_blur_h.texture_size.y);
-        glClear(GL_COLOR_BUFFER_BIT);
-        se_render_post_process_gaussian_blur(&m_renderer, &m_render_target_scene, true);
-    serender_target_use(0);
-    serender_target_use(&m_render_target_gaussian_blur_v);
-        glViewport(0, 0, m_render_target_gaussian_blur_v.texture_size.x, m_render_target_gaussian_blur_v.texture_size.y);
-        glClear(GL_COLOR_BUFFER_BIT);
-        se_render_post_process_gaussian_blur(&m_renderer, &m_render_target_scene, false);
-    serender_target_use(0);
-        // then blur with the other gaussian framebuffer
-    u32 blur_amount = 50;
-    bool horizontal = true;
-    for (u32 i = 0; i < blur_amount; ++i) {
-        if (!horizontal) {
-            serender_target_use(&m_render_target_gaussian_blur_v);
-            se_render_post_process_gaussian_blur(&m_renderer, &m_render_target_gaussian_blur_h, true);
-        } else {
-            serender_target_use(&m_render_target_gaussian_blur_h);
-            se_render_post_process_gaussian_blur(&m_renderer, &m_render_target_gaussian_blur_v, false);
-        }
-        horizontal = !horizontal;
-    }
-
-        //- Combine blurred bloom and scene
-    serender_target_use(&m_render_target_bloom);
-        glViewport(0, 0, m_render_target_bloom.texture_size.x, m_render_target_bloom.texture_size.y);
-        glClear(GL_COLOR_BUFFER_BIT);
-        se_render_post_process(&m_renderer, SE_RENDER_POSTPROCESS_BLOOM, &m_render_target_gaussian_blur_v);
-    serender_target_use(NULL);
-
-        //- Apply Tonemapping
-    glViewport(0, 0, window_w, window_h);
-    glClearColor(m_renderer.light_directional.ambient.r / 255.0f,
-                m_renderer.light_directional.ambient.g / 255.0f,
-                m_renderer.light_directional.ambient.b / 255.0f,
-                1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    se_render_post_process(&m_renderer, SE_RENDER_POSTPROCESS_TONEMAP, &m_render_target_bloom);
+        //- Render Scene, Bloom and Tonemapping (see build_render_graph)
+    // the graph's targets follow the window's size
+    se_render_graph_set_size(&m_render_graph, {(f32)window_w, (f32)window_h});
+    se_render_graph_execute(&m_render_graph);
 
     glClear(GL_DEPTH_BUFFER_BIT);
     if (m_mode == GAME_MODES::GAME) {
@@ -275,8 +279,14 @@ i32 App::raycast_to_select_entity() {
 
     i32 result = -1;
 
+    // the bvh finds the entities whose fat aabb the ray hits, the closest one is picked with their exact aabbs
+    u32 candidates[ENTITIES_MAX];
+    u32 candidates_count = se_bvh_query_ray(&m_level.entities.bvh, raycast_origin, raycast_dir, 100, candidates, ENTITIES_MAX);
+
     f32 closest_hit = SEMATH_INFINITY;
-    for (u32 i = 0; i < m_level.entities.count; ++i) {
+    for (u32 c = 0; c < candidates_count; ++c) {
+        u32 i = candidates[c];
+        if (i >= m_level.entities.count) continue;
         f32 hit;
         if (ray_overlaps_aabb3d(raycast_origin, raycast_dir, 100, m_level.entities.aabb_transformed[i], &hit)) {
             if (hit < closest_hit) {
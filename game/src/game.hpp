@@ -28,6 +28,9 @@ public:
 
     App(SDL_Window *window);
     ~App();
+        /// The settings meshes are imported with. The offline validate and cook steps use the same ones,
+        /// otherwise their cache keys wouldn't match the ones the game looks for
+    static SE_Mesh_Import_Settings mesh_import_settings();
 
     void update(f32 delta_time);
     void render();
@@ -54,13 +57,13 @@ private:
     bool m_has_queued_for_change_of_mode;
     GAME_MODES m_queued_mode;
 
-    SE_Render_Target m_render_target_scene; // the geometry in the scene (entities and particles)
-    SE_Render_Target m_render_target_downsample;
-    SE_Render_Target m_render_target_upsample;
-    SE_Render_Target m_render_target_blur;  // blurred scene
-    SE_Render_Target m_render_target_bloom;  // blurred scene
-    SE_Render_Target m_render_target_gaussian_blur_h;  // horizontally blurred
-    SE_Render_Target m_render_target_gaussian_blur_v;  // vertically blurred
+    SE_Render_Graph m_render_graph; // the passes of a frame, see build_render_graph
+    u32 m_render_graph_scene;       // the geometry in the scene (entities and particles)
+    u32 m_render_graph_bloom;       // the scene with bloom (see se_render_bloom)
+    void build_render_graph();
+    static void render_pass_scene(SE_Render_Graph *graph, u32 pass, void *app);
+    static void render_pass_bloom(SE_Render_Graph *graph, u32 pass, void *app);
+    static void render_pass_tonemap(SE_Render_Graph *graph, u32 pass, void *app);
 
     ///
     ///     UTILITY FUNCTIONALITIES
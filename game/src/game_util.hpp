@@ -38,8 +38,6 @@ u32 point_light_4 = -1;
 SE_Grid grid;
 RGBA value_mappings[SE_GRID_MAX_VALUE];
 
-SE_Animation animation;
-
 RGBA dim = {100, 100, 100, 255};
 RGBA lit = {255, 255, 255, 255};
 
@@ -55,19 +53,36 @@ u32 main_camera = -1;
 
 void App::util_load_meshes_from_disk() {
         // @temp TODO: MOVE TO LOADER
-    mesh_soulspear = se_render3d_load_mesh(&m_renderer, "game/meshes/soulspear/soulspear.obj", false);
+        // import all of the models in the background, then upload them in the same order as before
+        // so the mesh indices (which levels are saved with) don't change
+    enum {
+        MODEL_SOULSPEAR, MODEL_GUY, MODEL_CUBE, MODEL_CUBE_TINY,
+        MODEL_CRATE, MODEL_DIAMOND, MODEL_WALL, MODEL_BOX1, MODEL_COUNT
+    };
+    const char *model_filepaths[MODEL_COUNT] = {
+        "game/meshes/soulspear/soulspear.obj",
+        "game/meshes/Sitting Laughing.fbx",
+        "core/meshes/cube.fbx",
+        "core/meshes/cube_tiny.obj",
+        "game/meshes/demo/Crate/Wooden Crate.obj",
+        "game/meshes/demo/Diamond/diamond.obj",
+        "game/meshes/demo/Stone/STONES.fbx",
+        "game/meshes/demo/Box2/TestCube.fbx",
+    };
+    SE_Mesh_Load_Batch batch;
+    se_render3d_load_meshes_begin(&m_renderer, &batch, model_filepaths, MODEL_COUNT);
+
+    mesh_soulspear = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_SOULSPEAR);
 #if 1
     // mesh_guy = se_render3d_load_mesh(&m_renderer, "game/meshes/Booty Hip Hop Dance.fbx", true);
-    mesh_guy = se_render3d_load_mesh(&m_renderer, "game/meshes/Sitting Laughing.fbx", true);
+    mesh_guy = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_GUY);
     // mesh_guy = se_render3d_load_mesh(&m_renderer, "game/meshes/changedPrizm2.fbx", true);
     // mesh_guy = se_render3d_load_mesh(&m_renderer, "core/meshes/TriangularPrism.fbx", true);
     mesh_skeleton = se_render3d_add_mesh_empty(&m_renderer);
     se_mesh_generate_skinned_skeleton(m_renderer.user_meshes[mesh_skeleton], m_renderer.user_meshes[mesh_guy]->skeleton, true, true);
     // se_mesh_generate_static_skeleton(m_renderer.meshes[mesh_skeleton], m_renderer.meshes[mesh_guy]->skeleton);
-
-    animation.current_frame = 0;
-    animation.duration = m_renderer.user_meshes[mesh_guy]->skeleton->animations[0]->duration;
-    animation.speed = m_renderer.user_meshes[mesh_guy]->skeleton->animations[0]->ticks_per_second;
+        // the bones are drawn in the pose of the guy they belong to
+    m_renderer.user_meshes[mesh_skeleton]->animator = m_renderer.user_meshes[mesh_guy]->animator;
 #endif
 
     mesh_plane = se_render3d_add_plane(&m_renderer, v3f(1, 1, 1));
@@ -84,30 +99,35 @@ void App::util_load_meshes_from_disk() {
     point_light_4 = se_render3d_add_point_light_ext(&m_renderer, 1.0f, 0.14f, 0.07f);
     current_obj_aabb = se_render3d_add_mesh_empty(&m_renderer);
 
-    mesh_cube = se_render3d_load_mesh(&m_renderer, "core/meshes/cube.fbx", false);
-    mesh_cube_tiny = se_render3d_load_mesh(&m_renderer, "core/meshes/cube_tiny.obj", false);
+    mesh_cube = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_CUBE);
+    mesh_cube_tiny = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_CUBE_TINY);
     m_renderer.user_meshes[mesh_cube_tiny]->should_cast_shadow = false;
 
-    mesh_demo_crate = se_render3d_load_mesh(&m_renderer, "game/meshes/demo/Crate/Wooden Crate.obj", false);
+    mesh_demo_crate = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_CRATE);
 
-    mesh_demo_diamond = se_render3d_load_mesh(&m_renderer, "game/meshes/demo/Diamond/diamond.obj", false);
+    mesh_demo_diamond = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_DIAMOND);
     {
-        const char *vsd[2] = {
+        const char *vsd[4] = {
+            "core/shaders/3D/frame_header.glsl",
+            "core/shaders/3D/vertex_header.vsd",
             "core/shaders/3D/lit_header.vsd",
             "core/shaders/3D/lit.vsd"
         };
 
-        const char *fsd[2] = {
+        const char *fsd[3] = {
+            "core/shaders/3D/frame_header.glsl",
             "core/shaders/3D/lit_header.fsd",
             "game/shaders/diamond.fsd"
         };
-        diamond_shader = se_render3d_add_shader(&m_renderer, vsd, 2, fsd, 2, NULL, 0);
+        diamond_shader = se_render3d_add_shader(&m_renderer, vsd, 4, fsd, 3, NULL, 0);
     }
     m_renderer.user_materials[m_renderer.user_meshes[mesh_demo_diamond]->material_index]->shader_index = diamond_shader;
     m_renderer.user_materials[m_renderer.user_meshes[mesh_demo_diamond]->material_index]->type = SE_MATERIAL_TYPE_TRANSPARENT;
 
-    mesh_wall = se_render3d_load_mesh(&m_renderer, "game/meshes/demo/Stone/STONES.fbx", false);
-    mesh_box1 = se_render3d_load_mesh(&m_renderer, "game/meshes/demo/Box2/TestCube.fbx", false);
+    mesh_wall = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_WALL);
+    mesh_box1 = se_render3d_load_meshes_upload(&m_renderer, &batch, MODEL_BOX1);
+
+    se_render3d_load_meshes_end(&batch);
 }
 
 void App::util_create_default_scene() {
@@ -174,6 +194,14 @@ void App::util_create_scene_from_image(const char *filepath) {
         m_level.entities.position[player] = v3f(5, 0, 5);
         // @temp
         m_level.entities.scale[player] = v3f(0.05f,0.05f,0.05f);
+            // the player has its own animator, half way through the animation, so it isn't in step with the guys
+        const SE_Animator *guy_animator = m_renderer.user_meshes[mesh_guy]->animator;
+        if (guy_animator != NULL) {
+            u32 animator = se_render3d_add_animator(&m_renderer, guy_animator->skeleton);
+            SE_Animator *player_animator = m_renderer.user_animators[animator];
+            player_animator->playback.current_frame = player_animator->playback.duration * 0.5f;
+            m_level.entities.animator_index[player] = animator;
+        }
     }
 
     {   //- Lights
@@ -294,8 +322,7 @@ void App::util_update_game_mode(f32 delta_time) {
 
             //- Entities
     m_level.entities.update(&m_renderer, delta_time);
-    se_animation_update(&animation, delta_time);
-    se_skeleton_calculate_pose(m_renderer.user_meshes[mesh_guy]->skeleton, animation.current_frame);
+    se_render3d_update_animators(&m_renderer, delta_time);
 
         //- PLAYER MOVEMENT
     if (m_level.m_player) {
@@ -330,8 +357,7 @@ void App::util_update_engine_mode(f32 delta_time) {
         //- Entities
     m_level.entities.update(&m_renderer, delta_time);
 #if 1
-    se_animation_update(&animation, delta_time);
-    se_skeleton_calculate_pose(m_renderer.user_meshes[mesh_guy]->skeleton, animation.current_frame);
+    se_render3d_update_animators(&m_renderer, delta_time);
 #endif
 
         // select entities
@@ -486,5 +512,80 @@ void App::util_show_menubar() {
         if (ImGui::Button("load level")) {
             this->load_assets_and_level();
         }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark culling")) {
+            se_frustum_cull_benchmark(100000, 100); // prints the results
+            se_bvh_benchmark(100000, 100);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark point light shadows")) {
+            se_render3d_benchmark_omni_shadows(&m_renderer, m_level.entities.shadow_mesh_index, m_level.entities.transform,
+                m_level.entities.animator_index, &m_level.entities.bvh, m_level.entities.count, 100); // prints the results
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark directional shadows")) {
+            se_render3d_benchmark_directional_shadows(&m_renderer, m_level.entities.shadow_mesh_index, m_level.entities.transform,
+                m_level.entities.animator_index, &m_level.entities.bvh, m_level.entities.count,
+                se_bvh_get_bounds(&m_level.entities.bvh), 300, 0.05f); // prints the results
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark animation") && mesh_guy != (u32)-1 && m_renderer.user_meshes[mesh_guy]->skeleton != NULL) {
+            const SE_Animator *animator = m_renderer.user_meshes[mesh_guy]->animator;
+            se_skeleton_benchmark_pose(m_renderer.user_meshes[mesh_guy]->skeleton, animator->animation, 1000); // prints the results
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark 500 animators") && mesh_guy != (u32)-1 && m_renderer.user_meshes[mesh_guy]->skeleton != NULL) {
+            se_animators_benchmark(m_renderer.user_meshes[mesh_guy]->skeleton, 500, 100); // prints the results
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("benchmark vertex formats")) {
+            se_render3d_benchmark_vertex_formats("game/meshes/Sitting Laughing.fbx", 20); // prints the results
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("self tests")) {
+            se_render_queue_self_test(); // prints the results
+            se_render_graph_self_test();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("print render graph")) {
+            se_render_graph_print(&m_render_graph);
+        }
+        ImGui::SameLine();
+        const char *omni_shadow_paths[SE_OMNI_SHADOW_PATH_COUNT] = {"auto", "geometry shader", "vertex layer", "per face"};
+        i32 omni_shadow_path = m_renderer.omni_shadow_path;
+        ImGui::SetNextItemWidth(140);
+        if (ImGui::Combo("point light shadows", &omni_shadow_path, omni_shadow_paths, SE_OMNI_SHADOW_PATH_COUNT)) {
+            se_render3d_set_omni_shadow_path(&m_renderer, (SE_OMNI_SHADOW_PATH)omni_shadow_path);
+        }
+            // - Render Stats (shadow maps and scene of this frame)
+        ImGui::SameLine();
+        bool instancing = m_renderer.instancing;
+        ImGui::Checkbox("instancing", &instancing);
+        m_renderer.instancing = instancing;
+        ImGui::SameLine();
+        i32 cascades = m_renderer.shadow_cascades_count;
+        ImGui::SetNextItemWidth(80);
+        ImGui::SliderInt("shadow cascades", &cascades, 1, SERENDERER3D_MAX_SHADOW_CASCADES);
+        m_renderer.shadow_cascades_count = cascades;
+        ImGui::SameLine();
+        i32 bloom_mips = m_renderer.bloom_mips_count;
+        ImGui::SetNextItemWidth(80);
+        ImGui::SliderInt("bloom mips", &bloom_mips, 1, SERENDERER3D_MAX_BLOOM_MIPS);
+        m_renderer.bloom_mips_count = bloom_mips;
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        ImGui::SliderFloat("bloom threshold", &m_renderer.bloom_threshold, 0.0f, 5.0f);
+        ImGui::SameLine();
+        ImGui::Text("draw calls: %u, meshes: %u", m_renderer.stats.draw_calls, m_renderer.stats.instances);
+        ImGui::SameLine();
+        ImGui::Text("render targets: %.1f mb", m_render_graph.peak_bytes / (1024.0 * 1024.0));
+        ImGui::SameLine();
+        ImGui::Text("shadow maps rebuilt: %u (skipped %u)", m_renderer.stats.shadow_maps_rebuilt, m_renderer.stats.shadow_maps_skipped);
+        ImGui::SameLine();
+        ImGui::Text("bone palette: %u bones, %.1f kb", m_renderer.animation_palette_count,
+            m_renderer.animation_palette_count * sizeof(Mat4) / 1024.0);
+        ImGui::SameLine();
+        SE_GL_State_Stats gl_stats = se_gl_state_get_stats();
+        ImGui::Text("gl state calls: %u (skipped %u)", gl_stats.calls_issued, gl_stats.calls_skipped);
     } UI::window_end();
 }
\ No newline at end of file
@@ -9,7 +9,26 @@
 
 void apply_custom_style();
 
-int main() {
+int main(int argc, char **argv) {
+        //- Validate the asset cache and quit. Doesn't import anything or open a window
+    if (argc > 1 && strcmp(argv[1], "--validate-assets") == 0) {
+        SE_Mesh_Import_Settings settings = App::mesh_import_settings();
+        u32 stale_count = 0;
+        stale_count += se_mesh_cache_validate("core", &settings);
+        stale_count += se_mesh_cache_validate("game", &settings);
+        return stale_count > 0 ? 1 : 0;
+    }
+        //- Import every asset and cook its textures ahead of time, so the game starts without decoding any images
+    if (argc > 1 && strcmp(argv[1], "--cook-assets") == 0) {
+        SE_Mesh_Import_Settings settings = App::mesh_import_settings();
+        u32 failed_count = 0;
+        failed_count += se_mesh_cache_cook("core", &settings);
+        failed_count += se_mesh_cache_cook("game", &settings);
+        const char *asset_directories[2] = {"core", "game"};
+        se_mesh_cache_prune(asset_directories, 2, &settings); // the entries of the assets that were edited or removed
+        return failed_count > 0 ? 1 : 0;
+    }
+
         //- init SDL
     ERROR_ON_NOTZERO_SDL(SDL_Init(SDL_INIT_EVERYTHING), "init_sdl");
 
@@ -143,6 +162,7 @@ int main() {
         ImGui::Render();
         glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        se_gl_state_invalidate(); // ImGui changes the GL state behind our back
         SDL_GL_SwapWindow(window);
     }
 
@@ -0,0 +1,3 @@
+PUSHD ..\game\bin
+CALL game.exe --validate-assets
+POPD
\ No newline at end of file
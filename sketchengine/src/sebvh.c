@@ -0,0 +1,538 @@
+#include "sebvh.h"
+
+#include <stdio.h> // printf
+
+#define BVH_STACK_CAPACITY 256 // traversals need one more than the height of the tree
+
+///
+/// AABB HELPERS
+///
+
+static AABB3D bvh_union(AABB3D a, AABB3D b) {
+    return aabb3d_create(
+        se_math_min(a.min.x, b.min.x), se_math_min(a.min.y, b.min.y), se_math_min(a.min.z, b.min.z),
+        se_math_max(a.max.x, b.max.x), se_math_max(a.max.y, b.max.y), se_math_max(a.max.z, b.max.z));
+}
+
+static f32 bvh_area(AABB3D a) {
+    Vec3 d = vec3_sub(a.max, a.min);
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static b8 bvh_contains(AABB3D outer, AABB3D inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+        && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static b8 bvh_overlaps(AABB3D a, AABB3D b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x
+        && a.min.y <= b.max.y && a.max.y >= b.min.y
+        && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static AABB3D bvh_fatten(AABB3D aabb, f32 margin) {
+    Vec3 m = {margin, margin, margin};
+    aabb.min = vec3_sub(aabb.min, m);
+    aabb.max = vec3_add(aabb.max, m);
+    return aabb;
+}
+
+///
+/// NODES
+///
+
+static i32 bvh_allocate_node(SE_BVH *bvh) {
+    if (bvh->free_list == SE_BVH_NULL) {
+        u32 old_capacity = bvh->nodes_capacity;
+        u32 new_capacity = old_capacity == 0 ? 64 : old_capacity * 2;
+        bvh->nodes = realloc(bvh->nodes, new_capacity * sizeof(SE_BVH_Node));
+        for (u32 i = old_capacity; i < new_capacity; ++i) {
+            bvh->nodes[i].parent = i + 1 < new_capacity ? (i32)(i + 1) : SE_BVH_NULL;
+            bvh->nodes[i].height = -1;
+        }
+        bvh->nodes_capacity = new_capacity;
+        bvh->free_list = (i32)old_capacity;
+    }
+
+    i32 index = bvh->free_list;
+    SE_BVH_Node *node = &bvh->nodes[index];
+    bvh->free_list = node->parent;
+    node->parent = SE_BVH_NULL;
+    node->child1 = SE_BVH_NULL;
+    node->child2 = SE_BVH_NULL;
+    node->height = 0;
+    node->user_data = 0;
+    bvh->nodes_count++;
+    return index;
+}
+
+static void bvh_free_node(SE_BVH *bvh, i32 index) {
+    bvh->nodes[index].parent = bvh->free_list;
+    bvh->nodes[index].height = -1;
+    bvh->free_list = index;
+    bvh->nodes_count--;
+}
+
+static void bvh_update_node(SE_BVH *bvh, i32 index) {
+    SE_BVH_Node *node = &bvh->nodes[index];
+    const SE_BVH_Node *child1 = &bvh->nodes[node->child1];
+    const SE_BVH_Node *child2 = &bvh->nodes[node->child2];
+    node->aabb = bvh_union(child1->aabb, child2->aabb);
+    node->height = 1 + se_math_max(child1->height, child2->height);
+}
+
+    /// Swaps "x", a child of "a", with "y", a child of "z" (the other child of "a")
+static void bvh_swap(SE_BVH *bvh, i32 a_index, i32 x_index, i32 z_index, i32 y_index) {
+    SE_BVH_Node *a = &bvh->nodes[a_index];
+    SE_BVH_Node *z = &bvh->nodes[z_index];
+    if (a->child1 == x_index) a->child1 = y_index; else a->child2 = y_index;
+    if (z->child1 == y_index) z->child1 = x_index; else z->child2 = x_index;
+    bvh->nodes[x_index].parent = z_index;
+    bvh->nodes[y_index].parent = a_index;
+    bvh_update_node(bvh, z_index);
+    a->height = 1 + se_math_max(bvh->nodes[a->child1].height, bvh->nodes[a->child2].height);
+}
+
+    /// Tries swapping a child of "a" with a grandchild on the other side, picks the swap that shrinks the surface area
+    /// of the tree the most (if any). The aabb of "a" stays the same.
+static void bvh_rotate(SE_BVH *bvh, i32 a_index) {
+    const SE_BVH_Node *a = &bvh->nodes[a_index];
+    if (a->height < 2) return;
+
+    i32 b_index = a->child1;
+    i32 c_index = a->child2;
+    const SE_BVH_Node *b = &bvh->nodes[b_index];
+    const SE_BVH_Node *c = &bvh->nodes[c_index];
+
+    f32 best_delta = 0;
+    i32 best_x = SE_BVH_NULL, best_z = SE_BVH_NULL, best_y = SE_BVH_NULL;
+    if (c->height > 0) { // b swaps with a child of c, c is left with b and the other child
+        f32 c_area = bvh_area(c->aabb);
+        f32 delta1 = bvh_area(bvh_union(b->aabb, bvh->nodes[c->child2].aabb)) - c_area;
+        f32 delta2 = bvh_area(bvh_union(b->aabb, bvh->nodes[c->child1].aabb)) - c_area;
+        if (delta1 < best_delta) { best_delta = delta1; best_x = b_index; best_z = c_index; best_y = c->child1; }
+        if (delta2 < best_delta) { best_delta = delta2; best_x = b_index; best_z = c_index; best_y = c->child2; }
+    }
+    if (b->height > 0) { // c swaps with a child of b
+        f32 b_area = bvh_area(b->aabb);
+        f32 delta1 = bvh_area(bvh_union(c->aabb, bvh->nodes[b->child2].aabb)) - b_area;
+        f32 delta2 = bvh_area(bvh_union(c->aabb, bvh->nodes[b->child1].aabb)) - b_area;
+        if (delta1 < best_delta) { best_delta = delta1; best_x = c_index; best_z = b_index; best_y = b->child1; }
+        if (delta2 < best_delta) { best_delta = delta2; best_x = c_index; best_z = b_index; best_y = b->child2; }
+    }
+
+    if (best_x != SE_BVH_NULL) {
+        bvh_swap(bvh, a_index, best_x, best_z, best_y);
+    }
+}
+
+    /// Refits the aabbs and heights from "index" to the root, rotating on the way up
+static void bvh_refit(SE_BVH *bvh, i32 index) {
+    while (index != SE_BVH_NULL) {
+        bvh_update_node(bvh, index);
+        bvh_rotate(bvh, index);
+        index = bvh->nodes[index].parent;
+    }
+}
+
+    /// The node that adds the least surface area to the tree when it becomes the sibling of the new leaf.
+    /// Enlarging a node costs the same for every node above it, so subtrees that can't beat the best so far are skipped.
+static i32 bvh_find_best_sibling(const SE_BVH *bvh, AABB3D leaf_aabb) {
+    f32 leaf_area = bvh_area(leaf_aabb);
+    i32 best = bvh->root;
+    f32 best_cost = bvh_area(bvh_union(leaf_aabb, bvh->nodes[bvh->root].aabb));
+
+    i32 stack[BVH_STACK_CAPACITY];
+    f32 inherited_costs[BVH_STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count] = bvh->root;
+    inherited_costs[stack_count] = 0;
+    stack_count++;
+
+    while (stack_count > 0) {
+        stack_count--;
+        i32 index = stack[stack_count];
+        f32 inherited_cost = inherited_costs[stack_count];
+        const SE_BVH_Node *node = &bvh->nodes[index];
+
+        f32 direct_cost = bvh_area(bvh_union(leaf_aabb, node->aabb));
+        f32 cost = direct_cost + inherited_cost;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = index;
+        }
+        if (node->height == 0) continue;
+
+        f32 child_inherited_cost = inherited_cost + direct_cost - bvh_area(node->aabb);
+        f32 lower_bound = leaf_area + child_inherited_cost;
+        if (lower_bound < best_cost && stack_count + 2 <= BVH_STACK_CAPACITY) {
+            stack[stack_count] = node->child1;
+            inherited_costs[stack_count] = child_inherited_cost;
+            stack_count++;
+            stack[stack_count] = node->child2;
+            inherited_costs[stack_count] = child_inherited_cost;
+            stack_count++;
+        }
+    }
+    return best;
+}
+
+static void bvh_insert_leaf(SE_BVH *bvh, i32 leaf) {
+    if (bvh->root == SE_BVH_NULL) {
+        bvh->root = leaf;
+        bvh->nodes[leaf].parent = SE_BVH_NULL;
+        return;
+    }
+
+    i32 sibling = bvh_find_best_sibling(bvh, bvh->nodes[leaf].aabb);
+    i32 old_parent = bvh->nodes[sibling].parent;
+    i32 new_parent = bvh_allocate_node(bvh); // ! can move the nodes
+
+    SE_BVH_Node *nodes = bvh->nodes;
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    bvh_update_node(bvh, new_parent);
+
+    if (old_parent == SE_BVH_NULL) {
+        bvh->root = new_parent;
+    } else {
+        if (nodes[old_parent].child1 == sibling) nodes[old_parent].child1 = new_parent;
+        else                                     nodes[old_parent].child2 = new_parent;
+        bvh_refit(bvh, old_parent);
+    }
+}
+
+static void bvh_remove_leaf(SE_BVH *bvh, i32 leaf) {
+    if (leaf == bvh->root) {
+        bvh->root = SE_BVH_NULL;
+        return;
+    }
+
+    SE_BVH_Node *nodes = bvh->nodes;
+    i32 parent = nodes[leaf].parent;
+    i32 grand_parent = nodes[parent].parent;
+    i32 sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    nodes[sibling].parent = grand_parent;
+    if (grand_parent == SE_BVH_NULL) {
+        bvh->root = sibling;
+    } else {
+        if (nodes[grand_parent].child1 == parent) nodes[grand_parent].child1 = sibling;
+        else                                      nodes[grand_parent].child2 = sibling;
+        bvh_refit(bvh, grand_parent);
+    }
+    bvh_free_node(bvh, parent);
+}
+
+///
+/// TREE
+///
+
+void se_bvh_init(SE_BVH *bvh, f32 margin) {
+    memset(bvh, 0, sizeof(SE_BVH));
+    bvh->root = SE_BVH_NULL;
+    bvh->free_list = SE_BVH_NULL;
+    bvh->margin = margin;
+}
+
+void se_bvh_deinit(SE_BVH *bvh) {
+    free(bvh->nodes);
+    memset(bvh, 0, sizeof(SE_BVH));
+    bvh->root = SE_BVH_NULL;
+    bvh->free_list = SE_BVH_NULL;
+}
+
+void se_bvh_clear(SE_BVH *bvh) {
+    for (u32 i = 0; i < bvh->nodes_capacity; ++i) {
+        bvh->nodes[i].parent = i + 1 < bvh->nodes_capacity ? (i32)(i + 1) : SE_BVH_NULL;
+        bvh->nodes[i].height = -1;
+    }
+    bvh->free_list = bvh->nodes_capacity > 0 ? 0 : SE_BVH_NULL;
+    bvh->nodes_count = 0;
+    bvh->root = SE_BVH_NULL;
+}
+
+i32 se_bvh_insert(SE_BVH *bvh, AABB3D aabb, u32 user_data) {
+    i32 proxy = bvh_allocate_node(bvh);
+    bvh->nodes[proxy].aabb = bvh_fatten(aabb, bvh->margin);
+    bvh->nodes[proxy].user_data = user_data;
+    bvh_insert_leaf(bvh, proxy);
+    return proxy;
+}
+
+void se_bvh_remove(SE_BVH *bvh, i32 proxy) {
+    se_assert(proxy >= 0 && (u32)proxy < bvh->nodes_capacity && bvh->nodes[proxy].height == 0 && "not a leaf");
+    bvh_remove_leaf(bvh, proxy);
+    bvh_free_node(bvh, proxy);
+}
+
+b8 se_bvh_move(SE_BVH *bvh, i32 proxy, AABB3D aabb) {
+    se_assert(proxy >= 0 && (u32)proxy < bvh->nodes_capacity && bvh->nodes[proxy].height == 0 && "not a leaf");
+    SE_BVH_Node *leaf = &bvh->nodes[proxy];
+    if (bvh_contains(leaf->aabb, aabb)) return false;
+
+    if (bvh_overlaps(leaf->aabb, aabb) && leaf->parent != SE_BVH_NULL) {
+            // moved a little, refit where it is
+        leaf->aabb = bvh_fatten(aabb, bvh->margin);
+        bvh_refit(bvh, leaf->parent);
+    } else {
+            // moved away, find a new place for it
+        bvh_remove_leaf(bvh, proxy);
+        bvh->nodes[proxy].aabb = bvh_fatten(aabb, bvh->margin);
+        bvh_insert_leaf(bvh, proxy);
+    }
+    return true;
+}
+
+void se_bvh_set_user_data(SE_BVH *bvh, i32 proxy, u32 user_data) {
+    se_assert(proxy >= 0 && (u32)proxy < bvh->nodes_capacity && bvh->nodes[proxy].height == 0 && "not a leaf");
+    bvh->nodes[proxy].user_data = user_data;
+}
+
+AABB3D se_bvh_get_fat_aabb(const SE_BVH *bvh, i32 proxy) {
+    se_assert(proxy >= 0 && (u32)proxy < bvh->nodes_capacity && bvh->nodes[proxy].height == 0 && "not a leaf");
+    return bvh->nodes[proxy].aabb;
+}
+
+AABB3D se_bvh_get_bounds(const SE_BVH *bvh) {
+    if (bvh->root == SE_BVH_NULL) return (AABB3D) {0};
+    return bvh->nodes[bvh->root].aabb;
+}
+
+i32 se_bvh_get_height(const SE_BVH *bvh) {
+    if (bvh->root == SE_BVH_NULL) return 0;
+    return bvh->nodes[bvh->root].height;
+}
+
+///
+/// QUERIES
+///
+
+typedef enum BVH_OVERLAP {
+    BVH_OVERLAP_NONE,
+    BVH_OVERLAP_PARTIAL,
+    BVH_OVERLAP_FULL,   // everything below the node passes without testing
+} BVH_OVERLAP;
+
+typedef BVH_OVERLAP (*BVH_Test_Proc)(const void *shape, AABB3D aabb);
+
+static u32 bvh_query(const SE_BVH *bvh, BVH_Test_Proc test, const void *shape, u32 *result, u32 result_capacity) {
+    if (bvh->root == SE_BVH_NULL) return 0;
+    u32 result_count = 0;
+
+    i32 stack[BVH_STACK_CAPACITY];
+    b8 inside_stack[BVH_STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count] = bvh->root;
+    inside_stack[stack_count] = false;
+    stack_count++;
+
+    while (stack_count > 0) {
+        stack_count--;
+        i32 index = stack[stack_count];
+        b8 inside = inside_stack[stack_count];
+        const SE_BVH_Node *node = &bvh->nodes[index];
+
+        if (!inside) {
+            BVH_OVERLAP overlap = test(shape, node->aabb);
+            if (overlap == BVH_OVERLAP_NONE) continue;
+            inside = overlap == BVH_OVERLAP_FULL;
+        }
+
+        if (node->height == 0) {
+            if (result_count >= result_capacity) break;
+            result[result_count++] = node->user_data;
+        } else {
+            se_assert(stack_count + 2 <= BVH_STACK_CAPACITY && "the bvh is too deep");
+            stack[stack_count] = node->child2;
+            inside_stack[stack_count] = inside;
+            stack_count++;
+            stack[stack_count] = node->child1;
+            inside_stack[stack_count] = inside;
+            stack_count++;
+        }
+    }
+    return result_count;
+}
+
+static BVH_OVERLAP bvh_test_aabb(const void *shape, AABB3D aabb) {
+    const AABB3D *query = shape;
+    if (!bvh_overlaps(*query, aabb)) return BVH_OVERLAP_NONE;
+    return bvh_contains(*query, aabb) ? BVH_OVERLAP_FULL : BVH_OVERLAP_PARTIAL;
+}
+
+typedef struct BVH_Sphere {
+    Vec3 origin;
+    f32 radius;
+} BVH_Sphere;
+
+static BVH_OVERLAP bvh_test_sphere(const void *shape, AABB3D aabb) {
+    const BVH_Sphere *sphere = shape;
+    if (!aabb3d_overlaps_sphere(aabb, sphere->origin, sphere->radius)) return BVH_OVERLAP_NONE;
+        // the farthest corner is inside too
+    Vec3 far = {
+        se_math_max(se_math_abs(aabb.min.x - sphere->origin.x), se_math_abs(aabb.max.x - sphere->origin.x)),
+        se_math_max(se_math_abs(aabb.min.y - sphere->origin.y), se_math_abs(aabb.max.y - sphere->origin.y)),
+        se_math_max(se_math_abs(aabb.min.z - sphere->origin.z), se_math_abs(aabb.max.z - sphere->origin.z)),
+    };
+    return vec3_dot(far, far) <= sphere->radius * sphere->radius ? BVH_OVERLAP_FULL : BVH_OVERLAP_PARTIAL;
+}
+
+static BVH_OVERLAP bvh_test_frustum(const void *shape, AABB3D aabb) {
+    const SE_Frustum *frustum = shape;
+    Vec3 centre = vec3_mul_scalar(vec3_add(aabb.min, aabb.max), 0.5f);
+    Vec3 extent = vec3_mul_scalar(vec3_sub(aabb.max, aabb.min), 0.5f);
+    BVH_OVERLAP result = BVH_OVERLAP_FULL;
+    for (i32 i = 0; i < SE_FRUSTUM_PLANE_COUNT; ++i) {
+        Vec4 p = frustum->planes[i];
+        f32 distance = p.x * centre.x + p.y * centre.y + p.z * centre.z + p.w;
+        f32 radius = se_math_abs(p.x) * extent.x + se_math_abs(p.y) * extent.y + se_math_abs(p.z) * extent.z;
+        if (distance + radius < 0) return BVH_OVERLAP_NONE;
+        if (distance - radius < 0) result = BVH_OVERLAP_PARTIAL; // straddles this plane
+    }
+    return result;
+}
+
+typedef struct BVH_Ray {
+    Vec3 origin;
+    Vec3 inverse_direction;
+    f32 max_distance;
+} BVH_Ray;
+
+static BVH_OVERLAP bvh_test_ray(const void *shape, AABB3D aabb) {
+    const BVH_Ray *ray = shape;
+    f32 t1 = (aabb.min.x - ray->origin.x) * ray->inverse_direction.x;
+    f32 t2 = (aabb.max.x - ray->origin.x) * ray->inverse_direction.x;
+    f32 t3 = (aabb.min.y - ray->origin.y) * ray->inverse_direction.y;
+    f32 t4 = (aabb.max.y - ray->origin.y) * ray->inverse_direction.y;
+    f32 t5 = (aabb.min.z - ray->origin.z) * ray->inverse_direction.z;
+    f32 t6 = (aabb.max.z - ray->origin.z) * ray->inverse_direction.z;
+    f32 t_min = se_math_max(se_math_max(se_math_min(t1, t2), se_math_min(t3, t4)), se_math_min(t5, t6));
+    f32 t_max = se_math_min(se_math_min(se_math_max(t1, t2), se_math_max(t3, t4)), se_math_max(t5, t6));
+    if (t_max < 0 || t_min > t_max || t_min > ray->max_distance) return BVH_OVERLAP_NONE;
+    return BVH_OVERLAP_PARTIAL;
+}
+
+u32 se_bvh_query_aabb(const SE_BVH *bvh, AABB3D aabb, u32 *result, u32 result_capacity) {
+    return bvh_query(bvh, bvh_test_aabb, &aabb, result, result_capacity);
+}
+
+u32 se_bvh_query_sphere(const SE_BVH *bvh, Vec3 sphere_origin, f32 sphere_radius, u32 *result, u32 result_capacity) {
+    BVH_Sphere sphere = {sphere_origin, sphere_radius};
+    return bvh_query(bvh, bvh_test_sphere, &sphere, result, result_capacity);
+}
+
+u32 se_bvh_query_frustum(const SE_BVH *bvh, const SE_Frustum *frustum, u32 *result, u32 result_capacity) {
+    return bvh_query(bvh, bvh_test_frustum, frustum, result, result_capacity);
+}
+
+u32 se_bvh_query_ray
+(const SE_BVH *bvh, Vec3 ray_origin, Vec3 ray_direction, f32 max_distance, u32 *result, u32 result_capacity) {
+    vec3_normalise(&ray_direction);
+    BVH_Ray ray;
+    ray.origin = ray_origin;
+    ray.inverse_direction = v3f(1.0f / ray_direction.x, 1.0f / ray_direction.y, 1.0f / ray_direction.z);
+    ray.max_distance = max_distance;
+    return bvh_query(bvh, bvh_test_ray, &ray, result, result_capacity);
+}
+
+///
+/// BENCHMARK
+///
+
+static f64 bvh_benchmark_ms(u64 ticks, u32 iterations) {
+    return ticks * 1000.0 / (f64)SDL_GetPerformanceFrequency() / iterations;
+}
+
+f64 se_bvh_benchmark(u32 leaves_count, u32 iterations) {
+    AABB3D *aabbs = malloc(sizeof(AABB3D) * leaves_count);
+    i32 *proxies = malloc(sizeof(i32) * leaves_count);
+    u32 *result = malloc(sizeof(u32) * leaves_count);
+
+    srand(1234);
+    for (u32 i = 0; i < leaves_count; ++i) {
+        Vec3 pos = {
+            (rand() / (f32)RAND_MAX - 0.5f) * 200.0f,
+            (rand() / (f32)RAND_MAX - 0.5f) * 20.0f,
+            (rand() / (f32)RAND_MAX - 0.5f) * 200.0f,
+        };
+        f32 size = 0.25f + rand() / (f32)RAND_MAX * 2.0f;
+        aabbs[i] = aabb3d_create(pos.x - size, pos.y - size, pos.z - size, pos.x + size, pos.y + size, pos.z + size);
+    }
+
+    SE_BVH bvh;
+    se_bvh_init(&bvh, 0.1f);
+
+        //- Build and move
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < leaves_count; ++i) {
+        proxies[i] = se_bvh_insert(&bvh, aabbs[i], i);
+    }
+    u64 build_ticks = SDL_GetPerformanceCounter() - start;
+
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < leaves_count; ++i) {
+        Vec3 offset = {0.5f, 0, 0};
+        aabbs[i].min = vec3_add(aabbs[i].min, offset);
+        aabbs[i].max = vec3_add(aabbs[i].max, offset);
+        se_bvh_move(&bvh, proxies[i], aabbs[i]);
+    }
+    u64 move_ticks = SDL_GetPerformanceCounter() - start;
+
+        //- Frustum
+    Mat4 view = mat4_lookat(v3f(0, 5, 0), v3f(1, 5, 1), vec3_up());
+    Mat4 projection = mat4_perspective(SEMATH_DEG2RAD_MULTIPLIER * 60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    SE_Frustum frustum = se_frustum_from_matrix(mat4_mul(view, projection));
+
+    u32 frustum_count = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        frustum_count = se_bvh_query_frustum(&bvh, &frustum, result, leaves_count);
+    }
+    u64 frustum_ticks = SDL_GetPerformanceCounter() - start;
+
+    u32 brute_frustum_count = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        brute_frustum_count = se_frustum_cull_aabbs(&frustum, aabbs, leaves_count, result);
+    }
+    u64 brute_frustum_ticks = SDL_GetPerformanceCounter() - start;
+
+        //- Ray
+    Vec3 ray_origin = v3f(-100, 0, -100);
+    Vec3 ray_direction = v3f(1, 0, 1);
+    u32 ray_count = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        ray_count = se_bvh_query_ray(&bvh, ray_origin, ray_direction, 300.0f, result, leaves_count);
+    }
+    u64 ray_ticks = SDL_GetPerformanceCounter() - start;
+
+    u32 brute_ray_count = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        brute_ray_count = 0;
+        for (u32 i = 0; i < leaves_count; ++i) {
+            f32 hit;
+            if (ray_overlaps_aabb3d(ray_origin, ray_direction, 300.0f, aabbs[i], &hit)) result[brute_ray_count++] = i;
+        }
+    }
+    u64 brute_ray_ticks = SDL_GetPerformanceCounter() - start;
+
+    f64 frustum_ms = bvh_benchmark_ms(frustum_ticks, iterations);
+    printf("bvh: %u leaves, height %i, built in %.3f ms, moved in %.3f ms\n",
+            leaves_count, se_bvh_get_height(&bvh), bvh_benchmark_ms(build_ticks, 1), bvh_benchmark_ms(move_ticks, 1));
+    printf("bvh: frustum query %.3f ms (%u fat hits), brute force %.3f ms (%u hits)\n",
+            frustum_ms, frustum_count, bvh_benchmark_ms(brute_frustum_ticks, iterations), brute_frustum_count);
+    printf("bvh: ray query %.4f ms (%u fat hits), brute force %.4f ms (%u hits)\n",
+            bvh_benchmark_ms(ray_ticks, iterations), ray_count, bvh_benchmark_ms(brute_ray_ticks, iterations), brute_ray_count);
+
+    se_bvh_deinit(&bvh);
+    free(aabbs);
+    free(proxies);
+    free(result);
+    return frustum_ms;
+}
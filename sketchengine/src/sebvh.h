@@ -0,0 +1,65 @@
+#ifndef SEBVH_H
+#define SEBVH_H
+
+#include "sedefines.h"
+#include "semath.h"
+#include "sefrustum.h"
+
+///
+/// DYNAMIC BVH
+/// A dynamic aabb tree for scene queries (Erin Catto, "Dynamic Bounding Volume Hierarchies", GDC 2019).
+/// Leaves store a "fat" aabb (the given aabb grown by a margin) so small movements don't touch the tree.
+/// Leaves are inserted next to the sibling that adds the least surface area to the tree (branch and bound),
+/// and tree rotations keep it balanced as leaves are added, moved and removed.
+/// The queries write the "user_data" of the leaves whose fat aabb passes the test, the caller does the exact test.
+///
+
+#define SE_BVH_NULL -1
+
+typedef struct SE_BVH_Node {
+    AABB3D aabb;    // fat for leaves
+    i32 parent;     // the next free node while the node is not used
+    i32 child1;
+    i32 child2;     // SE_BVH_NULL for leaves
+    i32 height;     // 0 for leaves, -1 for free nodes
+    u32 user_data;  // leaves only
+} SE_BVH_Node;
+
+typedef struct SE_BVH {
+    SE_BVH_Node *nodes;
+    u32 nodes_capacity;
+    u32 nodes_count; // in use
+    i32 root;
+    i32 free_list;
+    f32 margin;      // added to every side of a leaf's aabb
+} SE_BVH;
+
+void se_bvh_init(SE_BVH *bvh, f32 margin);
+void se_bvh_deinit(SE_BVH *bvh);
+    /// Removes every leaf, keeps the memory
+void se_bvh_clear(SE_BVH *bvh);
+    /// Returns the proxy of the new leaf, used to move and remove it later
+i32 se_bvh_insert(SE_BVH *bvh, AABB3D aabb, u32 user_data);
+void se_bvh_remove(SE_BVH *bvh, i32 proxy);
+    /// Does nothing if "aabb" is still inside of the leaf's fat aabb. Otherwise the leaf and its ancestors are refitted
+    /// in place, or the leaf is reinserted if it moved away from where it was. Returns false if nothing was done.
+b8 se_bvh_move(SE_BVH *bvh, i32 proxy, AABB3D aabb);
+void se_bvh_set_user_data(SE_BVH *bvh, i32 proxy, u32 user_data);
+AABB3D se_bvh_get_fat_aabb(const SE_BVH *bvh, i32 proxy);
+    /// The fat aabb that contains every leaf, zero if the tree is empty
+AABB3D se_bvh_get_bounds(const SE_BVH *bvh);
+i32 se_bvh_get_height(const SE_BVH *bvh);
+
+    //- Queries. Each writes at most "result_capacity" user datas to "result" and returns how many it wrote.
+u32 se_bvh_query_aabb(const SE_BVH *bvh, AABB3D aabb, u32 *result, u32 result_capacity);
+u32 se_bvh_query_sphere(const SE_BVH *bvh, Vec3 sphere_origin, f32 sphere_radius, u32 *result, u32 result_capacity);
+u32 se_bvh_query_frustum(const SE_BVH *bvh, const SE_Frustum *frustum, u32 *result, u32 result_capacity);
+    /// The leaves the ray hits within "max_distance", in no particular order
+u32 se_bvh_query_ray
+(const SE_BVH *bvh, Vec3 ray_origin, Vec3 ray_direction, f32 max_distance, u32 *result, u32 result_capacity);
+
+    /// Builds a tree out of "leaves_count" random aabbs, moves them and queries it "iterations" times,
+    /// and prints the timings next to brute force. Returns the average milliseconds of one frustum query.
+f64 se_bvh_benchmark(u32 leaves_count, u32 iterations);
+
+#endif // SEBVH_H
@@ -26,6 +26,7 @@ typedef int i32;
 typedef unsigned int u32;
 typedef uint64_t u64;
 typedef short i16;
+typedef unsigned short u16;
 typedef char byte;
 typedef float f32;
 typedef double f64;
@@ -0,0 +1,225 @@
+#include "sefile.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <direct.h> // _mkdir
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <dirent.h>
+#endif
+
+#ifdef _WIN32
+b8 se_file_map_open(SE_File_Map *map, const char *filepath) {
+    memset(map, 0, sizeof(SE_File_Map));
+
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        printf("ERROR: could not create a file mapping for %s (%lu)\n", filepath, GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        printf("ERROR: could not map view of %s (%lu)\n", filepath, GetLastError());
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    map->data = data;
+    map->size = (u64)file_size.QuadPart;
+    map->file_handle = file;
+    map->mapping_handle = mapping;
+    return true;
+}
+
+void se_file_map_close(SE_File_Map *map) {
+    if (map->data != NULL) {
+        UnmapViewOfFile(map->data);
+        CloseHandle((HANDLE)map->mapping_handle);
+        CloseHandle((HANDLE)map->file_handle);
+    }
+    memset(map, 0, sizeof(SE_File_Map));
+}
+#else
+b8 se_file_map_open(SE_File_Map *map, const char *filepath) {
+    memset(map, 0, sizeof(SE_File_Map));
+
+    int file = open(filepath, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // the mapping keeps its own reference to the file
+    if (data == MAP_FAILED) {
+        printf("ERROR: could not mmap %s\n", filepath);
+        return false;
+    }
+
+    map->data = data;
+    map->size = (u64)file_stat.st_size;
+    return true;
+}
+
+void se_file_map_close(SE_File_Map *map) {
+    if (map->data != NULL) {
+        munmap((void*)map->data, (size_t)map->size);
+    }
+    memset(map, 0, sizeof(SE_File_Map));
+}
+#endif // _WIN32
+
+u64 se_hash_bytes(const void *data, u64 size, u64 hash) {
+    const ubyte *bytes = data;
+    for (u64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull; // FNV prime
+    }
+    return hash;
+}
+
+b8 se_file_hash(const char *filepath, u64 hash, u64 *result) {
+    SE_File_Map map;
+    if (!se_file_map_open(&map, filepath)) {
+        return false;
+    }
+    *result = se_hash_bytes(map.data, map.size, hash);
+    se_file_map_close(&map);
+    return true;
+}
+
+b8 se_file_modified_time(const char *filepath, u64 *result) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(filepath, GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+    *result = ((u64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat file_stat;
+    if (stat(filepath, &file_stat) != 0) {
+        return false;
+    }
+    // nanoseconds where the platform has them, so saving twice in the same second still changes the time
+    #if defined(__APPLE__)
+    *result = (u64)file_stat.st_mtimespec.tv_sec * 1000000000ull + (u64)file_stat.st_mtimespec.tv_nsec;
+    #elif defined(__linux__)
+    *result = (u64)file_stat.st_mtim.tv_sec * 1000000000ull + (u64)file_stat.st_mtim.tv_nsec;
+    #else
+    *result = (u64)file_stat.st_mtime * 1000000000ull;
+    #endif
+#endif
+    return true;
+}
+
+    /// Creates a single directory, the parent must already exist
+static b8 make_directory(const char *path) {
+#ifdef _WIN32
+    i32 error = _mkdir(path);
+#else
+    i32 error = mkdir(path, 0755);
+#endif
+    return error == 0 || errno == EEXIST;
+}
+
+b8 se_file_make_directory(const char *path) {
+    char buffer[1024];
+    u64 length = strlen(path);
+    if (length == 0 || length >= sizeof(buffer)) return false;
+    memcpy(buffer, path, length + 1);
+
+        // create every parent on the way
+    for (u64 i = 1; i < length; ++i) {
+        if (buffer[i] == '/' || buffer[i] == '\\') {
+            char separator = buffer[i];
+            buffer[i] = '\0';
+            make_directory(buffer);
+            buffer[i] = separator;
+        }
+    }
+    if (!make_directory(buffer)) {
+        printf("ERROR: could not create directory %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+u32 se_file_walk_directory(const char *directory, SE_File_Visit_Proc proc, void *user_data) {
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s/*", directory);
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(pattern, &find_data);
+    if (find == INVALID_HANDLE_VALUE) return 0;
+
+    u32 visited = 0;
+    do {
+        if (strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0) continue;
+
+        char filepath[MAX_PATH];
+        snprintf(filepath, sizeof(filepath), "%s/%s", directory, find_data.cFileName);
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            visited += se_file_walk_directory(filepath, proc, user_data);
+        } else {
+            proc(filepath, user_data);
+            visited++;
+        }
+    } while (FindNextFileA(find, &find_data));
+
+    FindClose(find);
+    return visited;
+}
+#else
+u32 se_file_walk_directory(const char *directory, SE_File_Visit_Proc proc, void *user_data) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) return 0;
+
+    u32 visited = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+        char filepath[4096];
+        snprintf(filepath, sizeof(filepath), "%s/%s", directory, entry->d_name);
+        struct stat file_stat;
+        if (stat(filepath, &file_stat) != 0) continue;
+        if (S_ISDIR(file_stat.st_mode)) {
+            visited += se_file_walk_directory(filepath, proc, user_data);
+        } else {
+            proc(filepath, user_data);
+            visited++;
+        }
+    }
+
+    closedir(dir);
+    return visited;
+}
+#endif // _WIN32
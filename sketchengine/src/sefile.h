@@ -0,0 +1,40 @@
+#ifndef SEFILE_H
+#define SEFILE_H
+
+#include "sedefines.h"
+
+/// A read-only view of a whole file, mapped into memory by the OS.
+/// The pages are faulted in on demand, so pointers into "data" can be handed
+/// straight to procedures like glBufferData without an intermediate copy.
+typedef struct SE_File_Map {
+    const ubyte *data; // NULL if the file is not mapped
+    u64 size;          // size of the file in bytes
+    /* platform handles */
+    void *file_handle;
+    void *mapping_handle;
+} SE_File_Map;
+
+    /// Maps the file at "filepath" into memory. Returns false if the file could not be opened or mapped.
+    /// Call se_file_map_close once you are done with the data.
+b8 se_file_map_open(SE_File_Map *map, const char *filepath);
+    /// Unmaps the file. Any pointer into the mapped data is invalid after this call.
+void se_file_map_close(SE_File_Map *map);
+
+    /// 64 bit FNV-1a hash of "size" bytes. Pass the result of a previous call as "hash" to hash several buffers
+    /// as one, or SE_HASH_SEED to start a new hash.
+#define SE_HASH_SEED 0xcbf29ce484222325ull
+u64 se_hash_bytes(const void *data, u64 size, u64 hash);
+    /// Hashes the contents of the file. Returns false if the file could not be read.
+b8 se_file_hash(const char *filepath, u64 hash, u64 *result);
+    /// The time the file was last written to, in platform units. Only useful to compare against another modified time
+    /// of the same file. Returns false if the file does not exist.
+b8 se_file_modified_time(const char *filepath, u64 *result);
+
+    /// Creates the directory and any of its missing parents. Returns true if the directory exists afterwards.
+b8 se_file_make_directory(const char *path);
+
+    /// Calls "proc" for every file in "directory" and its sub directories. Returns the number of files visited.
+typedef void (*SE_File_Visit_Proc)(const char *filepath, void *user_data);
+u32 se_file_walk_directory(const char *directory, SE_File_Visit_Proc proc, void *user_data);
+
+#endif // SEFILE_H
@@ -0,0 +1,149 @@
+#include "sefrustum.h"
+
+#include <stdio.h> // printf
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SEFRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+SE_Frustum se_frustum_from_matrix(Mat4 projection_view) {
+    // Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+    // clip = v * projection_view, so column j of the matrix gives clip component j
+    const f32 *m = projection_view.data;
+    Vec4 column[4];
+    for (i32 j = 0; j < 4; ++j) {
+        column[j] = (Vec4) {m[j], m[4 + j], m[8 + j], m[12 + j]};
+    }
+
+    SE_Frustum frustum;
+    for (i32 axis = 0; axis < 3; ++axis) { // -w <= x, y, z <= w
+        Vec4 c = column[axis];
+        Vec4 w = column[3];
+        frustum.planes[axis * 2 + 0] = (Vec4) {w.x + c.x, w.y + c.y, w.z + c.z, w.w + c.w};
+        frustum.planes[axis * 2 + 1] = (Vec4) {w.x - c.x, w.y - c.y, w.z - c.z, w.w - c.w};
+    }
+
+    for (i32 i = 0; i < SE_FRUSTUM_PLANE_COUNT; ++i) {
+        Vec4 *p = &frustum.planes[i];
+        f32 length = vec3_magnitude(v3f(p->x, p->y, p->z));
+        if (length > 0) {
+            p->x /= length;
+            p->y /= length;
+            p->z /= length;
+            p->w /= length;
+        }
+    }
+    return frustum;
+}
+
+b8 se_frustum_overlaps_aabb(const SE_Frustum *frustum, AABB3D aabb) {
+    Vec3 centre = vec3_mul_scalar(vec3_add(aabb.min, aabb.max), 0.5f);
+    Vec3 extent = vec3_mul_scalar(vec3_sub(aabb.max, aabb.min), 0.5f);
+    for (i32 i = 0; i < SE_FRUSTUM_PLANE_COUNT; ++i) {
+        Vec4 p = frustum->planes[i];
+        f32 distance = p.x * centre.x + p.y * centre.y + p.z * centre.z + p.w;
+        f32 radius = se_math_abs(p.x) * extent.x + se_math_abs(p.y) * extent.y + se_math_abs(p.z) * extent.z;
+        if (distance + radius < 0) return false; // completely behind this plane
+    }
+    return true;
+}
+
+u32 se_frustum_cull_aabbs(const SE_Frustum *frustum, const AABB3D *aabbs, u32 count, u32 *result) {
+    u32 result_count = 0;
+    u32 i = 0;
+
+#ifdef SEFRUSTUM_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4) {
+        const AABB3D *a = aabbs + i;
+            // four aabbs as centre and extent, one lane each
+        __m128 min_x = _mm_setr_ps(a[0].min.x, a[1].min.x, a[2].min.x, a[3].min.x);
+        __m128 min_y = _mm_setr_ps(a[0].min.y, a[1].min.y, a[2].min.y, a[3].min.y);
+        __m128 min_z = _mm_setr_ps(a[0].min.z, a[1].min.z, a[2].min.z, a[3].min.z);
+        __m128 max_x = _mm_setr_ps(a[0].max.x, a[1].max.x, a[2].max.x, a[3].max.x);
+        __m128 max_y = _mm_setr_ps(a[0].max.y, a[1].max.y, a[2].max.y, a[3].max.y);
+        __m128 max_z = _mm_setr_ps(a[0].max.z, a[1].max.z, a[2].max.z, a[3].max.z);
+        __m128 centre_x = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+        __m128 centre_y = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+        __m128 centre_z = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+        __m128 extent_x = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+        __m128 extent_y = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+        __m128 extent_z = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+        __m128 outside = zero;
+        for (i32 p = 0; p < SE_FRUSTUM_PLANE_COUNT; ++p) {
+            Vec4 plane = frustum->planes[p];
+            __m128 nx = _mm_set1_ps(plane.x);
+            __m128 ny = _mm_set1_ps(plane.y);
+            __m128 nz = _mm_set1_ps(plane.z);
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, centre_x), _mm_mul_ps(ny, centre_y)),
+                _mm_add_ps(_mm_mul_ps(nz, centre_z), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, nx), extent_x), _mm_mul_ps(_mm_andnot_ps(sign_mask, ny), extent_y)),
+                _mm_mul_ps(_mm_andnot_ps(sign_mask, nz), extent_z));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        i32 outside_mask = _mm_movemask_ps(outside);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            if ((outside_mask & (1 << lane)) == 0) result[result_count++] = i + lane;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (se_frustum_overlaps_aabb(frustum, aabbs[i])) result[result_count++] = i;
+    }
+    return result_count;
+}
+
+f64 se_frustum_cull_benchmark(u32 aabbs_count, u32 iterations) {
+    AABB3D *aabbs = malloc(sizeof(AABB3D) * aabbs_count);
+    u32 *visible = malloc(sizeof(u32) * aabbs_count);
+
+    srand(1234);
+    for (u32 i = 0; i < aabbs_count; ++i) {
+        Vec3 pos = {
+            (rand() / (f32)RAND_MAX - 0.5f) * 200.0f,
+            (rand() / (f32)RAND_MAX - 0.5f) * 20.0f,
+            (rand() / (f32)RAND_MAX - 0.5f) * 200.0f,
+        };
+        f32 size = 0.25f + rand() / (f32)RAND_MAX * 2.0f;
+        aabbs[i] = aabb3d_create(pos.x - size, pos.y - size, pos.z - size, pos.x + size, pos.y + size, pos.z + size);
+    }
+
+    Mat4 view = mat4_lookat(v3f(0, 5, 0), v3f(1, 5, 1), vec3_up());
+    Mat4 projection = mat4_perspective(SEMATH_DEG2RAD_MULTIPLIER * 60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    SE_Frustum frustum = se_frustum_from_matrix(mat4_mul(view, projection));
+
+    u32 visible_count = 0;
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        visible_count = se_frustum_cull_aabbs(&frustum, aabbs, aabbs_count, visible);
+    }
+    u64 cull_ticks = SDL_GetPerformanceCounter() - start;
+
+    u32 scalar_visible_count = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        scalar_visible_count = 0;
+        for (u32 i = 0; i < aabbs_count; ++i) {
+            if (se_frustum_overlaps_aabb(&frustum, aabbs[i])) visible[scalar_visible_count++] = i;
+        }
+    }
+    u64 scalar_ticks = SDL_GetPerformanceCounter() - start;
+
+    f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64 cull_ms = cull_ticks * 1000.0 / frequency / iterations;
+    f64 scalar_ms = scalar_ticks * 1000.0 / frequency / iterations;
+    printf("frustum culling: %u aabbs, %u visible, %.3f ms per cull (one at a time: %.3f ms, %u visible)\n",
+            aabbs_count, visible_count, cull_ms, scalar_ms, scalar_visible_count);
+
+    free(aabbs);
+    free(visible);
+    return cull_ms;
+}
@@ -0,0 +1,36 @@
+#ifndef SEFRUSTUM_H
+#define SEFRUSTUM_H
+
+#include "sedefines.h"
+#include "semath.h"
+
+///
+/// FRUSTUM CULLING
+///
+
+typedef enum SE_FRUSTUM_PLANE {
+    SE_FRUSTUM_PLANE_LEFT,
+    SE_FRUSTUM_PLANE_RIGHT,
+    SE_FRUSTUM_PLANE_BOTTOM,
+    SE_FRUSTUM_PLANE_TOP,
+    SE_FRUSTUM_PLANE_NEAR,
+    SE_FRUSTUM_PLANE_FAR,
+    SE_FRUSTUM_PLANE_COUNT
+} SE_FRUSTUM_PLANE;
+
+typedef struct SE_Frustum {
+    // a point p is inside of a plane when dot(plane.xyz, p) + plane.w >= 0. The normals are normalised.
+    Vec4 planes[SE_FRUSTUM_PLANE_COUNT];
+} SE_Frustum;
+
+    /// Extracts the planes of the frustum from a view projection matrix (eg mat4_mul(view, projection))
+SE_Frustum se_frustum_from_matrix(Mat4 projection_view);
+b8 se_frustum_overlaps_aabb(const SE_Frustum *frustum, AABB3D aabb);
+    /// Writes the indices of the aabbs that overlap the frustum to "result" (room for "count" indices) and
+    /// returns how many there are. Four aabbs are tested at a time with SSE when it's available.
+u32 se_frustum_cull_aabbs(const SE_Frustum *frustum, const AABB3D *aabbs, u32 count, u32 *result);
+    /// Culls "aabbs_count" random aabbs against a camera frustum "iterations" times and prints the timings.
+    /// Returns the average milliseconds of one cull.
+f64 se_frustum_cull_benchmark(u32 aabbs_count, u32 iterations);
+
+#endif // SEFRUSTUM_H
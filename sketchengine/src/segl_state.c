@@ -0,0 +1,214 @@
+#include "segl_state.h"
+
+#include <string.h> // memset
+
+#define GL_STATE_UNKNOWN 0xFFFFFFFF // never a valid name or enum, so the next call always goes through
+
+typedef enum GL_STATE_CAPABILITY {
+    GL_STATE_CAPABILITY_BLEND,
+    GL_STATE_CAPABILITY_CULL_FACE,
+    GL_STATE_CAPABILITY_DEPTH_TEST,
+    GL_STATE_CAPABILITY_SCISSOR_TEST,
+    GL_STATE_CAPABILITY_COUNT
+} GL_STATE_CAPABILITY;
+
+typedef enum GL_STATE_TEXTURE_TARGET {
+    GL_STATE_TEXTURE_TARGET_2D,
+    GL_STATE_TEXTURE_TARGET_2D_ARRAY,
+    GL_STATE_TEXTURE_TARGET_CUBE_MAP,
+    GL_STATE_TEXTURE_TARGET_COUNT
+} GL_STATE_TEXTURE_TARGET;
+
+typedef struct GL_State {
+    GLuint program;
+    GLuint vao;
+    GLuint draw_framebuffer;
+    GLuint read_framebuffer;
+    GLenum active_texture; // index of the unit, not GL_TEXTURE0 + index
+    GLuint textures[SE_GL_STATE_MAX_TEXTURE_UNITS][GL_STATE_TEXTURE_TARGET_COUNT];
+    u32 capabilities[GL_STATE_CAPABILITY_COUNT]; // true, false or unknown
+    GLenum blend_src;
+    GLenum blend_dst;
+    GLenum cull_face;
+    GLenum depth_func;
+    u32 depth_mask;
+    f32 line_width; // negative is unknown
+    f32 point_size; // negative is unknown
+
+    SE_GL_State_Stats stats;
+} GL_State;
+
+static GL_State gl_state;
+static b8 gl_state_initialised = false;
+
+static b8 gl_state_count(b8 changed) {
+    if (changed) {
+        gl_state.stats.calls_issued++;
+    } else {
+        gl_state.stats.calls_skipped++;
+    }
+    return changed;
+}
+
+    /// Returns true if the call should go through and updates the cached value
+static b8 gl_state_changed(u32 *cached, u32 value) {
+    if (!gl_state_initialised) se_gl_state_invalidate();
+    b8 changed = *cached != value;
+    *cached = value;
+    return gl_state_count(changed);
+}
+
+static b8 gl_state_changed_f32(f32 *cached, f32 value) {
+    if (!gl_state_initialised) se_gl_state_invalidate();
+    b8 changed = *cached != value;
+    *cached = value;
+    return gl_state_count(changed);
+}
+
+static i32 gl_state_capability_index(GLenum capability) {
+    switch (capability) {
+        case GL_BLEND:        return GL_STATE_CAPABILITY_BLEND;
+        case GL_CULL_FACE:    return GL_STATE_CAPABILITY_CULL_FACE;
+        case GL_DEPTH_TEST:   return GL_STATE_CAPABILITY_DEPTH_TEST;
+        case GL_SCISSOR_TEST: return GL_STATE_CAPABILITY_SCISSOR_TEST;
+    }
+    return -1;
+}
+
+static i32 gl_state_texture_target_index(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D:       return GL_STATE_TEXTURE_TARGET_2D;
+        case GL_TEXTURE_2D_ARRAY: return GL_STATE_TEXTURE_TARGET_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP: return GL_STATE_TEXTURE_TARGET_CUBE_MAP;
+    }
+    return -1;
+}
+
+void se_gl_state_invalidate() {
+    SE_GL_State_Stats stats = gl_state.stats;
+    memset(&gl_state, 0xFF, sizeof(GL_State)); // every field becomes GL_STATE_UNKNOWN
+    gl_state.line_width = -1.0f;
+    gl_state.point_size = -1.0f;
+    gl_state.stats = stats;
+    gl_state_initialised = true;
+}
+
+SE_GL_State_Stats se_gl_state_get_stats() {
+    return gl_state.stats;
+}
+
+void se_gl_state_reset_stats() {
+    gl_state.stats = (SE_GL_State_Stats) {0};
+}
+
+void se_gl_use_program(GLuint program) {
+    if (gl_state_changed(&gl_state.program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void se_gl_bind_vertex_array(GLuint vao) {
+    if (gl_state_changed(&gl_state.vao, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void se_gl_bind_framebuffer(GLenum target, GLuint framebuffer) {
+    if (!gl_state_initialised) se_gl_state_invalidate();
+    b8 changed = false;
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) {
+        changed |= gl_state.draw_framebuffer != framebuffer;
+        gl_state.draw_framebuffer = framebuffer;
+    }
+    if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) {
+        changed |= gl_state.read_framebuffer != framebuffer;
+        gl_state.read_framebuffer = framebuffer;
+    }
+    if (gl_state_count(changed)) {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void se_gl_active_texture(GLenum unit) {
+    se_assert(unit - GL_TEXTURE0 < SE_GL_STATE_MAX_TEXTURE_UNITS);
+    if (gl_state_changed(&gl_state.active_texture, unit - GL_TEXTURE0)) {
+        glActiveTexture(unit);
+    }
+}
+
+void se_gl_bind_texture(GLenum target, GLuint texture) {
+    i32 target_index = gl_state_texture_target_index(target);
+    if (!gl_state_initialised) se_gl_state_invalidate();
+    if (target_index < 0 || gl_state.active_texture == GL_STATE_UNKNOWN) {
+        gl_state_count(true);
+        glBindTexture(target, texture);
+        return;
+    }
+    if (gl_state_changed(&gl_state.textures[gl_state.active_texture][target_index], texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void se_gl_enable(GLenum capability) {
+    i32 index = gl_state_capability_index(capability);
+    if (index < 0) {
+        gl_state_count(true);
+        glEnable(capability);
+        return;
+    }
+    if (gl_state_changed(&gl_state.capabilities[index], true)) {
+        glEnable(capability);
+    }
+}
+
+void se_gl_disable(GLenum capability) {
+    i32 index = gl_state_capability_index(capability);
+    if (index < 0) {
+        gl_state_count(true);
+        glDisable(capability);
+        return;
+    }
+    if (gl_state_changed(&gl_state.capabilities[index], false)) {
+        glDisable(capability);
+    }
+}
+
+void se_gl_blend_func(GLenum src, GLenum dst) {
+    if (!gl_state_initialised) se_gl_state_invalidate();
+    b8 changed = gl_state.blend_src != src || gl_state.blend_dst != dst;
+    gl_state.blend_src = src;
+    gl_state.blend_dst = dst;
+    if (gl_state_count(changed)) {
+        glBlendFunc(src, dst);
+    }
+}
+
+void se_gl_cull_face(GLenum mode) {
+    if (gl_state_changed(&gl_state.cull_face, mode)) {
+        glCullFace(mode);
+    }
+}
+
+void se_gl_depth_func(GLenum func) {
+    if (gl_state_changed(&gl_state.depth_func, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void se_gl_depth_mask(GLboolean flag) {
+    if (gl_state_changed(&gl_state.depth_mask, flag ? true : false)) {
+        glDepthMask(flag);
+    }
+}
+
+void se_gl_line_width(f32 width) {
+    if (gl_state_changed_f32(&gl_state.line_width, width)) {
+        glLineWidth(width);
+    }
+}
+
+void se_gl_point_size(f32 size) {
+    if (gl_state_changed_f32(&gl_state.point_size, size)) {
+        glPointSize(size);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SEGL_STATE_H
+#define SEGL_STATE_H
+
+#include "sedefines.h"
+#include "GL/glew.h"
+
+///
+/// GL STATE CACHE
+/// Shadows the OpenGL state the engine changes often and skips the calls that would not change anything.
+/// There is one cache because there is one context, and like the context it belongs to the main thread.
+/// Every engine module goes through these instead of calling the gl procedures directly. Code outside of the engine
+/// that changes the state (ImGui, etc) must call se_gl_state_invalidate afterwards.
+///
+
+#define SE_GL_STATE_MAX_TEXTURE_UNITS 32
+
+typedef struct SE_GL_State_Stats {
+    u32 calls_issued;
+    u32 calls_skipped;
+} SE_GL_State_Stats;
+
+    /// Forgets everything, the next call of each kind is always issued.
+    /// Also needed after deleting a bound object, since GL unbinds it behind our back and the name gets reused.
+void se_gl_state_invalidate();
+SE_GL_State_Stats se_gl_state_get_stats();
+void se_gl_state_reset_stats();
+
+void se_gl_use_program(GLuint program);
+void se_gl_bind_vertex_array(GLuint vao);
+void se_gl_bind_framebuffer(GLenum target, GLuint framebuffer);
+    /// "unit" is GL_TEXTURE0 + index, the same as glActiveTexture
+void se_gl_active_texture(GLenum unit);
+    /// Binds to the active texture unit. Only GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY and GL_TEXTURE_CUBE_MAP are cached.
+void se_gl_bind_texture(GLenum target, GLuint texture);
+    /// Only GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST and GL_SCISSOR_TEST are cached
+void se_gl_enable(GLenum capability);
+void se_gl_disable(GLenum capability);
+void se_gl_blend_func(GLenum src, GLenum dst);
+void se_gl_cull_face(GLenum mode);
+void se_gl_depth_func(GLenum func);
+void se_gl_depth_mask(GLboolean flag);
+void se_gl_line_width(f32 width);
+void se_gl_point_size(f32 size);
+
+#endif // SEGL_STATE_H
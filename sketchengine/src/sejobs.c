@@ -0,0 +1,116 @@
+#include "sejobs.h"
+
+#include <stdio.h>  // printf of ERROR_ON_NULL_SDL
+#include <string.h> // memset
+
+    /// Pops a job off the queue. Assumes the mutex is locked. Returns false if there are no jobs.
+static b8 job_queue_pop(SE_Job_Queue *queue, SE_Job *job) {
+    if (queue->jobs_count == 0) return false;
+    *job = queue->jobs[queue->jobs_head];
+    queue->jobs_head = (queue->jobs_head + 1) % SE_JOB_QUEUE_CAPACITY;
+    queue->jobs_count--;
+    return true;
+}
+
+    /// Marks a job as finished. Assumes the mutex is locked.
+static void job_queue_finish(SE_Job_Queue *queue) {
+    se_assert(queue->pending_count > 0);
+    queue->pending_count--;
+    if (queue->pending_count == 0) {
+        SDL_CondBroadcast(queue->jobs_done);
+    }
+}
+
+static int job_queue_worker(void *data) {
+    SE_Job_Queue *queue = data;
+
+    SDL_LockMutex(queue->mutex);
+    for (;;) {
+        SE_Job job;
+        while (!queue->shutting_down && !job_queue_pop(queue, &job)) {
+            SDL_CondWait(queue->job_added, queue->mutex);
+        }
+        if (queue->shutting_down) break;
+
+        SDL_UnlockMutex(queue->mutex);
+            job.proc(job.data);
+        SDL_LockMutex(queue->mutex);
+        job_queue_finish(queue);
+    }
+    SDL_UnlockMutex(queue->mutex);
+    return 0;
+}
+
+void se_job_queue_init(SE_Job_Queue *queue, u32 worker_count) {
+    memset(queue, 0, sizeof(SE_Job_Queue));
+
+    if (worker_count == 0) {
+        i32 cpu_count = SDL_GetCPUCount();
+        worker_count = cpu_count > 1 ? cpu_count - 1 : 1; // leave a core for the main thread
+    }
+    if (worker_count > SE_JOB_QUEUE_MAX_WORKERS) worker_count = SE_JOB_QUEUE_MAX_WORKERS;
+
+    queue->mutex     = SDL_CreateMutex();
+    queue->job_added = SDL_CreateCond();
+    queue->jobs_done = SDL_CreateCond();
+    ERROR_ON_NULL_SDL(queue->mutex, "se_job_queue_init could not create a mutex");
+
+    for (u32 i = 0; i < worker_count; ++i) {
+        queue->workers[i] = SDL_CreateThread(job_queue_worker, "se_job_worker", queue);
+        if (queue->workers[i] == NULL) {
+            print_sdl_error();
+            break;
+        }
+        queue->worker_count++;
+    }
+}
+
+void se_job_queue_deinit(SE_Job_Queue *queue) {
+    se_job_queue_wait(queue);
+
+    SDL_LockMutex(queue->mutex);
+        queue->shutting_down = true;
+        SDL_CondBroadcast(queue->job_added);
+    SDL_UnlockMutex(queue->mutex);
+
+    for (u32 i = 0; i < queue->worker_count; ++i) {
+        SDL_WaitThread(queue->workers[i], NULL);
+    }
+
+    SDL_DestroyCond(queue->jobs_done);
+    SDL_DestroyCond(queue->job_added);
+    SDL_DestroyMutex(queue->mutex);
+    memset(queue, 0, sizeof(SE_Job_Queue));
+}
+
+void se_job_queue_add(SE_Job_Queue *queue, SE_Job_Proc proc, void *data) {
+    SDL_LockMutex(queue->mutex);
+    if (queue->jobs_count >= SE_JOB_QUEUE_CAPACITY || queue->worker_count == 0) {
+        SDL_UnlockMutex(queue->mutex);
+        proc(data); // no room, do it ourselves
+        return;
+    }
+
+    u32 tail = (queue->jobs_head + queue->jobs_count) % SE_JOB_QUEUE_CAPACITY;
+    queue->jobs[tail] = (SE_Job) {proc, data};
+    queue->jobs_count++;
+    queue->pending_count++;
+    SDL_CondSignal(queue->job_added);
+    SDL_UnlockMutex(queue->mutex);
+}
+
+void se_job_queue_wait(SE_Job_Queue *queue) {
+    SDL_LockMutex(queue->mutex);
+    while (queue->pending_count > 0) {
+        SE_Job job;
+        if (job_queue_pop(queue, &job)) {
+            SDL_UnlockMutex(queue->mutex);
+                job.proc(job.data);
+            SDL_LockMutex(queue->mutex);
+            job_queue_finish(queue);
+        } else {
+            SDL_CondWait(queue->jobs_done, queue->mutex);
+        }
+    }
+    SDL_UnlockMutex(queue->mutex);
+}
@@ -0,0 +1,45 @@
+#ifndef SEJOBS_H
+#define SEJOBS_H
+
+#include "sedefines.h"
+
+/// A fixed size pool of worker threads (SDL threads) that run jobs from a shared queue.
+/// Jobs must not touch OpenGL, the context belongs to the main thread.
+
+typedef void (*SE_Job_Proc)(void *data);
+
+typedef struct SE_Job {
+    SE_Job_Proc proc;
+    void *data;
+} SE_Job;
+
+#define SE_JOB_QUEUE_MAX_WORKERS 32
+#define SE_JOB_QUEUE_CAPACITY 1024
+
+typedef struct SE_Job_Queue {
+    u32 worker_count;
+    SDL_Thread *workers[SE_JOB_QUEUE_MAX_WORKERS];
+
+    SDL_mutex *mutex;
+    SDL_cond *job_added;    // signalled when there is a new job (or when shutting down)
+    SDL_cond *jobs_done;    // signalled when the last pending job finishes
+
+    /* ring buffer of jobs waiting to be picked up */
+    SE_Job jobs[SE_JOB_QUEUE_CAPACITY];
+    u32 jobs_head;
+    u32 jobs_count;
+
+    u32 pending_count;      // queued + running jobs
+    b8 shutting_down;
+} SE_Job_Queue;
+
+    /// Starts "worker_count" threads. If worker_count is 0, one less than the number of CPU cores is used (at least one).
+void se_job_queue_init(SE_Job_Queue *queue, u32 worker_count);
+    /// Waits for the remaining jobs and joins the worker threads
+void se_job_queue_deinit(SE_Job_Queue *queue);
+    /// Adds a job to the queue. If the queue is full, the job is run on the calling thread instead.
+void se_job_queue_add(SE_Job_Queue *queue, SE_Job_Proc proc, void *data);
+    /// Blocks until every job added so far has finished. The calling thread helps out with the jobs while it waits.
+void se_job_queue_wait(SE_Job_Queue *queue);
+
+#endif // SEJOBS_H
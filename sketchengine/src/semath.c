@@ -358,7 +358,7 @@ f32 se_math_round(f32 x) {
  f32 vec3_distance(Vec3 v1, Vec3 v2) {
     Vec3 d = (Vec3) {
         v1.x - v2.x,
-        v1.x - v2.y,
+        v1.y - v2.y,
         v1.z - v2.z};
     return vec3_magnitude(d);
 }
@@ -1197,6 +1197,34 @@ AABB3D aabb3d_calculate_from_array(AABB3D *array, u32 array_count) {
     return result;
 }
 
+AABB3D aabb3d_transform(AABB3D aabb, Mat4 transform) {
+    // Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990
+    const f32 *m = transform.data;
+    f32 min[3] = {m[12], m[13], m[14]};
+    f32 max[3] = {m[12], m[13], m[14]};
+    f32 local_min[3] = {aabb.min.x, aabb.min.y, aabb.min.z};
+    f32 local_max[3] = {aabb.max.x, aabb.max.y, aabb.max.z};
+    for (i32 j = 0; j < 3; ++j) {     // world axis
+        for (i32 i = 0; i < 3; ++i) { // local axis
+            f32 a = m[i * 4 + j] * local_min[i];
+            f32 b = m[i * 4 + j] * local_max[i];
+            min[j] += a < b ? a : b;
+            max[j] += a < b ? b : a;
+        }
+    }
+    return aabb3d_create(min[0], min[1], min[2], max[0], max[1], max[2]);
+}
+
+b8 aabb3d_overlaps_sphere(AABB3D aabb, Vec3 sphere_origin, f32 sphere_radius) {
+    Vec3 closest = {
+        se_math_max(aabb.min.x, se_math_min(sphere_origin.x, aabb.max.x)),
+        se_math_max(aabb.min.y, se_math_min(sphere_origin.y, aabb.max.y)),
+        se_math_max(aabb.min.z, se_math_min(sphere_origin.z, aabb.max.z)),
+    };
+    Vec3 diff = vec3_sub(closest, sphere_origin);
+    return vec3_dot(diff, diff) <= sphere_radius * sphere_radius;
+}
+
 /// ----
 /// RECT
 /// ----
@@ -482,6 +482,11 @@ AABB3D aabb3d_one();
 
 AABB3D aabb3d_calculate_from_array(AABB3D *array, u32 array_count);
 
+/// The aabb that contains the given aabb after it's transformed (rotation included)
+AABB3D aabb3d_transform(AABB3D aabb, Mat4 transform);
+
+b8 aabb3d_overlaps_sphere(AABB3D aabb, Vec3 sphere_origin, f32 sphere_radius);
+
 /// ----
 /// RECT
 /// ----
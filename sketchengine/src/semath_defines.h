@@ -11,6 +11,9 @@
 #ifndef se_math_min
     #define se_math_min(a,b) (((a) < (b)) ? (a) : (b))
 #endif
+#ifndef se_math_clamp
+    #define se_math_clamp(x,min,max) se_math_min(se_math_max(x, min), max)
+#endif
 
 // * note: we use right handed coordinate system
 
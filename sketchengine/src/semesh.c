@@ -25,6 +25,7 @@ void sedefault_mesh(SE_Mesh *mesh) {
     mesh->next_mesh_index = -1;
     mesh->type = SE_MESH_TYPE_NORMAL;
     mesh->skeleton = NULL;
+    mesh->animator = NULL;
     mesh->should_cast_shadow = true;
 }
 
@@ -35,7 +36,7 @@ void se_mesh_generate_skinned // same as se_mesh_generate but for skinned vertic
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->ibo);
 
-    glBindVertexArray(mesh->vao);
+    se_gl_bind_vertex_array(mesh->vao);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
 
@@ -71,28 +72,14 @@ void se_mesh_generate_skinned // same as se_mesh_generate but for skinned vertic
     mesh->indexed = true;
     // mesh->aabb = (AABB3D) {0}; //se_mesh_calc_aabb(vertices, vert_count);
     mesh->aabb = se_mesh_calc_aabb_skinned(vertices, vert_count);
+    mesh->vertex_format = SE_VERTEX_FORMAT_FULL;
 
     // unselect
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-    /// Returns the final transformation of a given SE_Bone_Node based on its parents
-static Mat4 recursive_calc_bone_transform(const SE_Skeleton *skeleton, const SE_Bone_Node *node) {
-    se_assert(node->bones_info_index >= 0 && node->bones_info_index < skeleton->bone_count);
-    if (node->parent >= 0) { // if we have a parent go up the tree
-        Mat4 parent_transform = recursive_calc_bone_transform(skeleton, &skeleton->bone_nodes[node->parent]);
-        return mat4_mul(parent_transform, node->local_transform);
-    }
-    return node->local_transform;
-}
-
-static Mat4 seskeleton_get_bone_final_transform(const SE_Skeleton *skeleton, i32 bone_node_index) {
-    se_assert(bone_node_index >= 0 && bone_node_index < skeleton->bone_node_count);
-    return recursive_calc_bone_transform(skeleton, &skeleton->bone_nodes[bone_node_index]);
-}
-
 static void recursive_generate_skeleton_verts
 (const SE_Skeleton *skeleton, SE_Skinned_Vertex *verts, u32 *vert_count, u32 *indices, u32 *index_count, const SE_Bone_Node *node, Mat4 parent_transform) {
     Mat4 final_transform = node->local_transform;
@@ -634,6 +621,14 @@ void ai_scene_to_mesh_save_data
             }
         }
     }
+
+        // once every mesh has added its bones to the skeleton
+    if (skeleton != NULL) {
+        se_skeleton_bind_animations(skeleton);
+        for (u32 i = 0; i < skeleton->animations_count; ++i) {
+            se_skeletal_animation_compress(skeleton, skeleton->animations[i]);
+        }
+    }
 }
 
 void skeleton_deep_copy
@@ -664,59 +659,34 @@ void skeleton_deep_copy
 
         //- Animations
     dest->animations_count = src->animations_count;
-    dest->current_animation = src->current_animation;
     for (u32 i = 0; i < dest->animations_count; ++i) {
         dest->animations[i] = malloc(sizeof(SE_Skeletal_Animation));
         memset(dest->animations[i], 0, sizeof(SE_Skeletal_Animation));
 
         se_string_init(&dest->animations[i]->name, src->animations[i]->name.buffer);
 
-        dest->animations[i]->animated_bones_count = src->animations[i]->animated_bones_count;
-        dest->animations[i]->animated_bones = malloc(sizeof(SE_Bone_Animations) *
-                                                dest->animations[i]->animated_bones_count);
-        memset( dest->animations[i]->animated_bones, 0,
-                sizeof(SE_Bone_Animations) *
-                dest->animations[i]->animated_bones_count);
-
-        for (u32 j = 0; j < dest->animations[i]->animated_bones_count; ++j) {
-            SE_Bone_Animations *src_animated_bone = &src->animations[i]->animated_bones[j];
-            SE_Bone_Animations *dest_animated_bone = &dest->animations[i]->animated_bones[j];
-
-            se_string_init(&dest_animated_bone->name, src_animated_bone->name.buffer);
-
-            dest_animated_bone->position_count = src_animated_bone->position_count;
-            dest_animated_bone->rotation_count = src_animated_bone->rotation_count;
-            dest_animated_bone->scale_count    = src_animated_bone->scale_count;
-
-            dest_animated_bone->positions = malloc(sizeof(Vec3) * dest_animated_bone->position_count);
-            dest_animated_bone->rotations = malloc(sizeof(Quat) * dest_animated_bone->rotation_count);
-            dest_animated_bone->scales    = malloc(sizeof(Vec3) * dest_animated_bone->scale_count);
-
-            dest_animated_bone->position_time_stamps = malloc(sizeof(f32) * dest_animated_bone->position_count);
-            dest_animated_bone->rotation_time_stamps = malloc(sizeof(f32) * dest_animated_bone->rotation_count);
-            dest_animated_bone->scale_time_stamps    = malloc(sizeof(f32) * dest_animated_bone->scale_count);
-
-            memcpy( dest_animated_bone->positions, src_animated_bone->positions, sizeof(Vec3) *
-                    dest_animated_bone->position_count);
-            memcpy( dest_animated_bone->rotations, src_animated_bone->rotations, sizeof(Quat) *
-                    dest_animated_bone->rotation_count);
-            memcpy( dest_animated_bone->scales, src_animated_bone->scales, sizeof(Vec3) *
-                    dest_animated_bone->scale_count);
-
-            memcpy( dest_animated_bone->position_time_stamps, src_animated_bone->position_time_stamps,
-                    sizeof(f32) * dest_animated_bone->position_count);
-            memcpy( dest_animated_bone->rotation_time_stamps, src_animated_bone->rotation_time_stamps,
-                    sizeof(f32) * dest_animated_bone->rotation_count);
-            memcpy( dest_animated_bone->scale_time_stamps, src_animated_bone->scale_time_stamps,
-                    sizeof(f32) * dest_animated_bone->scale_count);
+        const SE_Skeletal_Animation *src_animation = src->animations[i];
+        SE_Skeletal_Animation *dest_animation = dest->animations[i];
+        se_assert(src_animation->animated_bones_count == 0 && "only compressed animations are copied");
+
+        dest_animation->frames_count    = src_animation->frames_count;
+        dest_animation->frames_per_tick = src_animation->frames_per_tick;
+        dest_animation->max_error       = src_animation->max_error;
+        dest_animation->channels_count  = src_animation->channels_count;
+        dest_animation->channels = malloc(sizeof(SE_Animation_Channel) * src_animation->channels_count);
+        memcpy(dest_animation->channels, src_animation->channels, sizeof(SE_Animation_Channel) * src_animation->channels_count);
+        dest_animation->keys_count = src_animation->keys_count;
+        dest_animation->keys = malloc(sizeof(SE_Animation_Key) * src_animation->keys_count);
+        memcpy(dest_animation->keys, src_animation->keys, sizeof(SE_Animation_Key) * src_animation->keys_count);
 
-        }
         dest->animations[i]->duration = src->animations[i]->duration;
         dest->animations[i]->ticks_per_second = src->animations[i]->ticks_per_second;
-    }
 
-        //- Final Pose
-    memcpy(dest->final_pose, src->final_pose, sizeof(Mat4) * SE_SKELETON_BONES_CAPACITY);
+        dest->animations[i]->node_channels_count = src->animations[i]->node_channels_count;
+        dest->animations[i]->node_channels = malloc(sizeof(i32) * src->animations[i]->node_channels_count);
+        memcpy( dest->animations[i]->node_channels, src->animations[i]->node_channels,
+                sizeof(i32) * src->animations[i]->node_channels_count);
+    }
 }
 
 /// Assumes that the "file" is opened. This procedure does not handle closing the file.
@@ -748,244 +718,797 @@ static void write_skeleton_to_disk_binary
     for (u32 i = 0; i < skeleton->animations_count; ++i) {
         se_string_write_to_disk_binary(&skeleton->animations[i]->name, file);
 
-        fwrite(&skeleton->animations[i]->animated_bones_count, sizeof(u32), 1, file);
-        for (u32 j = 0; j < skeleton->animations[i]->animated_bones_count; ++j) {
-            SE_Bone_Animations *animated_bone = &skeleton->animations[i]->animated_bones[j];
+        fwrite(&skeleton->animations[i]->duration, sizeof(f32), 1, file);
+        fwrite(&skeleton->animations[i]->ticks_per_second, sizeof(f32), 1, file);
 
-            se_string_write_to_disk_binary(&animated_bone->name, file);
+        fwrite(&skeleton->animations[i]->frames_count, sizeof(u32), 1, file);
+        fwrite(&skeleton->animations[i]->frames_per_tick, sizeof(f32), 1, file);
+        fwrite(&skeleton->animations[i]->max_error, sizeof(f32), 1, file);
+        fwrite(&skeleton->animations[i]->channels_count, sizeof(u32), 1, file);
+        fwrite(skeleton->animations[i]->channels, sizeof(SE_Animation_Channel), skeleton->animations[i]->channels_count, file);
+        fwrite(&skeleton->animations[i]->keys_count, sizeof(u32), 1, file);
+        fwrite(skeleton->animations[i]->keys, sizeof(SE_Animation_Key), skeleton->animations[i]->keys_count, file);
 
-            fwrite(&animated_bone->position_count, sizeof(u32), 1, file);
-            fwrite(&animated_bone->rotation_count, sizeof(u32), 1, file);
-            fwrite(&animated_bone->scale_count, sizeof(u32), 1, file);
+        fwrite(&skeleton->animations[i]->node_channels_count, sizeof(u32), 1, file);
+        fwrite(skeleton->animations[i]->node_channels, sizeof(i32), skeleton->animations[i]->node_channels_count, file);
+    }
+}
 
-            fwrite(animated_bone->positions, sizeof(Vec3), animated_bone->position_count, file);
-            fwrite(animated_bone->rotations, sizeof(Quat), animated_bone->rotation_count, file);
-            fwrite(animated_bone->scales, sizeof(Vec3), animated_bone->scale_count, file);
+    /// A read cursor into a mapped .mesh file
+typedef struct SE_Mesh_File_Cursor {
+    const ubyte *data;
+    u64 size;
+    u64 at;
+    b8 overflowed; // set if we tried to read past the end of the data
+} SE_Mesh_File_Cursor;
+
+    /// Returns a pointer to the next "size" bytes and advances the cursor. Returns NULL on overflow.
+static const void* mesh_file_cursor_take(SE_Mesh_File_Cursor *cursor, u64 size) {
+    if (cursor->overflowed || size > cursor->size - cursor->at) {
+        cursor->overflowed = true;
+        return NULL;
+    }
+    const void *result = cursor->data + cursor->at;
+    cursor->at += size;
+    return result;
+}
 
-            fwrite(animated_bone->position_time_stamps, sizeof(f32), animated_bone->position_count, file);
-            fwrite(animated_bone->rotation_time_stamps, sizeof(f32), animated_bone->rotation_count, file);
-            fwrite(animated_bone->scale_time_stamps, sizeof(f32), animated_bone->scale_count, file);
-        }
+static void mesh_file_cursor_read(SE_Mesh_File_Cursor *cursor, void *dest, u64 size) {
+    const void *src = mesh_file_cursor_take(cursor, size);
+    if (src != NULL) {
+        memcpy(dest, src, size);
+    } else {
+        memset(dest, 0, size);
+    }
+}
 
-        fwrite(&skeleton->animations[i]->duration, sizeof(f32), 1, file);
-        fwrite(&skeleton->animations[i]->ticks_per_second, sizeof(f32), 1, file);
+    /// Reads a string that was written by se_string_write_to_disk_binary
+static void mesh_file_cursor_read_string(SE_Mesh_File_Cursor *cursor, SE_String *string) {
+    u32 size = 0;
+    mesh_file_cursor_read(cursor, &size, sizeof(u32));
+    const char *buffer = mesh_file_cursor_take(cursor, (u64)size + 1);
+    if (buffer != NULL && buffer[size] == '\0') {
+        se_string_init(string, buffer);
+    } else {
+        cursor->overflowed = true;
+        se_string_init(string, "");
     }
-        //- Final Pose
-    fwrite(skeleton->final_pose, sizeof(Mat4), SE_SKELETON_BONES_CAPACITY, file);
 }
 
-/// Assumes that the "file" is opened. This procedure does not handle closing the file.
-/// Reads the given skeleton from the disk in binary mode
-static void read_skeleton_from_disk_binary
-(SE_Skeleton *skeleton, FILE *file) {
+/// Reads the given skeleton from a mapped .mesh file (the SE_MESH_FILE_SECTION_SKELETON blob).
+/// The layout matches write_skeleton_to_disk_binary. Returns false if the blob was too small.
+static b8 read_skeleton_from_memory
+(SE_Skeleton *skeleton, SE_Mesh_File_Cursor *cursor) {
         //- Bone Info
-    fread(&skeleton->bone_count, sizeof(u32), 1, file);
+    mesh_file_cursor_read(cursor, &skeleton->bone_count, sizeof(u32));
+    if (skeleton->bone_count > SE_SKELETON_BONES_CAPACITY) return false;
     for (u32 i = 0; i < skeleton->bone_count; ++i) {
-        fread(&skeleton->bones_info[i].id, sizeof(i32), 1, file);
-        fread(&skeleton->bones_info[i].offset, sizeof(Mat4), 1, file);
-        se_string_read_from_disk_binary(&skeleton->bones_info[i].name, file);
+        mesh_file_cursor_read(cursor, &skeleton->bones_info[i].id, sizeof(i32));
+        mesh_file_cursor_read(cursor, &skeleton->bones_info[i].offset, sizeof(Mat4));
+        mesh_file_cursor_read_string(cursor, &skeleton->bones_info[i].name);
     }
 
         //- Bone Nodes
-    fread(&skeleton->bone_node_count, sizeof(u32), 1, file);
+    mesh_file_cursor_read(cursor, &skeleton->bone_node_count, sizeof(u32));
+    if (skeleton->bone_node_count > SE_SKELETON_BONES_CAPACITY) return false;
     for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
-        se_string_read_from_disk_binary(&skeleton->bone_nodes[i].name, file);
-        fread(&skeleton->bone_nodes[i].bones_info_index, sizeof(i32), 1, file);
-        fread(&skeleton->bone_nodes[i].children_count, sizeof(u32), 1, file);
-        fread(skeleton->bone_nodes[i].children, sizeof(i32), skeleton->bone_nodes[i].children_count, file);
-        fread(&skeleton->bone_nodes[i].parent, sizeof(i32), 1, file);
-        fread(&skeleton->bone_nodes[i].local_transform, sizeof(Mat4), 1, file);
-        fread(&skeleton->bone_nodes[i].inverse_neutral_transform, sizeof(Mat4), 1, file);
+        mesh_file_cursor_read_string(cursor, &skeleton->bone_nodes[i].name);
+        mesh_file_cursor_read(cursor, &skeleton->bone_nodes[i].bones_info_index, sizeof(i32));
+        mesh_file_cursor_read(cursor, &skeleton->bone_nodes[i].children_count, sizeof(u32));
+        if (skeleton->bone_nodes[i].children_count > MAX_BONE_CHILDREN) return false;
+        mesh_file_cursor_read(cursor, skeleton->bone_nodes[i].children, sizeof(i32) * skeleton->bone_nodes[i].children_count);
+        mesh_file_cursor_read(cursor, &skeleton->bone_nodes[i].parent, sizeof(i32));
+        mesh_file_cursor_read(cursor, &skeleton->bone_nodes[i].local_transform, sizeof(Mat4));
+        mesh_file_cursor_read(cursor, &skeleton->bone_nodes[i].inverse_neutral_transform, sizeof(Mat4));
+            // posing walks the nodes in order, so parents must come first
+        if (skeleton->bone_nodes[i].parent >= (i32)i) return false;
+        if (skeleton->bone_nodes[i].bones_info_index < 0 || skeleton->bone_nodes[i].bones_info_index >= (i32)skeleton->bone_count) return false;
     }
 
         //- Animations
-    fread(&skeleton->animations_count, sizeof(u32), 1, file);
-    for (u32 i = 0; i < skeleton->animations_count; ++i) {
+    u32 animations_count = 0;
+    mesh_file_cursor_read(cursor, &animations_count, sizeof(u32));
+    if (animations_count > SE_SKELETON_MAX_ANIMATIONS) return false;
+    for (u32 i = 0; i < animations_count; ++i) {
         skeleton->animations[i] = malloc(sizeof(SE_Skeletal_Animation));
         memset(skeleton->animations[i], 0, sizeof(SE_Skeletal_Animation));
+        skeleton->animations_count++; // so se_skeleton_deinit can clean up if we bail out half way
+
+        mesh_file_cursor_read_string(cursor, &skeleton->animations[i]->name);
+
+        mesh_file_cursor_read(cursor, &skeleton->animations[i]->duration, sizeof(f32));
+        mesh_file_cursor_read(cursor, &skeleton->animations[i]->ticks_per_second, sizeof(f32));
+
+        SE_Skeletal_Animation *animation = skeleton->animations[i];
+        mesh_file_cursor_read(cursor, &animation->frames_count, sizeof(u32));
+        mesh_file_cursor_read(cursor, &animation->frames_per_tick, sizeof(f32));
+        mesh_file_cursor_read(cursor, &animation->max_error, sizeof(f32));
+        if (animation->frames_count == 0 || animation->frames_count > SE_ANIMATION_MAX_FRAMES) return false;
+
+        u32 channels_count = 0;
+        mesh_file_cursor_read(cursor, &channels_count, sizeof(u32));
+        if (cursor->overflowed || channels_count > cursor->size / sizeof(SE_Animation_Channel)) return false;
+        animation->channels = malloc(sizeof(SE_Animation_Channel) * channels_count);
+        animation->channels_count = channels_count;
+        mesh_file_cursor_read(cursor, animation->channels, sizeof(SE_Animation_Channel) * channels_count);
+
+        u32 keys_count = 0;
+        mesh_file_cursor_read(cursor, &keys_count, sizeof(u32));
+        if (cursor->overflowed || keys_count > cursor->size / sizeof(SE_Animation_Key)) return false;
+        animation->keys = malloc(sizeof(SE_Animation_Key) * keys_count);
+        animation->keys_count = keys_count;
+        mesh_file_cursor_read(cursor, animation->keys, sizeof(SE_Animation_Key) * keys_count);
+        if (cursor->overflowed) return false;
+
+            // the keys of every track must be in the keys array and on the frame grid, in order
+        for (u32 c = 0; c < channels_count; ++c) {
+            for (u32 track = 0; track < SE_ANIMATION_TRACKS_COUNT; ++track) {
+                u32 first = animation->channels[c].first_key[track];
+                u32 count = animation->channels[c].keys_count[track];
+                if (first > keys_count || count > keys_count - first) return false;
+                for (u32 k = first; k < first + count; ++k) {
+                    if (animation->keys[k].frame >= animation->frames_count) return false;
+                    if (k > first && animation->keys[k].frame <= animation->keys[k - 1].frame) return false;
+                }
+            }
+        }
 
-        se_string_read_from_disk_binary(&skeleton->animations[i]->name, file);
-
-        fread(&skeleton->animations[i]->animated_bones_count, sizeof(u32), 1, file);
-        skeleton->animations[i]->animated_bones = malloc(
-                    sizeof(SE_Bone_Animations) *
-                    skeleton->animations[i]->animated_bones_count);
-        memset(skeleton->animations[i]->animated_bones, 0,
-                    sizeof(SE_Bone_Animations) *
-                    skeleton->animations[i]->animated_bones_count);
+        u32 node_channels_count = 0;
+        mesh_file_cursor_read(cursor, &node_channels_count, sizeof(u32));
+        if (cursor->overflowed || node_channels_count != skeleton->bone_node_count) return false;
+        skeleton->animations[i]->node_channels = malloc(sizeof(i32) * node_channels_count);
+        skeleton->animations[i]->node_channels_count = node_channels_count;
+        mesh_file_cursor_read(cursor, skeleton->animations[i]->node_channels, sizeof(i32) * node_channels_count);
+        for (u32 j = 0; j < node_channels_count; ++j) {
+            if (skeleton->animations[i]->node_channels[j] >= (i32)channels_count) return false;
+        }
+    }
+    return !cursor->overflowed;
+}
 
-        for (u32 j = 0; j < skeleton->animations[i]->animated_bones_count; ++j) {
-            SE_Bone_Animations *animated_bone = &skeleton->animations[i]->animated_bones[j];
+//// ANIMATION BONES ////
 
-            se_string_read_from_disk_binary(&animated_bone->name, file);
+    /// Gets the normalised value of 'amount' for lerp and slerp
+static f32 get_scale_factor(f32 last_time_stamp, f32 next_time_stamp, f32 animation_time) {
+    f32 mid_way_length = animation_time - last_time_stamp;
+    f32 frame_delta    = next_time_stamp - last_time_stamp;
+    return mid_way_length / frame_delta;
+}
 
-            fread(&animated_bone->position_count, sizeof(u32), 1, file);
-            fread(&animated_bone->rotation_count, sizeof(u32), 1, file);
-            fread(&animated_bone->scale_count, sizeof(u32), 1, file);
+static void bone_animations_deinit(SE_Bone_Animations *bone) {
+    // bone->bone_node_index = -1;
+    se_string_deinit(&bone->name);
+    free(bone->positions);
+    free(bone->rotations);
+    free(bone->scales);
+    free(bone->position_time_stamps);
+    free(bone->rotation_time_stamps);
+    free(bone->scale_time_stamps);
+}
 
-            animated_bone->positions = malloc(sizeof(Vec3) * animated_bone->position_count);
-            animated_bone->rotations = malloc(sizeof(Quat) * animated_bone->rotation_count);
-            animated_bone->scales    = malloc(sizeof(Vec3) * animated_bone->scale_count);
+//- Quantisation
 
-            animated_bone->position_time_stamps = malloc(sizeof(f32) * animated_bone->position_count);
-            animated_bone->rotation_time_stamps = malloc(sizeof(f32) * animated_bone->rotation_count);
-            animated_bone->scale_time_stamps = malloc(sizeof(f32) * animated_bone->scale_count);
+#define SE_ANIMATION_QUAT_RANGE 0.70710678f // the three smallest components of a unit quaternion are within +-1/sqrt(2)
 
-            fread(animated_bone->positions, sizeof(Vec3), animated_bone->position_count, file);
-            fread(animated_bone->rotations, sizeof(Quat), animated_bone->rotation_count, file);
-            fread(animated_bone->scales, sizeof(Vec3), animated_bone->scale_count, file);
+static void quantise_quat(Quat q, u16 value[3]) {
+    f32 components[4] = {q.x, q.y, q.z, q.w};
+    u32 largest = 0;
+    for (u32 i = 1; i < 4; ++i) {
+        if (se_math_abs(components[i]) > se_math_abs(components[largest])) largest = i;
+    }
+        // q and -q are the same rotation, flip it so the dropped component is positive
+    f32 sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    u16 smallest[3];
+    for (u32 i = 0, j = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        f32 normalised = se_math_clamp(components[i] * sign / SE_ANIMATION_QUAT_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+        smallest[j++] = (u16)(normalised * 32767.0f + 0.5f);
+    }
+    value[0] = (u16)(((largest & 1) << 15) | smallest[0]);
+    value[1] = (u16)(((largest >> 1) << 15) | smallest[1]);
+    value[2] = smallest[2];
+}
 
-            fread(animated_bone->position_time_stamps, sizeof(f32), animated_bone->position_count, file);
-            fread(animated_bone->rotation_time_stamps, sizeof(f32), animated_bone->rotation_count, file);
-            fread(animated_bone->scale_time_stamps, sizeof(f32), animated_bone->scale_count, file);
-        }
+static Quat dequantise_quat(const u16 value[3]) {
+    u32 largest = (value[0] >> 15) | ((value[1] >> 15) << 1);
+    f32 components[4];
+    f32 length_squared = 0.0f;
+    for (u32 i = 0, j = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        components[i] = ((value[j++] & 0x7fff) / 32767.0f * 2.0f - 1.0f) * SE_ANIMATION_QUAT_RANGE;
+        length_squared += components[i] * components[i];
+    }
+    components[largest] = se_math_sqrt(se_math_max(1.0f - length_squared, 0.0f));
+    return (Quat) {components[0], components[1], components[2], components[3]};
+}
 
-        fread(&skeleton->animations[i]->duration, sizeof(f32), 1, file);
-        fread(&skeleton->animations[i]->ticks_per_second, sizeof(f32), 1, file);
+static void quantise_vec3(Vec3 v, Vec3 min, Vec3 extent, u16 value[3]) {
+    f32 offsets[3] = {v.x - min.x, v.y - min.y, v.z - min.z};
+    f32 extents[3] = {extent.x, extent.y, extent.z};
+    for (u32 i = 0; i < 3; ++i) {
+        value[i] = extents[i] > 0.0f ? (u16)(se_math_clamp(offsets[i] / extents[i], 0.0f, 1.0f) * 65535.0f + 0.5f) : 0;
     }
-        //- Final Pose
-    fread(skeleton->final_pose, sizeof(Mat4), SE_SKELETON_BONES_CAPACITY, file);
 }
 
-//// ANIMATION BONES ////
+static Vec3 dequantise_vec3(const u16 value[3], Vec3 min, Vec3 extent) {
+    return (Vec3) {
+        min.x + extent.x * (value[0] / 65535.0f),
+        min.y + extent.y * (value[1] / 65535.0f),
+        min.z + extent.z * (value[2] / 65535.0f)
+    };
+}
 
-    /// Gets the normalised value of 'amount' for lerp and slerp
-static f32 get_scale_factor(f32 last_time_stamp, f32 next_time_stamp, f32 animation_time) {
-    f32 mid_way_length = animation_time - last_time_stamp;
-    f32 frame_delta    = next_time_stamp - last_time_stamp;
-    return mid_way_length / frame_delta;
+//- Sampling
+
+    /// Normalised lerp the short way round. Keys are close enough together that it's indistinguishable from slerp.
+static Quat animation_quat_nlerp(Quat q_0, Quat q_1, f32 amount) {
+    if (quat_dot(q_0, q_1) < 0.0f) {
+        q_1 = (Quat) {-q_1.x, -q_1.y, -q_1.z, -q_1.w};
+    }
+    return quat_normalize((Quat) {
+        q_0.x + (q_1.x - q_0.x) * amount,
+        q_0.y + (q_1.y - q_0.y) * amount,
+        q_0.z + (q_1.z - q_0.z) * amount,
+        q_0.w + (q_1.w - q_0.w) * amount
+    });
 }
 
-    /// Returns the interpolated translation of the bone at the given animation time
-static Mat4 interpolate_bone_pos(SE_Bone_Animations *bone, f32 animation_time) {
-    if (bone->position_count == 0) return mat4_identity();
-    if (bone->position_count == 1) {
-        return mat4_translation(bone->positions[0]);
+    /// scale * rotation * translation, without multiplying the matrices
+static Mat4 bone_local_transform(Vec3 position, Quat rotation, Vec3 scale) {
+    Mat4 result = quat_to_rotation_matrix(rotation, v3f(0,0,0));
+    for (u32 column = 0; column < 3; ++column) {
+        result.data[0 + column] *= scale.x;
+        result.data[4 + column] *= scale.y;
+        result.data[8 + column] *= scale.z;
     }
+    result.data[12] = position.x;
+    result.data[13] = position.y;
+    result.data[14] = position.z;
+    return result;
+}
 
-        // find index 0 and 1
-    i32 index_0;
-    for (u32 i = 0; i < bone->position_count - 1; ++i) {
-        if (animation_time < bone->position_time_stamps[i + 1]) {
-            index_0 = i;
-            break;
+    /// Returns the first key "i" with frame < keys[i + 1].frame, the key to interpolate from.
+    /// Past the last key this is count - 2. "count" must be at least 2.
+    /// The search starts at the key found last time (the cursor): playing forward only steps over a few keys and
+    /// seeks or loops fall back to a binary search. The result is written back to the cursor.
+static u32 find_key(const SE_Animation_Key *keys, u32 count, f32 frame, u32 *cursor) {
+    u32 last = count - 2;
+    u32 key = se_math_min(*cursor, last);
+    if (key == 0 || frame >= keys[key].frame) {
+            // playing forward, step over the keys passed since the last pose
+        for (u32 step = 0; step < SE_ANIMATION_CURSOR_MAX_STEPS && key < last && frame >= keys[key + 1].frame; ++step) {
+            ++key;
+        }
+        if (key == last || frame < keys[key + 1].frame) {
+            *cursor = key;
+            return key;
         }
     }
-    i32 index_1 = index_0 + 1;
 
-        // interpolate
-    f32 scale_factor = get_scale_factor(bone->position_time_stamps[index_0], bone->position_time_stamps[index_1], animation_time);
-    Vec3 interpolated_pos = vec3_lerp(bone->positions[index_0], bone->positions[index_1], scale_factor);
-    return mat4_translation(interpolated_pos);
+        // seeked or looped, binary search for the first key ending after frame
+    u32 low  = 0;
+    u32 high = last;
+    while (low < high) {
+        u32 mid = (low + high) / 2;
+        if (frame < keys[mid + 1].frame) high = mid;
+        else low = mid + 1;
+    }
+    *cursor = low;
+    return low;
 }
 
-    /// Returns the interpolated rotation of the bone at the given animation time
-static Mat4 interpolate_bone_rot(SE_Bone_Animations *bone, f32 animation_time) {
-    if (bone->rotation_count == 0) return mat4_identity();
-    if (bone->rotation_count == 1) {
-        Quat rot = quat_normalize(bone->rotations[0]);
-        return quat_to_mat4(rot);
+    /// Position or scale track at "frame", "identity" if the track has no keys
+static Vec3 sample_track_vec3
+(const SE_Animation_Key *keys, u32 count, Vec3 min, Vec3 extent, Vec3 identity, f32 frame, u32 *cursor) {
+    if (count == 0) return identity;
+    if (count == 1) return dequantise_vec3(keys[0].value, min, extent);
+
+    u32 index_0 = find_key(keys, count, frame, cursor);
+    u32 index_1 = index_0 + 1;
+    f32 scale_factor = get_scale_factor(keys[index_0].frame, keys[index_1].frame, frame);
+    return vec3_lerp(dequantise_vec3(keys[index_0].value, min, extent), dequantise_vec3(keys[index_1].value, min, extent), scale_factor);
+}
+
+static Quat sample_track_quat(const SE_Animation_Key *keys, u32 count, f32 frame, u32 *cursor) {
+    if (count == 0) return quat_identity();
+    if (count == 1) return dequantise_quat(keys[0].value);
+
+    u32 index_0 = find_key(keys, count, frame, cursor);
+    u32 index_1 = index_0 + 1;
+    f32 scale_factor = get_scale_factor(keys[index_0].frame, keys[index_1].frame, frame);
+    return animation_quat_nlerp(dequantise_quat(keys[index_0].value), dequantise_quat(keys[index_1].value), scale_factor);
+}
+
+    /// The local transform of a compressed channel at "frame" (a position on the frame grid).
+    /// "cursor" holds the key last found in each of its tracks.
+static Mat4 sample_channel(const SE_Skeletal_Animation *animation, const SE_Animation_Channel *channel, f32 frame, u32 *cursor) {
+    const SE_Animation_Key *keys = animation->keys;
+    Vec3 position = sample_track_vec3(
+        keys + channel->first_key[SE_ANIMATION_TRACK_POSITION], channel->keys_count[SE_ANIMATION_TRACK_POSITION],
+        channel->position_min, channel->position_extent, v3f(0,0,0), frame, &cursor[SE_ANIMATION_TRACK_POSITION]);
+    Quat rotation = sample_track_quat(
+        keys + channel->first_key[SE_ANIMATION_TRACK_ROTATION], channel->keys_count[SE_ANIMATION_TRACK_ROTATION],
+        frame, &cursor[SE_ANIMATION_TRACK_ROTATION]);
+    Vec3 scale = sample_track_vec3(
+        keys + channel->first_key[SE_ANIMATION_TRACK_SCALE], channel->keys_count[SE_ANIMATION_TRACK_SCALE],
+        channel->scale_min, channel->scale_extent, v3f(1,1,1), frame, &cursor[SE_ANIMATION_TRACK_SCALE]);
+    return bone_local_transform(position, rotation, scale);
+}
+
+    /// Poses every bone node of the skeleton. The nodes are stored parents first, so one pass over them
+    /// has the model space transform of a node's parent ready by the time the node is reached.
+    /// The keys of "cursor" are moved to animation_time. The result is written to "final_pose".
+static void calculate_bone_pose
+(const SE_Skeleton *skeleton, const SE_Skeletal_Animation *animation, f32 animation_time, SE_Animation_Cursor *cursor,
+ Mat4 *final_pose) {
+    se_assert(animation->node_channels_count == skeleton->bone_node_count && "the animation was not bound to the skeleton");
+    se_assert(animation->frames_count > 0 && "the animation was not compressed");
+
+    f32 frame = se_math_clamp(animation_time * animation->frames_per_tick, 0.0f, (f32)(animation->frames_count - 1));
+    Mat4 node_transforms[SE_SKELETON_BONES_CAPACITY]; // model space
+    for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
+        const SE_Bone_Node *node = &skeleton->bone_nodes[i];
+        i32 channel = animation->node_channels[i];
+
+        Mat4 local_transform = channel >= 0
+            ? sample_channel(animation, &animation->channels[channel], frame, cursor->keys[i])
+            : node->local_transform;
+        node_transforms[i] = node->parent >= 0 ? mat4_mul(local_transform, node_transforms[node->parent]) : local_transform;
+
+        const SE_Bone_Info *bone_info = &skeleton->bones_info[node->bones_info_index];
+        final_pose[bone_info->id] = mat4_mul(bone_info->offset, node_transforms[i]);
     }
+}
 
-        // find index 0 and 1
-    i32 index_0;
-    for (u32 i = 0; i < bone->rotation_count - 1; ++i) {
-        if (animation_time < bone->rotation_time_stamps[i + 1]) {
-            index_0 = i;
-            break;
+    /// Same as calculate_bone_pose with every node at its local_transform
+static void calculate_bind_pose(const SE_Skeleton *skeleton, Mat4 *final_pose) {
+    Mat4 node_transforms[SE_SKELETON_BONES_CAPACITY]; // model space
+    for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
+        const SE_Bone_Node *node = &skeleton->bone_nodes[i];
+        node_transforms[i] = node->parent >= 0
+            ? mat4_mul(node->local_transform, node_transforms[node->parent])
+            : node->local_transform;
+
+        const SE_Bone_Info *bone_info = &skeleton->bones_info[node->bones_info_index];
+        final_pose[bone_info->id] = mat4_mul(bone_info->offset, node_transforms[i]);
+    }
+}
+
+//- Compression
+
+se_array_struct(SE_Animation_Key);
+
+    /// Samples the imported tracks of "bone" at each of the ascending "times" (in ticks), interpolating the way posing used to
+static void sample_imported_bone
+(const SE_Bone_Animations *bone, const f32 *times, u32 times_count, Vec3 *positions, Quat *rotations, Vec3 *scales) {
+    u32 position_key = 0;
+    u32 rotation_key = 0;
+    u32 scale_key    = 0;
+    for (u32 frame = 0; frame < times_count; ++frame) {
+        f32 time = times[frame];
+
+        if (bone->position_count < 2) {
+            positions[frame] = bone->position_count == 0 ? v3f(0,0,0) : bone->positions[0];
+        } else {
+            const f32 *time_stamps = bone->position_time_stamps;
+            while (position_key < bone->position_count - 2 && time >= time_stamps[position_key + 1]) ++position_key;
+            f32 scale_factor = time >= time_stamps[bone->position_count - 1] ? 1.0f // hold the last key
+                : get_scale_factor(time_stamps[position_key], time_stamps[position_key + 1], time);
+            positions[frame] = vec3_lerp(bone->positions[position_key], bone->positions[position_key + 1], scale_factor);
+        }
+
+        if (bone->rotation_count < 2) {
+            rotations[frame] = bone->rotation_count == 0 ? quat_identity() : quat_normalize(bone->rotations[0]);
+        } else {
+            const f32 *time_stamps = bone->rotation_time_stamps;
+            while (rotation_key < bone->rotation_count - 2 && time >= time_stamps[rotation_key + 1]) ++rotation_key;
+            f32 scale_factor = time >= time_stamps[bone->rotation_count - 1] ? 1.0f
+                : get_scale_factor(time_stamps[rotation_key], time_stamps[rotation_key + 1], time);
+            rotations[frame] = quat_normalize(quat_slerp(bone->rotations[rotation_key], bone->rotations[rotation_key + 1], scale_factor));
+        }
+
+        if (bone->scale_count < 2) {
+            scales[frame] = bone->scale_count == 0 ? v3f(1,1,1) : bone->scales[0];
+        } else {
+            const f32 *time_stamps = bone->scale_time_stamps;
+            while (scale_key < bone->scale_count - 2 && time >= time_stamps[scale_key + 1]) ++scale_key;
+            f32 scale_factor = time >= time_stamps[bone->scale_count - 1] ? 1.0f
+                : get_scale_factor(time_stamps[scale_key], time_stamps[scale_key + 1], time);
+            scales[frame] = vec3_lerp(bone->scales[scale_key], bone->scales[scale_key + 1], scale_factor);
         }
     }
-    i32 index_1 = index_0 + 1;
+}
+
+    /// Distance between two unit quaternions the short way round. Two rotations "angle" apart are 2 * sin(angle / 4) apart.
+static f32 animation_quat_distance(Quat q_0, Quat q_1) {
+    Vec4 difference = {q_0.x - q_1.x, q_0.y - q_1.y, q_0.z - q_1.z, q_0.w - q_1.w};
+    Vec4 sum        = {q_0.x + q_1.x, q_0.y + q_1.y, q_0.z + q_1.z, q_0.w + q_1.w};
+    return se_math_sqrt(se_math_min(
+        difference.x * difference.x + difference.y * difference.y + difference.z * difference.z + difference.w * difference.w,
+        sum.x * sum.x + sum.y * sum.y + sum.z * sum.z + sum.w * sum.w));
+}
 
-        // interpolate
-    f32 scale_factor = get_scale_factor(bone->rotation_time_stamps[index_0], bone->rotation_time_stamps[index_1], animation_time);
-    Quat interpolated_rot = quat_slerp(bone->rotations[index_0], bone->rotations[index_1], scale_factor);
-    interpolated_rot = quat_normalize(interpolated_rot);
-    // return quat_to_mat4(interpolated_rot);
-    return quat_to_rotation_matrix(interpolated_rot, v3f(0,0,0));
+static Vec3 vec3_min_components(Vec3 v_0, Vec3 v_1) {
+    return v3f(se_math_min(v_0.x, v_1.x), se_math_min(v_0.y, v_1.y), se_math_min(v_0.z, v_1.z));
 }
 
-    /// Returns the interpolated scale of the bone at the given animation time
-static Mat4 interpolate_bone_scale(SE_Bone_Animations *bone, f32 animation_time) {
-    if (bone->scale_count == 0) return mat4_identity();
-    if (bone->scale_count == 1) {
-        return mat4_scale(bone->scales[0]);
+static Vec3 vec3_max_components(Vec3 v_0, Vec3 v_1) {
+    return v3f(se_math_max(v_0.x, v_1.x), se_math_max(v_0.y, v_1.y), se_math_max(v_0.z, v_1.z));
+}
+
+static f32 vec3_max_difference(Vec3 v_0, Vec3 v_1) {
+    return se_math_max(se_math_abs(v_0.x - v_1.x), se_math_max(se_math_abs(v_0.y - v_1.y), se_math_abs(v_0.z - v_1.z)));
+}
+
+    /// One track of a channel on its way to being compressed
+typedef struct SE_Animation_Track_Samples {
+    SE_ANIMATION_TRACK track;
+    u32 frames_count;
+    const Vec3 *vec3s;  // the samples of a position or scale track
+    const Quat *quats;  // the samples of a rotation track
+    Vec3 min;           // quantisation range of a position or scale track
+    Vec3 extent;
+    f32 tolerance;      // distance for positions, quaternion distance for rotations and per component for scales
+    Vec3 *decoded_vec3s; // every sample quantised and decoded again
+    Quat *decoded_quats;
+} SE_Animation_Track_Samples;
+
+static f32 track_sample_error(const SE_Animation_Track_Samples *samples, u32 frame, Vec3 vec3, Quat quat) {
+    switch (samples->track) {
+        case SE_ANIMATION_TRACK_POSITION: return vec3_distance(vec3, samples->vec3s[frame]);
+        case SE_ANIMATION_TRACK_ROTATION: return animation_quat_distance(quat, samples->quats[frame]);
+        default:                          return vec3_max_difference(vec3, samples->vec3s[frame]);
     }
+}
 
-        // find index 0 and 1
-    i32 index_0;
-    for (u32 i = 0; i < bone->scale_count - 1; ++i) {
-        if (animation_time < bone->scale_time_stamps[i + 1]) {
-            index_0 = i;
-            break;
+    /// Whether interpolating between keys at frame "start" and "end" rebuilds every frame in between within tolerance
+static b8 track_segment_fits(const SE_Animation_Track_Samples *samples, u32 start, u32 end) {
+    for (u32 frame = start + 1; frame < end; ++frame) {
+        f32 scale_factor = get_scale_factor((f32)start, (f32)end, (f32)frame);
+        Vec3 vec3 = {0};
+        Quat quat = {0};
+        if (samples->track == SE_ANIMATION_TRACK_ROTATION) {
+            quat = animation_quat_nlerp(samples->decoded_quats[start], samples->decoded_quats[end], scale_factor);
+        } else {
+            vec3 = vec3_lerp(samples->decoded_vec3s[start], samples->decoded_vec3s[end], scale_factor);
         }
+        if (track_sample_error(samples, frame, vec3, quat) > samples->tolerance) return false;
     }
-    i32 index_1 = index_0 + 1;
+    return true;
+}
 
-        // interpolate
-    f32 scale_factor = get_scale_factor(bone->scale_time_stamps[index_0], bone->scale_time_stamps[index_1], animation_time);
-    Vec3 interpolated_scale = vec3_lerp(bone->scales[index_0], bone->scales[index_1], scale_factor);
-    return mat4_scale(interpolated_scale);
+static void track_add_key(const SE_Animation_Track_Samples *samples, Array(SE_Animation_Key) *keys, u32 frame) {
+    SE_Animation_Key key = {0};
+    key.frame = (u16)frame;
+    if (samples->track == SE_ANIMATION_TRACK_ROTATION) {
+        quantise_quat(samples->quats[frame], key.value);
+    } else {
+        quantise_vec3(samples->vec3s[frame], samples->min, samples->extent, key.value);
+    }
+    array_add(SE_Animation_Key, (*keys), key);
 }
 
-static Mat4 get_interpolated_bone_transform(SE_Bone_Animations *bone, f32 animation_time) {
-    Mat4 translation = interpolate_bone_pos   (bone, animation_time);
-    Mat4 rotation    = interpolate_bone_rot   (bone, animation_time);
-    Mat4 scale       = interpolate_bone_scale (bone, animation_time);
+    /// Appends the keys of the track to "keys" and returns how many there are
+static u32 compress_track(SE_Animation_Track_Samples *samples, Array(SE_Animation_Key) *keys) {
+    u32 frames_count = samples->frames_count;
+    b8 is_rotation = samples->track == SE_ANIMATION_TRACK_ROTATION;
+
+        // tracks that stay at the identity are dropped, constant tracks keep one key
+    Vec3 identity = samples->track == SE_ANIMATION_TRACK_SCALE ? v3f(1,1,1) : v3f(0,0,0);
+    b8 is_identity = true;
+    b8 is_constant = true;
+    for (u32 frame = 0; frame < frames_count; ++frame) {
+        if (track_sample_error(samples, frame, identity, quat_identity()) > samples->tolerance) is_identity = false;
+        if (track_sample_error(samples, frame, is_rotation ? v3f(0,0,0) : samples->vec3s[0], is_rotation ? samples->quats[0] : quat_identity())
+            > samples->tolerance) is_constant = false;
+    }
+    if (is_identity) return 0;
+    if (is_constant) {
+        samples->min = is_rotation ? v3f(0,0,0) : samples->vec3s[0];
+        samples->extent = v3f(0,0,0);
+        track_add_key(samples, keys, 0);
+        return 1;
+    }
 
-    Mat4 result = scale;
-    result = mat4_mul(result, rotation);
-    result = mat4_mul(result, translation);
-    return result;
+        // quantise every sample so the errors below include the quantisation
+    if (!is_rotation) {
+        Vec3 max = samples->vec3s[0];
+        samples->min = samples->vec3s[0];
+        for (u32 frame = 1; frame < frames_count; ++frame) {
+            samples->min = vec3_min_components(samples->min, samples->vec3s[frame]);
+            max = vec3_max_components(max, samples->vec3s[frame]);
+        }
+        samples->extent = vec3_sub(max, samples->min);
+    }
+    for (u32 frame = 0; frame < frames_count; ++frame) {
+        u16 value[3];
+        if (is_rotation) {
+            quantise_quat(samples->quats[frame], value);
+            samples->decoded_quats[frame] = dequantise_quat(value);
+        } else {
+            quantise_vec3(samples->vec3s[frame], samples->min, samples->extent, value);
+            samples->decoded_vec3s[frame] = dequantise_vec3(value, samples->min, samples->extent);
+        }
+    }
+
+        // greedily make every segment as long as it can be: double its length until it stops fitting,
+        // then binary search between the last length that fitted and the first that didn't
+    u32 count = 1;
+    track_add_key(samples, keys, 0);
+    for (u32 start = 0; start < frames_count - 1;) {
+        u32 fits = start + 1;
+        u32 length = 2;
+        while (start + length < frames_count && track_segment_fits(samples, start, start + length)) {
+            fits = start + length;
+            length *= 2;
+        }
+        u32 does_not_fit = se_math_min(start + length, frames_count);
+        while (does_not_fit - fits > 1) {
+            u32 mid = (fits + does_not_fit) / 2;
+            if (track_segment_fits(samples, start, mid)) fits = mid;
+            else does_not_fit = mid;
+        }
+        track_add_key(samples, keys, fits);
+        count++;
+        start = fits;
+    }
+    return count;
 }
 
-static void bone_animations_deinit(SE_Bone_Animations *bone) {
-    // bone->bone_node_index = -1;
-    se_string_deinit(&bone->name);
-    free(bone->positions);
-    free(bone->rotations);
-    free(bone->scales);
-    free(bone->position_time_stamps);
-    free(bone->rotation_time_stamps);
-    free(bone->scale_time_stamps);
+static int compare_f32(const void *a, const void *b) {
+    f32 x = *(const f32*)a;
+    f32 y = *(const f32*)b;
+    return (x > y) - (x < y);
 }
 
-static void recursive_calculate_bone_pose // calculate the pose of the given bone based on the animation, do the same for its children
-(SE_Skeleton *skeleton, const SE_Skeletal_Animation *animation, f32 animation_time, const SE_Bone_Node *node, Mat4 parent_transform) {
-    se_assert(node->bones_info_index >= 0);
+    /// The times the error of the compressed clip is measured at: every imported key of every channel and every frame of
+    /// the grid, sorted and without duplicates. The imported and compressed tracks are both linear between their keys,
+    /// so the two are furthest apart at one of these. Returns how many there are, free "result" when done.
+static u32 animation_error_times(const SE_Skeletal_Animation *animation, const f32 *grid_times, u32 frames_count, f32 **result) {
+    u32 capacity = frames_count;
+    for (u32 c = 0; c < animation->animated_bones_count; ++c) {
+        const SE_Bone_Animations *bone = &animation->animated_bones[c];
+        capacity += bone->position_count + bone->rotation_count + bone->scale_count;
+    }
 
-    SE_Bone_Animations *animated_bone = NULL;
-    for (u32 i = 0; i < animation->animated_bones_count; ++i) {
-        if (se_string_compare(&animation->animated_bones[i].name, &node->name)) { // @performance: change this from a string compare to a hash compare
-            animated_bone = &animation->animated_bones[i];
-            break;
+    f32 *times = malloc(sizeof(f32) * capacity);
+    u32 count = 0;
+    memcpy(times, grid_times, sizeof(f32) * frames_count);
+    count += frames_count;
+    for (u32 c = 0; c < animation->animated_bones_count; ++c) {
+        const SE_Bone_Animations *bone = &animation->animated_bones[c];
+        const f32 *time_stamps[3] = {bone->position_time_stamps, bone->rotation_time_stamps, bone->scale_time_stamps};
+        u32 time_stamps_count[3]  = {bone->position_count, bone->rotation_count, bone->scale_count};
+        for (u32 track = 0; track < 3; ++track) {
+            for (u32 k = 0; k < time_stamps_count[track]; ++k) {
+                times[count++] = se_math_clamp(time_stamps[track][k], 0.0f, se_math_max(animation->duration, 0.0f));
+            }
         }
     }
 
-    Mat4 final_node_transform = node->local_transform;
-        //- the node transform with its parents taken into account
-    if (animated_bone != NULL) {
-        final_node_transform = get_interpolated_bone_transform(animated_bone, animation_time);
-        final_node_transform = mat4_mul(final_node_transform, parent_transform);
+    qsort(times, count, sizeof(f32), compare_f32);
+    u32 unique_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (unique_count == 0 || times[i] != times[unique_count - 1]) times[unique_count++] = times[i];
     }
+    *result = times;
+    return unique_count;
+}
 
-    se_assert(node->bones_info_index >= 0 && node->bones_info_index < skeleton->bone_count);
-    i32 index = skeleton->bones_info[node->bones_info_index].id;
-    Mat4 offset = skeleton->bones_info[node->bones_info_index].offset;
-        // inverse neutral pose
-    // final_node_transform = mat4_mul(node->inverse_neutral_transform, final_node_transform);
-    skeleton->final_pose[index] = mat4_mul(offset, final_node_transform);
+    /// Largest model space distance between the imported and compressed poses, over every one of the "times",
+    /// every bone and the points "vertex_distance" away from it along its axes. "positions", "rotations" and "scales" are
+    /// the imported tracks sampled at "times", "times_count" per channel.
+static f32 animation_compression_error
+(const SE_Skeleton *skeleton, const SE_Skeletal_Animation *animation, const f32 *times, u32 times_count,
+ const Vec3 *positions, const Quat *rotations, const Vec3 *scales, f32 vertex_distance) {
+    SE_Animation_Cursor *cursor = malloc(sizeof(SE_Animation_Cursor));
+    memset(cursor, 0, sizeof(SE_Animation_Cursor));
+    Vec4 points[4] = {
+        {0, 0, 0, 1},
+        {vertex_distance, 0, 0, 1},
+        {0, vertex_distance, 0, 1},
+        {0, 0, vertex_distance, 1}
+    };
 
-        // repeat for children
-    for (u32 i = 0; i < node->children_count; ++i) {
-        recursive_calculate_bone_pose(skeleton, animation, animation_time, &skeleton->bone_nodes[node->children[i]], final_node_transform);
+    f32 max_error = 0.0f;
+    Mat4 imported[SE_SKELETON_BONES_CAPACITY];
+    Mat4 compressed[SE_SKELETON_BONES_CAPACITY];
+    for (u32 t = 0; t < times_count; ++t) {
+        f32 frame = se_math_clamp(times[t] * animation->frames_per_tick, 0.0f, (f32)(animation->frames_count - 1));
+        for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
+            const SE_Bone_Node *node = &skeleton->bone_nodes[i];
+            i32 channel = animation->node_channels[i];
+            Mat4 imported_local   = node->local_transform;
+            Mat4 compressed_local = node->local_transform;
+            if (channel >= 0) {
+                u32 sample = channel * times_count + t;
+                imported_local   = bone_local_transform(positions[sample], rotations[sample], scales[sample]);
+                compressed_local = sample_channel(animation, &animation->channels[channel], frame, cursor->keys[i]);
+            }
+            imported[i]   = node->parent >= 0 ? mat4_mul(imported_local, imported[node->parent]) : imported_local;
+            compressed[i] = node->parent >= 0 ? mat4_mul(compressed_local, compressed[node->parent]) : compressed_local;
+
+            for (u32 p = 0; p < 4; ++p) {
+                Vec4 a = mat4_mul_vec4(imported[i], points[p]);
+                Vec4 b = mat4_mul_vec4(compressed[i], points[p]);
+                max_error = se_math_max(max_error, vec3_distance(v3f(a.x, a.y, a.z), v3f(b.x, b.y, b.z)));
+            }
+        }
     }
+    free(cursor);
+    return max_error;
 }
 
-static void recursive_calc_skeleton_pose_without_animation(SE_Skeleton *skeleton) {
-    for (u32 i = 0; i < SE_SKELETON_BONES_CAPACITY; ++i) {
-        skeleton->final_pose[i] = seskeleton_get_bone_final_transform(skeleton, i);
+void se_skeletal_animation_compress(const SE_Skeleton *skeleton, SE_Skeletal_Animation *animation) {
+    se_assert(animation->node_channels_count == skeleton->bone_node_count && "bind the animation before compressing it");
+    u32 channels_count = animation->animated_bones_count;
+
+        //- Frame grid
+        // as dense as the densest track, mocap is usually keyed every frame
+    u32 frames_count = 1;
+    u64 imported_size = 0;
+    for (u32 c = 0; c < channels_count; ++c) {
+        const SE_Bone_Animations *bone = &animation->animated_bones[c];
+        frames_count = se_math_max(frames_count, se_math_max(bone->position_count, se_math_max(bone->rotation_count, bone->scale_count)));
+        imported_size += bone->position_count * (sizeof(Vec3) + sizeof(f32))
+                       + bone->rotation_count * (sizeof(Quat) + sizeof(f32))
+                       + bone->scale_count    * (sizeof(Vec3) + sizeof(f32));
+    }
+    if (animation->duration <= 0.0f) frames_count = 1;
+    frames_count = se_math_min(frames_count, SE_ANIMATION_MAX_FRAMES);
+    f32 ticks_per_frame = frames_count > 1 ? animation->duration / (frames_count - 1) : 0.0f;
+
+    f32 *grid_times = malloc(sizeof(f32) * frames_count);
+    for (u32 frame = 0; frame < frames_count; ++frame) {
+        grid_times[frame] = frame * ticks_per_frame;
+    }
+    Vec3 *positions = malloc(sizeof(Vec3) * channels_count * frames_count);
+    Quat *rotations = malloc(sizeof(Quat) * channels_count * frames_count);
+    Vec3 *scales    = malloc(sizeof(Vec3) * channels_count * frames_count);
+    for (u32 c = 0; c < channels_count; ++c) {
+        sample_imported_bone(&animation->animated_bones[c], grid_times, frames_count,
+            &positions[c * frames_count], &rotations[c * frames_count], &scales[c * frames_count]);
     }
+
+        //- Reference
+        // the error is measured against the imported keys, not the grid, so it also covers what resampling lost
+    f32 *error_times;
+    u32 error_times_count = animation_error_times(animation, grid_times, frames_count, &error_times);
+    Vec3 *error_positions = malloc(sizeof(Vec3) * channels_count * error_times_count);
+    Quat *error_rotations = malloc(sizeof(Quat) * channels_count * error_times_count);
+    Vec3 *error_scales    = malloc(sizeof(Vec3) * channels_count * error_times_count);
+    for (u32 c = 0; c < channels_count; ++c) {
+        sample_imported_bone(&animation->animated_bones[c], error_times, error_times_count,
+            &error_positions[c * error_times_count], &error_rotations[c * error_times_count], &error_scales[c * error_times_count]);
+    }
+
+        //- Error budget
+        // a bone's rotation moves everything below it, so it has to be as accurate as the farthest
+        // descendant (or skin) needs. Positions are in the space of the (maybe scaled) parent.
+    Mat4 bind_pose[SE_SKELETON_BONES_CAPACITY];
+    f32 reach[SE_SKELETON_BONES_CAPACITY];
+    Vec3 bind_min = v3f( SEMATH_INFINITY,  SEMATH_INFINITY,  SEMATH_INFINITY);
+    Vec3 bind_max = v3f(-SEMATH_INFINITY, -SEMATH_INFINITY, -SEMATH_INFINITY);
+    for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
+        const SE_Bone_Node *node = &skeleton->bone_nodes[i];
+        bind_pose[i] = node->parent >= 0 ? mat4_mul(node->local_transform, bind_pose[node->parent]) : node->local_transform;
+        Vec3 position = v3f(bind_pose[i].data[12], bind_pose[i].data[13], bind_pose[i].data[14]);
+        bind_min = vec3_min_components(bind_min, position);
+        bind_max = vec3_max_components(bind_max, position);
+        reach[i] = 0.0f;
+        for (i32 ancestor = node->parent; ancestor >= 0; ancestor = skeleton->bone_nodes[ancestor].parent) {
+            Vec3 ancestor_position = v3f(bind_pose[ancestor].data[12], bind_pose[ancestor].data[13], bind_pose[ancestor].data[14]);
+            reach[ancestor] = se_math_max(reach[ancestor], vec3_distance(position, ancestor_position));
+        }
+    }
+    f32 skeleton_size = skeleton->bone_node_count > 0 ? vec3_distance(bind_min, bind_max) : 0.0f;
+    if (skeleton_size <= 0.0f) skeleton_size = 1.0f;
+    f32 allowed_error   = SE_ANIMATION_MAX_ERROR_RATIO * skeleton_size;
+    f32 vertex_distance = SE_ANIMATION_VERTEX_DISTANCE_RATIO * skeleton_size;
+
+        // clips can animate nodes the skeleton doesn't have, so there can be more channels than bones
+    i32 *channel_nodes = malloc(sizeof(i32) * se_math_max(channels_count, 1));
+    for (u32 c = 0; c < channels_count; ++c) channel_nodes[c] = -1;
+    for (u32 i = 0; i < skeleton->bone_node_count; ++i) {
+        i32 channel = animation->node_channels[i];
+        if (channel >= 0 && (u32)channel < channels_count) channel_nodes[channel] = i;
+    }
+
+        //- Compress
+        // every bone on a chain adds its error, so start with a share of the budget for each track and halve it
+        // until the measured error is within the budget
+    animation->frames_count    = frames_count;
+    animation->frames_per_tick = ticks_per_frame > 0.0f ? 1.0f / ticks_per_frame : 0.0f;
+    animation->channels_count  = channels_count;
+    animation->channels        = malloc(sizeof(SE_Animation_Channel) * channels_count);
+    Array(SE_Animation_Key) keys;
+    array_init(SE_Animation_Key, keys);
+    Vec3 *decoded_vec3s = malloc(sizeof(Vec3) * frames_count);
+    Quat *decoded_quats = malloc(sizeof(Quat) * frames_count);
+
+    f32 budget_share = 0.5f;
+    for (u32 attempt = 0; attempt < SE_ANIMATION_COMPRESS_ATTEMPTS; ++attempt, budget_share *= 0.5f) {
+        keys.size = 0;
+        for (u32 c = 0; c < channels_count; ++c) {
+            SE_Animation_Channel *channel = &animation->channels[c];
+            memset(channel, 0, sizeof(SE_Animation_Channel));
+            i32 node = channel_nodes[c];
+            if (node < 0) continue; // no bone uses this channel
+
+            i32 parent = skeleton->bone_nodes[node].parent;
+            f32 parent_scale = parent >= 0 ? vec3_magnitude(v3f(bind_pose[parent].data[0], bind_pose[parent].data[1], bind_pose[parent].data[2])) : 1.0f;
+            f32 error = allowed_error * budget_share;
+            f32 angle = error / (reach[node] + vertex_distance);
+
+            SE_Animation_Track_Samples samples = {0};
+            samples.frames_count  = frames_count;
+            samples.decoded_vec3s = decoded_vec3s;
+            samples.decoded_quats = decoded_quats;
+
+            samples.track     = SE_ANIMATION_TRACK_POSITION;
+            samples.vec3s     = &positions[c * frames_count];
+            samples.tolerance = parent_scale > 0.0f ? error / parent_scale : error;
+            channel->first_key[samples.track]  = keys.size;
+            channel->keys_count[samples.track] = compress_track(&samples, &keys);
+            channel->position_min    = samples.min;
+            channel->position_extent = samples.extent;
+
+            samples.track     = SE_ANIMATION_TRACK_ROTATION;
+            samples.quats     = &rotations[c * frames_count];
+            samples.tolerance = 2.0f * se_math_sin(angle * 0.25f);
+            channel->first_key[samples.track]  = keys.size;
+            channel->keys_count[samples.track] = compress_track(&samples, &keys);
+
+            samples.track     = SE_ANIMATION_TRACK_SCALE;
+            samples.vec3s     = &scales[c * frames_count];
+            samples.tolerance = angle;
+            channel->first_key[samples.track]  = keys.size;
+            channel->keys_count[samples.track] = compress_track(&samples, &keys);
+            channel->scale_min    = samples.min;
+            channel->scale_extent = samples.extent;
+        }
+
+        animation->keys_count = keys.size;
+        animation->keys = keys.data;
+        animation->max_error = animation_compression_error(skeleton, animation, error_times, error_times_count,
+            error_positions, error_rotations, error_scales, vertex_distance);
+        if (animation->max_error <= allowed_error) break;
+    }
+
+        // the keys array can be up to half again as big as it needs to be
+    animation->keys = malloc(sizeof(SE_Animation_Key) * se_math_max(keys.size, 1));
+    memcpy(animation->keys, keys.data, sizeof(SE_Animation_Key) * keys.size);
+    array_deinit(keys);
+    free(decoded_vec3s);
+    free(decoded_quats);
+    free(positions);
+    free(rotations);
+    free(scales);
+    free(grid_times);
+    free(error_times);
+    free(error_positions);
+    free(error_rotations);
+    free(error_scales);
+    free(channel_nodes);
+
+        //- Report
+    u64 compressed_size = sizeof(SE_Animation_Key) * animation->keys_count + sizeof(SE_Animation_Channel) * channels_count;
+    printf("animation '%s': %u channels, %u frames, %.1f KB -> %.1f KB (%.1fx), max error %g (allowed %g)\n",
+            animation->name.buffer, channels_count, frames_count, imported_size / 1024.0, compressed_size / 1024.0,
+            compressed_size > 0 ? (f64)imported_size / compressed_size : 0.0, animation->max_error, allowed_error);
+    if (animation->max_error > allowed_error) {
+        printf("WARNING: animation '%s' is still over its error budget after %u attempts, it's kept as it is (max error %g, allowed %g)\n",
+                animation->name.buffer, SE_ANIMATION_COMPRESS_ATTEMPTS, animation->max_error, allowed_error);
+    }
+
+        // the imported keyframes aren't needed anymore
+    for (u32 c = 0; c < channels_count; ++c) {
+        bone_animations_deinit(&animation->animated_bones[c]);
+    }
+    free(animation->animated_bones);
+    animation->animated_bones = NULL;
+    animation->animated_bones_count = 0;
 }
 
 ///---------------------------------------------------------------------------------------------------------------------------------
@@ -1007,8 +1530,10 @@ void se_mesh_deinit(SE_Mesh *mesh) {
     glDeleteVertexArrays(1, &mesh->vao);
     glDeleteBuffers(1, &mesh->vbo);
     glDeleteBuffers(1, &mesh->ibo);
+    se_gl_state_invalidate();
     mesh->material_index = 0;
     mesh->skeleton = NULL; // because we don't own the skeleton
+    mesh->animator = NULL;
 }
 
 void se_mesh_generate_quad(SE_Mesh *mesh, Vec2 scale) { // 2d plane
@@ -1296,7 +1821,7 @@ void se_mesh_generate_static_skeleton
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->ibo);
 
-    glBindVertexArray(mesh->vao);
+    se_gl_bind_vertex_array(mesh->vao);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
 
@@ -1332,6 +1857,7 @@ void se_mesh_generate_static_skeleton
     mesh->type = SE_MESH_TYPE_LINE; // sense we're going to generate a skeleton we're going to be lines
 #endif
     mesh->skeleton = NULL; // we don't want to remember the original skeleton. No reason yet.
+    mesh->animator = NULL;
 
         //- fill data
     glBufferData(GL_ARRAY_BUFFER, sizeof(SE_Vertex3D) * vert_count,    verts, GL_STATIC_DRAW);
@@ -1346,7 +1872,7 @@ void se_mesh_generate_static_skeleton
     free(indices);
 
         //- unselect
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -1358,7 +1884,7 @@ void se_mesh_generate_skinned_skeleton
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->ibo);
 
-    glBindVertexArray(mesh->vao);
+    se_gl_bind_vertex_array(mesh->vao);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
 
@@ -1426,7 +1952,7 @@ void se_mesh_generate_skinned_skeleton
     free(indices);
 
         // unselect
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
@@ -1440,7 +1966,7 @@ void se_mesh_generate(SE_Mesh *mesh, u32 vert_count, const SE_Vertex3D *vertices
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->ibo);
 
-    glBindVertexArray(mesh->vao);
+    se_gl_bind_vertex_array(mesh->vao);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
 
@@ -1486,9 +2012,244 @@ void se_mesh_generate(SE_Mesh *mesh, u32 vert_count, const SE_Vertex3D *vertices
     mesh->element_count = index_count;
     mesh->indexed = true;
     mesh->aabb = se_mesh_calc_aabb(vertices, vert_count);
+    mesh->vertex_format = SE_VERTEX_FORMAT_FULL;
+
+    // unselect
+    se_gl_bind_vertex_array(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+//// PACKED VERTICES ////
+
+static i16 pack_snorm16(f32 value) {
+    if (value >  1.0f) value =  1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return (i16)(value * 32767.0f + (value >= 0 ? 0.5f : -0.5f));
+}
+
+static u16 pack_unorm16(f32 value) {
+    if (value > 1.0f) value = 1.0f;
+    if (value < 0.0f) value = 0.0f;
+    return (u16)(value * 65535.0f + 0.5f);
+}
+
+static f32 sign_not_zero(f32 value) {
+    return value >= 0 ? 1.0f : -1.0f;
+}
+
+    /// Octahedral encoding of a unit vector into two snorm16 values
+static void pack_octahedral(Vec3 v, i16 result[2]) {
+    f32 l1_norm = se_math_abs(v.x) + se_math_abs(v.y) + se_math_abs(v.z);
+    if (l1_norm <= 0) {
+        result[0] = 0;
+        result[1] = 0;
+        return;
+    }
+
+    f32 x = v.x / l1_norm;
+    f32 y = v.y / l1_norm;
+    if (v.z < 0) { // fold the bottom half of the octahedron over the top
+        f32 folded_x = (1.0f - se_math_abs(y)) * sign_not_zero(x);
+        f32 folded_y = (1.0f - se_math_abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+    result[0] = pack_snorm16(x);
+    result[1] = pack_snorm16(y);
+}
+
+    /// Calculates the position and uv bounds of the given vertices. "stride" is the distance in bytes between vertices
+static SE_Vertex_Quantisation vertex_quantisation_calc(const ubyte *verts, u32 count, u32 stride) {
+    SE_Vertex_Quantisation result = {0};
+    if (count == 0) return result;
+
+    const SE_Vertex3D *first = (const SE_Vertex3D*)verts;
+    Vec3 min = first->position;
+    Vec3 max = first->position;
+    Vec2 uv_min = first->texture_coord;
+    Vec2 uv_max = first->texture_coord;
+
+    for (u32 i = 1; i < count; ++i) {
+        const SE_Vertex3D *vert = (const SE_Vertex3D*)(verts + (u64)i * stride);
+        min.x = se_math_min(min.x, vert->position.x);
+        min.y = se_math_min(min.y, vert->position.y);
+        min.z = se_math_min(min.z, vert->position.z);
+        max.x = se_math_max(max.x, vert->position.x);
+        max.y = se_math_max(max.y, vert->position.y);
+        max.z = se_math_max(max.z, vert->position.z);
+
+        uv_min.x = se_math_min(uv_min.x, vert->texture_coord.x);
+        uv_min.y = se_math_min(uv_min.y, vert->texture_coord.y);
+        uv_max.x = se_math_max(uv_max.x, vert->texture_coord.x);
+        uv_max.y = se_math_max(uv_max.y, vert->texture_coord.y);
+    }
+
+    result.position_offset = vec3_mul_scalar(vec3_add(min, max), 0.5f);
+    result.position_scale  = vec3_mul_scalar(vec3_sub(max, min), 0.5f);
+    result.uv_offset = uv_min;
+    result.uv_scale  = (Vec2) {uv_max.x - uv_min.x, uv_max.y - uv_min.y};
+    return result;
+}
+
+static void vertex_pack(const SE_Vertex3D *vert, const SE_Vertex_Quantisation *quantisation, SE_Packed_Vertex3D *result) {
+        //- Position
+    f32 position[3] = {
+        vert->position.x - quantisation->position_offset.x,
+        vert->position.y - quantisation->position_offset.y,
+        vert->position.z - quantisation->position_offset.z,
+    };
+    f32 scale[3] = {
+        quantisation->position_scale.x,
+        quantisation->position_scale.y,
+        quantisation->position_scale.z,
+    };
+    for (u32 i = 0; i < 3; ++i) {
+        result->position[i] = scale[i] > 0 ? pack_snorm16(position[i] / scale[i]) : 0;
+    }
+
+        //- Normal, tangent and the handedness of the bitangent
+    f32 handedness = vec3_dot(vec3_cross(vert->normal, vert->tangent), vert->bitangent);
+    result->position[3] = handedness < 0 ? -32767 : 32767;
+    pack_octahedral(vert->normal, result->normal);
+    pack_octahedral(vert->tangent, result->tangent);
+
+        //- UV
+    f32 u = quantisation->uv_scale.x > 0 ? (vert->texture_coord.x - quantisation->uv_offset.x) / quantisation->uv_scale.x : 0;
+    f32 v = quantisation->uv_scale.y > 0 ? (vert->texture_coord.y - quantisation->uv_offset.y) / quantisation->uv_scale.y : 0;
+    result->texture_coord[0] = pack_unorm16(u);
+    result->texture_coord[1] = pack_unorm16(v);
+}
+
+SE_Vertex_Quantisation se_vertices_pack(const SE_Vertex3D *verts, u32 count, SE_Packed_Vertex3D *out) {
+    SE_Vertex_Quantisation quantisation = vertex_quantisation_calc((const ubyte*)verts, count, sizeof(SE_Vertex3D));
+    for (u32 i = 0; i < count; ++i) {
+        vertex_pack(&verts[i], &quantisation, &out[i]);
+    }
+    return quantisation;
+}
+
+SE_Vertex_Quantisation se_skinned_vertices_pack(const SE_Skinned_Vertex *verts, u32 count, SE_Packed_Skinned_Vertex *out) {
+    SE_Vertex_Quantisation quantisation = vertex_quantisation_calc((const ubyte*)verts, count, sizeof(SE_Skinned_Vertex));
+    for (u32 i = 0; i < count; ++i) {
+        vertex_pack(&verts[i].vert, &quantisation, &out[i].vert);
+
+            //- Bones
+            // quantise the weights to unorm8 and give the rounding error to the heaviest bone so they still add up to 255
+        i32 total = 0;
+        u32 heaviest = 0;
+        for (u32 j = 0; j < SE_MAX_BONE_WEIGHTS; ++j) {
+            i32 bone_id = verts[i].bone_ids[j];
+            f32 weight  = verts[i].bone_weights[j];
+            se_assert(bone_id < 256 && "bone id does not fit in a packed vertex");
+            if (bone_id < 0 || weight <= 0) {
+                out[i].bone_ids[j] = 0;
+                out[i].bone_weights[j] = 0;
+            } else {
+                out[i].bone_ids[j] = (ubyte)bone_id;
+                out[i].bone_weights[j] = (ubyte)(se_math_min(weight, 1.0f) * 255.0f + 0.5f);
+            }
+            total += out[i].bone_weights[j];
+            if (out[i].bone_weights[j] > out[i].bone_weights[heaviest]) heaviest = j;
+        }
+
+        if (total > 0) {
+            i32 adjusted = out[i].bone_weights[heaviest] + (255 - total);
+            out[i].bone_weights[heaviest] = (ubyte)se_math_max(0, se_math_min(255, adjusted));
+        }
+    }
+    return quantisation;
+}
+
+    /// Sets up the vertex attributes of SE_Packed_Vertex3D. Must match vertex_header.vsd
+static void packed_vertex_enable_attributes(u32 stride, u64 offset) {
+        // -- enable position (w holds the bitangent sign)
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, stride, (void*)(offset + offsetof(SE_Packed_Vertex3D, position)));
+        // -- enable normal (octahedral)
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)(offset + offsetof(SE_Packed_Vertex3D, normal)));
+        // -- enable uv
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(offset + offsetof(SE_Packed_Vertex3D, texture_coord)));
+        // -- enable tangent (octahedral)
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)(offset + offsetof(SE_Packed_Vertex3D, tangent)));
+        // the bitangent (4) is reconstructed in the shader from the normal and tangent
+}
+
+static AABB3D vertex_quantisation_to_aabb(SE_Vertex_Quantisation quantisation) {
+    AABB3D result = {
+        vec3_sub(quantisation.position_offset, quantisation.position_scale),
+        vec3_add(quantisation.position_offset, quantisation.position_scale)
+    };
+    return result;
+}
+
+void se_mesh_generate_packed
+(SE_Mesh *mesh, u32 vert_count, const SE_Packed_Vertex3D *vertices, u32 index_count, u32 *indices, SE_Vertex_Quantisation quantisation) {
+    se_assert(mesh->type == SE_MESH_TYPE_NORMAL && "only normal meshes can be generated from packed vertices");
+
+    // generate buffers
+    glGenBuffers(1, &mesh->vbo);
+    glGenVertexArrays(1, &mesh->vao);
+    glGenBuffers(1, &mesh->ibo);
+
+    se_gl_bind_vertex_array(mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+
+    // fill data
+    glBufferData(GL_ARRAY_BUFFER, sizeof(SE_Packed_Vertex3D) * vert_count, vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(u32), indices, GL_STATIC_DRAW);
+
+    packed_vertex_enable_attributes(sizeof(SE_Packed_Vertex3D), 0);
+
+    mesh->element_count = index_count;
+    mesh->indexed = true;
+    mesh->aabb = vertex_quantisation_to_aabb(quantisation);
+    mesh->vertex_format = SE_VERTEX_FORMAT_PACKED;
+    mesh->quantisation = quantisation;
+
+    // unselect
+    se_gl_bind_vertex_array(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void se_mesh_generate_skinned_packed
+(SE_Mesh *mesh, u32 vert_count, const SE_Packed_Skinned_Vertex *vertices, u32 index_count, u32 *indices, SE_Vertex_Quantisation quantisation) {
+    se_assert(mesh->type == SE_MESH_TYPE_SKINNED && "mesh type was something other than skinned but we tried to generate one");
+
+    // generate buffers
+    glGenBuffers(1, &mesh->vbo);
+    glGenVertexArrays(1, &mesh->vao);
+    glGenBuffers(1, &mesh->ibo);
+
+    se_gl_bind_vertex_array(mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+
+    // fill data
+    glBufferData(GL_ARRAY_BUFFER, sizeof(SE_Packed_Skinned_Vertex) * vert_count, vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(u32), indices, GL_STATIC_DRAW);
+
+    packed_vertex_enable_attributes(sizeof(SE_Packed_Skinned_Vertex), offsetof(SE_Packed_Skinned_Vertex, vert));
+        // enable bone weights (unorm8)
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SE_Packed_Skinned_Vertex), (void*)offsetof(SE_Packed_Skinned_Vertex, bone_weights));
+        // enable bone ids. Unsigned so they go to their own location (packed_bone_ids) instead of the signed bone_ids
+    glEnableVertexAttribArray(7);
+    glVertexAttribIPointer(7, 4, GL_UNSIGNED_BYTE, sizeof(SE_Packed_Skinned_Vertex), (void*)offsetof(SE_Packed_Skinned_Vertex, bone_ids));
+
+    mesh->element_count = index_count;
+    mesh->indexed = true;
+    mesh->aabb = vertex_quantisation_to_aabb(quantisation);
+    mesh->vertex_format = SE_VERTEX_FORMAT_PACKED;
+    mesh->quantisation = quantisation;
 
     // unselect
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -1630,6 +2391,9 @@ void se_skeleton_deinit(SE_Skeleton *skeleton) {
             free(skeleton->animations[i]->animated_bones[j].scale_time_stamps);
         }
         free(skeleton->animations[i]->animated_bones);
+        free(skeleton->animations[i]->channels);
+        free(skeleton->animations[i]->keys);
+        free(skeleton->animations[i]->node_channels);
         free(skeleton->animations[i]);
     }
 
@@ -1638,34 +2402,234 @@ void se_skeleton_deinit(SE_Skeleton *skeleton) {
     skeleton->bone_node_count = 0;
 }
 
-void se_skeleton_calculate_pose
-(SE_Skeleton *skeleton, f32 frame) {
-    se_assert(skeleton->animations_count > 0);
+void se_skeleton_bind_animations(SE_Skeleton *skeleton) {
+    for (u32 i = 0; i < skeleton->animations_count; ++i) {
+        SE_Skeletal_Animation *animation = skeleton->animations[i];
+        if (animation->animated_bones == NULL) continue; // already compressed, the channel names are gone
+        free(animation->node_channels);
+        animation->node_channels_count = skeleton->bone_node_count;
+        animation->node_channels = malloc(sizeof(i32) * skeleton->bone_node_count);
+
+        for (u32 node = 0; node < skeleton->bone_node_count; ++node) {
+            animation->node_channels[node] = -1;
+            for (u32 channel = 0; channel < animation->animated_bones_count; ++channel) {
+                if (se_string_compare(&animation->animated_bones[channel].name, &skeleton->bone_nodes[node].name)) {
+                    animation->node_channels[node] = channel;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+f64 se_skeleton_benchmark_pose(const SE_Skeleton *skeleton, u32 animation_index, u32 poses) {
+    if (animation_index >= skeleton->animations_count || poses == 0) return 0;
+    const SE_Skeletal_Animation *animation = skeleton->animations[animation_index];
+
+        // a throwaway animator, the benchmark shouldn't change what's drawn
+    SE_Animator *animator = malloc(sizeof(SE_Animator));
+    se_animator_init(animator, 0, skeleton);
+    se_animator_play(animator, skeleton, animation_index);
+
+        // playing forward
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < poses; ++i) {
+        se_animator_calculate_pose(animator, skeleton, animation->duration * i / poses);
+    }
+    u64 cursor_ticks = SDL_GetPerformanceCounter() - start;
+
+        // every pose is a seek
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < poses; ++i) {
+        memset(&animator->cursor, 0, sizeof(SE_Animation_Cursor));
+        se_animator_calculate_pose(animator, skeleton, animation->duration * i / poses);
+    }
+    u64 seek_ticks = SDL_GetPerformanceCounter() - start;
+    free(animator);
+
+        // what every instance shares against what each instance owns
+    u64 shared_size = sizeof(SE_Skeleton);
+    for (u32 i = 0; i < skeleton->animations_count; ++i) {
+        const SE_Skeletal_Animation *shared = skeleton->animations[i];
+        shared_size += sizeof(SE_Skeletal_Animation) + sizeof(SE_Animation_Channel) * shared->channels_count
+            + sizeof(SE_Animation_Key) * shared->keys_count + sizeof(i32) * shared->node_channels_count;
+    }
+
+    f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64 cursor_us = cursor_ticks * 1000000.0 / frequency / poses;
+    f64 seek_us = seek_ticks * 1000000.0 / frequency / poses;
+    printf("animation: %u poses of %u bones, %u channels, %u frames and %u keys (%.1f KB, max error %g), %.3f us per pose "
+            "(seeking every pose: %.3f us)\n",
+            poses, skeleton->bone_node_count, animation->channels_count, animation->frames_count, animation->keys_count,
+            sizeof(SE_Animation_Key) * animation->keys_count / 1024.0, animation->max_error, cursor_us, seek_us);
+    printf("animation: %.1f KB per animator, %.1f KB of skeleton and animations shared by every animator\n",
+            sizeof(SE_Animator) / 1024.0, shared_size / 1024.0);
+    return cursor_us;
+}
+
+//- ANIMATOR
+
+void se_animator_init(SE_Animator *animator, u32 skeleton_index, const SE_Skeleton *skeleton) {
+    memset(animator, 0, sizeof(SE_Animator));
+    animator->skeleton = skeleton_index;
+    animator->palette_offset = SE_ANIMATOR_NO_PALETTE;
+    for (u32 i = 0; i < SE_SKELETON_BONES_CAPACITY; ++i) animator->final_pose[i] = mat4_identity();
     if (skeleton->animations_count > 0) {
-        recursive_calculate_bone_pose(skeleton, skeleton->animations[skeleton->current_animation], frame, &skeleton->bone_nodes[0], mat4_identity());
+        se_animator_play(animator, skeleton, 0);
     } else {
-        recursive_calc_skeleton_pose_without_animation(skeleton);
+        calculate_bind_pose(skeleton, animator->final_pose);
     }
 }
 
+void se_animator_play(SE_Animator *animator, const SE_Skeleton *skeleton, u32 animation) {
+    se_assert(animation < skeleton->animations_count);
+    animator->animation = animation;
+    animator->playback.duration = skeleton->animations[animation]->duration;
+    animator->playback.speed = skeleton->animations[animation]->ticks_per_second;
+    animator->playback.current_frame = 0;
+    se_animator_calculate_pose(animator, skeleton, 0);
+}
+
+void se_animator_update(SE_Animator *animator, const SE_Skeleton *skeleton, f32 delta_time) {
+    if (skeleton->animations_count == 0) return; // stays in the bind pose
+    se_animation_update(&animator->playback, delta_time);
+    se_animator_calculate_pose(animator, skeleton, animator->playback.current_frame);
+}
+
+void se_animator_calculate_pose(SE_Animator *animator, const SE_Skeleton *skeleton, f32 animation_time) {
+    se_assert(animator->animation < skeleton->animations_count);
+    calculate_bone_pose(skeleton, skeleton->animations[animator->animation], animation_time, &animator->cursor,
+        animator->final_pose);
+}
+
+//- Batches
+
+    /// A contiguous run of animators updated by one job
+typedef struct Animator_Batch_Job {
+    SE_Animator *const *animators;
+    u32 count;
+    SE_Skeleton *const *skeletons;
+    f32 delta_time;
+    Mat4 *palette;
+} Animator_Batch_Job;
+
+static void animator_batch_job_proc(void *data) {
+    Animator_Batch_Job *job = data;
+    for (u32 i = 0; i < job->count; ++i) {
+        SE_Animator *animator = job->animators[i];
+        const SE_Skeleton *skeleton = job->skeletons[animator->skeleton];
+        se_animator_update(animator, skeleton, job->delta_time);
+        if (job->palette != NULL) {
+            memcpy(&job->palette[animator->palette_offset], animator->final_pose, sizeof(Mat4) * animator->palette_count);
+        }
+    }
+}
+
+u32 se_animators_update(SE_Animator *const *animators, u32 count, SE_Skeleton *const *skeletons, f32 delta_time,
+        SE_Job_Queue *jobs, Mat4 *palette) {
+        // the offsets first, so the jobs write to their own part of the palette
+    u32 palette_count = 0;
+    if (palette != NULL) {
+        for (u32 i = 0; i < count; ++i) {
+            animators[i]->palette_offset = palette_count;
+            animators[i]->palette_count = skeletons[animators[i]->skeleton]->bone_count;
+            palette_count += animators[i]->palette_count;
+        }
+    }
+
+    u32 chunks_count = jobs != NULL ? jobs->worker_count + 1 : 1;
+    chunks_count = se_math_min(chunks_count, (count + SE_ANIMATOR_BATCH_MIN_CHUNK - 1) / SE_ANIMATOR_BATCH_MIN_CHUNK);
+    if (chunks_count <= 1) {
+        Animator_Batch_Job job = {animators, count, skeletons, delta_time, palette};
+        animator_batch_job_proc(&job);
+        return palette_count;
+    }
+
+    Animator_Batch_Job batch[SE_JOB_QUEUE_MAX_WORKERS + 1];
+    u32 first = 0;
+    for (u32 i = 0; i < chunks_count; ++i) {
+        u32 chunk_count = count / chunks_count + (i < count % chunks_count ? 1 : 0);
+        batch[i] = (Animator_Batch_Job) {
+            animators + first, chunk_count, skeletons, delta_time, palette
+        };
+        se_job_queue_add(jobs, animator_batch_job_proc, &batch[i]);
+        first += chunk_count;
+    }
+    se_job_queue_wait(jobs);
+    return palette_count;
+}
+
+f64 se_animators_benchmark(const SE_Skeleton *skeleton, u32 characters, u32 updates) {
+    if (skeleton->animations_count == 0 || characters == 0 || updates == 0) return 0;
+    const SE_Skeletal_Animation *animation = skeleton->animations[0];
+
+    SE_Animator *animators_data = malloc(sizeof(SE_Animator) * characters);
+    SE_Animator **animators = malloc(sizeof(SE_Animator*) * characters);
+    for (u32 i = 0; i < characters; ++i) {
+        animators[i] = &animators_data[i];
+        se_animator_init(animators[i], 0, skeleton);
+            // everyone at a different point of the animation
+        animators[i]->playback.current_frame = animation->duration * i / characters;
+    }
+    Mat4 *palette = malloc(sizeof(Mat4) * skeleton->bone_count * characters);
+    SE_Skeleton *const skeletons[1] = {(SE_Skeleton*)skeleton};
+    f32 delta_time = 1.0f / 60.0f;
+
+    i32 cpu_count = SDL_GetCPUCount();
+    u32 max_threads = se_math_clamp(cpu_count, 1, SE_JOB_QUEUE_MAX_WORKERS + 1);
+    f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64 single_ms = 0;
+    f64 result_ms = 0;
+    for (u32 threads = 1; threads <= max_threads; ++threads) {
+        SE_Job_Queue queue;
+        if (threads > 1) se_job_queue_init(&queue, threads - 1); // the calling thread is the last one
+
+        u64 start = SDL_GetPerformanceCounter();
+        for (u32 i = 0; i < updates; ++i) {
+            se_animators_update(animators, characters, skeletons, delta_time, threads > 1 ? &queue : NULL, palette);
+        }
+        result_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / updates;
+        if (threads == 1) single_ms = result_ms;
+
+        if (threads > 1) se_job_queue_deinit(&queue);
+        printf("animators: %u characters of %u bones on %u threads, %.3f ms per update (%.2fx)\n",
+                characters, skeleton->bone_node_count, threads, result_ms, single_ms / result_ms);
+    }
+
+    free(palette);
+    free(animators);
+    free(animators_data);
+    return result_ms;
+}
+
 
 void se_save_data_mesh_deinit(SE_Save_Data_Meshes *save_data) {
     b8 is_skeleton_freed = false;
+    b8 is_mapped = save_data->file_map.data != NULL; // vertices and indices live in the mapped file
 
     for (u32 i = 0; i < save_data->meshes_count; ++i) {
         SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
 
             //- Vertices
-        if (raw_data->type == SE_MESH_TYPE_SKINNED) {
+        if (!is_mapped) {
             free(raw_data->skinned_verts);
-        } else {
             free(raw_data->verts);
+            free(raw_data->packed_skinned_verts);
+            free(raw_data->packed_verts);
         }
+        raw_data->verts = NULL;
+        raw_data->skinned_verts = NULL;
+        raw_data->packed_verts = NULL;
+        raw_data->packed_skinned_verts = NULL;
         raw_data->vert_count = 0;
 
             //- Indices
-        free(raw_data->indices);
+        if (!is_mapped) {
+            free(raw_data->indices);
+        }
+        raw_data->indices = NULL;
         raw_data->index_count = 0;
+        raw_data->lods_count = 0;
 
             //- Material
         raw_data->type = SE_MATERIAL_TYPE_LIT;
@@ -1683,143 +2647,412 @@ void se_save_data_mesh_deinit(SE_Save_Data_Meshes *save_data) {
         raw_data->skeleton_data = NULL;
     }
     free(save_data->meshes);
+    save_data->meshes = NULL;
     save_data->meshes_count = 0;
+
+    se_file_map_close(&save_data->file_map);
 }
 
-void se_save_data_read_mesh(SE_Save_Data_Meshes *save_data, const char *save_file) {
-    FILE *file;
-    file = fopen(save_file, "rb"); // read binary
-        fread(&save_data->meshes_count, sizeof(u32), 1, file);
-        save_data->meshes = malloc(sizeof(SE_Mesh_Raw_Data) * save_data->meshes_count);
-        memset(save_data->meshes, 0, sizeof(SE_Mesh_Raw_Data) * save_data->meshes_count);
+void se_save_data_pack_vertices(SE_Save_Data_Meshes *save_data) {
+    se_assert(save_data->file_map.data == NULL && "can not pack the vertices of a mapped file");
 
-        for (u32 i = 0; i < save_data->meshes_count; ++i) {
-            SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
-                //- Header
-            fread(&raw_data->type, sizeof(SE_MESH_TYPES), 1, file);
-                //- Verts
-                // read how many verts are in the file
-                // make space for the verts and load them from file
-            fread(&raw_data->vert_count, sizeof(u32), 1, file);
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        if (raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED) continue;
 
-            raw_data->skinned_verts = NULL;
+        if (raw_data->type == SE_MESH_TYPE_NORMAL) {
+            raw_data->packed_verts = malloc(sizeof(SE_Packed_Vertex3D) * raw_data->vert_count);
+            raw_data->quantisation = se_vertices_pack(raw_data->verts, raw_data->vert_count, raw_data->packed_verts);
+            free(raw_data->verts);
             raw_data->verts = NULL;
-
-            if (raw_data->type == SE_MESH_TYPE_SKINNED) {
-                raw_data->skinned_verts = malloc(sizeof(SE_Skinned_Vertex) * raw_data->vert_count);
-                fread(raw_data->skinned_verts, sizeof(SE_Skinned_Vertex), raw_data->vert_count, file);
-            } else {
-                raw_data->verts = malloc(sizeof(SE_Vertex3D) * raw_data->vert_count);
-                fread(raw_data->verts, sizeof(SE_Vertex3D), raw_data->vert_count, file);
+        } else
+        if (raw_data->type == SE_MESH_TYPE_SKINNED) {
+            b8 bone_ids_fit = true;
+            for (u32 v = 0; v < raw_data->vert_count && bone_ids_fit; ++v) {
+                for (u32 j = 0; j < SE_MAX_BONE_WEIGHTS; ++j) {
+                    if (raw_data->skinned_verts[v].bone_ids[j] > 255) bone_ids_fit = false;
+                }
             }
-
-            // make space for indices
-            fread(&raw_data->index_count, sizeof(u32), 1, file);
-            raw_data->indices = malloc(sizeof(u32) * raw_data->index_count);
-            fread(raw_data->indices, sizeof(u32), raw_data->index_count, file);
-
-                //- Shape
-            fread(&raw_data->line_width, sizeof(f32), 1, file);
-            fread(&raw_data->point_radius, sizeof(f32), 1, file);
-            fread(&raw_data->is_indexed, sizeof(b8), 1, file);
-            fread(&raw_data->aabb, sizeof(AABB3D), 1, file);
-            fread(&raw_data->should_cast_shadow, sizeof(b8), 1, file);
-
-                //- Material
-            fread(&raw_data->material_type, sizeof(i32), 1, file);
-            fread(&raw_data->material_shader_index, sizeof(u32), 1, file);
-            fread(&raw_data->base_diffuse, sizeof(f32), 4, file);
-            u32 diffuse_buffer_size;
-            u32 specular_buffer_size;
-            u32 normal_buffer_size;
-            fread(&diffuse_buffer_size, sizeof(u32), 1, file);
-            fread(&specular_buffer_size, sizeof(u32), 1, file);
-            fread(&normal_buffer_size, sizeof(u32), 1, file);
-
-            if (diffuse_buffer_size > 0) {
-                char diffuse_buffer[1024];
-                fread(diffuse_buffer, sizeof(char), diffuse_buffer_size + 1, file);
-                se_string_init(&raw_data->texture_diffuse_filepath, diffuse_buffer);
+            if (!bone_ids_fit) {
+                printf("WARNING: mesh %u has bone ids that do not fit in a packed vertex. Keeping the full vertex format\n", i);
+                continue;
             }
 
-            if (specular_buffer_size > 0) {
-                char specular_buffer[1024];
-                fread(specular_buffer, sizeof(char), specular_buffer_size + 1, file);
-                se_string_init(&raw_data->texture_specular_filepath, specular_buffer);
+            raw_data->packed_skinned_verts = malloc(sizeof(SE_Packed_Skinned_Vertex) * raw_data->vert_count);
+            raw_data->quantisation = se_skinned_vertices_pack(raw_data->skinned_verts, raw_data->vert_count, raw_data->packed_skinned_verts);
+            free(raw_data->skinned_verts);
+            raw_data->skinned_verts = NULL;
+        } else {
+            continue; // lines, points and sprites need the full format
+        }
+        raw_data->vertex_format = SE_VERTEX_FORMAT_PACKED;
+    }
+}
+
+    /// Reads the SE_MESH_FILE_SECTION_INFO blob into the raw data
+static b8 read_mesh_info_from_memory(SE_Mesh_Raw_Data *raw_data, SE_Mesh_File_Cursor *cursor) {
+    SE_Mesh_File_Info info;
+    mesh_file_cursor_read(cursor, &info, sizeof(SE_Mesh_File_Info));
+    if (cursor->overflowed || info.type >= SE_MESH_TYPES_COUNT) return false;
+    if (info.vertex_format != SE_VERTEX_FORMAT_FULL && info.vertex_format != SE_VERTEX_FORMAT_PACKED) return false;
+    if (info.lods_count > SE_MESH_LODS_MAX) return false;
+    for (u32 i = 0; i < info.lods_count; ++i) {
+        if (info.lods[i].index_offset > info.index_count || info.lods[i].index_count > info.index_count - info.lods[i].index_offset) return false;
+    }
+
+        //- Header
+    raw_data->type = info.type;
+    raw_data->vert_count  = info.vert_count;
+    raw_data->vertex_format = info.vertex_format;
+    raw_data->quantisation  = info.quantisation;
+    raw_data->index_count = info.index_count;
+    raw_data->lods_count  = info.lods_count;
+    memcpy(raw_data->lods, info.lods, sizeof(raw_data->lods));
+        //- Shape
+    raw_data->line_width   = info.line_width;
+    raw_data->point_radius = info.point_radius;
+    raw_data->is_indexed   = info.is_indexed;
+    raw_data->aabb         = info.aabb;
+    raw_data->should_cast_shadow = info.should_cast_shadow;
+        //- Material
+    raw_data->material_type = info.material_type;
+    raw_data->material_shader_index = info.material_shader_index;
+    raw_data->base_diffuse  = info.base_diffuse;
+
+    SE_String *filepaths[3] = {
+        &raw_data->texture_diffuse_filepath,
+        &raw_data->texture_specular_filepath,
+        &raw_data->texture_normal_filepath,
+    };
+    for (u32 i = 0; i < 3; ++i) {
+        u32 size = info.texture_filepath_sizes[i];
+        if (size == 0) continue;
+        const char *buffer = mesh_file_cursor_take(cursor, (u64)size + 1);
+        if (buffer == NULL || buffer[size] != '\0') return false;
+        se_string_init(filepaths[i], buffer);
+    }
+    return true;
+}
+
+    /// Was the file written by this version of the engine?
+static b8 mesh_file_header_is_compatible(const SE_Mesh_File_Header *header) {
+    return header->magic == SE_MESH_FILE_MAGIC
+        && header->version == SE_MESH_FILE_VERSION
+        && header->vertex_size == sizeof(SE_Vertex3D)
+        && header->skinned_vertex_size == sizeof(SE_Skinned_Vertex)
+        && header->packed_vertex_size == sizeof(SE_Packed_Vertex3D)
+        && header->packed_skinned_vertex_size == sizeof(SE_Packed_Skinned_Vertex);
+}
+
+b8 se_save_data_mesh_file_is_valid(const char *save_file, u64 content_key) {
+    FILE *file = fopen(save_file, "rb");
+    if (file == NULL) return false;
+
+    SE_Mesh_File_Header header;
+    b8 is_valid = fread(&header, sizeof(SE_Mesh_File_Header), 1, file) == 1
+               && mesh_file_header_is_compatible(&header)
+               && header.content_key == content_key;
+    fclose(file);
+    return is_valid;
+}
+
+b8 se_save_data_read_mesh(SE_Save_Data_Meshes *save_data, const char *save_file) {
+    memset(save_data, 0, sizeof(SE_Save_Data_Meshes));
+    if (!se_file_map_open(&save_data->file_map, save_file)) {
+        return false;
+    }
+
+    const ubyte *data = save_data->file_map.data;
+    u64 size = save_data->file_map.size;
+
+        //- Header
+    if (size < sizeof(SE_Mesh_File_Header)) {
+        printf("WARNING: %s is not a valid mesh file\n", save_file);
+        se_file_map_close(&save_data->file_map);
+        return false;
+    }
+
+    const SE_Mesh_File_Header *header = (const SE_Mesh_File_Header*)data;
+    if (!mesh_file_header_is_compatible(header)) {
+        printf("WARNING: %s was written by a different version of the engine (version %u, expected %u)\n",
+                save_file, header->magic == SE_MESH_FILE_MAGIC ? header->version : 0, SE_MESH_FILE_VERSION);
+        se_file_map_close(&save_data->file_map);
+        return false;
+    }
+
+    if (header->sections_offset > size
+        || (u64)header->sections_count * sizeof(SE_Mesh_File_Section) > size - header->sections_offset) {
+        printf("WARNING: %s has a corrupt section table\n", save_file);
+        se_file_map_close(&save_data->file_map);
+        return false;
+    }
+
+    save_data->content_key = header->content_key;
+    save_data->dependencies_key = header->dependencies_key;
+    save_data->meshes_count = header->meshes_count;
+    save_data->meshes = malloc(sizeof(SE_Mesh_Raw_Data) * save_data->meshes_count);
+    memset(save_data->meshes, 0, sizeof(SE_Mesh_Raw_Data) * save_data->meshes_count);
+
+        //- Sections
+    const SE_Mesh_File_Section *sections = (const SE_Mesh_File_Section*)(data + header->sections_offset);
+    b8 is_valid = true;
+    SE_Skeleton *skeleton = NULL; // all the meshes in a file share the same skeleton
+
+        // the info sections come first, so the vertex and index sections can be validated against their counts
+    for (u32 section_type = 0; section_type < SE_MESH_FILE_SECTIONS_COUNT && is_valid; ++section_type) {
+        for (u32 i = 0; i < header->sections_count && is_valid; ++i) {
+            const SE_Mesh_File_Section *section = &sections[i];
+            if (section->type != section_type) continue;
+
+            if (section->mesh_index >= save_data->meshes_count
+                || section->offset > size || section->size > size - section->offset
+                || section->offset % SE_MESH_FILE_ALIGNMENT != 0) {
+                is_valid = false;
+                break;
             }
 
-            if (normal_buffer_size > 0) {
-                char normal_buffer[1024];
-                fread(normal_buffer, sizeof(char), normal_buffer_size + 1, file);
-                se_string_init(&raw_data->texture_normal_filepath, normal_buffer);
+            SE_Mesh_Raw_Data *raw_data = &save_data->meshes[section->mesh_index];
+            SE_Mesh_File_Cursor cursor = {data + section->offset, section->size, 0, false};
+
+            switch (section_type) {
+                case SE_MESH_FILE_SECTION_INFO: {
+                    is_valid = read_mesh_info_from_memory(raw_data, &cursor);
+                } break;
+                case SE_MESH_FILE_SECTION_VERTICES: {
+                    b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+                    b8 is_packed  = raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED;
+                    u64 vertex_size = is_packed
+                        ? (is_skinned ? sizeof(SE_Packed_Skinned_Vertex) : sizeof(SE_Packed_Vertex3D))
+                        : (is_skinned ? sizeof(SE_Skinned_Vertex) : sizeof(SE_Vertex3D));
+
+                    if (section->size != vertex_size * raw_data->vert_count) {
+                        is_valid = false;
+                    } else
+                    if (is_packed) {
+                        if (is_skinned) raw_data->packed_skinned_verts = (SE_Packed_Skinned_Vertex*)cursor.data;
+                        else            raw_data->packed_verts = (SE_Packed_Vertex3D*)cursor.data;
+                    } else {
+                        if (is_skinned) raw_data->skinned_verts = (SE_Skinned_Vertex*)cursor.data;
+                        else            raw_data->verts = (SE_Vertex3D*)cursor.data;
+                    }
+                } break;
+                case SE_MESH_FILE_SECTION_INDICES: {
+                    if (section->size != sizeof(u32) * raw_data->index_count) {
+                        is_valid = false;
+                    } else {
+                        raw_data->indices = (u32*)cursor.data;
+                    }
+                } break;
+                case SE_MESH_FILE_SECTION_SKELETON: {
+                    if (skeleton != NULL) {
+                        is_valid = false; // there can only be one skeleton per file
+                        break;
+                    }
+                    skeleton = malloc(sizeof(SE_Skeleton));
+                    memset(skeleton, 0, sizeof(SE_Skeleton));
+                        // hand it to the raw data before reading so it gets freed on failure
+                    raw_data->skeleton_data = skeleton;
+                    is_valid = read_skeleton_from_memory(skeleton, &cursor);
+                } break;
             }
+        }
+    }
 
-                //- Skeleton
-            if (raw_data->type == SE_MESH_TYPE_SKINNED) {
-                raw_data->skeleton_data = malloc(sizeof(SE_Skeleton));
-                memset(raw_data->skeleton_data, 0, sizeof(SE_Skeleton));
-                read_skeleton_from_disk_binary(raw_data->skeleton_data, file);
+        //- Every mesh with vertices or indices must have had their sections
+    for (u32 i = 0; i < save_data->meshes_count && is_valid; ++i) {
+        const SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+        const void *verts = raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED
+            ? (is_skinned ? (const void*)raw_data->packed_skinned_verts : (const void*)raw_data->packed_verts)
+            : (is_skinned ? (const void*)raw_data->skinned_verts : (const void*)raw_data->verts);
+        if ((raw_data->vert_count > 0 && verts == NULL) || (raw_data->index_count > 0 && raw_data->indices == NULL)) {
+            is_valid = false;
+        }
+    }
+
+        //- Every skinned mesh in the file shares the skeleton
+    if (is_valid && skeleton != NULL) {
+        for (u32 i = 0; i < save_data->meshes_count; ++i) {
+            if (save_data->meshes[i].type == SE_MESH_TYPE_SKINNED) {
+                save_data->meshes[i].skeleton_data = skeleton;
             }
         }
-    fclose(file);
+    }
+
+    if (!is_valid) {
+        printf("WARNING: %s has a corrupt section\n", save_file);
+        se_save_data_mesh_deinit(save_data);
+        return false;
+    }
+
+    return true;
+}
+
+    /// Pads the file with zeros so the next write starts at a SE_MESH_FILE_ALIGNMENT aligned offset.
+    /// Returns the aligned offset.
+static u64 mesh_file_write_padding(FILE *file) {
+    static const ubyte zeros[SE_MESH_FILE_ALIGNMENT] = {0};
+    u64 offset = (u64)ftell(file);
+    u64 padding = (SE_MESH_FILE_ALIGNMENT - (offset % SE_MESH_FILE_ALIGNMENT)) % SE_MESH_FILE_ALIGNMENT;
+    fwrite(zeros, 1, padding, file);
+    return offset + padding;
+}
+
+    /// Writes an aligned blob and records it in the section table
+static void mesh_file_write_section(FILE *file, SE_Mesh_File_Section *section, u32 type, u32 mesh_index, const void *data, u64 size) {
+    section->type = type;
+    section->mesh_index = mesh_index;
+    section->offset = mesh_file_write_padding(file);
+    section->size = size;
+    if (size > 0) {
+        fwrite(data, 1, size, file);
+    }
 }
 
 void se_save_data_write_mesh(const SE_Save_Data_Meshes *save_data, const char *save_file) {
+        // written to a temporary file first (like the cooked textures), so a model that's loading on another
+        // thread or process never reads it half written, and two threads writing the same model don't interleave
+    char temp_filepath[512];
+    snprintf(temp_filepath, sizeof(temp_filepath), "%s.%lu.tmp", save_file, (unsigned long)SDL_ThreadID());
     FILE *file;
-    file = fopen(save_file, "wb"); // write binary
-        fwrite(&save_data->meshes_count, sizeof(u32), 1, file);
-        for (u32 i = 0; i < save_data->meshes_count; ++i) {
-            SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
-                //- Header
-            fwrite(&raw_data->type, sizeof(SE_MESH_TYPES), 1, file);
-                //- Verts
-            fwrite(&raw_data->vert_count, sizeof(u32), 1, file);
-            if (raw_data->type == SE_MESH_TYPE_SKINNED) {
-                // then write skinned_verts data
-                fwrite(raw_data->skinned_verts, sizeof(SE_Skinned_Vertex), raw_data->vert_count, file);
-            } else {
-                // write verts data
-                // then write skinned_verts as null / what's already stored
-                fwrite(raw_data->verts, sizeof(SE_Vertex3D), raw_data->vert_count, file);
-            }
+    file = fopen(temp_filepath, "wb"); // write binary
+    if (file == NULL) {
+        printf("ERROR: could not open %s for writing\n", temp_filepath);
+        return;
+    }
 
-            fwrite(&raw_data->index_count, sizeof(u32), 1, file);
-            fwrite(raw_data->indices, sizeof(u32), raw_data->index_count, file);
-
-                //- Shape
-            fwrite(&raw_data->line_width, sizeof(f32), 1, file);
-            fwrite(&raw_data->point_radius, sizeof(f32), 1, file);
-            fwrite(&raw_data->is_indexed, sizeof(b8), 1, file);
-            fwrite(&raw_data->aabb, sizeof(AABB3D), 1, file);
-            fwrite(&raw_data->should_cast_shadow, sizeof(b8), 1, file);
-
-                //- Material
-            fwrite(&raw_data->material_type, sizeof(i32), 1, file);
-            fwrite(&raw_data->material_shader_index, sizeof(u32), 1, file);
-            fwrite(&raw_data->base_diffuse, sizeof(f32), 4, file);
-            fwrite(&raw_data->texture_diffuse_filepath.size, sizeof(u32), 1, file);
-            fwrite(&raw_data->texture_specular_filepath.size, sizeof(u32), 1, file);
-            fwrite(&raw_data->texture_normal_filepath.size, sizeof(u32), 1, file);
-
-            if (raw_data->texture_diffuse_filepath.size > 0) {
-                fwrite(raw_data->texture_diffuse_filepath.buffer,
-                        sizeof(char), raw_data->texture_diffuse_filepath.size + 1, file);
-            }
+        //- Header and section table
+        // every mesh has an info, a vertex and an index section. Skinned meshes also have a skeleton section.
+    SE_Mesh_File_Header header = {0};
+    header.magic = SE_MESH_FILE_MAGIC;
+    header.version = SE_MESH_FILE_VERSION;
+    header.vertex_size = sizeof(SE_Vertex3D);
+    header.skinned_vertex_size = sizeof(SE_Skinned_Vertex);
+    header.packed_vertex_size = sizeof(SE_Packed_Vertex3D);
+    header.packed_skinned_vertex_size = sizeof(SE_Packed_Skinned_Vertex);
+    header.meshes_count = save_data->meshes_count;
+    header.sections_count = save_data->meshes_count * 3;
+    header.content_key = save_data->content_key;
+    header.dependencies_key = save_data->dependencies_key;
+
+        // the meshes of a file share one skeleton, so it is only written once
+    const SE_Skeleton *skeleton = NULL;
+    u32 skeleton_mesh_index = 0;
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        const SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        if (raw_data->type == SE_MESH_TYPE_SKINNED && raw_data->skeleton_data) {
+            skeleton = raw_data->skeleton_data;
+            skeleton_mesh_index = i;
+            header.sections_count += 1;
+            break;
+        }
+    }
+    header.sections_offset = sizeof(SE_Mesh_File_Header);
 
-            if (raw_data->texture_specular_filepath.size > 0) {
-                fwrite(raw_data->texture_specular_filepath.buffer,
-                        sizeof(char), raw_data->texture_specular_filepath.size + 1, file);
-            }
+    SE_Mesh_File_Section *sections = malloc(sizeof(SE_Mesh_File_Section) * header.sections_count);
+    memset(sections, 0, sizeof(SE_Mesh_File_Section) * header.sections_count);
+
+        // reserve space, the real header and table are written once we know the offsets
+    fwrite(&header, sizeof(SE_Mesh_File_Header), 1, file);
+    fwrite(sections, sizeof(SE_Mesh_File_Section), header.sections_count, file);
+
+    u32 section_index = 0;
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        const SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+
+            //- Info
+        SE_Mesh_File_Info info = {0};
+        info.type = raw_data->type;
+        info.vert_count = raw_data->vert_count;
+        info.vertex_format = raw_data->vertex_format;
+        info.quantisation = raw_data->quantisation;
+        info.index_count = raw_data->index_count;
+        info.line_width = raw_data->line_width;
+        info.point_radius = raw_data->point_radius;
+        info.is_indexed = raw_data->is_indexed;
+        info.aabb = raw_data->aabb;
+        info.should_cast_shadow = raw_data->should_cast_shadow;
+        info.material_type = raw_data->material_type;
+        info.material_shader_index = raw_data->material_shader_index;
+        info.base_diffuse = raw_data->base_diffuse;
+        info.lods_count = raw_data->lods_count;
+        memcpy(info.lods, raw_data->lods, sizeof(info.lods));
+
+        const SE_String *filepaths[3] = {
+            &raw_data->texture_diffuse_filepath,
+            &raw_data->texture_specular_filepath,
+            &raw_data->texture_normal_filepath,
+        };
+        for (u32 j = 0; j < 3; ++j) {
+            info.texture_filepath_sizes[j] = filepaths[j]->buffer != NULL ? filepaths[j]->size : 0;
+        }
 
-            if (raw_data->texture_normal_filepath.size > 0) {
-                fwrite(raw_data->texture_normal_filepath.buffer,
-                        sizeof(char), raw_data->texture_normal_filepath.size + 1, file);
+        SE_Mesh_File_Section *info_section = &sections[section_index++];
+        mesh_file_write_section(file, info_section, SE_MESH_FILE_SECTION_INFO, i, &info, sizeof(SE_Mesh_File_Info));
+        for (u32 j = 0; j < 3; ++j) {
+            if (info.texture_filepath_sizes[j] > 0) {
+                fwrite(filepaths[j]->buffer, sizeof(char), info.texture_filepath_sizes[j] + 1, file);
+                info_section->size += info.texture_filepath_sizes[j] + 1;
             }
+        }
 
-                //- Skeleton
-            if (raw_data->type == SE_MESH_TYPE_SKINNED && raw_data->skeleton_data) {
-                write_skeleton_to_disk_binary(raw_data->skeleton_data, file);
+            //- Verts
+        const void *verts;
+        u64 vertex_size;
+        if (raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED) {
+            if (raw_data->type == SE_MESH_TYPE_SKINNED) {
+                verts = raw_data->packed_skinned_verts;
+                vertex_size = sizeof(SE_Packed_Skinned_Vertex);
+            } else {
+                verts = raw_data->packed_verts;
+                vertex_size = sizeof(SE_Packed_Vertex3D);
             }
+        } else {
+            if (raw_data->type == SE_MESH_TYPE_SKINNED) {
+                verts = raw_data->skinned_verts;
+                vertex_size = sizeof(SE_Skinned_Vertex);
+            } else {
+                verts = raw_data->verts;
+                vertex_size = sizeof(SE_Vertex3D);
+            }
+        }
+        mesh_file_write_section(file, &sections[section_index++], SE_MESH_FILE_SECTION_VERTICES, i,
+                                verts, vertex_size * raw_data->vert_count);
+
+            //- Indices
+        mesh_file_write_section(file, &sections[section_index++], SE_MESH_FILE_SECTION_INDICES, i,
+                                raw_data->indices, sizeof(u32) * raw_data->index_count);
+
+            //- Skeleton
+        if (skeleton != NULL && i == skeleton_mesh_index) {
+            SE_Mesh_File_Section *skeleton_section = &sections[section_index++];
+            mesh_file_write_section(file, skeleton_section, SE_MESH_FILE_SECTION_SKELETON, i, NULL, 0);
+            write_skeleton_to_disk_binary(skeleton, file);
+            skeleton_section->size = (u64)ftell(file) - skeleton_section->offset;
         }
+    }
+    se_assert(section_index == header.sections_count);
+
+        //- Go back and fill in the header and the section table
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(SE_Mesh_File_Header), 1, file);
+    fwrite(sections, sizeof(SE_Mesh_File_Section), header.sections_count, file);
+
+    free(sections);
+    b8 is_written = ferror(file) == 0;
     fclose(file);
-}
\ No newline at end of file
+
+    if (!is_written) {
+        printf("ERROR: could not write %s\n", temp_filepath);
+        remove(temp_filepath);
+        return;
+    }
+    if (rename(temp_filepath, save_file) != 0) {
+            // rename doesn't replace an existing file on windows, remove the out of date entry and try again
+        remove(save_file);
+        if (rename(temp_filepath, save_file) != 0) {
+                // another thread has just written the same entry, or it's mapped by a reader
+            remove(temp_filepath);
+        }
+    }
+}
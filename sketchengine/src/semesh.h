@@ -10,6 +10,9 @@
 #include "sesprite.h"
 #include "sestring.h"
 #include "secamera.h"
+#include "sefile.h"
+#include "seanimation.h"
+#include "sejobs.h"
 #include "khash.h"
 
 //// VERTEX ////
@@ -32,9 +35,57 @@ typedef struct SE_Skinned_Vertex {
     f32 bone_weights[SE_MAX_BONE_WEIGHTS];
 } SE_Skinned_Vertex;
 
+//- PACKED VERTICES
+// An optional compressed layout for lit and skinned meshes (20 and 28 bytes instead of 60 and 92).
+// Decoded in vertex_header.vsd using the mesh's SE_Vertex_Quantisation.
+
+typedef enum SE_VERTEX_FORMATS {
+    SE_VERTEX_FORMAT_FULL,   // SE_Vertex3D, SE_Skinned_Vertex
+    SE_VERTEX_FORMAT_PACKED, // SE_Packed_Vertex3D, SE_Packed_Skinned_Vertex
+} SE_VERTEX_FORMATS;
+
+typedef struct SE_Packed_Vertex3D {
+    i16 position[4];      // snorm16 quantised against the mesh bounds. w is the sign of the bitangent
+    i16 normal[2];        // octahedral encoded snorm16
+    i16 tangent[2];       // octahedral encoded snorm16
+    u16 texture_coord[2]; // unorm16 quantised against the uv bounds
+} SE_Packed_Vertex3D;
+
+typedef struct SE_Packed_Skinned_Vertex {
+    SE_Packed_Vertex3D vert;
+    ubyte bone_ids[SE_MAX_BONE_WEIGHTS];     // unused slots are zero with a weight of zero
+    ubyte bone_weights[SE_MAX_BONE_WEIGHTS]; // unorm8, they add up to 255
+} SE_Packed_Skinned_Vertex;
+
+    /// A level of detail is a range of the mesh's index buffer. All lods share the same vertices.
+    /// Lod 0 is the full mesh, each lod after it is simplified from lod 0 with fewer triangles than the one before.
+#define SE_MESH_LODS_MAX 4
+typedef struct SE_Mesh_Lod {
+    u32 index_offset; // first index of this lod in the index buffer
+    u32 index_count;
+    f32 error;        // how far the simplified surface is from lod 0, relative to the size of the mesh
+} SE_Mesh_Lod;
+
+    /// What the shaders need to decode packed vertices:
+    /// position = position_offset + position * position_scale
+    /// uv = uv_offset + texture_coord * uv_scale
+typedef struct SE_Vertex_Quantisation {
+    Vec3 position_offset; // centre of the bounds
+    Vec3 position_scale;  // half the size of the bounds
+    Vec2 uv_offset;       // min uv
+    Vec2 uv_scale;        // size of the uv bounds
+} SE_Vertex_Quantisation;
+
+    /// Packs "count" vertices into "out" (which must have space for "count" vertices).
+    /// Returns the quantisation the packed vertices must be decoded with.
+SE_Vertex_Quantisation se_vertices_pack(const SE_Vertex3D *verts, u32 count, SE_Packed_Vertex3D *out);
+    /// Same as se_vertices_pack but for skinned vertices. Bone ids must be in the [-1, 255] range.
+SE_Vertex_Quantisation se_skinned_vertices_pack(const SE_Skinned_Vertex *verts, u32 count, SE_Packed_Skinned_Vertex *out);
+
 //// ANIMATION ////
 
 #define SE_MAX_ANIMATION_BONE_KEYFRAMES 1000
+    /// The keyframes of one bone as assimp imported them. Only kept until se_skeletal_animation_compress.
 typedef struct SE_Bone_Animations {
     // i32 bone_node_index;
     SE_String name; // name pf the bone
@@ -51,14 +102,68 @@ typedef struct SE_Bone_Animations {
     f32  *scale_time_stamps;    // array of scale timestamps
 } SE_Bone_Animations;
 
+//- Compressed animation
+// Every track is resampled on a uniform grid of frames, so a key only stores the number of its frame.
+// Keys that linear interpolation can rebuild within the error bound are dropped, constant tracks keep a
+// single key and tracks that never leave the identity keep none.
+
+    /// Allowed bone position error as a fraction of the skeleton's size (its bind pose bounding box diagonal)
+#define SE_ANIMATION_MAX_ERROR_RATIO 0.0005f
+    /// Rotation error is also measured on points this far from every bone (as a fraction of the skeleton's size),
+    /// standing in for the skin around it
+#define SE_ANIMATION_VERTEX_DISTANCE_RATIO 0.03f
+#define SE_ANIMATION_MAX_FRAMES 65536
+    /// How many times the tracks' share of the error budget is halved before a clip is kept over budget
+#define SE_ANIMATION_COMPRESS_ATTEMPTS 6
+
+typedef enum SE_ANIMATION_TRACK {
+    SE_ANIMATION_TRACK_POSITION,
+    SE_ANIMATION_TRACK_ROTATION,
+    SE_ANIMATION_TRACK_SCALE,
+
+    SE_ANIMATION_TRACKS_COUNT
+} SE_ANIMATION_TRACK;
+
+    /// 8 bytes. Rotations keep their three smallest components in 15 bits each (smallest three), and the index of
+    /// the dropped largest one in the top bits of value[0] and value[1]. Positions and scales are 16 bits per
+    /// component within the range of their track.
+typedef struct SE_Animation_Key {
+    u16 frame;
+    u16 value[3];
+} SE_Animation_Key;
+
+    /// The compressed tracks of one animated bone
+typedef struct SE_Animation_Channel {
+        // the box the position and scale keys are quantised in
+    Vec3 position_min;
+    Vec3 position_extent;
+    Vec3 scale_min;
+    Vec3 scale_extent;
+        // the keys of each track (SE_ANIMATION_TRACK) in the animation's keys array. No keys means identity.
+    u32 first_key[SE_ANIMATION_TRACKS_COUNT];
+    u32 keys_count[SE_ANIMATION_TRACKS_COUNT];
+} SE_Animation_Channel;
+
 typedef struct SE_Skeletal_Animation {
         // name of the animation
     SE_String name;
-        // animation data
+        // animation data as imported, freed once compressed
     u32 animated_bones_count;
     SE_Bone_Animations *animated_bones;
     f32 duration;
     f32 ticks_per_second;
+        // compressed animation data, one channel for each animated bone
+    u32 frames_count;    // of the uniform grid, the last frame is at "duration"
+    f32 frames_per_tick;
+    u32 channels_count;
+    SE_Animation_Channel *channels;
+    u32 keys_count;
+    SE_Animation_Key *keys;
+    f32 max_error;       // the largest model space bone position error the compression measured
+        // the channel (index into channels) of each bone node, -1 if the node isn't animated.
+        // Resolved once by se_skeleton_bind_animations so posing never looks channels up by name.
+    u32 node_channels_count;
+    i32 *node_channels;
 } SE_Skeletal_Animation;
 
 //// SKELETON AND BONES ////
@@ -83,34 +188,92 @@ typedef struct SE_Bone_Node { // contains skeletal heirarchy information of a gi
     Mat4 inverse_neutral_transform; // the inverse t-pose model space transform of the bone
 } SE_Bone_Node;
 
-#define SE_SKELETON_BONES_CAPACITY 100 // ! needs to match with MAX_BONES in skinned_vertex.vsd
+#define SE_SKELETON_BONES_CAPACITY 100 // the shaders read bone_count matrices of each pose from the bone palette, any count fits
 #define SE_SKELETON_MAX_ANIMATIONS 100
-    /// contains skeletal heirarchy, bone info
+
+    /// How many keys the cursor steps over before giving up and binary searching
+#define SE_ANIMATION_CURSOR_MAX_STEPS 4
+    /// Where the last pose was sampled from, so the next pose doesn't search the tracks from the start.
+    /// Each entry is only a hint, a stale cursor (after a seek, a loop or switching animations) gives the same pose.
+typedef struct SE_Animation_Cursor {
+        // the key each bone node interpolated from, for its position, rotation and scale tracks
+    u32 keys[SE_SKELETON_BONES_CAPACITY][SE_ANIMATION_TRACKS_COUNT];
+} SE_Animation_Cursor;
+
+    /// contains skeletal heirarchy, bone info and the animations that can play on it.
+    /// Read only once loaded, so every model animated with it shares one copy. The per-instance state (which
+    /// animation, where in it and the resulting pose) lives in an SE_Animator.
 typedef struct SE_Skeleton {
         // array of bone data (index into transformed bones in vertex shader, and offset matrix)
     u32 bone_count;
     SE_Bone_Info bones_info[SE_SKELETON_BONES_CAPACITY];
-        // the heirarchy of bones (parent child relationship)
+        // the heirarchy of bones (parent child relationship). Parents always come before their children
     u32 bone_node_count;
     SE_Bone_Node bone_nodes[SE_SKELETON_BONES_CAPACITY];
 
         // animations associated with this skeleton. The animations are loaded
         // when the skeleton is loaded from a file
     u32 animations_count;
-    u32 current_animation;
     SE_Skeletal_Animation *animations[SE_SKELETON_MAX_ANIMATIONS];
-
-        // the pose sent to GPU, call se_skeleton_calculate_pose to update this pose
-    Mat4 final_pose[SE_SKELETON_BONES_CAPACITY];
 } SE_Skeleton;
 
-    /// We do not have an animator class, instead use this procedure.
-    /// Based on the given skeleton, skeleton->current_animation, and animation_time, we update the pose of the skeleton.
-    /// The result is stored in final_bone_transforms and final_bone_transforms_count.
-void se_skeleton_calculate_pose(SE_Skeleton *skeleton, f32 animation_time);
+    /// Resolves the channels of every animation to the skeleton's bone nodes by name. Done once at import before
+    /// the animations are compressed, the result is saved in the .mesh file.
+void se_skeleton_bind_animations(SE_Skeleton *skeleton);
+    /// Replaces the imported keyframes of a bound animation with compressed channels, see "Compressed animation".
+    /// Prints the sizes and the largest error.
+void se_skeletal_animation_compress(const SE_Skeleton *skeleton, SE_Skeletal_Animation *animation);
+    /// Poses the skeleton "poses" times across one of its animations and prints the timings, next to posing
+    /// without the cursor (every pose a seek), and the size of an animator next to the skeleton it shares.
+    /// Returns the average microseconds of one pose.
+f64 se_skeleton_benchmark_pose(const SE_Skeleton *skeleton, u32 animation, u32 poses);
 void se_skeleton_deinit(SE_Skeleton *skeleton);
 void skeleton_deep_copy(SE_Skeleton *dest, const SE_Skeleton *src);
 
+//- ANIMATOR
+
+    /// One instance of a skeleton playing an animation. Small and cheap to create, make one per animated model
+    /// and point it at the shared skeleton by index.
+typedef struct SE_Animator {
+    u32 skeleton;  // index into SE_Renderer3D user_skeletons
+    u32 animation; // index into the skeleton's animations
+    SE_Animation playback; // time and speed in ticks of the current animation
+    SE_Animation_Cursor cursor;
+        // the pose, call se_animator_update or se_animator_calculate_pose to update it
+    Mat4 final_pose[SE_SKELETON_BONES_CAPACITY];
+        // where final_pose was last packed into a bone palette by se_animators_update, palette_count matrices
+        // from palette_offset. The GPU reads the pose from there. SE_ANIMATOR_NO_PALETTE until it's packed
+    u32 palette_offset;
+    u32 palette_count;
+} SE_Animator;
+
+#define SE_ANIMATOR_NO_PALETTE 0xFFFFFFFF
+
+    /// Starts the skeleton's first animation from the beginning. If it has no animations the pose is the bind pose.
+void se_animator_init(SE_Animator *animator, u32 skeleton_index, const SE_Skeleton *skeleton);
+    /// Switches to another of the skeleton's animations and poses its first frame
+void se_animator_play(SE_Animator *animator, const SE_Skeleton *skeleton, u32 animation);
+    /// Advances the playback by delta_time (looping at the end) and updates the pose
+void se_animator_update(SE_Animator *animator, const SE_Skeleton *skeleton, f32 delta_time);
+    /// Updates final_pose to the current animation at animation_time (in ticks)
+void se_animator_calculate_pose(SE_Animator *animator, const SE_Skeleton *skeleton, f32 animation_time);
+
+    //- Batches
+    /// Fewest animators a job updates, below this the job overhead costs more than it saves
+#define SE_ANIMATOR_BATCH_MIN_CHUNK 16
+    /// se_animator_update for "count" animators. "skeletons" is indexed by SE_Animator.skeleton.
+    /// The animators are split into contiguous chunks, one job per worker of "jobs" (plus one for the calling
+    /// thread, which helps), or all updated on the calling thread if "jobs" is NULL.
+    /// If "palette" isn't NULL, the poses are also packed back to back into it, bone_count matrices each, ready to be
+    /// uploaded, and each animator's palette_offset and palette_count are set. The palette needs room for the sum of
+    /// the bone counts. Returns the number of matrices in the palette.
+u32 se_animators_update(SE_Animator *const *animators, u32 count, SE_Skeleton *const *skeletons, f32 delta_time,
+    SE_Job_Queue *jobs, Mat4 *palette);
+    /// Updates "characters" animators of the skeleton (staggered through its first animation) "updates" times with
+    /// se_animators_update, on 1 thread and then with every thread count up to the number of cores. Prints the timings.
+    /// Returns the average milliseconds of one update on every core.
+f64 se_animators_benchmark(const SE_Skeleton *skeleton, u32 characters, u32 updates);
+
 //// MATERIAL ////
 typedef enum SE_MATERIAL_TYPES {
     SE_MATERIAL_TYPE_LIT,
@@ -161,8 +324,15 @@ typedef struct SE_Mesh_Raw_Data {
     u32 vert_count;
     SE_Vertex3D *verts; // array of verts
     SE_Skinned_Vertex *skinned_verts; // array of skinned verts
+    // if vertex_format is SE_VERTEX_FORMAT_PACKED, the packed arrays are used instead
+    SE_VERTEX_FORMATS vertex_format;
+    SE_Packed_Vertex3D *packed_verts;
+    SE_Packed_Skinned_Vertex *packed_skinned_verts;
+    SE_Vertex_Quantisation quantisation;
     u32 index_count;
     u32 *indices;       // array of indices
+    u32 lods_count;     // 0 if the mesh has no lods, otherwise the index buffer holds every lod (see SE_Mesh_Lod)
+    SE_Mesh_Lod lods[SE_MESH_LODS_MAX];
         //- Shape
     f32 line_width;
     f32 point_radius;
@@ -183,17 +353,91 @@ typedef struct SE_Mesh_Raw_Data {
 typedef struct SE_Save_Data_Meshes {
     u32 meshes_count;     // number of meshes in this file that are linked together
     SE_Mesh_Raw_Data *meshes; // array of raw data
+    // When the save data was read from disk, the vertex and index arrays of every
+    // raw data point straight into this mapping instead of being allocated.
+    SE_File_Map file_map;
+    u64 content_key; // key of the source asset this was generated from (see se_mesh_cache_key), 0 if unknown
+    u64 dependencies_key; // key of the textures the meshes reference (see se_mesh_cache_dependencies_key), 0 if unknown
 } SE_Save_Data_Meshes;
 
+//// MESH FILE ////
+// The layout of a .mesh file on disk:
+// [SE_Mesh_File_Header][SE_Mesh_File_Section * sections_count][section blobs ...]
+// Every blob starts at a SE_MESH_FILE_ALIGNMENT aligned offset so that the vertex and
+// index blobs can be used in place once the file is mapped into memory.
+// Bump SE_MESH_FILE_VERSION whenever the layout of a section changes. Files with a
+// different version or vertex layout are rejected and regenerated from the source asset.
+
+#define SE_MESH_FILE_MAGIC 0x4853454D // "MESH"
+#define SE_MESH_FILE_VERSION 8
+#define SE_MESH_FILE_ALIGNMENT 16
+
+typedef enum SE_MESH_FILE_SECTIONS {
+    SE_MESH_FILE_SECTION_INFO,     // SE_Mesh_File_Info followed by the texture filepaths
+    SE_MESH_FILE_SECTION_VERTICES, // SE_Vertex3D, SE_Skinned_Vertex, or their packed counterparts
+    SE_MESH_FILE_SECTION_INDICES,  // u32 array
+    SE_MESH_FILE_SECTION_SKELETON, // serialised skeleton and its animations
+
+    SE_MESH_FILE_SECTIONS_COUNT
+} SE_MESH_FILE_SECTIONS;
+
+typedef struct SE_Mesh_File_Header {
+    u32 magic;
+    u32 version;
+    u32 vertex_size;         // sizeof(SE_Vertex3D) when the file was written
+    u32 skinned_vertex_size; // sizeof(SE_Skinned_Vertex) when the file was written
+    u32 packed_vertex_size;  // sizeof(SE_Packed_Vertex3D) when the file was written
+    u32 packed_skinned_vertex_size; // sizeof(SE_Packed_Skinned_Vertex) when the file was written
+    u32 meshes_count;
+    u32 sections_count;
+    u64 sections_offset;     // offset of the section table from the beginning of the file
+    u64 content_key;         // SE_Save_Data_Meshes::content_key
+    u64 dependencies_key;    // SE_Save_Data_Meshes::dependencies_key
+} SE_Mesh_File_Header;
+
+typedef struct SE_Mesh_File_Section {
+    u32 type;       // SE_MESH_FILE_SECTIONS
+    u32 mesh_index; // which raw data this section belongs to
+    u64 offset;     // offset from the beginning of the file (aligned to SE_MESH_FILE_ALIGNMENT)
+    u64 size;       // size of the blob in bytes
+} SE_Mesh_File_Section;
+
+    /// Fixed size part of SE_MESH_FILE_SECTION_INFO
+typedef struct SE_Mesh_File_Info {
+    u32 type;
+    u32 vert_count;
+    u32 vertex_format;
+    SE_Vertex_Quantisation quantisation;
+    u32 index_count;
+    f32 line_width;
+    f32 point_radius;
+    u32 is_indexed;
+    AABB3D aabb;
+    u32 should_cast_shadow;
+    u32 material_type;
+    u32 material_shader_index;
+    Vec4 base_diffuse;
+    u32 texture_filepath_sizes[3]; // diffuse, specular, normal. Each string is stored with its null terminator
+    u32 lods_count;
+    SE_Mesh_Lod lods[SE_MESH_LODS_MAX];
+} SE_Mesh_File_Info;
+
+    /// Converts the vertices of every normal and skinned mesh in the save data to SE_VERTEX_FORMAT_PACKED.
+    /// Lines, points and sprites keep the full format.
+void se_save_data_pack_vertices(SE_Save_Data_Meshes *save_data);
     /// Free the memory resources used by the "raw_data"
 void se_save_data_mesh_deinit(SE_Save_Data_Meshes *save_data);
     /// Load SE_Mesh_Raw_Data from "save_file" and load a SE_Mesh from that.
-    /// Returns the index of the loaded mesh.
+    /// The file is mapped into memory and the vertex and index arrays point into that mapping.
+    /// Returns false if the file does not exist, is corrupt, or was written by a different version of the engine.
     //! The user must manage memory. Call "se_save_data_mesh_deinit" to
-    //! properly manage the data's memory
-void se_save_data_read_mesh(SE_Save_Data_Meshes *save_data, const char *save_file);
-    /// Saves the given SE_Mesh_Raw_Data to disk.
+    //! properly manage the data's memory (and unmap the file)
+b8 se_save_data_read_mesh(SE_Save_Data_Meshes *save_data, const char *save_file);
+    /// Saves the given SE_Mesh_Raw_Data to disk. The file is replaced in one go, readers never see it half written.
 void se_save_data_write_mesh(const SE_Save_Data_Meshes *save_data, const char *save_file);
+    /// Only reads the header of the mesh file. Returns true if it can be loaded by this version of the engine
+    /// and was generated from a source asset with the given content key.
+b8 se_save_data_mesh_file_is_valid(const char *save_file, u64 content_key);
 
 #define SE_MESH_VERTICES_MAX 10000
 typedef struct SE_Mesh {
@@ -210,6 +454,14 @@ typedef struct SE_Mesh {
     // note that based on the material type, different shaders will be used
     SE_MESH_TYPES type;
 
+    /* packed vertices */
+    SE_VERTEX_FORMATS vertex_format;
+    SE_Vertex_Quantisation quantisation;
+
+    /* levels of detail */
+    u32 lods_count; // 0 means the whole index buffer is drawn
+    SE_Mesh_Lod lods[SE_MESH_LODS_MAX];
+
     /* line */
     f32 line_width;
     /* point */
@@ -217,6 +469,7 @@ typedef struct SE_Mesh {
 
     /* skinned */
     SE_Skeleton *skeleton; // ! not owned. // @TODO change to a u32 index into SE_Renderer3D user_skeletons array
+    SE_Animator *animator; // ! not owned. The pose the mesh is drawn with unless it's submitted with its own animator
 } SE_Mesh;
 
 /// delete vao, vbo, ibo
@@ -240,6 +493,9 @@ void ai_scene_to_mesh_save_data(const struct aiScene *scene, SE_Save_Data_Meshes
 
 void sedefault_mesh(SE_Mesh *mesh);
 void se_mesh_generate_skinned(SE_Mesh *mesh, u32 vert_count, const SE_Skinned_Vertex *vertices, u32 index_count, u32 *indices);
+    /// Same as se_mesh_generate and se_mesh_generate_skinned but for packed vertices. See se_vertices_pack
+void se_mesh_generate_packed(SE_Mesh *mesh, u32 vert_count, const SE_Packed_Vertex3D *vertices, u32 index_count, u32 *indices, SE_Vertex_Quantisation quantisation);
+void se_mesh_generate_skinned_packed(SE_Mesh *mesh, u32 vert_count, const SE_Packed_Skinned_Vertex *vertices, u32 index_count, u32 *indices, SE_Vertex_Quantisation quantisation);
 /// calculate the bounding box of a collection of vertices
 AABB3D se_mesh_calc_aabb(const SE_Vertex3D *verts, u32 verts_count);
 AABB3D se_mesh_calc_aabb_skinned(const SE_Skinned_Vertex *verts, u32 verts_count);
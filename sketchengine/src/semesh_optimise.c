@@ -0,0 +1,732 @@
+#include "semesh_optimise.h"
+#include "sefile.h" // se_hash_bytes
+#include <math.h>
+#include <stdio.h>
+
+//// ANALYSIS ////
+
+SE_Vertex_Cache_Stats se_vertex_cache_analyse(const u32 *indices, u32 index_count, u32 vert_count, u32 cache_size) {
+    SE_Vertex_Cache_Stats stats = {0};
+    if (index_count < 3 || vert_count == 0) return stats;
+
+        // a vertex is in the cache if it was added less than "cache_size" misses ago
+    u32 *cache_timestamps = malloc(sizeof(u32) * vert_count);
+    memset(cache_timestamps, 0, sizeof(u32) * vert_count);
+    b8 *is_used = malloc(sizeof(b8) * vert_count);
+    memset(is_used, 0, sizeof(b8) * vert_count);
+
+    u32 timestamp = cache_size + 1;
+    u32 unique_count = 0;
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 v = indices[i];
+        if (timestamp - cache_timestamps[v] > cache_size) {
+            cache_timestamps[v] = timestamp++;
+            stats.vertices_transformed++;
+        }
+        if (!is_used[v]) {
+            is_used[v] = true;
+            unique_count++;
+        }
+    }
+
+    stats.acmr = (f32)stats.vertices_transformed / (index_count / 3);
+    stats.atvr = unique_count > 0 ? (f32)stats.vertices_transformed / unique_count : 0;
+
+    free(is_used);
+    free(cache_timestamps);
+    return stats;
+}
+
+//// VERTEX CACHE ////
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+
+#define FORSYTH_CACHE_SIZE 32
+
+static f32 forsyth_vertex_score(i32 cache_position, u32 live_triangles) {
+    if (live_triangles == 0) return -1.0f; // nothing left to draw with this vertex
+
+    f32 score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            score = 0.75f; // used by the last triangle, don't favour it so the strips don't get too thin
+        } else {
+            score = powf(1.0f - (f32)(cache_position - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+        }
+    }
+        // boost vertices with few triangles left so we don't leave lonely triangles behind
+    score += 2.0f * powf((f32)live_triangles, -0.5f);
+    return score;
+}
+
+void se_optimise_vertex_cache(u32 *result, const u32 *indices, u32 index_count, u32 vert_count) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) return;
+
+        //- Vertex to triangle adjacency
+    u32 *live_triangles = malloc(sizeof(u32) * vert_count);
+    memset(live_triangles, 0, sizeof(u32) * vert_count);
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        live_triangles[indices[i]]++;
+    }
+
+    u32 *adjacency_offsets = malloc(sizeof(u32) * (vert_count + 1));
+    adjacency_offsets[0] = 0;
+    for (u32 v = 0; v < vert_count; ++v) {
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+    }
+
+    u32 *adjacency = malloc(sizeof(u32) * triangle_count * 3);
+    u32 *adjacency_fill = malloc(sizeof(u32) * vert_count);
+    memcpy(adjacency_fill, adjacency_offsets, sizeof(u32) * vert_count);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = indices[t * 3 + k];
+            adjacency[adjacency_fill[v]++] = t;
+        }
+    }
+    free(adjacency_fill);
+
+        //- Scores
+    i32 *cache_positions = malloc(sizeof(i32) * vert_count);
+    f32 *vertex_scores   = malloc(sizeof(f32) * vert_count);
+    for (u32 v = 0; v < vert_count; ++v) {
+        cache_positions[v] = -1;
+        vertex_scores[v] = forsyth_vertex_score(-1, live_triangles[v]);
+    }
+
+    f32 *triangle_scores = malloc(sizeof(f32) * triangle_count);
+    b8 *is_emitted = malloc(sizeof(b8) * triangle_count);
+    memset(is_emitted, 0, sizeof(b8) * triangle_count);
+
+    i32 best_triangle = -1;
+    f32 best_score = -1.0f;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        const u32 *tri = &indices[t * 3];
+        triangle_scores[t] = vertex_scores[tri[0]] + vertex_scores[tri[1]] + vertex_scores[tri[2]];
+        if (triangle_scores[t] > best_score) {
+            best_score = triangle_scores[t];
+            best_triangle = t;
+        }
+    }
+
+        //- Emit triangles
+    u32 cache[FORSYTH_CACHE_SIZE + 3];
+    u32 cache_count = 0;
+    u32 scan_cursor = 0; // used to find a new triangle when none of the cached vertices have any left
+
+    for (u32 emitted = 0; emitted < triangle_count; ++emitted) {
+        if (best_triangle < 0) {
+            while (is_emitted[scan_cursor]) scan_cursor++;
+            best_triangle = scan_cursor;
+        }
+
+        const u32 *tri = &indices[best_triangle * 3];
+        result[emitted * 3 + 0] = tri[0];
+        result[emitted * 3 + 1] = tri[1];
+        result[emitted * 3 + 2] = tri[2];
+        is_emitted[best_triangle] = true;
+
+            // remove the triangle from its vertices' adjacency
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = tri[k];
+            u32 *triangles = &adjacency[adjacency_offsets[v]];
+            for (u32 j = 0; j < live_triangles[v]; ++j) {
+                if (triangles[j] == (u32)best_triangle) {
+                    triangles[j] = triangles[live_triangles[v] - 1];
+                    live_triangles[v]--;
+                    break;
+                }
+            }
+        }
+
+            // the triangle's vertices go to the front of the cache
+        u32 new_cache[FORSYTH_CACHE_SIZE + 3];
+        u32 new_cache_count = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            b8 is_duplicate = false;
+            for (u32 j = 0; j < new_cache_count; ++j) {
+                if (new_cache[j] == tri[k]) is_duplicate = true;
+            }
+            if (!is_duplicate) new_cache[new_cache_count++] = tri[k];
+        }
+        for (u32 i = 0; i < cache_count; ++i) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                new_cache[new_cache_count++] = v;
+            }
+        }
+
+        for (u32 i = 0; i < new_cache_count; ++i) {
+            cache_positions[new_cache[i]] = i < FORSYTH_CACHE_SIZE ? (i32)i : -1; // pushed out of the cache
+        }
+
+            // rescore the vertices that moved and the triangles that use them
+        best_triangle = -1;
+        best_score = -1.0f;
+        for (u32 i = 0; i < new_cache_count; ++i) {
+            u32 v = new_cache[i];
+            vertex_scores[v] = forsyth_vertex_score(cache_positions[v], live_triangles[v]);
+        }
+        for (u32 i = 0; i < new_cache_count; ++i) {
+            u32 v = new_cache[i];
+            const u32 *triangles = &adjacency[adjacency_offsets[v]];
+            for (u32 j = 0; j < live_triangles[v]; ++j) {
+                u32 t = triangles[j];
+                const u32 *other = &indices[t * 3];
+                triangle_scores[t] = vertex_scores[other[0]] + vertex_scores[other[1]] + vertex_scores[other[2]];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+
+        cache_count = se_math_min(new_cache_count, FORSYTH_CACHE_SIZE);
+        memcpy(cache, new_cache, sizeof(u32) * cache_count);
+    }
+
+    free(is_emitted);
+    free(triangle_scores);
+    free(vertex_scores);
+    free(cache_positions);
+    free(adjacency);
+    free(adjacency_offsets);
+    free(live_triangles);
+}
+
+//// OVERDRAW ////
+// Based on "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander, Nehab, Barczak)
+
+typedef struct Overdraw_Cluster {
+    u32 start; // first triangle
+    u32 count; // number of triangles
+    f32 sort_key;
+} Overdraw_Cluster;
+
+static int overdraw_cluster_compare(const void *a, const void *b) {
+    f32 key_a = ((const Overdraw_Cluster*)a)->sort_key;
+    f32 key_b = ((const Overdraw_Cluster*)b)->sort_key;
+    return (key_a < key_b) - (key_a > key_b); // descending
+}
+
+static const Vec3* overdraw_position(const Vec3 *positions, u32 position_stride, u32 index) {
+    return (const Vec3*)((const ubyte*)positions + (u64)position_stride * index);
+}
+
+void se_optimise_overdraw
+(u32 *result, const u32 *indices, u32 index_count, const Vec3 *positions, u32 position_stride, u32 vert_count, f32 threshold) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) return;
+
+        //- Split into clusters
+        // simulate the cache, a triangle that misses on all of its vertices starts a new cluster (hard boundary).
+        // a cluster is also ended early once its running ACMR is within "threshold" of the mesh's (soft boundary)
+    SE_Vertex_Cache_Stats mesh_stats = se_vertex_cache_analyse(indices, index_count, vert_count, SE_VERTEX_CACHE_ANALYSE_SIZE);
+
+    Overdraw_Cluster *clusters = malloc(sizeof(Overdraw_Cluster) * triangle_count);
+    u32 clusters_count = 0;
+
+    u32 *cache_timestamps = malloc(sizeof(u32) * vert_count);
+    memset(cache_timestamps, 0, sizeof(u32) * vert_count);
+    u32 timestamp = SE_VERTEX_CACHE_ANALYSE_SIZE + 1;
+    u32 cluster_misses = 0;
+
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 misses = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = indices[t * 3 + k];
+            if (timestamp - cache_timestamps[v] > SE_VERTEX_CACHE_ANALYSE_SIZE) {
+                cache_timestamps[v] = timestamp++;
+                misses++;
+            }
+        }
+
+        b8 is_hard_boundary = misses == 3;
+        b8 is_soft_boundary = false;
+        if (clusters_count > 0) {
+            Overdraw_Cluster *current = &clusters[clusters_count - 1];
+            f32 cluster_acmr = (f32)cluster_misses / current->count;
+            is_soft_boundary = current->count >= 16 && cluster_acmr <= mesh_stats.acmr * threshold;
+        }
+
+        if (clusters_count == 0 || is_hard_boundary || is_soft_boundary) {
+            clusters[clusters_count++] = (Overdraw_Cluster) {t, 0, 0};
+            cluster_misses = 0;
+        }
+        clusters[clusters_count - 1].count++;
+        cluster_misses += misses;
+    }
+    free(cache_timestamps);
+
+        //- Sort clusters
+        // clusters that face away from the centre of the mesh are likely to occlude the rest, so they go first
+    Vec3 mesh_centre = {0};
+    f32 mesh_area = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        Vec3 a = *overdraw_position(positions, position_stride, indices[t * 3 + 0]);
+        Vec3 b = *overdraw_position(positions, position_stride, indices[t * 3 + 1]);
+        Vec3 c = *overdraw_position(positions, position_stride, indices[t * 3 + 2]);
+        f32 area = vec3_magnitude(vec3_cross(vec3_sub(b, a), vec3_sub(c, a)));
+        Vec3 centroid = vec3_mul_scalar(vec3_add(vec3_add(a, b), c), 1.0f / 3.0f);
+        mesh_centre = vec3_add(mesh_centre, vec3_mul_scalar(centroid, area));
+        mesh_area += area;
+    }
+    if (mesh_area > 0) mesh_centre = vec3_mul_scalar(mesh_centre, 1.0f / mesh_area);
+
+    for (u32 i = 0; i < clusters_count; ++i) {
+        Overdraw_Cluster *cluster = &clusters[i];
+        Vec3 centre = {0};
+        Vec3 normal = {0}; // area weighted
+        f32 area_total = 0;
+        for (u32 t = cluster->start; t < cluster->start + cluster->count; ++t) {
+            Vec3 a = *overdraw_position(positions, position_stride, indices[t * 3 + 0]);
+            Vec3 b = *overdraw_position(positions, position_stride, indices[t * 3 + 1]);
+            Vec3 c = *overdraw_position(positions, position_stride, indices[t * 3 + 2]);
+            Vec3 face_normal = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+            f32 area = vec3_magnitude(face_normal);
+            Vec3 centroid = vec3_mul_scalar(vec3_add(vec3_add(a, b), c), 1.0f / 3.0f);
+            centre = vec3_add(centre, vec3_mul_scalar(centroid, area));
+            normal = vec3_add(normal, face_normal);
+            area_total += area;
+        }
+        if (area_total > 0) centre = vec3_mul_scalar(centre, 1.0f / area_total);
+        f32 normal_length = vec3_magnitude(normal);
+        if (normal_length > 0) normal = vec3_mul_scalar(normal, 1.0f / normal_length);
+
+        cluster->sort_key = vec3_dot(vec3_sub(centre, mesh_centre), normal);
+    }
+
+    qsort(clusters, clusters_count, sizeof(Overdraw_Cluster), overdraw_cluster_compare);
+
+    u32 emitted = 0;
+    for (u32 i = 0; i < clusters_count; ++i) {
+        memcpy(&result[emitted * 3], &indices[clusters[i].start * 3], sizeof(u32) * 3 * clusters[i].count);
+        emitted += clusters[i].count;
+    }
+
+        //- Don't give up too much vertex cache efficiency for it
+    SE_Vertex_Cache_Stats result_stats = se_vertex_cache_analyse(result, index_count, vert_count, SE_VERTEX_CACHE_ANALYSE_SIZE);
+    if (result_stats.acmr > mesh_stats.acmr * threshold) {
+        memcpy(result, indices, sizeof(u32) * index_count);
+    }
+
+    free(clusters);
+}
+
+//// VERTEX FETCH ////
+
+u32 se_optimise_vertex_fetch(void *result, u32 *indices, u32 index_count, const void *verts, u32 vert_count, u32 vertex_size) {
+    u32 *remap = malloc(sizeof(u32) * vert_count);
+    memset(remap, 0xFF, sizeof(u32) * vert_count);
+
+    u32 next_vertex = 0;
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 v = indices[i];
+        if (remap[v] == (u32)-1) {
+            remap[v] = next_vertex;
+            memcpy((ubyte*)result + (u64)next_vertex * vertex_size, (const ubyte*)verts + (u64)v * vertex_size, vertex_size);
+            next_vertex++;
+        }
+        indices[i] = remap[v];
+    }
+
+    free(remap);
+    return next_vertex;
+}
+
+//// SIMPLIFICATION ////
+// Quadric error metric edge collapse (Garland, Heckbert). Vertices only collapse onto one of their neighbours,
+// so a simplified index buffer still uses the original vertex buffer. Vertices on borders, attribute seams
+// (several vertices sharing a position) or non-manifold edges are locked so UV charts and silhouettes hold up.
+
+typedef struct Quadric {
+    f64 a2, b2, c2, d2;
+    f64 ab, ac, ad;
+    f64 bc, bd, cd;
+} Quadric;
+
+static void quadric_add(Quadric *q, const Quadric *other) {
+    q->a2 += other->a2; q->b2 += other->b2; q->c2 += other->c2; q->d2 += other->d2;
+    q->ab += other->ab; q->ac += other->ac; q->ad += other->ad;
+    q->bc += other->bc; q->bd += other->bd; q->cd += other->cd;
+}
+
+    /// Quadric of the plane ax + by + cz + d = 0, scaled by "weight"
+static Quadric quadric_from_plane(f64 a, f64 b, f64 c, f64 d, f64 weight) {
+    Quadric q;
+    q.a2 = a * a * weight; q.b2 = b * b * weight; q.c2 = c * c * weight; q.d2 = d * d * weight;
+    q.ab = a * b * weight; q.ac = a * c * weight; q.ad = a * d * weight;
+    q.bc = b * c * weight; q.bd = b * d * weight; q.cd = c * d * weight;
+    return q;
+}
+
+    /// Sum of the squared distances of "v" to the planes in the quadric
+static f64 quadric_error(const Quadric *q, Vec3 v) {
+    f64 x = v.x, y = v.y, z = v.z;
+    f64 error = q->a2 * x * x + q->b2 * y * y + q->c2 * z * z
+        + 2.0 * (q->ab * x * y + q->ac * x * z + q->bc * y * z)
+        + 2.0 * (q->ad * x + q->bd * y + q->cd * z)
+        + q->d2;
+    return error > 0 ? error : 0;
+}
+
+    /// Open addressing hash table used to weld vertices by position and to count edges.
+    /// Keys can not be ~0.
+typedef struct Simplify_Table {
+    u64 *keys;
+    u32 *values;
+    u32 capacity; // power of two
+} Simplify_Table;
+
+#define SIMPLIFY_TABLE_EMPTY (~0ull)
+
+static void simplify_table_init(Simplify_Table *table, u32 count) {
+    table->capacity = 16;
+    while (table->capacity < count * 2) table->capacity *= 2;
+    table->keys   = malloc(sizeof(u64) * table->capacity);
+    table->values = malloc(sizeof(u32) * table->capacity);
+    memset(table->keys, 0xFF, sizeof(u64) * table->capacity);
+}
+
+static void simplify_table_deinit(Simplify_Table *table) {
+    free(table->keys);
+    free(table->values);
+}
+
+static u64 hash_u64(u64 key) { // murmur3 finaliser
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+    /// Returns the slot of "key", inserting it with "value" if it's not in the table. "is_new" is set accordingly.
+static u32 simplify_table_insert(Simplify_Table *table, u64 key, u32 value, b8 *is_new) {
+    u32 mask = table->capacity - 1;
+    u32 slot = (u32)hash_u64(key) & mask;
+    while (table->keys[slot] != SIMPLIFY_TABLE_EMPTY) {
+        if (table->keys[slot] == key) {
+            *is_new = false;
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    table->keys[slot] = key;
+    table->values[slot] = value;
+    *is_new = true;
+    return slot;
+}
+
+typedef struct Simplify_Collapse {
+    u32 from;
+    u32 to;
+    f32 cost;
+} Simplify_Collapse;
+
+static int simplify_collapse_compare(const void *a, const void *b) {
+    f32 cost_a = ((const Simplify_Collapse*)a)->cost;
+    f32 cost_b = ((const Simplify_Collapse*)b)->cost;
+    return (cost_a > cost_b) - (cost_a < cost_b);
+}
+
+static Vec3 triangle_normal(Vec3 a, Vec3 b, Vec3 c) {
+    return vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+}
+
+u32 se_simplify
+(u32 *result, const u32 *indices, u32 index_count, const Vec3 *positions, u32 position_stride, u32 vert_count,
+ u32 target_index_count, f32 target_error, f32 *result_error) {
+    *result_error = 0;
+    if (index_count < 3 || vert_count == 0) return 0;
+
+        //- Positions, normalised so errors are relative to the size of the mesh
+    Vec3 *local = malloc(sizeof(Vec3) * vert_count);
+    Vec3 min = *overdraw_position(positions, position_stride, indices[0]);
+    Vec3 max = min;
+    for (u32 i = 0; i < index_count; ++i) {
+        Vec3 p = *overdraw_position(positions, position_stride, indices[i]);
+        min = (Vec3) {se_math_min(min.x, p.x), se_math_min(min.y, p.y), se_math_min(min.z, p.z)};
+        max = (Vec3) {se_math_max(max.x, p.x), se_math_max(max.y, p.y), se_math_max(max.z, p.z)};
+    }
+    f32 extent = se_math_max(max.x - min.x, se_math_max(max.y - min.y, max.z - min.z));
+    f32 scale = extent > 0 ? 1.0f / extent : 1.0f;
+    for (u32 v = 0; v < vert_count; ++v) {
+        local[v] = vec3_mul_scalar(vec3_sub(*overdraw_position(positions, position_stride, v), min), scale);
+    }
+
+        //- Weld vertices that share a position
+    u32 *weld = malloc(sizeof(u32) * vert_count);
+    u32 *weld_count = malloc(sizeof(u32) * vert_count);
+    memset(weld_count, 0, sizeof(u32) * vert_count);
+    {
+        Simplify_Table table;
+        simplify_table_init(&table, vert_count);
+        for (u32 v = 0; v < vert_count; ++v) {
+            Vec3 p = *overdraw_position(positions, position_stride, v);
+            u32 bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            u64 key = se_hash_bytes(bits, sizeof(bits), SE_HASH_SEED) & ~(1ull << 63); // never SIMPLIFY_TABLE_EMPTY
+                // linear probe past any colliding vertex that isn't at the same position
+            u32 mask = table.capacity - 1;
+            u32 slot = (u32)hash_u64(key) & mask;
+            while (table.keys[slot] != SIMPLIFY_TABLE_EMPTY) {
+                if (table.keys[slot] == key && memcmp(overdraw_position(positions, position_stride, table.values[slot]), &p, sizeof(Vec3)) == 0) break;
+                slot = (slot + 1) & mask;
+            }
+            if (table.keys[slot] == SIMPLIFY_TABLE_EMPTY) {
+                table.keys[slot] = key;
+                table.values[slot] = v;
+            }
+            weld[v] = table.values[slot];
+            weld_count[weld[v]]++;
+        }
+        simplify_table_deinit(&table);
+    }
+
+        //- Lock vertices on borders and non-manifold edges (edges that don't have exactly two triangles)
+    b8 *is_locked = malloc(sizeof(b8) * vert_count);
+    memset(is_locked, 0, sizeof(b8) * vert_count);
+    {
+        Simplify_Table edges;
+        simplify_table_init(&edges, index_count);
+        for (u32 i = 0; i < index_count; i += 3) {
+            for (u32 k = 0; k < 3; ++k) {
+                u32 a = weld[indices[i + k]];
+                u32 b = weld[indices[i + (k + 1) % 3]];
+                u64 key = a < b ? ((u64)a << 32 | b) : ((u64)b << 32 | a);
+                b8 is_new;
+                u32 slot = simplify_table_insert(&edges, key, 1, &is_new);
+                if (!is_new) edges.values[slot]++;
+            }
+        }
+        for (u32 slot = 0; slot < edges.capacity; ++slot) {
+            if (edges.keys[slot] == SIMPLIFY_TABLE_EMPTY || edges.values[slot] == 2) continue;
+            is_locked[edges.keys[slot] >> 32] = true;
+            is_locked[edges.keys[slot] & 0xFFFFFFFF] = true;
+        }
+        simplify_table_deinit(&edges);
+    }
+
+        //- Quadrics, shared by welded vertices
+    Quadric *quadrics = malloc(sizeof(Quadric) * vert_count);
+    memset(quadrics, 0, sizeof(Quadric) * vert_count);
+    for (u32 i = 0; i < index_count; i += 3) {
+        Vec3 p0 = local[indices[i + 0]];
+        Vec3 n = triangle_normal(p0, local[indices[i + 1]], local[indices[i + 2]]);
+        f32 area = vec3_magnitude(n);
+        if (area <= 0) continue;
+        n = vec3_mul_scalar(n, 1.0f / area);
+        Quadric q = quadric_from_plane(n.x, n.y, n.z, -vec3_dot(n, p0), area);
+        for (u32 k = 0; k < 3; ++k) {
+            quadric_add(&quadrics[weld[indices[i + k]]], &q);
+        }
+    }
+
+        //- Collapse passes
+    u32 *current = malloc(sizeof(u32) * index_count);
+    memcpy(current, indices, sizeof(u32) * index_count);
+    u32 current_count = index_count;
+
+    u32 *remap = malloc(sizeof(u32) * vert_count);
+    b8 *is_touched = malloc(sizeof(b8) * vert_count);
+    u32 *adjacency_offsets = malloc(sizeof(u32) * (vert_count + 1));
+    u32 *adjacency_fill = malloc(sizeof(u32) * vert_count);
+    u32 *adjacency = malloc(sizeof(u32) * index_count);
+    Simplify_Collapse *collapses = malloc(sizeof(Simplify_Collapse) * index_count * 2);
+    f32 max_cost = target_error * target_error;
+    f32 error = 0;
+
+    while (current_count > target_index_count) {
+            // vertex to triangle adjacency
+        memset(adjacency_offsets, 0, sizeof(u32) * (vert_count + 1));
+        for (u32 i = 0; i < current_count; ++i) adjacency_offsets[current[i] + 1]++;
+        for (u32 v = 0; v < vert_count; ++v) adjacency_offsets[v + 1] += adjacency_offsets[v];
+        memcpy(adjacency_fill, adjacency_offsets, sizeof(u32) * vert_count);
+        for (u32 i = 0; i < current_count; ++i) adjacency[adjacency_fill[current[i]]++] = i / 3;
+
+            // every edge can be collapsed in both directions if its source vertex is free
+        u32 collapses_count = 0;
+        for (u32 i = 0; i < current_count; i += 3) {
+            for (u32 k = 0; k < 3; ++k) {
+                u32 a = current[i + k];
+                u32 b = current[i + (k + 1) % 3];
+                u32 edge[2][2] = {{a, b}, {b, a}};
+                for (u32 e = 0; e < 2; ++e) {
+                    u32 from = edge[e][0];
+                    u32 to   = edge[e][1];
+                    if (weld_count[weld[from]] > 1 || is_locked[weld[from]] || weld[from] == weld[to]) continue;
+                    Quadric q = quadrics[weld[from]];
+                    quadric_add(&q, &quadrics[weld[to]]);
+                    collapses[collapses_count++] = (Simplify_Collapse) {from, to, (f32)quadric_error(&q, local[to])};
+                }
+            }
+        }
+        if (collapses_count == 0) break;
+        qsort(collapses, collapses_count, sizeof(Simplify_Collapse), simplify_collapse_compare);
+
+        for (u32 v = 0; v < vert_count; ++v) remap[v] = v;
+        memset(is_touched, 0, sizeof(b8) * vert_count);
+
+        u32 triangles_to_remove = (current_count - target_index_count) / 3;
+        u32 triangles_removed = 0;
+        u32 collapsed = 0;
+        for (u32 c = 0; c < collapses_count && triangles_removed < triangles_to_remove; ++c) {
+            Simplify_Collapse *collapse = &collapses[c];
+            if (collapse->cost > max_cost) break; // sorted, the rest are worse
+            if (is_touched[collapse->from] || is_touched[collapse->to]) continue;
+
+                // don't flip any of the triangles that move
+            b8 is_flipped = false;
+            u32 removed = 0;
+            for (u32 j = adjacency_offsets[collapse->from]; j < adjacency_offsets[collapse->from + 1] && !is_flipped; ++j) {
+                const u32 *tri = &current[adjacency[j] * 3];
+                if (tri[0] == collapse->to || tri[1] == collapse->to || tri[2] == collapse->to) {
+                    removed++;
+                    continue;
+                }
+                Vec3 before[3], after[3];
+                for (u32 k = 0; k < 3; ++k) {
+                    before[k] = local[tri[k]];
+                    after[k]  = local[tri[k] == collapse->from ? collapse->to : tri[k]];
+                }
+                Vec3 normal_before = triangle_normal(before[0], before[1], before[2]);
+                Vec3 normal_after  = triangle_normal(after[0], after[1], after[2]);
+                is_flipped = vec3_dot(normal_before, normal_after) < 0.25f * vec3_magnitude(normal_before) * vec3_magnitude(normal_after);
+            }
+            if (is_flipped) continue;
+
+            remap[collapse->from] = collapse->to;
+            quadric_add(&quadrics[weld[collapse->to]], &quadrics[weld[collapse->from]]);
+            is_touched[collapse->from] = true;
+            is_touched[collapse->to] = true;
+            error = se_math_max(error, collapse->cost);
+            triangles_removed += removed;
+            collapsed++;
+        }
+        if (collapsed == 0) break;
+
+            // apply the collapses and drop the triangles that became degenerate
+        u32 new_count = 0;
+        for (u32 i = 0; i < current_count; i += 3) {
+            u32 a = remap[current[i + 0]];
+            u32 b = remap[current[i + 1]];
+            u32 c = remap[current[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            current[new_count++] = a;
+            current[new_count++] = b;
+            current[new_count++] = c;
+        }
+        current_count = new_count;
+    }
+
+    memcpy(result, current, sizeof(u32) * current_count);
+    *result_error = sqrtf(error);
+
+    free(collapses);
+    free(adjacency);
+    free(adjacency_fill);
+    free(adjacency_offsets);
+    free(is_touched);
+    free(remap);
+    free(current);
+    free(quadrics);
+    free(is_locked);
+    free(weld_count);
+    free(weld);
+    free(local);
+    return current_count;
+}
+
+//// SAVE DATA ////
+
+void se_save_data_optimise(SE_Save_Data_Meshes *save_data) {
+    se_assert(save_data->file_map.data == NULL && "can not optimise a mapped file");
+
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        if (raw_data->type != SE_MESH_TYPE_NORMAL && raw_data->type != SE_MESH_TYPE_SKINNED) continue;
+        if (raw_data->vertex_format != SE_VERTEX_FORMAT_FULL) continue;
+        if (raw_data->index_count == 0 || raw_data->index_count % 3 != 0) continue;
+
+        b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+        void *verts = is_skinned ? (void*)raw_data->skinned_verts : (void*)raw_data->verts;
+        u32 vertex_size = is_skinned ? sizeof(SE_Skinned_Vertex) : sizeof(SE_Vertex3D);
+        const Vec3 *positions = is_skinned ? &raw_data->skinned_verts[0].vert.position : &raw_data->verts[0].position;
+
+        SE_Vertex_Cache_Stats before = se_vertex_cache_analyse(raw_data->indices, raw_data->index_count, raw_data->vert_count, SE_VERTEX_CACHE_ANALYSE_SIZE);
+
+        u32 *cache_optimised = malloc(sizeof(u32) * raw_data->index_count);
+        se_optimise_vertex_cache(cache_optimised, raw_data->indices, raw_data->index_count, raw_data->vert_count);
+        se_optimise_overdraw(raw_data->indices, cache_optimised, raw_data->index_count, positions, vertex_size, raw_data->vert_count, 1.05f);
+        free(cache_optimised);
+
+        void *fetch_optimised = malloc((u64)vertex_size * raw_data->vert_count);
+        u32 old_vert_count = raw_data->vert_count;
+        raw_data->vert_count = se_optimise_vertex_fetch(fetch_optimised, raw_data->indices, raw_data->index_count, verts, raw_data->vert_count, vertex_size);
+        free(verts);
+        if (is_skinned) raw_data->skinned_verts = fetch_optimised;
+        else            raw_data->verts = fetch_optimised;
+
+        SE_Vertex_Cache_Stats after = se_vertex_cache_analyse(raw_data->indices, raw_data->index_count, raw_data->vert_count, SE_VERTEX_CACHE_ANALYSE_SIZE);
+        printf("mesh optimise: mesh %u, %u tris, %u verts (was %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+                i, raw_data->index_count / 3, raw_data->vert_count, old_vert_count,
+                before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+}
+
+void se_save_data_generate_lods(SE_Save_Data_Meshes *save_data, const SE_Mesh_Lod_Settings *settings) {
+    se_assert(save_data->file_map.data == NULL && "can not generate lods for a mapped file");
+    u32 lods_count = se_math_min(settings->lods_count, SE_MESH_LODS_MAX);
+
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        if (raw_data->type != SE_MESH_TYPE_NORMAL && raw_data->type != SE_MESH_TYPE_SKINNED) continue;
+        if (raw_data->vertex_format != SE_VERTEX_FORMAT_FULL) continue;
+        if (raw_data->index_count == 0 || raw_data->index_count % 3 != 0) continue;
+
+        b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+        u32 position_stride = is_skinned ? sizeof(SE_Skinned_Vertex) : sizeof(SE_Vertex3D);
+        const Vec3 *positions = is_skinned ? &raw_data->skinned_verts[0].vert.position : &raw_data->verts[0].position;
+
+        raw_data->lods_count = 1;
+        raw_data->lods[0] = (SE_Mesh_Lod) {0, raw_data->index_count, 0};
+
+            // every lod is simplified from lod 0 and appended to the index buffer. Simplifying from the source instead of
+            // the previous lod means the quadrics, and so the error se_simplify returns, are measured against the source
+            // surface rather than against an already simplified one
+        u32 source_index_count = raw_data->index_count;
+        u32 *lod_indices = malloc(sizeof(u32) * source_index_count);
+        u32 *lod_optimised = malloc(sizeof(u32) * source_index_count);
+        f32 target_ratio = 1.0f;
+        for (u32 l = 1; l < lods_count; ++l) {
+            SE_Mesh_Lod *previous = &raw_data->lods[l - 1];
+            target_ratio *= settings->target_ratio;
+            u32 target_index_count = (u32)(source_index_count * target_ratio) / 3 * 3;
+
+            f32 error;
+            u32 lod_index_count = se_simplify(lod_indices, raw_data->indices, source_index_count,
+                                              positions, position_stride, raw_data->vert_count,
+                                              target_index_count, settings->target_errors[l], &error);
+                // not worth a lod if it barely saves anything
+            if (lod_index_count == 0 || lod_index_count > previous->index_count * 9 / 10) break;
+
+            se_optimise_vertex_cache(lod_optimised, lod_indices, lod_index_count, raw_data->vert_count);
+
+            SE_Mesh_Lod *lod = &raw_data->lods[l];
+            lod->index_offset = raw_data->index_count;
+            lod->index_count = lod_index_count;
+            lod->error = se_math_max(error, previous->error); // a coarser lod never claims to be more accurate
+            raw_data->indices = realloc(raw_data->indices, sizeof(u32) * (raw_data->index_count + lod_index_count));
+            memcpy(&raw_data->indices[lod->index_offset], lod_optimised, sizeof(u32) * lod_index_count);
+            raw_data->index_count += lod_index_count;
+            raw_data->lods_count++;
+
+            printf("mesh lods: mesh %u, lod %u: %u tris (%.1f%% of lod 0), error %.4f\n",
+                    i, l, lod_index_count / 3, 100.0f * lod_index_count / raw_data->lods[0].index_count, lod->error);
+        }
+        free(lod_optimised);
+        free(lod_indices);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SE_MESH_OPTIMISE_H
+#define SE_MESH_OPTIMISE_H
+
+#include "semesh.h"
+
+///
+/// MESH OPTIMISATION
+/// Offline reordering of index and vertex buffers, run by the import pipeline before meshes are saved.
+/// All of the procedures work on triangle lists.
+///
+
+    /// How well an index buffer uses the post-transform vertex cache, simulated with a FIFO cache
+typedef struct SE_Vertex_Cache_Stats {
+    u32 vertices_transformed; // cache misses
+    f32 acmr; // average cache miss ratio, vertices transformed per triangle (0.5 is ideal, 3 is worst)
+    f32 atvr; // average transformed vertex ratio, vertices transformed per unique vertex (1 is ideal)
+} SE_Vertex_Cache_Stats;
+
+#define SE_VERTEX_CACHE_ANALYSE_SIZE 16
+
+SE_Vertex_Cache_Stats se_vertex_cache_analyse(const u32 *indices, u32 index_count, u32 vert_count, u32 cache_size);
+    /// Reorders the triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm).
+    /// "result" must have room for "index_count" indices and can not be "indices".
+void se_optimise_vertex_cache(u32 *result, const u32 *indices, u32 index_count, u32 vert_count);
+    /// Reorders clusters of triangles so the ones facing outwards are drawn first, reducing overdraw.
+    /// "indices" should already be optimised for the vertex cache. Clusters are only split where the cache
+    /// would restart anyway, or where the ACMR stays within "threshold" (eg 1.05) of the input.
+    /// "result" must have room for "index_count" indices and can not be "indices".
+void se_optimise_overdraw
+(u32 *result, const u32 *indices, u32 index_count, const Vec3 *positions, u32 position_stride, u32 vert_count, f32 threshold);
+    /// Reorders the vertices in the order they are first used by "indices" and rewrites the indices to match.
+    /// Unused vertices are dropped. "result" must have room for "vert_count" vertices. Returns the new vertex count.
+u32 se_optimise_vertex_fetch(void *result, u32 *indices, u32 index_count, const void *verts, u32 vert_count, u32 vertex_size);
+
+    /// Simplifies the mesh by collapsing edges until it has at most "target_index_count" indices, or until the next
+    /// collapse would move the surface by more than "target_error" (relative to the size of the mesh, eg 0.01 for 1%).
+    /// The result uses the same vertices. Borders and attribute seams are kept.
+    /// "result" must have room for "index_count" indices. Returns the number of indices in "result".
+u32 se_simplify
+(u32 *result, const u32 *indices, u32 index_count, const Vec3 *positions, u32 position_stride, u32 vert_count,
+ u32 target_index_count, f32 target_error, f32 *result_error);
+
+typedef struct SE_Mesh_Lod_Settings {
+    u32 lods_count;     // including lod 0, at most SE_MESH_LODS_MAX
+    f32 target_ratio;   // triangles of each lod compared to the previous one
+    f32 target_errors[SE_MESH_LODS_MAX]; // max error of each lod against lod 0, relative to the size of the mesh. [0] is unused
+} SE_Mesh_Lod_Settings;
+
+    /// Runs the vertex cache, overdraw and vertex fetch optimisations on every normal and skinned mesh
+    /// in the save data and prints the ACMR/ATVR of each mesh before and after. Must run before packing.
+void se_save_data_optimise(SE_Save_Data_Meshes *save_data);
+    /// Appends simplified lods to the index buffer of every normal and skinned mesh (see SE_Mesh_Lod).
+    /// Stops early for meshes that can't be simplified much further. Must run before packing.
+void se_save_data_generate_lods(SE_Save_Data_Meshes *save_data, const SE_Mesh_Lod_Settings *settings);
+
+#endif // SE_MESH_OPTIMISE_H
@@ -0,0 +1,417 @@
+#include "serender_graph.h"
+
+#include <stdio.h> // printf
+
+void se_render_graph_init(SE_Render_Graph *graph, Vec2 size) {
+    memset(graph, 0, sizeof(SE_Render_Graph));
+    graph->size = size;
+}
+
+void se_render_graph_deinit(SE_Render_Graph *graph) {
+    for (u32 i = 0; i < graph->physicals_count; ++i) {
+        if (graph->physicals[i].allocated) serender_target_deinit(&graph->physicals[i].target);
+    }
+    for (u32 i = 0; i < graph->garbage_count; ++i) {
+        serender_target_deinit(&graph->garbage[i]);
+    }
+    memset(graph, 0, sizeof(SE_Render_Graph));
+}
+
+void se_render_graph_clear(SE_Render_Graph *graph) {
+    graph->passes_count = 0;
+    graph->resources_count = 0;
+    graph->order_count = 0;
+    graph->compiled = false;
+}
+
+void se_render_graph_set_size(SE_Render_Graph *graph, Vec2 size) {
+    graph->size = size;
+}
+
+u32 se_render_graph_add_target(SE_Render_Graph *graph, const char *name, SE_Render_Graph_Target_Desc desc) {
+    se_assert(graph->resources_count < SE_RENDER_GRAPH_MAX_RESOURCES);
+    se_assert(desc.colour_count <= SE_RENDER_TARGET_MAX_TEXTURE);
+    SE_Render_Graph_Resource *resource = &graph->resources[graph->resources_count];
+    memset(resource, 0, sizeof(SE_Render_Graph_Resource));
+    resource->name = name;
+    resource->desc = desc;
+    resource->physical = SE_RENDER_GRAPH_NULL;
+    graph->compiled = false;
+    return graph->resources_count++;
+}
+
+u32 se_render_graph_import_target(SE_Render_Graph *graph, const char *name, SE_Render_Target *target) {
+    SE_Render_Graph_Target_Desc desc = {0};
+    u32 result = se_render_graph_add_target(graph, name, desc);
+    graph->resources[result].imported = true;
+    graph->resources[result].target = target;
+    return result;
+}
+
+u32 se_render_graph_add_pass
+(SE_Render_Graph *graph, const char *name, u32 output, GLbitfield clear, SE_Render_Graph_Execute execute, void *user_data) {
+    se_assert(graph->passes_count < SE_RENDER_GRAPH_MAX_PASSES);
+    se_assert(output < graph->resources_count);
+    SE_Render_Graph_Pass *pass = &graph->passes[graph->passes_count];
+    memset(pass, 0, sizeof(SE_Render_Graph_Pass));
+    pass->name = name;
+    pass->execute = execute;
+    pass->user_data = user_data;
+    pass->output = output;
+    pass->clear = clear;
+    graph->compiled = false;
+    return graph->passes_count++;
+}
+
+void se_render_graph_read(SE_Render_Graph *graph, u32 pass, u32 resource, u32 attachments) {
+    se_assert(pass < graph->passes_count && resource < graph->resources_count);
+    SE_Render_Graph_Pass *p = &graph->passes[pass];
+    se_assert(p->reads_count < SE_RENDER_GRAPH_MAX_PASS_READS);
+    se_assert(resource != p->output && "a pass can't read the target it draws to");
+    p->reads[p->reads_count] = resource;
+    p->read_attachments[p->reads_count] = attachments;
+    p->reads_count++;
+    graph->compiled = false;
+}
+
+    /// Bytes per texel of a colour buffer
+static u32 render_graph_texel_bytes(GLint internal_format) {
+    switch (internal_format) {
+        case GL_R8: return 1;
+        case GL_RG8: case GL_R16F: return 2;
+        case GL_RGB: case GL_RGB8: case GL_RGBA: case GL_RGBA8: // rgb is padded
+        case GL_R11F_G11F_B10F: case GL_RGB10_A2: case GL_R32F: case GL_RG16F: return 4;
+        case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: return 8;
+        case GL_RGB32F: case GL_RGBA32F: return 16;
+    }
+    return 4;
+}
+
+u64 se_render_graph_target_bytes(SE_Render_Graph_Target_Desc desc, u32 colour_count, Vec2 size) {
+    u64 texels = (u64)size.x * (u64)size.y;
+    u64 result = texels * render_graph_texel_bytes(desc.config.internal_format) * colour_count;
+    if (desc.has_depth) result += texels * 4;
+    return result;
+}
+
+static Vec2 render_graph_target_size(const SE_Render_Graph *graph, f32 scale) {
+    return v2f(
+        se_math_max((i32)(graph->size.x * scale), 1),
+        se_math_max((i32)(graph->size.y * scale), 1));
+}
+
+static b8 render_graph_descs_match(SE_Render_Graph_Target_Desc a, SE_Render_Graph_Target_Desc b) {
+    return a.scale == b.scale
+        && a.colour_count == b.colour_count
+        && a.has_depth == b.has_depth
+        && a.config.internal_format == b.config.internal_format
+        && a.config.format == b.config.format
+        && a.config.type == b.config.type
+        && a.config.wrap == b.config.wrap
+        && a.config.filter == b.config.filter;
+}
+
+b8 se_render_graph_compile(SE_Render_Graph *graph) {
+    u32 passes_count = graph->passes_count;
+    u32 resources_count = graph->resources_count;
+    graph->compiled = false;
+    graph->order_count = 0;
+
+        //- Dependencies (a bit per pass that has to run first)
+    u32 depends_on[SE_RENDER_GRAPH_MAX_PASSES] = {0};
+    for (u32 p = 0; p < passes_count; ++p) {
+        const SE_Render_Graph_Pass *pass = &graph->passes[p];
+            // passes that write the same target keep the order they were added in
+        for (u32 w = 0; w < p; ++w) {
+            if (graph->passes[w].output == pass->output) depends_on[p] |= 1u << w;
+        }
+            // a read depends on the writers added before it, or on every writer if none were
+        for (u32 r = 0; r < pass->reads_count; ++r) {
+            u32 earlier_writers = 0;
+            u32 writers = 0;
+            for (u32 w = 0; w < passes_count; ++w) {
+                if (w == p || graph->passes[w].output != pass->reads[r]) continue;
+                writers |= 1u << w;
+                if (w < p) earlier_writers |= 1u << w;
+            }
+            depends_on[p] |= earlier_writers ? earlier_writers : writers;
+        }
+    }
+
+        //- Order (topological, passes that are ready run in the order they were added)
+    u32 sorted[SE_RENDER_GRAPH_MAX_PASSES];
+    u32 sorted_count = 0;
+    u32 done = 0;
+    while (sorted_count < passes_count) {
+        u32 next = SE_RENDER_GRAPH_NULL;
+        for (u32 p = 0; p < passes_count; ++p) {
+            if ((done & (1u << p)) == 0 && (depends_on[p] & ~done) == 0) {
+                next = p;
+                break;
+            }
+        }
+        if (next == SE_RENDER_GRAPH_NULL) {
+            printf("render graph: the passes depend on each other in a cycle\n");
+            return false;
+        }
+        done |= 1u << next;
+        sorted[sorted_count++] = next;
+    }
+
+        //- Culling (walk back from the imported resources)
+    u32 needed = 0; // a bit per resource
+    for (u32 r = 0; r < resources_count; ++r) {
+        if (graph->resources[r].imported) needed |= 1u << r;
+    }
+    for (i32 i = sorted_count - 1; i >= 0; --i) {
+        SE_Render_Graph_Pass *pass = &graph->passes[sorted[i]];
+        pass->culled = (needed & (1u << pass->output)) == 0;
+        if (pass->culled) continue;
+        for (u32 r = 0; r < pass->reads_count; ++r) {
+            needed |= 1u << pass->reads[r];
+        }
+    }
+    for (u32 i = 0; i < sorted_count; ++i) {
+        if (!graph->passes[sorted[i]].culled) graph->order[graph->order_count++] = sorted[i];
+    }
+
+        //- Lifetimes and the colour buffers that are read
+    for (u32 r = 0; r < resources_count; ++r) {
+        SE_Render_Graph_Resource *resource = &graph->resources[r];
+        resource->first_use = SE_RENDER_GRAPH_NULL;
+        resource->last_use = 0;
+        resource->colour_count = 0;
+        resource->physical = SE_RENDER_GRAPH_NULL;
+    }
+    for (u32 i = 0; i < graph->order_count; ++i) {
+        const SE_Render_Graph_Pass *pass = &graph->passes[graph->order[i]];
+        for (i32 r = -1; r < (i32)pass->reads_count; ++r) {
+            SE_Render_Graph_Resource *resource = &graph->resources[r < 0 ? pass->output : pass->reads[r]];
+            if (resource->first_use == SE_RENDER_GRAPH_NULL) resource->first_use = i;
+            resource->last_use = i;
+            if (r >= 0) {
+                u32 attachments = pass->read_attachments[r];
+                u32 count = 0;
+                while (attachments >> count) count++; // up to the highest bit
+                resource->colour_count = se_math_max(resource->colour_count, count);
+            }
+        }
+    }
+
+        //- Pooling and aliasing
+    // transient resources in the order they're first used. A pooled target is free once the last pass that
+    // uses its resource is done, the next resource with the same format can have it.
+    for (u32 i = 0; i < graph->physicals_count; ++i) {
+        graph->physicals[i].used = false;
+    }
+    graph->unaliased_bytes = 0;
+    for (u32 i = 0; i < graph->order_count; ++i) {
+        for (u32 r = 0; r < resources_count; ++r) {
+            SE_Render_Graph_Resource *resource = &graph->resources[r];
+            if (resource->imported || resource->first_use != i) continue;
+            graph->unaliased_bytes += se_render_graph_target_bytes(resource->desc, resource->desc.colour_count,
+                render_graph_target_size(graph, resource->desc.scale));
+
+            SE_Render_Graph_Target_Desc desc = resource->desc;
+            desc.colour_count = se_math_min(resource->colour_count, resource->desc.colour_count);
+            u32 physical = SE_RENDER_GRAPH_NULL;
+            for (u32 p = 0; p < graph->physicals_count; ++p) {
+                SE_Render_Graph_Physical *candidate = &graph->physicals[p];
+                if (!render_graph_descs_match(candidate->desc, desc)) continue;
+                if (candidate->used && candidate->free_after >= i) continue;
+                physical = p;
+                if (candidate->used) break; // already in use this frame, best to share it
+            }
+            if (physical == SE_RENDER_GRAPH_NULL) {
+                se_assert(graph->physicals_count < SE_RENDER_GRAPH_MAX_RESOURCES);
+                physical = graph->physicals_count++;
+                memset(&graph->physicals[physical], 0, sizeof(SE_Render_Graph_Physical));
+                graph->physicals[physical].desc = desc;
+            }
+            graph->physicals[physical].used = true;
+            graph->physicals[physical].free_after = resource->last_use;
+            resource->physical = physical;
+        }
+    }
+
+        //- Drop the pooled targets nobody uses anymore (freed by the next execute)
+    u32 remap[SE_RENDER_GRAPH_MAX_RESOURCES];
+    u32 kept = 0;
+    for (u32 p = 0; p < graph->physicals_count; ++p) {
+        SE_Render_Graph_Physical *physical = &graph->physicals[p];
+        if (!physical->used) {
+            if (physical->allocated) {
+                se_assert(graph->garbage_count < SE_RENDER_GRAPH_MAX_RESOURCES);
+                graph->garbage[graph->garbage_count++] = physical->target;
+            }
+            remap[p] = SE_RENDER_GRAPH_NULL;
+            continue;
+        }
+        remap[p] = kept;
+        graph->physicals[kept++] = *physical;
+    }
+    graph->physicals_count = kept;
+    for (u32 r = 0; r < resources_count; ++r) {
+        SE_Render_Graph_Resource *resource = &graph->resources[r];
+        if (resource->physical != SE_RENDER_GRAPH_NULL) resource->physical = remap[resource->physical];
+    }
+
+    graph->peak_bytes = 0;
+    for (u32 p = 0; p < graph->physicals_count; ++p) {
+        const SE_Render_Graph_Physical *physical = &graph->physicals[p];
+        graph->peak_bytes += se_render_graph_target_bytes(physical->desc, physical->desc.colour_count,
+            render_graph_target_size(graph, physical->desc.scale));
+    }
+
+    graph->compiled = true;
+    return true;
+}
+
+void se_render_graph_execute(SE_Render_Graph *graph) {
+    se_assert(graph->compiled && "call se_render_graph_compile after changing the graph");
+
+        //- Pooled targets
+    graph->peak_bytes = 0; // at the current size
+    for (u32 i = 0; i < graph->garbage_count; ++i) {
+        serender_target_deinit(&graph->garbage[i]);
+    }
+    graph->garbage_count = 0;
+    for (u32 p = 0; p < graph->physicals_count; ++p) {
+        SE_Render_Graph_Physical *physical = &graph->physicals[p];
+        Vec2 size = render_graph_target_size(graph, physical->desc.scale);
+        if (physical->allocated && (physical->size.x != size.x || physical->size.y != size.y)) {
+            serender_target_deinit(&physical->target);
+            physical->allocated = false;
+        }
+        if (!physical->allocated) {
+            serender_target_init_ext(&physical->target, size, physical->desc.colour_count, physical->desc.has_depth,
+                physical->desc.config);
+            physical->size = size;
+            physical->allocated = true;
+        }
+        graph->peak_bytes += se_render_graph_target_bytes(physical->desc, physical->desc.colour_count, size);
+    }
+
+        //- Passes
+    for (u32 i = 0; i < graph->order_count; ++i) {
+        SE_Render_Graph_Pass *pass = &graph->passes[graph->order[i]];
+        const SE_Render_Target *target = se_render_graph_get_target(graph, pass->output);
+        if (target == NULL) {
+            se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, graph->size.x, graph->size.y);
+        } else {
+            serender_target_use((SE_Render_Target *)target);
+        }
+        if (pass->clear) glClear(pass->clear);
+        pass->execute(graph, graph->order[i], pass->user_data);
+    }
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const SE_Render_Target *se_render_graph_get_target(const SE_Render_Graph *graph, u32 resource) {
+    se_assert(resource < graph->resources_count);
+    const SE_Render_Graph_Resource *r = &graph->resources[resource];
+    if (r->imported) return r->target;
+    if (r->physical == SE_RENDER_GRAPH_NULL) return NULL; // culled
+    return &graph->physicals[r->physical].target;
+}
+
+void se_render_graph_print(const SE_Render_Graph *graph) {
+    printf("render graph: %u passes (%u culled), %u resources, %u pooled targets\n",
+        graph->order_count, graph->passes_count - graph->order_count, graph->resources_count, graph->physicals_count);
+    for (u32 i = 0; i < graph->order_count; ++i) {
+        const SE_Render_Graph_Pass *pass = &graph->passes[graph->order[i]];
+        printf("  %u: %s -> %s\n", i, pass->name, graph->resources[pass->output].name);
+    }
+    for (u32 p = 0; p < graph->passes_count; ++p) {
+        if (graph->passes[p].culled) printf("  culled: %s\n", graph->passes[p].name);
+    }
+    for (u32 r = 0; r < graph->resources_count; ++r) {
+        const SE_Render_Graph_Resource *resource = &graph->resources[r];
+        if (resource->imported) continue;
+        if (resource->physical == SE_RENDER_GRAPH_NULL) {
+            printf("  %s: unused\n", resource->name);
+        } else {
+            printf("  %s: pooled target %u, passes %u to %u, %u of %u colour buffers\n", resource->name, resource->physical,
+                resource->first_use, resource->last_use, graph->physicals[resource->physical].desc.colour_count,
+                resource->desc.colour_count);
+        }
+    }
+    printf("  peak memory: %.2f mb (%.2f mb without pooling)\n",
+        graph->peak_bytes / (1024.0 * 1024.0), graph->unaliased_bytes / (1024.0 * 1024.0));
+}
+
+//- SELF TEST
+
+static b8 render_graph_expect(b8 condition, const char *what) {
+    if (!condition) printf("render graph self test: FAILED %s\n", what);
+    return condition;
+}
+
+static void render_graph_self_test_pass(SE_Render_Graph *graph, u32 pass, void *user_data) {
+    (void)graph; (void)pass; (void)user_data; // the self test only compiles the graph, nothing is drawn
+}
+
+b8 se_render_graph_self_test(void) {
+    b8 passed = true;
+    SE_Render_Target_Config hdr = {GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_CLAMP_TO_EDGE, GL_LINEAR};
+    SE_Render_Graph_Target_Desc colour_desc = {1.0f, 1, false, hdr};
+    SE_Render_Graph_Target_Desc depth_desc  = {1.0f, 1, true, hdr};
+
+    SE_Render_Graph graph;
+    se_render_graph_init(&graph, v2f(1920, 1080));
+
+        //- Build
+    // a chain of blurs between the scene and the backbuffer, plus a debug view nobody reads.
+    // the passes are added out of order so the order has to come from the reads
+    u32 backbuffer = se_render_graph_import_target(&graph, "backbuffer", NULL);
+    u32 scene = se_render_graph_add_target(&graph, "scene", depth_desc);
+    u32 blur_a = se_render_graph_add_target(&graph, "blur a", colour_desc);
+    u32 blur_b = se_render_graph_add_target(&graph, "blur b", colour_desc);
+    u32 blur_c = se_render_graph_add_target(&graph, "blur c", colour_desc);
+    u32 debug = se_render_graph_add_target(&graph, "debug", colour_desc);
+
+    u32 tonemap_pass = se_render_graph_add_pass(&graph, "tonemap", backbuffer, 0, render_graph_self_test_pass, NULL);
+    se_render_graph_read(&graph, tonemap_pass, blur_c, 1);
+    u32 blur_c_pass = se_render_graph_add_pass(&graph, "blur c", blur_c, 0, render_graph_self_test_pass, NULL);
+    se_render_graph_read(&graph, blur_c_pass, blur_b, 1);
+    u32 blur_a_pass = se_render_graph_add_pass(&graph, "blur a", blur_a, 0, render_graph_self_test_pass, NULL);
+    se_render_graph_read(&graph, blur_a_pass, scene, 1);
+    u32 debug_pass = se_render_graph_add_pass(&graph, "debug", debug, 0, render_graph_self_test_pass, NULL);
+    se_render_graph_read(&graph, debug_pass, scene, 1);
+    u32 scene_pass = se_render_graph_add_pass(&graph, "scene", scene, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, render_graph_self_test_pass, NULL);
+    u32 blur_b_pass = se_render_graph_add_pass(&graph, "blur b", blur_b, 0, render_graph_self_test_pass, NULL);
+    se_render_graph_read(&graph, blur_b_pass, blur_a, 1);
+
+        //- Order and culling
+    passed &= render_graph_expect(se_render_graph_compile(&graph), "the graph compiles");
+    u32 expected_order[5] = {scene_pass, blur_a_pass, blur_b_pass, blur_c_pass, tonemap_pass};
+    b8 is_ordered = graph.order_count == 5;
+    for (u32 i = 0; i < 5 && is_ordered; ++i) {
+        if (graph.order[i] != expected_order[i]) is_ordered = false;
+    }
+    passed &= render_graph_expect(is_ordered, "the passes run in the order of their reads");
+    passed &= render_graph_expect(graph.passes[debug_pass].culled, "the pass nobody reads from is culled");
+    passed &= render_graph_expect(!graph.passes[scene_pass].culled && !graph.passes[tonemap_pass].culled, "the passes that lead to the backbuffer are kept");
+    passed &= render_graph_expect(graph.resources[debug].physical == SE_RENDER_GRAPH_NULL, "the culled pass' target isn't pooled");
+
+        //- Pooling
+    // blur a is done before blur c is written, so they can share. The others are alive at the same time or differ in format
+    const SE_Render_Graph_Resource *resources = graph.resources;
+    passed &= render_graph_expect(resources[blur_a].physical != SE_RENDER_GRAPH_NULL
+                               && resources[blur_a].physical == resources[blur_c].physical, "targets that don't overlap share a pooled target");
+    passed &= render_graph_expect(resources[blur_a].physical != resources[blur_b].physical
+                               && resources[blur_b].physical != resources[blur_c].physical, "targets that overlap don't share");
+    passed &= render_graph_expect(resources[scene].physical != resources[blur_a].physical
+                               && resources[scene].physical != resources[blur_b].physical, "targets with different formats don't share");
+    passed &= render_graph_expect(graph.physicals_count == 3, "three pooled targets cover the four transient targets");
+    passed &= render_graph_expect(graph.peak_bytes < graph.unaliased_bytes, "pooling saves memory");
+
+        //- Cycles
+    se_render_graph_read(&graph, scene_pass, blur_c, 1);
+    passed &= render_graph_expect(!se_render_graph_compile(&graph), "a cycle fails to compile");
+
+    se_render_graph_deinit(&graph); // nothing was executed, so there's nothing on the GPU to free
+    printf("render graph self test: %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
@@ -0,0 +1,125 @@
+#ifndef SERENDER_GRAPH_H
+#define SERENDER_GRAPH_H
+
+#include "sedefines.h"
+#include "semath.h"
+#include "serender_target.h"
+
+///
+/// RENDER GRAPH
+/// The passes of a frame and the render targets they read and write. Each pass draws to one target and can read
+/// from any number of others. se_render_graph_compile works out the order the passes run in, culls the ones nobody
+/// reads from, and gives each transient target a pooled render target. Targets whose lifetimes don't overlap
+/// share the same pooled target if their formats match. Compiling doesn't touch OpenGL, so the scheduling can run
+/// without a context. se_render_graph_execute (re)allocates the pooled targets (eg after se_render_graph_set_size)
+/// and runs the passes.
+///
+
+#define SE_RENDER_GRAPH_MAX_PASSES 32
+#define SE_RENDER_GRAPH_MAX_RESOURCES 32
+#define SE_RENDER_GRAPH_MAX_PASS_READS 8
+#define SE_RENDER_GRAPH_NULL 0xFFFFFFFF
+
+typedef struct SE_Render_Graph SE_Render_Graph;
+    /// Called with the pass' target bound, its viewport set and the clear done
+typedef void (*SE_Render_Graph_Execute)(SE_Render_Graph *graph, u32 pass, void *user_data);
+
+typedef struct SE_Render_Graph_Target_Desc {
+    f32 scale;         // of the graph's size, eg 0.5 for half resolution
+    u32 colour_count;  // the most colour buffers the target can have, the ones no pass reads are dropped
+    b8 has_depth;
+    SE_Render_Target_Config config;
+} SE_Render_Graph_Target_Desc;
+
+typedef struct SE_Render_Graph_Resource {
+    const char *name;
+    SE_Render_Graph_Target_Desc desc;
+    b8 imported;               // owned by the user, never pooled and always needed
+    SE_Render_Target *target;  // of imported resources, NULL for the default framebuffer
+
+        // compiled
+    u32 first_use;  // in execution order
+    u32 last_use;
+    u32 colour_count;          // the colour buffers that are actually read
+    u32 physical;              // index into the pool, or SE_RENDER_GRAPH_NULL
+} SE_Render_Graph_Resource;
+
+typedef struct SE_Render_Graph_Pass {
+    const char *name;
+    SE_Render_Graph_Execute execute;
+    void *user_data;
+    u32 output;       // the resource it draws to
+    GLbitfield clear; // eg GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 0 keeps the contents
+    u32 reads_count;
+    u32 reads[SE_RENDER_GRAPH_MAX_PASS_READS];
+    u32 read_attachments[SE_RENDER_GRAPH_MAX_PASS_READS]; // bit per colour buffer
+
+        // compiled
+    b8 culled;
+} SE_Render_Graph_Pass;
+
+    /// A render target in the pool. Transient resources are given one of these by se_render_graph_compile.
+typedef struct SE_Render_Graph_Physical {
+    SE_Render_Graph_Target_Desc desc; // colour_count is what the resources need, not what they asked for
+    u32 free_after;     // the last use of the resource that has it, while compiling
+    b8 used;            // by the current compile
+    b8 allocated;
+    Vec2 size;          // allocated size
+    SE_Render_Target target;
+} SE_Render_Graph_Physical;
+
+struct SE_Render_Graph {
+    Vec2 size; // of the default framebuffer, transient targets are scaled from this
+
+    u32 passes_count;
+    SE_Render_Graph_Pass passes[SE_RENDER_GRAPH_MAX_PASSES];
+    u32 resources_count;
+    SE_Render_Graph_Resource resources[SE_RENDER_GRAPH_MAX_RESOURCES];
+
+    u32 physicals_count;
+    SE_Render_Graph_Physical physicals[SE_RENDER_GRAPH_MAX_RESOURCES];
+    u32 garbage_count; // pooled targets the last compile didn't need, freed by the next execute
+    SE_Render_Target garbage[SE_RENDER_GRAPH_MAX_RESOURCES];
+
+        // compiled
+    b8 compiled;
+    u32 order_count;  // passes that aren't culled
+    u32 order[SE_RENDER_GRAPH_MAX_PASSES];
+    u64 peak_bytes;       // the pooled targets at the graph's size
+    u64 unaliased_bytes;  // if every transient resource had its own target with all of the colour buffers it asked for
+};
+
+void se_render_graph_init(SE_Render_Graph *graph, Vec2 size);
+    /// Frees the pooled targets
+void se_render_graph_deinit(SE_Render_Graph *graph);
+    /// Removes the passes and resources, keeps the pooled targets for the next compile
+void se_render_graph_clear(SE_Render_Graph *graph);
+    /// The transient targets are reallocated at the next execute if their size changed
+void se_render_graph_set_size(SE_Render_Graph *graph, Vec2 size);
+
+    //- Building (returns the index of the resource or pass)
+u32 se_render_graph_add_target(SE_Render_Graph *graph, const char *name, SE_Render_Graph_Target_Desc desc);
+    /// A target owned by the user, NULL for the default framebuffer. Passes that lead to it are never culled.
+u32 se_render_graph_import_target(SE_Render_Graph *graph, const char *name, SE_Render_Target *target);
+u32 se_render_graph_add_pass
+(SE_Render_Graph *graph, const char *name, u32 output, GLbitfield clear, SE_Render_Graph_Execute execute, void *user_data);
+    /// The pass reads the colour buffers in "attachments" (a bit each) of the resource
+void se_render_graph_read(SE_Render_Graph *graph, u32 pass, u32 resource, u32 attachments);
+
+    /// Orders the passes so each one runs after the passes that write what it reads (passes that write the same
+    /// resource run in the order they were added), culls the passes that don't lead to an imported resource, and assigns
+    /// the pooled targets. Doesn't call OpenGL. Returns false if the passes depend on each other in a cycle.
+b8 se_render_graph_compile(SE_Render_Graph *graph);
+    /// Allocates the pooled targets that are missing or the wrong size, frees the unused ones, and runs the passes
+void se_render_graph_execute(SE_Render_Graph *graph);
+    /// The render target of the resource, valid while the graph executes. NULL for the default framebuffer.
+const SE_Render_Target *se_render_graph_get_target(const SE_Render_Graph *graph, u32 resource);
+    /// The bytes of a target of the given format and size (an estimate of what the driver allocates)
+u64 se_render_graph_target_bytes(SE_Render_Graph_Target_Desc desc, u32 colour_count, Vec2 size);
+    /// Prints the execution order, which passes were culled, the pooled targets and the peak memory
+void se_render_graph_print(const SE_Render_Graph *graph);
+    /// Compiles a small graph on the CPU and checks the pass order, the culled passes and which targets share a pooled one.
+    /// Prints what failed.
+b8 se_render_graph_self_test(void);
+
+#endif // SERENDER_GRAPH_H
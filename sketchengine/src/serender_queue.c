@@ -0,0 +1,203 @@
+#include "serender_queue.h"
+
+#include <stdio.h> // printf
+
+void se_render_queue_init(SE_Render_Queue *queue, u32 capacity) {
+    memset(queue, 0, sizeof(SE_Render_Queue));
+    queue->capacity      = capacity;
+    queue->items         = malloc(capacity * sizeof(SE_Render_Item));
+    queue->items_scratch = malloc(capacity * sizeof(SE_Render_Item));
+    queue->transforms    = malloc(capacity * sizeof(Mat4));
+    queue->animators     = malloc(capacity * sizeof(u32));
+    queue->batch         = malloc(capacity * sizeof(Mat4));
+}
+
+void se_render_queue_deinit(SE_Render_Queue *queue) {
+    free(queue->items);
+    free(queue->items_scratch);
+    free(queue->transforms);
+    free(queue->animators);
+    free(queue->batch);
+    memset(queue, 0, sizeof(SE_Render_Queue));
+}
+
+void se_render_queue_clear(SE_Render_Queue *queue) {
+    queue->items_count = 0;
+    queue->transforms_count = 0;
+}
+
+u32 se_render_queue_add_transform(SE_Render_Queue *queue, Mat4 transform, u32 animator_index) {
+    if (queue->transforms_count >= queue->capacity) return SE_RENDER_QUEUE_FULL;
+    queue->transforms[queue->transforms_count] = transform;
+    queue->animators[queue->transforms_count] = animator_index;
+    return queue->transforms_count++;
+}
+
+b8 se_render_queue_push(SE_Render_Queue *queue, u64 key, u32 mesh_index, u32 transform_index) {
+    if (queue->items_count >= queue->capacity) return false;
+    se_assert(transform_index < queue->transforms_count);
+    queue->items[queue->items_count++] = (SE_Render_Item) {key, mesh_index, transform_index};
+    return true;
+}
+
+void se_render_queue_sort(SE_Render_Queue *queue) {
+    SE_Render_Item *src = queue->items;
+    SE_Render_Item *dst = queue->items_scratch;
+    u32 count = queue->items_count;
+    if (count <= 1) return;
+
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        u32 offsets[256] = {0};
+        for (u32 i = 0; i < count; ++i) {
+            offsets[(src[i].key >> shift) & 0xFF]++;
+        }
+        if (offsets[(src[0].key >> shift) & 0xFF] == count) continue; // every key has the same byte here
+
+        u32 offset = 0;
+        for (u32 b = 0; b < 256; ++b) {
+            u32 bucket_count = offsets[b];
+            offsets[b] = offset;
+            offset += bucket_count;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        SE_Render_Item *temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    queue->items = src;
+    queue->items_scratch = dst;
+}
+
+    /// The top bits of a non-negative float keep their order when compared as integers
+static u64 render_key_depth(f32 depth) {
+    if (!(depth > 0)) return 0; // also catches NaN
+    u32 bits;
+    memcpy(&bits, &depth, sizeof(u32));
+    return bits >> (32 - SE_RENDER_KEY_DEPTH_BITS);
+}
+
+u64 se_render_key(b8 transparent, u32 shader_index, u32 material_index, u32 mesh_index, f32 depth) {
+    se_assert(shader_index   < (1 << SE_RENDER_KEY_SHADER_BITS));
+    se_assert(material_index < (1 << SE_RENDER_KEY_MATERIAL_BITS));
+    se_assert(mesh_index     < (1 << SE_RENDER_KEY_MESH_BITS));
+
+    u64 state = shader_index;
+    state = (state << SE_RENDER_KEY_MATERIAL_BITS) | material_index;
+    state = (state << SE_RENDER_KEY_MESH_BITS)     | mesh_index;
+    u64 depth_bits = render_key_depth(depth);
+
+    const u32 state_bits = SE_RENDER_KEY_SHADER_BITS + SE_RENDER_KEY_MATERIAL_BITS + SE_RENDER_KEY_MESH_BITS;
+    const u32 unused_bits = 64 - 1 - state_bits - SE_RENDER_KEY_DEPTH_BITS;
+    u64 key;
+    if (transparent) {
+        u64 far_first = ((u64)1 << SE_RENDER_KEY_DEPTH_BITS) - 1 - depth_bits;
+        key = ((u64)1 << 63) | (far_first << (state_bits + unused_bits)) | (state << unused_bits);
+    } else {
+        key = (state << (SE_RENDER_KEY_DEPTH_BITS + unused_bits)) | (depth_bits << unused_bits);
+    }
+    return key;
+}
+
+b8 se_render_key_is_transparent(u64 key) {
+    return (key >> 63) != 0;
+}
+
+//- SELF TEST
+
+static b8 render_queue_expect(b8 condition, const char *what) {
+    if (!condition) printf("render queue self test: FAILED %s\n", what);
+    return condition;
+}
+
+    /// The field "bits" wide that starts "shift" bits from the bottom of the key
+static u32 render_key_field(u64 key, u32 shift, u32 bits) {
+    return (u32)((key >> shift) & (((u64)1 << bits) - 1));
+}
+
+b8 se_render_queue_self_test(void) {
+    b8 passed = true;
+    const u32 state_bits = SE_RENDER_KEY_SHADER_BITS + SE_RENDER_KEY_MATERIAL_BITS + SE_RENDER_KEY_MESH_BITS;
+    const u32 unused_bits = 64 - 1 - state_bits - SE_RENDER_KEY_DEPTH_BITS;
+    const u32 max_shader   = (1 << SE_RENDER_KEY_SHADER_BITS) - 1;
+    const u32 max_material = (1 << SE_RENDER_KEY_MATERIAL_BITS) - 1;
+    const u32 max_mesh     = (1 << SE_RENDER_KEY_MESH_BITS) - 1;
+
+        //- Packing
+    // every field reads back from where the layout in serender_queue.h says it is, even at its largest value
+    u64 opaque = se_render_key(false, max_shader, 1, max_mesh, 0);
+    u32 mesh_shift = unused_bits + SE_RENDER_KEY_DEPTH_BITS;
+    passed &= render_queue_expect(!se_render_key_is_transparent(opaque), "opaque keys have the pass bit clear");
+    passed &= render_queue_expect(render_key_field(opaque, mesh_shift, SE_RENDER_KEY_MESH_BITS) == max_mesh, "opaque mesh bits");
+    passed &= render_queue_expect(render_key_field(opaque, mesh_shift + SE_RENDER_KEY_MESH_BITS, SE_RENDER_KEY_MATERIAL_BITS) == 1, "opaque material bits");
+    passed &= render_queue_expect(render_key_field(opaque, mesh_shift + SE_RENDER_KEY_MESH_BITS + SE_RENDER_KEY_MATERIAL_BITS, SE_RENDER_KEY_SHADER_BITS) == max_shader, "opaque shader bits");
+    passed &= render_queue_expect(render_key_field(opaque, 0, unused_bits + SE_RENDER_KEY_DEPTH_BITS) == 0, "opaque depth 0 leaves the depth bits clear");
+
+    u64 transparent = se_render_key(true, 1, max_material, 2, 0);
+    passed &= render_queue_expect(se_render_key_is_transparent(transparent), "transparent keys have the pass bit set");
+    passed &= render_queue_expect(render_key_field(transparent, unused_bits, SE_RENDER_KEY_MESH_BITS) == 2, "transparent mesh bits");
+    passed &= render_queue_expect(render_key_field(transparent, unused_bits + SE_RENDER_KEY_MESH_BITS, SE_RENDER_KEY_MATERIAL_BITS) == max_material, "transparent material bits");
+    passed &= render_queue_expect(render_key_field(transparent, unused_bits + SE_RENDER_KEY_MESH_BITS + SE_RENDER_KEY_MATERIAL_BITS, SE_RENDER_KEY_SHADER_BITS) == 1, "transparent shader bits");
+    passed &= render_queue_expect(render_key_field(transparent, unused_bits + state_bits, SE_RENDER_KEY_DEPTH_BITS) == ((u32)1 << SE_RENDER_KEY_DEPTH_BITS) - 1, "transparent depth 0 sorts last");
+    passed &= render_queue_expect(render_key_field(se_render_key(false, 3, 4, 5, 1e30f), 0, unused_bits) == 0
+                               && render_key_field(se_render_key(true, 3, 4, 5, 1e30f), 0, unused_bits) == 0, "the unused bits stay clear");
+
+        //- Order
+    passed &= render_queue_expect(se_render_key(false, 1, 9, 9, 1000.0f) < se_render_key(false, 2, 0, 0, 0.0f), "opaque keys sort by shader before depth");
+    passed &= render_queue_expect(se_render_key(false, 1, 1, 9, 1000.0f) < se_render_key(false, 1, 2, 0, 0.0f), "opaque keys sort by material before depth");
+    passed &= render_queue_expect(se_render_key(false, 1, 1, 1, 0.5f) < se_render_key(false, 1, 1, 1, 2.0f), "opaque keys sort front to back");
+    passed &= render_queue_expect(se_render_key(true, 1, 1, 1, 2.0f) < se_render_key(true, 1, 1, 1, 0.5f), "transparent keys sort back to front");
+    passed &= render_queue_expect(se_render_key(true, 9, 9, 9, 2.0f) < se_render_key(true, 0, 0, 0, 0.5f), "transparent keys sort by depth before state");
+    passed &= render_queue_expect(se_render_key(false, max_shader, max_material, max_mesh, 1e30f) < se_render_key(true, 0, 0, 0, 1e30f), "opaque keys sort before transparent ones");
+    u32 nan_bits = 0x7FC00000;
+    f32 nan_depth;
+    memcpy(&nan_depth, &nan_bits, sizeof(f32));
+    passed &= render_queue_expect(se_render_key(false, 1, 1, 1, -5.0f) == se_render_key(false, 1, 1, 1, 0.0f)
+                               && se_render_key(false, 1, 1, 1, nan_depth) == se_render_key(false, 1, 1, 1, 0.0f), "negative and NaN depths are 0");
+
+        //- Sort
+    // few distinct keys so most items share theirs with others. The items are pushed in transform order,
+    // so a stable sort keeps the transform indices of equal keys ascending
+    SE_Render_Queue queue;
+    se_render_queue_init(&queue, 4096);
+    u32 random = 12345;
+    for (u32 i = 0; i < queue.capacity; ++i) {
+        random = random * 1664525 + 1013904223; // numerical recipes lcg
+        u32 transform_index = se_render_queue_add_transform(&queue, mat4_identity(), SE_RENDER_NO_ANIMATOR);
+        b8 is_transparent = (random >> 28) == 0;
+        u64 key = se_render_key(is_transparent, (random >> 8) % 3, (random >> 12) % 4, 0, (f32)((random >> 16) % 5));
+        se_render_queue_push(&queue, key, i, transform_index);
+    }
+    se_render_queue_sort(&queue);
+    b8 is_sorted = true;
+    b8 is_stable = true;
+    for (u32 i = 1; i < queue.items_count; ++i) {
+        const SE_Render_Item *previous = &queue.items[i - 1];
+        const SE_Render_Item *item = &queue.items[i];
+        if (previous->key > item->key) is_sorted = false;
+        if (previous->key == item->key && previous->transform_index > item->transform_index) is_stable = false;
+    }
+    passed &= render_queue_expect(queue.items_count == queue.capacity, "every item was pushed");
+    passed &= render_queue_expect(is_sorted, "the sorted keys are ascending");
+    passed &= render_queue_expect(is_stable, "items with the same key keep the order they were pushed in");
+
+        // every key the same, so each byte is skipped
+    se_render_queue_clear(&queue);
+    for (u32 i = 0; i < 16; ++i) {
+        u32 transform_index = se_render_queue_add_transform(&queue, mat4_identity(), SE_RENDER_NO_ANIMATOR);
+        se_render_queue_push(&queue, se_render_key(false, 1, 2, 3, 4.0f), i, transform_index);
+    }
+    se_render_queue_sort(&queue);
+    b8 is_unchanged = true;
+    for (u32 i = 0; i < queue.items_count; ++i) {
+        if (queue.items[i].transform_index != i) is_unchanged = false;
+    }
+    passed &= render_queue_expect(is_unchanged, "sorting equal keys doesn't move anything");
+    se_render_queue_deinit(&queue);
+
+    printf("render queue self test: %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
@@ -0,0 +1,63 @@
+#ifndef SERENDER_QUEUE_H
+#define SERENDER_QUEUE_H
+
+#include "sedefines.h"
+#include "semath.h"
+
+///
+/// RENDER QUEUE
+/// Draw items collected over a frame and sorted by a packed 64 bit key before anything is drawn.
+/// This part does not touch OpenGL. The renderer fills the queue (se_render3d_submit_mesh) and walks it
+/// (se_render3d_execute_queue).
+///
+/// Key layout, from the most significant bit:
+///     opaque:      [pass 1 = 0][shader 7][material 14][mesh 14][depth 24][unused 4]   -> grouped by state, front to back
+///     transparent: [pass 1 = 1][~depth 24][shader 7][material 14][mesh 14][unused 4]  -> back to front
+///
+
+#define SE_RENDER_KEY_SHADER_BITS   7  // SERENDERER3D_MAX_SHADERS must fit
+#define SE_RENDER_KEY_MATERIAL_BITS 14 // SERENDERER3D_MAX_MATERIALS must fit
+#define SE_RENDER_KEY_MESH_BITS     14 // SERENDERER3D_MAX_MESHES must fit
+#define SE_RENDER_KEY_DEPTH_BITS    24
+
+#define SE_RENDER_QUEUE_FULL 0xFFFFFFFF
+#define SE_RENDER_NO_ANIMATOR 0xFFFFFFFF // the item is posed by its mesh's own animator (if it's skinned)
+
+typedef struct SE_Render_Item {
+    u64 key;             // also holds the shader, material and depth, see se_render_key
+    u32 mesh_index;
+    u32 transform_index; // into SE_Render_Queue.transforms
+} SE_Render_Item;
+
+typedef struct SE_Render_Queue {
+    u32 capacity; // of items and transforms
+
+    u32 items_count;
+    SE_Render_Item *items;
+    SE_Render_Item *items_scratch; // the other half of the radix sort
+
+    u32 transforms_count;
+    Mat4 *transforms; // several items can point to the same transform (meshes linked with next_mesh_index)
+    u32 *animators;   // one per transform, the animator (or SE_RENDER_NO_ANIMATOR) the transform's meshes are posed by
+    Mat4 *batch;      // scratch for whoever walks the queue, room for "capacity" transforms
+} SE_Render_Queue;
+
+void se_render_queue_init(SE_Render_Queue *queue, u32 capacity);
+void se_render_queue_deinit(SE_Render_Queue *queue);
+void se_render_queue_clear(SE_Render_Queue *queue);
+    /// Returns the index of the transform or SE_RENDER_QUEUE_FULL. "animator_index" is handed back to the renderer
+    /// untouched, pass SE_RENDER_NO_ANIMATOR for meshes that aren't animated per instance.
+u32 se_render_queue_add_transform(SE_Render_Queue *queue, Mat4 transform, u32 animator_index);
+    /// Returns false if the queue is full
+b8 se_render_queue_push(SE_Render_Queue *queue, u64 key, u32 mesh_index, u32 transform_index);
+    /// Sorts the items by key (LSD radix sort, stable). Bytes that are the same across every key are skipped.
+void se_render_queue_sort(SE_Render_Queue *queue);
+
+    /// "depth" is the distance from the camera. Negative depths are treated as 0.
+u64 se_render_key(b8 transparent, u32 shader_index, u32 material_index, u32 mesh_index, f32 depth);
+b8 se_render_key_is_transparent(u64 key);
+
+    /// Checks the key packing and order, and that the sort is stable, on the CPU. Prints what failed.
+b8 se_render_queue_self_test(void);
+
+#endif // SERENDER_QUEUE_H
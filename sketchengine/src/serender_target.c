@@ -6,7 +6,7 @@
 void serender_target_init_ext(SE_Render_Target *render_target, SE_Render_Target_Config config) {
     // The framebuffer, which regroups 0, 1, or more textures, and 0 or 1 depth buffer.
     glGenFramebuffers(1, &render_target->frame_buffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
     render_target->config = config;
 
     // -- configure our frame buffer
@@ -15,7 +15,7 @@ void serender_target_init_ext(SE_Render_Target *render_target, SE_Render_Target_
     if (config.has_colour) {
         // the texture we're going to be rendering to
         glGenTextures(1, &render_target->texture);
-        glBindTexture(GL_TEXTURE_2D, render_target->texture);
+        se_gl_bind_texture(GL_TEXTURE_2D, render_target->texture);
         // Give an empty image to opengl (the last '0')
         glTexImage2D(GL_TEXTURE_2D, 0, config.internal_format, config.size.x, config.size.y, 0, config.format, config.type, 0);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.mag_filter);
@@ -35,7 +35,7 @@ void serender_target_init_ext(SE_Render_Target *render_target, SE_Render_Target_
     // the depth buffer
     if (config.has_depth) {
         glGenTextures(1, &render_target->depth_buffer);
-        glBindTexture(GL_TEXTURE_2D, render_target->depth_buffer);
+        se_gl_bind_texture(GL_TEXTURE_2D, render_target->depth_buffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, config.size.x, config.size.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.mag_filter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, config.min_filter);
@@ -51,8 +51,8 @@ void serender_target_init_ext(SE_Render_Target *render_target, SE_Render_Target_
     // check for errors
     SDL_assert_always(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 }
 
 void serender_target_init(SE_Render_Target *render_target, const Rect viewport, const b8 has_colour, const b8 has_depth) {
@@ -96,7 +96,7 @@ void se_render_target_resize(SE_Render_Target *render_target, Rect new_viewport)
 
     const SE_Render_Target_Config config = render_target->config;
     if (render_target->config.has_colour) {
-        glBindTexture(GL_TEXTURE_2D, render_target->texture);
+        se_gl_bind_texture(GL_TEXTURE_2D, render_target->texture);
         glTexImage2D(GL_TEXTURE_2D, 0, config.internal_format, config.size.x,
                     config.size.y, 0, config.format, config.type, 0);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.mag_filter);
@@ -109,7 +109,7 @@ void se_render_target_resize(SE_Render_Target *render_target, Rect new_viewport)
 
     // the depth buffer
     if (render_target->config.has_depth) {
-        glBindTexture(GL_TEXTURE_2D, render_target->depth_buffer);
+        se_gl_bind_texture(GL_TEXTURE_2D, render_target->depth_buffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, render_target->config.size.x,
                     render_target->config.size.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.mag_filter);
@@ -130,9 +130,9 @@ void serender_target_deinit(SE_Render_Target *render_target) {
 
 void serender_target_use(SE_Render_Target *render_target) {
     if (render_target == NULL) {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
     } else {
-        glBindFramebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
         Rect v = render_target->viewport;
         glViewport(v.x, v.y, v.w, v.h);
     }
@@ -145,13 +145,14 @@ void serender_target_deinit(SE_Render_Target *render_target) {
     }
     glDeleteTextures(render_target->colour_buffers_count, render_target->colour_buffers);
     glDeleteFramebuffers(1, &render_target->frame_buffer);
+    se_gl_state_invalidate();
 }
 
 void serender_target_use(SE_Render_Target *render_target) {
     if (render_target == NULL) {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
     } else {
-        glBindFramebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
         glViewport(0, 0, render_target->texture_size.x, render_target->texture_size.y);
     }
 }
@@ -159,7 +160,7 @@ void serender_target_use(SE_Render_Target *render_target) {
 void serender_target_init_ext(SE_Render_Target *render_target, Vec2 size, u32 colour_count, b8 has_depth, SE_Render_Target_Config config) {
     // The framebuffer, which regroups 0, 1, or more textures, and 0 or 1 depth buffer.
     glGenFramebuffers(1, &render_target->frame_buffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, render_target->frame_buffer);
     render_target->texture_size = size;
     render_target->colour_buffers_count = colour_count;
     render_target->has_depth = has_depth;
@@ -171,7 +172,7 @@ void serender_target_init_ext(SE_Render_Target *render_target, Vec2 size, u32 co
 
         GLenum *draw_buffers = malloc(sizeof(GLenum) * colour_count);
         for (u32 i = 0; i < colour_count; ++i) {
-            glBindTexture(GL_TEXTURE_2D, render_target->colour_buffers[i]);
+            se_gl_bind_texture(GL_TEXTURE_2D, render_target->colour_buffers[i]);
             // Give an empty image to opengl (the last '0')
             glTexImage2D(GL_TEXTURE_2D, 0, config.internal_format, size.x, size.y, 0, config.format, config.type, 0);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.filter);
@@ -195,7 +196,7 @@ void serender_target_init_ext(SE_Render_Target *render_target, Vec2 size, u32 co
     // the depth buffer
     if (has_depth) {
         glGenTextures(1, &render_target->depth_buffer);
-        glBindTexture(GL_TEXTURE_2D, render_target->depth_buffer);
+        se_gl_bind_texture(GL_TEXTURE_2D, render_target->depth_buffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size.x, size.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config.filter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, config.filter);
@@ -211,8 +212,8 @@ void serender_target_init_ext(SE_Render_Target *render_target, Vec2 size, u32 co
     // check for errors
     SDL_assert_always(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 }
 
 void serender_target_init(SE_Render_Target *render_target, Vec2 size, u32 colour_count, b8 has_depth) {
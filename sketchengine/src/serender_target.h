@@ -3,6 +3,7 @@
 
 #include "sedefines.h"
 #include "GL/glew.h"
+#include "segl_state.h"
 #include "semath.h"
 
 ///
@@ -1,52 +1,269 @@
 #include "serenderer_util.h"
 
-u32 se_render3d_load_mesh(SE_Renderer3D *renderer, const char *model_filepath, b8 with_skeleton) {
-    u32 result = -1;
+SE_Mesh_Import_Settings se_mesh_import_settings_default() {
+    SE_Mesh_Import_Settings settings = {0};
+    settings.pack_vertices = false;
+    settings.lods.lods_count = SE_MESH_LODS_MAX;
+    settings.lods.target_ratio = 0.5f;
+    settings.lods.target_errors[1] = 0.005f;
+    settings.lods.target_errors[2] = 0.01f;
+    settings.lods.target_errors[3] = 0.02f;
+    return settings;
+}
 
-    // check if a generated mesh file has already been generated for this mesh.
-    // if not generate it and load it.
-    {
-        FILE *file;
-        SE_String save_data_filepath;
-        se_string_init(&save_data_filepath, model_filepath);
-        se_string_append(&save_data_filepath, ".mesh");
-
-        if (file = fopen(save_data_filepath.buffer, "rb")) {
-            fclose(file);
-            // file was found. So we don't need to regenrate it.
-            printf("file: %s has already been generated.\n", model_filepath);
-        } else {
-            printf("file: %s has NOT been generated. So we're generating it.\n", model_filepath);
-            // file was not found. So we need to generate a mesh file.
-                // load scene from file
-            const struct aiScene *scene = aiImportFile(model_filepath, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-
-            if (scene == NULL) {
-                printf("ERROR: could not mesh from %s (%s)\n", model_filepath, aiGetErrorString());
-                return result;
-            }
+    /// Folds the path and modified time of "filepath" into "key". Files that don't exist are folded in as well,
+    /// so adding them later changes the key too.
+static u64 hash_dependency(const char *filepath, u64 key) {
+    u64 modified_time = 0;
+    se_file_modified_time(filepath, &modified_time);
+    key = se_hash_bytes(filepath, strlen(filepath), key);
+    return se_hash_bytes(&modified_time, sizeof(u64), key);
+}
 
-            {    //- Trun scene into a save file
-                SE_Save_Data_Meshes save_data = {0};
-                ai_scene_to_mesh_save_data(scene, &save_data, model_filepath);
-                    //- Save to disk for later use
-                se_save_data_write_mesh(&save_data, save_data_filepath.buffer);
-                se_save_data_mesh_deinit(&save_data);
+    /// Folds in the material libraries an .obj references with "mtllib". The importer reads the materials from them,
+    /// so editing one has to change the key just like editing the .obj.
+static u64 hash_material_libraries(const char *model_filepath, u64 key) {
+    const char *extension = strrchr(model_filepath, '.');
+    if (extension == NULL || (strcmp(extension, ".obj") != 0 && strcmp(extension, ".OBJ") != 0)) return key;
+
+    SE_File_Map map;
+    if (!se_file_map_open(&map, model_filepath)) return key;
+
+        // material libraries are relative to the model
+    const char *directory_end = strrchr(model_filepath, '/');
+    u64 directory_length = directory_end != NULL ? (u64)(directory_end - model_filepath) + 1 : 0;
+
+    const char *text = (const char*)map.data;
+    u64 line_start = 0;
+    while (line_start < map.size) {
+        u64 line_end = line_start;
+        while (line_end < map.size && text[line_end] != '\n' && text[line_end] != '\r') line_end++;
+
+        const char *line = text + line_start;
+        u64 line_length = line_end - line_start;
+        if (line_length > 7 && memcmp(line, "mtllib", 6) == 0 && (line[6] == ' ' || line[6] == '\t')) {
+            u64 name_start = 7;
+            while (name_start < line_length && (line[name_start] == ' ' || line[name_start] == '\t')) name_start++;
+            while (line_length > name_start && (line[line_length - 1] == ' ' || line[line_length - 1] == '\t')) line_length--;
+
+            char library_filepath[1024];
+            u64 name_length = line_length - name_start;
+            if (name_length > 0 && directory_length + name_length < sizeof(library_filepath)) {
+                memcpy(library_filepath, model_filepath, directory_length);
+                memcpy(library_filepath + directory_length, line + name_start, name_length);
+                library_filepath[directory_length + name_length] = '\0';
+                key = hash_dependency(library_filepath, key);
             }
+        }
+        line_start = line_end + 1;
+    }
 
-            aiReleaseImport(scene);
+    se_file_map_close(&map);
+    return key;
+}
+
+u64 se_mesh_cache_key(const char *model_filepath, const SE_Mesh_Import_Settings *settings) {
+    u32 versions[4] = { mesh_import_flags, mesh_import_pipeline_version, SE_MESH_FILE_VERSION, settings->pack_vertices };
+
+        // the filepath is part of the key because texture paths are resolved relative to it
+    u64 key = se_hash_bytes(model_filepath, strlen(model_filepath), SE_HASH_SEED);
+    key = se_hash_bytes(versions, sizeof(versions), key);
+    key = se_hash_bytes(&settings->lods.lods_count, sizeof(u32), key);
+    key = se_hash_bytes(&settings->lods.target_ratio, sizeof(f32), key);
+    key = se_hash_bytes(settings->lods.target_errors, sizeof(settings->lods.target_errors), key);
+    if (!se_file_hash(model_filepath, key, &key)) {
+        return 0;
+    }
+    key = hash_material_libraries(model_filepath, key);
+    return key == 0 ? 1 : key; // 0 means "no key"
+}
+
+u64 se_mesh_cache_dependencies_key(const SE_Save_Data_Meshes *save_data) {
+    u64 key = SE_HASH_SEED;
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        const SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        const SE_String *texture_filepaths[3] = {
+            &raw_data->texture_diffuse_filepath, &raw_data->texture_specular_filepath, &raw_data->texture_normal_filepath
+        };
+        for (u32 j = 0; j < 3; ++j) {
+            if (texture_filepaths[j]->buffer == NULL) continue;
+            key = hash_dependency(texture_filepaths[j]->buffer, key);
         }
+    }
+    return key == 0 ? 1 : key; // 0 means "no key"
+}
+
+    /// Returns true if "save_data" was generated from the current version of the asset with key "content_key"
+    /// and none of the textures it references have changed since
+static b8 mesh_cache_entry_is_up_to_date(const SE_Save_Data_Meshes *save_data, u64 content_key) {
+    return save_data->content_key == content_key
+        && save_data->dependencies_key == se_mesh_cache_dependencies_key(save_data);
+}
+
+void se_mesh_cache_entry_filepath(SE_String *result, u64 content_key) {
+    char filename[32];
+    snprintf(filename, sizeof(filename), "/%016llx.mesh", (unsigned long long)content_key);
+    se_string_init(result, SE_MESH_CACHE_DIRECTORY);
+    se_string_append(result, filename);
+}
 
-        se_string_deinit(&save_data_filepath);
+typedef struct Mesh_Cache_Validation {
+    const SE_Mesh_Import_Settings *settings;
+    u32 assets_count;
+    u32 stale_count;
+} Mesh_Cache_Validation;
+
+static void mesh_cache_validate_file(const char *filepath, void *user_data) {
+    Mesh_Cache_Validation *validation = user_data;
+
+    const char *extension = strrchr(filepath, '.');
+    if (extension == NULL || strcmp(extension, ".mesh") == 0 || !aiIsExtensionSupported(extension)) return;
+    validation->assets_count++;
+
+    u64 key = se_mesh_cache_key(filepath, validation->settings);
+    SE_String entry_filepath;
+    se_mesh_cache_entry_filepath(&entry_filepath, key);
+    b8 is_up_to_date = false;
+    if (key != 0 && se_save_data_mesh_file_is_valid(entry_filepath.buffer, key)) {
+            // the header matches, check the textures it references too
+        SE_Save_Data_Meshes save_data;
+        if (se_save_data_read_mesh(&save_data, entry_filepath.buffer)) {
+            is_up_to_date = mesh_cache_entry_is_up_to_date(&save_data, key);
+            se_save_data_mesh_deinit(&save_data);
+        }
+    }
+    if (!is_up_to_date) {
+        printf("mesh cache: %s is stale or missing (%s)\n", filepath, entry_filepath.buffer);
+        validation->stale_count++;
+    }
+    se_string_deinit(&entry_filepath);
+}
+
+u32 se_mesh_cache_validate(const char *directory, const SE_Mesh_Import_Settings *settings) {
+    Mesh_Cache_Validation validation = {0};
+    validation.settings = settings;
+    se_file_walk_directory(directory, mesh_cache_validate_file, &validation);
+    printf("mesh cache: %s has %u importable assets, %u up to date, %u need importing\n",
+            directory, validation.assets_count, validation.assets_count - validation.stale_count, validation.stale_count);
+    return validation.stale_count;
+}
+
+typedef struct Mesh_Cache_Prune {
+    const SE_Mesh_Import_Settings *settings;
+    u32 keys_count;
+    u32 keys_capacity;
+    u64 *keys; // the keys of the entries that are still in use
+    u32 deleted_count;
+} Mesh_Cache_Prune;
+
+static void mesh_cache_prune_collect_key(const char *filepath, void *user_data) {
+    Mesh_Cache_Prune *prune = user_data;
+
+    const char *extension = strrchr(filepath, '.');
+    if (extension == NULL || strcmp(extension, ".mesh") == 0 || !aiIsExtensionSupported(extension)) return;
+    u64 key = se_mesh_cache_key(filepath, prune->settings);
+    if (key == 0) return;
+    if (prune->keys_count == prune->keys_capacity) {
+        prune->keys_capacity = prune->keys_capacity == 0 ? 16 : prune->keys_capacity * 2;
+        prune->keys = realloc(prune->keys, sizeof(u64) * prune->keys_capacity);
+    }
+    prune->keys[prune->keys_count++] = key;
+}
+
+static void mesh_cache_prune_entry(const char *filepath, void *user_data) {
+    Mesh_Cache_Prune *prune = user_data;
+
+        // entries are named after their key (see se_mesh_cache_entry_filepath), leave anything else alone
+    const char *filename = strrchr(filepath, '/');
+    filename = filename != NULL ? filename + 1 : filepath;
+    char *name_end = NULL;
+    u64 key = strtoull(filename, &name_end, 16);
+    if (name_end == filename || strcmp(name_end, ".mesh") != 0) return;
+
+    for (u32 i = 0; i < prune->keys_count; ++i) {
+        if (prune->keys[i] == key) return;
+    }
+    if (remove(filepath) == 0) {
+        printf("mesh cache: deleted stale entry %s\n", filepath);
+        prune->deleted_count++;
+    } else {
+        printf("ERROR: could not delete stale mesh cache entry %s\n", filepath);
+    }
+}
+
+u32 se_mesh_cache_prune(const char **directories, u32 directories_count, const SE_Mesh_Import_Settings *settings) {
+    Mesh_Cache_Prune prune = {0};
+    prune.settings = settings;
+    for (u32 i = 0; i < directories_count; ++i) {
+        se_file_walk_directory(directories[i], mesh_cache_prune_collect_key, &prune);
+    }
+    se_file_walk_directory(SE_MESH_CACHE_DIRECTORY, mesh_cache_prune_entry, &prune);
+    printf("mesh cache: deleted %u stale entries, %u assets in use\n", prune.deleted_count, prune.keys_count);
+
+    free(prune.keys);
+    return prune.deleted_count;
+}
+
+    /// Fills "save_data" from the mesh cache. If the asset has no up to date cache entry,
+    /// the model is imported with assimp and the entry is written for next time.
+    /// Doesn't touch OpenGL so it's safe to call from a worker thread.
+static b8 mesh_save_data_load_or_import
+(SE_Save_Data_Meshes *save_data, const char *model_filepath, const SE_Mesh_Import_Settings *settings) {
+    memset(save_data, 0, sizeof(SE_Save_Data_Meshes));
+
+    u64 key = se_mesh_cache_key(model_filepath, settings);
+    if (key == 0) {
+        printf("ERROR: could not read %s\n", model_filepath);
+        return false;
     }
 
     SE_String save_data_filepath;
-        se_string_init(&save_data_filepath, model_filepath);
-        se_string_append(&save_data_filepath, ".mesh");
+    se_mesh_cache_entry_filepath(&save_data_filepath, key);
+
+    if (se_save_data_read_mesh(save_data, save_data_filepath.buffer) && mesh_cache_entry_is_up_to_date(save_data, key)) {
+        // up to date entry was found. So we don't need to regenrate it.
+        printf("file: %s is cached in %s\n", model_filepath, save_data_filepath.buffer);
+    } else {
+        se_save_data_mesh_deinit(save_data); // in case a mismatching entry was read
+        memset(save_data, 0, sizeof(SE_Save_Data_Meshes));
+
+        printf("file: %s has NOT been generated (or is out of date). So we're generating it.\n", model_filepath);
+            // load scene from file
+        const struct aiScene *scene = aiImportFile(model_filepath, mesh_import_flags);
+
+        if (scene == NULL) {
+            printf("ERROR: could not mesh from %s (%s)\n", model_filepath, aiGetErrorString());
+            se_string_deinit(&save_data_filepath);
+            return false;
+        }
 
-        SE_Save_Data_Meshes save_data = {0};
-        se_save_data_read_mesh(&save_data, save_data_filepath.buffer);
+            //- Trun scene into a save file
+        ai_scene_to_mesh_save_data(scene, save_data, model_filepath);
+        se_save_data_optimise(save_data);
+        se_save_data_generate_lods(save_data, &settings->lods);
+        if (settings->pack_vertices) {
+            se_save_data_pack_vertices(save_data);
+        }
+        save_data->content_key = key;
+        save_data->dependencies_key = se_mesh_cache_dependencies_key(save_data);
+            //- Save to the cache for later use
+        if (se_file_make_directory(SE_MESH_CACHE_DIRECTORY)) {
+            se_save_data_write_mesh(save_data, save_data_filepath.buffer);
+        }
+
+        aiReleaseImport(scene);
+    }
     se_string_deinit(&save_data_filepath);
+    return true;
+}
+
+u32 se_render3d_load_mesh(SE_Renderer3D *renderer, const char *model_filepath, b8 with_skeleton) {
+    u32 result = -1;
+
+    SE_Save_Data_Meshes save_data;
+    if (!mesh_save_data_load_or_import(&save_data, model_filepath, &renderer->import_settings)) {
+        return result;
+    }
 
         //- Generate meshes from save data
     result = se_save_data_mesh_to_mesh(renderer, &save_data);
@@ -55,13 +272,270 @@ u32 se_render3d_load_mesh(SE_Renderer3D *renderer, const char *model_filepath, b
     return result;
 }
 
+    /// Uploads every mesh of "save_data" in the format it's stored in and deletes it again "iterations" times.
+    /// Adds up the vertex bytes of one upload in "out_vertex_bytes" and returns the average milliseconds.
+static f64 benchmark_mesh_upload(const SE_Save_Data_Meshes *save_data, u32 iterations, u64 *out_vertex_bytes) {
+    *out_vertex_bytes = 0;
+    for (u32 i = 0; i < save_data->meshes_count; ++i) {
+        const SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+        b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+        if (raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED) {
+            *out_vertex_bytes += (u64)raw_data->vert_count * (is_skinned ? sizeof(SE_Packed_Skinned_Vertex) : sizeof(SE_Packed_Vertex3D));
+        } else {
+            *out_vertex_bytes += (u64)raw_data->vert_count * (is_skinned ? sizeof(SE_Skinned_Vertex) : sizeof(SE_Vertex3D));
+        }
+    }
+
+    glFinish();
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 it = 0; it < iterations; ++it) {
+        for (u32 i = 0; i < save_data->meshes_count; ++i) {
+            SE_Mesh_Raw_Data *raw_data = &save_data->meshes[i];
+            SE_Mesh mesh = {0};
+            mesh.type = raw_data->type;
+            b8 is_skinned = raw_data->type == SE_MESH_TYPE_SKINNED;
+            if (raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED) {
+                if (is_skinned) {
+                    se_mesh_generate_skinned_packed(&mesh, raw_data->vert_count, raw_data->packed_skinned_verts, raw_data->index_count, raw_data->indices, raw_data->quantisation);
+                } else {
+                    se_mesh_generate_packed(&mesh, raw_data->vert_count, raw_data->packed_verts, raw_data->index_count, raw_data->indices, raw_data->quantisation);
+                }
+            } else {
+                if (is_skinned) {
+                    se_mesh_generate_skinned(&mesh, raw_data->vert_count, raw_data->skinned_verts, raw_data->index_count, raw_data->indices);
+                } else {
+                    se_mesh_generate(&mesh, raw_data->vert_count, raw_data->verts, raw_data->index_count, raw_data->indices);
+                }
+            }
+            glFinish(); // wait for the copy to actually happen
+            se_mesh_deinit(&mesh);
+        }
+    }
+    u64 ticks = SDL_GetPerformanceCounter() - start;
+    return ticks * 1000.0 / (f64)SDL_GetPerformanceFrequency() / se_math_max(iterations, 1);
+}
+
+f64 se_render3d_benchmark_vertex_formats(const char *model_filepath, u32 iterations) {
+        // import instead of reading the cache because cached entries are mapped and can't be packed in place
+    const struct aiScene *scene = aiImportFile(model_filepath, mesh_import_flags);
+    if (scene == NULL) {
+        printf("ERROR: could not mesh from %s (%s)\n", model_filepath, aiGetErrorString());
+        return 0;
+    }
+    SE_Save_Data_Meshes save_data;
+    memset(&save_data, 0, sizeof(SE_Save_Data_Meshes));
+    ai_scene_to_mesh_save_data(scene, &save_data, model_filepath);
+    se_save_data_optimise(&save_data);
+    aiReleaseImport(scene);
+
+    u64 vert_count = 0;
+    for (u32 i = 0; i < save_data.meshes_count; ++i) {
+        vert_count += save_data.meshes[i].vert_count;
+    }
+
+    u64 full_bytes;
+    f64 full_ms = benchmark_mesh_upload(&save_data, iterations, &full_bytes);
+    se_save_data_pack_vertices(&save_data);
+    u64 packed_bytes;
+    f64 packed_ms = benchmark_mesh_upload(&save_data, iterations, &packed_bytes);
+
+    f64 verts = (f64)se_math_max(vert_count, 1);
+    printf("vertex formats (%s, %llu verts):\n", model_filepath, (unsigned long long)vert_count);
+    printf("    full:   %.1f bytes per vertex, %.1f KB, uploaded in %.3f ms\n", full_bytes / verts, full_bytes / 1024.0, full_ms);
+    printf("    packed: %.1f bytes per vertex, %.1f KB, uploaded in %.3f ms\n", packed_bytes / verts, packed_bytes / 1024.0, packed_ms);
+
+    se_save_data_mesh_deinit(&save_data);
+    return packed_ms;
+}
+
+//// BATCH LOADING ////
+
+    /// One model of a SE_Mesh_Load_Batch. Everything in here is filled on a worker thread.
+typedef struct SE_Mesh_Load_Job {
+    const char *model_filepath;
+    SE_Mesh_Import_Settings settings;
+    b8 loaded;
+    SE_Save_Data_Meshes save_data;
+    SE_Texture_Cooked *textures; // cooked textures, meshes_count * SE_MESH_LOAD_JOB_TEXTURES (diffuse, specular, normal)
+} SE_Mesh_Load_Job;
+
+#define SE_MESH_LOAD_JOB_TEXTURES 3
+
+static void mesh_load_job_proc(void *data) {
+    SE_Mesh_Load_Job *job = data;
+    job->loaded = mesh_save_data_load_or_import(&job->save_data, job->model_filepath, &job->settings);
+    if (!job->loaded || job->save_data.meshes_count == 0) return;
+
+        //- read the cooked textures here as well, cooking the ones that are missing from the cache
+    job->textures = malloc(sizeof(SE_Texture_Cooked) * job->save_data.meshes_count * SE_MESH_LOAD_JOB_TEXTURES);
+    memset(job->textures, 0, sizeof(SE_Texture_Cooked) * job->save_data.meshes_count * SE_MESH_LOAD_JOB_TEXTURES);
+    for (u32 i = 0; i < job->save_data.meshes_count; ++i) {
+        SE_Mesh_Raw_Data *raw_data = &job->save_data.meshes[i];
+        SE_Texture_Cooked *textures = &job->textures[i * SE_MESH_LOAD_JOB_TEXTURES];
+        if (raw_data->texture_diffuse_filepath.buffer  != NULL) se_texture_cooked_load_or_cook(&textures[0], raw_data->texture_diffuse_filepath.buffer, SE_TEXTURE_ROLE_ALBEDO);
+        if (raw_data->texture_specular_filepath.buffer != NULL) se_texture_cooked_load_or_cook(&textures[1], raw_data->texture_specular_filepath.buffer, SE_TEXTURE_ROLE_DATA);
+        if (raw_data->texture_normal_filepath.buffer   != NULL) se_texture_cooked_load_or_cook(&textures[2], raw_data->texture_normal_filepath.buffer, SE_TEXTURE_ROLE_NORMAL);
+    }
+}
+
+    /// Uploads a texture. Uses the already read "cooked" texture if there is one, otherwise loads it from "filepath".
+static void material_texture_load
+(SE_Texture *texture, SE_Texture_Cooked *cooked, const SE_String *filepath, SE_TEXTURE_ROLE role) {
+    if (cooked != NULL) {
+        if (!cooked->loaded) return; // failed on the worker, the error has already been printed
+        se_texture_load_cooked(texture, cooked);
+        se_texture_cooked_unload(cooked);
+    } else if (filepath->buffer != NULL) {
+        se_texture_load_role(texture, filepath->buffer, role);
+    }
+}
+
+static u32 save_data_mesh_to_mesh_with_textures
+(SE_Renderer3D *renderer, const SE_Save_Data_Meshes *save_data, SE_Texture_Cooked *textures);
+
+void se_render3d_load_meshes_begin
+(SE_Renderer3D *renderer, SE_Mesh_Load_Batch *batch, const char **model_filepaths, u32 count) {
+    memset(batch, 0, sizeof(SE_Mesh_Load_Batch));
+    batch->count = count;
+    batch->jobs = malloc(sizeof(SE_Mesh_Load_Job) * count);
+    memset(batch->jobs, 0, sizeof(SE_Mesh_Load_Job) * count);
+
+    batch->start_ticks = SDL_GetPerformanceCounter();
+    se_job_queue_init(&batch->queue, 0);
+    for (u32 i = 0; i < count; ++i) {
+        batch->jobs[i].model_filepath = model_filepaths[i];
+        batch->jobs[i].settings       = renderer->import_settings;
+        se_job_queue_add(&batch->queue, mesh_load_job_proc, &batch->jobs[i]);
+    }
+}
+
+u32 se_render3d_load_meshes_upload(SE_Renderer3D *renderer, SE_Mesh_Load_Batch *batch, u32 index) {
+    se_assert(index < batch->count);
+    if (!batch->decoded) {
+        se_job_queue_wait(&batch->queue);
+        batch->decoded = true;
+        f64 decode_ms = (f64)(SDL_GetPerformanceCounter() - batch->start_ticks) * 1000.0 / (f64)SDL_GetPerformanceFrequency();
+        printf("mesh batch: imported and decoded %u models on %u workers in %.3f ms\n", batch->count, batch->queue.worker_count, decode_ms);
+    }
+
+    SE_Mesh_Load_Job *job = &batch->jobs[index];
+    if (!job->loaded) return -1;
+    return save_data_mesh_to_mesh_with_textures(renderer, &job->save_data, job->textures);
+}
+
+void se_render3d_load_meshes_end(SE_Mesh_Load_Batch *batch) {
+    se_job_queue_deinit(&batch->queue);
+    for (u32 i = 0; i < batch->count; ++i) {
+        SE_Mesh_Load_Job *job = &batch->jobs[i];
+        if (job->textures != NULL) {
+            for (u32 j = 0; j < job->save_data.meshes_count * SE_MESH_LOAD_JOB_TEXTURES; ++j) {
+                se_texture_cooked_unload(&job->textures[j]); // never uploaded
+            }
+            free(job->textures);
+        }
+        if (job->loaded) {
+            se_save_data_mesh_deinit(&job->save_data);
+        }
+    }
+    free(batch->jobs);
+    memset(batch, 0, sizeof(SE_Mesh_Load_Batch));
+}
+
+void se_render3d_load_meshes
+(SE_Renderer3D *renderer, const char **model_filepaths, u32 count, u32 *mesh_indices) {
+    SE_Mesh_Load_Batch batch;
+    se_render3d_load_meshes_begin(renderer, &batch, model_filepaths, count);
+    for (u32 i = 0; i < count; ++i) {
+        mesh_indices[i] = se_render3d_load_meshes_upload(renderer, &batch, i);
+    }
+    se_render3d_load_meshes_end(&batch);
+}
+
+typedef struct Mesh_Cache_Cook {
+    u32 count;
+    u32 capacity;
+    SE_String *filepaths;
+} Mesh_Cache_Cook;
+
+static void mesh_cache_cook_collect_file(const char *filepath, void *user_data) {
+    Mesh_Cache_Cook *cook = user_data;
+
+    const char *extension = strrchr(filepath, '.');
+    if (extension == NULL || strcmp(extension, ".mesh") == 0 || !aiIsExtensionSupported(extension)) return;
+    if (cook->count == cook->capacity) {
+        cook->capacity = cook->capacity == 0 ? 16 : cook->capacity * 2;
+        cook->filepaths = realloc(cook->filepaths, sizeof(SE_String) * cook->capacity);
+    }
+    se_string_init(&cook->filepaths[cook->count++], filepath);
+}
+
+u32 se_mesh_cache_cook(const char *directory, const SE_Mesh_Import_Settings *settings) {
+    Mesh_Cache_Cook cook = {0};
+    se_file_walk_directory(directory, mesh_cache_cook_collect_file, &cook);
+    if (cook.count == 0) return 0;
+
+        // the same jobs as a load batch, minus the uploading
+    u64 start_ticks = SDL_GetPerformanceCounter();
+    SE_Mesh_Load_Job *jobs = malloc(sizeof(SE_Mesh_Load_Job) * cook.count);
+    memset(jobs, 0, sizeof(SE_Mesh_Load_Job) * cook.count);
+    SE_Job_Queue queue;
+    se_job_queue_init(&queue, 0);
+    for (u32 i = 0; i < cook.count; ++i) {
+        jobs[i].model_filepath = cook.filepaths[i].buffer;
+        jobs[i].settings       = *settings;
+        se_job_queue_add(&queue, mesh_load_job_proc, &jobs[i]);
+    }
+    se_job_queue_wait(&queue);
+    se_job_queue_deinit(&queue);
+
+    u32 failed_count = 0;
+    for (u32 i = 0; i < cook.count; ++i) {
+        SE_Mesh_Load_Job *job = &jobs[i];
+        if (!job->loaded) {
+            failed_count++;
+        }
+        if (job->textures != NULL) {
+            const SE_Mesh_Raw_Data *meshes = job->save_data.meshes;
+            for (u32 j = 0; j < job->save_data.meshes_count * SE_MESH_LOAD_JOB_TEXTURES; ++j) {
+                const SE_Mesh_Raw_Data *raw_data = &meshes[j / SE_MESH_LOAD_JOB_TEXTURES];
+                const SE_String *filepaths[SE_MESH_LOAD_JOB_TEXTURES] = {
+                    &raw_data->texture_diffuse_filepath, &raw_data->texture_specular_filepath, &raw_data->texture_normal_filepath
+                };
+                if (filepaths[j % SE_MESH_LOAD_JOB_TEXTURES]->buffer != NULL && !job->textures[j].loaded) {
+                    failed_count++;
+                }
+                se_texture_cooked_unload(&job->textures[j]);
+            }
+            free(job->textures);
+        }
+        if (job->loaded) {
+            se_save_data_mesh_deinit(&job->save_data);
+        }
+        se_string_deinit(&cook.filepaths[i]);
+    }
+    free(jobs);
+    free(cook.filepaths);
+
+    f64 cook_ms = (f64)(SDL_GetPerformanceCounter() - start_ticks) * 1000.0 / (f64)SDL_GetPerformanceFrequency();
+    printf("asset cache: cooked %u assets in %s and their textures in %.1f ms, %u failed\n", cook.count, directory, cook_ms, failed_count);
+    return failed_count;
+}
+
 u32 se_save_data_mesh_to_mesh
 (SE_Renderer3D *renderer, const SE_Save_Data_Meshes *save_data) {
+    return save_data_mesh_to_mesh_with_textures(renderer, save_data, NULL);
+}
+
+    /// "textures" are the cooked textures of each mesh already read (see SE_Mesh_Load_Job), or NULL to load them from the cache here
+static u32 save_data_mesh_to_mesh_with_textures
+(SE_Renderer3D *renderer, const SE_Save_Data_Meshes *save_data, SE_Texture_Cooked *textures) {
         //- Should we add a skeleton?
-    SE_Skeleton *skeleton;
+        // the meshes of a model share one skeleton and are posed by one animator
+    SE_Animator *animator = NULL;
     if (save_data->meshes_count > 0 && save_data->meshes[0].skeleton_data != NULL) {
         u32 skeleton_index = se_render3d_add_skeleton(renderer);
-        skeleton = renderer->user_skeletons[skeleton_index];
+        skeleton_deep_copy(renderer->user_skeletons[skeleton_index], save_data->meshes[0].skeleton_data);
+        animator = renderer->user_animators[se_render3d_add_animator(renderer, skeleton_index)];
     }
 
     u32 result = renderer->user_meshes_count;
@@ -78,10 +552,20 @@ u32 se_save_data_mesh_to_mesh
             mesh->type = raw_data->type;
 
                 //- generate vao
-            if (mesh->type == SE_MESH_TYPE_SKINNED) {
-                se_mesh_generate_skinned(mesh, raw_data->vert_count, raw_data->skinned_verts, raw_data->index_count, raw_data->indices);
+                // the size and upload time of each vertex format are measured by se_render3d_benchmark_vertex_formats
+            b8 is_skinned = mesh->type == SE_MESH_TYPE_SKINNED;
+            if (raw_data->vertex_format == SE_VERTEX_FORMAT_PACKED) {
+                if (is_skinned) {
+                    se_mesh_generate_skinned_packed(mesh, raw_data->vert_count, raw_data->packed_skinned_verts, raw_data->index_count, raw_data->indices, raw_data->quantisation);
+                } else {
+                    se_mesh_generate_packed(mesh, raw_data->vert_count, raw_data->packed_verts, raw_data->index_count, raw_data->indices, raw_data->quantisation);
+                }
             } else {
-                se_mesh_generate(mesh, raw_data->vert_count, raw_data->verts, raw_data->index_count, raw_data->indices);
+                if (is_skinned) {
+                    se_mesh_generate_skinned(mesh, raw_data->vert_count, raw_data->skinned_verts, raw_data->index_count, raw_data->indices);
+                } else {
+                    se_mesh_generate(mesh, raw_data->vert_count, raw_data->verts, raw_data->index_count, raw_data->indices);
+                }
             }
 
                 //- materials
@@ -100,28 +584,22 @@ u32 se_save_data_mesh_to_mesh
             material->base_diffuse = (Vec4) {1, 1, 1, 1};
             material->base_diffuse = raw_data->base_diffuse;
 
-            if (raw_data->texture_diffuse_filepath.buffer != NULL) {
-                se_texture_load(&material->texture_diffuse,
-                                raw_data->texture_diffuse_filepath.buffer,
-                                SE_TEXTURE_LOAD_CONFIG_CONVERT_TO_LINEAR_SPACE);
-            }
+            SE_Texture_Cooked *mesh_textures = textures != NULL ? &textures[i * SE_MESH_LOAD_JOB_TEXTURES] : NULL;
+            material_texture_load(&material->texture_diffuse,  mesh_textures ? &mesh_textures[0] : NULL, &raw_data->texture_diffuse_filepath, SE_TEXTURE_ROLE_ALBEDO);
+            material_texture_load(&material->texture_specular, mesh_textures ? &mesh_textures[1] : NULL, &raw_data->texture_specular_filepath, SE_TEXTURE_ROLE_DATA);
+            material_texture_load(&material->texture_normal,   mesh_textures ? &mesh_textures[2] : NULL, &raw_data->texture_normal_filepath, SE_TEXTURE_ROLE_NORMAL);
 
-            if (raw_data->texture_specular_filepath.buffer != NULL) {
-                se_texture_load(&material->texture_specular, raw_data->texture_specular_filepath.buffer, SE_TEXTURE_LOAD_CONFIG_NULL);
-            }
-
-            if (raw_data->texture_normal_filepath.buffer != NULL) {
-                se_texture_load(&material->texture_normal, raw_data->texture_normal_filepath.buffer, SE_TEXTURE_LOAD_CONFIG_NULL);
-            }
+            mesh->lods_count = raw_data->lods_count;
+            memcpy(mesh->lods, raw_data->lods, sizeof(mesh->lods));
 
             mesh->line_width   = raw_data->line_width;
             mesh->point_radius = raw_data->point_radius;
             mesh->should_cast_shadow = raw_data->should_cast_shadow;
 
                 //- skeleton and animations
-            if (raw_data->skeleton_data != NULL) {
-                mesh->skeleton = skeleton; // @TODO change to index like material
-                skeleton_deep_copy(mesh->skeleton, raw_data->skeleton_data);
+            if (raw_data->skeleton_data != NULL && animator != NULL) {
+                mesh->skeleton = renderer->user_skeletons[animator->skeleton]; // @TODO change to index like material
+                mesh->animator = animator;
             }
         }
 
@@ -138,10 +616,10 @@ u32 se_save_data_mesh_to_mesh
 #if 0 // @remove this version and use the cleaner procedure
 void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform) {
     /* default */
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glLineWidth(1.0f);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+    se_gl_disable(GL_BLEND);
+    se_gl_enable(GL_CULL_FACE);
+    se_gl_line_width(1.0f);
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
 
     // take the mesh (world space) and project it to view space
     // then take that and project it to the clip space
@@ -157,12 +635,12 @@ void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform) {
     /* configs for this mesh */
     if (mesh->type == SE_MESH_TYPE_LINE) { // LINE
         primitive = GL_LINES;
-        glLineWidth(mesh->line_width);
+        se_gl_line_width(mesh->line_width);
         if (mesh->skeleton != NULL && mesh->skeleton->animations_count > 0) {
         //- ANIMATED LINES
             shader = renderer->user_shaders[renderer->shader_skinned_mesh_skeleton];
                 // used for animated skeleton
-            set_material_uniforms_skeleton(renderer, shader, material, transform, mesh->skeleton->final_pose);
+            set_material_uniforms_skeleton(renderer, shader, material, transform, mesh->animator);
         } else {
         //- LINE
             shader = renderer->user_shaders[renderer->shader_lines];
@@ -179,127 +657,128 @@ void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform) {
         shader = renderer->user_shaders[renderer->shader_sprite];
         //- SPRITE
         set_material_uniforms_sprite(renderer, shader, material, transform);
-        glDisable(GL_CULL_FACE);
-        glEnable(GL_BLEND);
+        se_gl_disable(GL_CULL_FACE);
+        se_gl_enable(GL_BLEND);
     } else
         //- SKINNED MESH
     if (mesh->type == SE_MESH_TYPE_SKINNED) { // SKELETAL ANIMATION
         shader = renderer->user_shaders[renderer->shader_skinned_mesh];
-        set_material_uniforms_skinned(renderer, material, transform, mesh->skeleton->final_pose);
+        set_material_uniforms_skinned(renderer, material, transform, mesh->animator);
     } else
     if (mesh->type == SE_MESH_TYPE_POINT) { // MESH MADE OUT OF POINTS
         //- POINT
         shader = renderer->user_shaders[renderer->shader_lines];
         primitive = GL_POINTS;
-        glPointSize(mesh->point_radius);
+        se_gl_point_size(mesh->point_radius);
             // Note: points use the same shader as lines
         set_material_uniforms_lines(renderer, shader, material, transform);
     }
 
         //- Draw Call
-    glBindVertexArray(mesh->vao);
+    se_gl_bind_vertex_array(mesh->vao);
     if (mesh->indexed) {
         glDrawElements(primitive, mesh->element_count, GL_UNSIGNED_INT, 0);
     } else {
         glDrawArrays(primitive, 0, mesh->element_count);
     }
 
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
 }
 #endif
 
 static void reset_opengl_parameters() {
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glLineWidth(1.0f);
-    glPointSize(1.0f);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+    se_gl_disable(GL_BLEND);
+    se_gl_enable(GL_CULL_FACE);
+    se_gl_line_width(1.0f);
+    se_gl_point_size(1.0f);
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
 }
 
-void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform, b8 transparent_pass) {
+    /// se_render_mesh with the skinned mesh posed by "animator"
+static void render_mesh_posed(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform, b8 transparent_pass, const SE_Animator *animator) {
         //- OpenGL Parameters
     reset_opengl_parameters();
     if (transparent_pass) {
-        glEnable(GL_BLEND);
-        // glDisable(GL_CULL_FACE);
+        se_gl_enable(GL_BLEND);
+        // se_gl_disable(GL_CULL_FACE);
     }
 
         //- Mesh Parameters
     i32 primitive = GL_TRIANGLES;
     SE_Material *material = renderer->user_materials[mesh->material_index];
-    SE_Shader *shader = renderer->user_shaders[material->shader_index];
+    u32 shader_index = material->shader_index;
 
     switch (mesh->type) {
             //- Normal Mesh
         case SE_MESH_TYPE_NORMAL: {
             primitive = GL_TRIANGLES;
             if (material->type == SE_MATERIAL_TYPE_LIT) {
-                set_material_uniforms_lit(renderer, shader, material, transform);
+                set_material_uniforms_lit(renderer, shader_index, material, transform);
             } else
             if (material->type == SE_MATERIAL_TYPE_CUSTOM) {
                 // @temp think of what we can do here. How can I provide the ability to
                 // add custom uniforms to custom shaders that are part of the lit workflow?
-                set_material_uniforms_lit(renderer, shader, material, transform);
+                set_material_uniforms_lit(renderer, shader_index, material, transform);
             } else
             if (material->type == SE_MATERIAL_TYPE_TRANSPARENT) {
                 // @temp think of what we can do here. How can I provide the ability to
                 // add custom uniforms to custom shaders that are part of the lit workflow?
-                set_material_uniforms_lit(renderer, shader, material, transform);
+                set_material_uniforms_lit(renderer, shader_index, material, transform);
             }
+            set_vertex_format_uniforms(&renderer->user_shader_uniforms[shader_index], mesh);
         } break;
 
             //- Skinned Mesh
         case SE_MESH_TYPE_SKINNED: {
             primitive = GL_TRIANGLES;
             if (material->type == SE_MATERIAL_TYPE_LIT) {
-                set_material_uniforms_skinned(renderer, material, transform, mesh->skeleton->final_pose);
+                set_material_uniforms_skinned(renderer, material, transform, animator);
+                set_vertex_format_uniforms(&renderer->user_shader_uniforms[renderer->shader_skinned_mesh], mesh);
             }
         } break;
 
             //- Lines, Skeletons
         case SE_MESH_TYPE_LINE: {
             primitive = GL_LINES;
-            glLineWidth(mesh->line_width);
+            se_gl_line_width(mesh->line_width);
             if (mesh->skeleton && mesh->skeleton->animations_count > 0) {
                 if (material->type == SE_MATERIAL_TYPE_LIT) {
-                    shader = renderer->user_shaders[renderer->shader_skinned_mesh_skeleton];
-                    set_material_uniforms_skeleton(renderer, shader, material, transform, mesh->skeleton->final_pose);
+                    shader_index = renderer->shader_skinned_mesh_skeleton;
+                    set_material_uniforms_skeleton(renderer, shader_index, material, transform, animator);
                 }
             } else {
-                shader = renderer->user_shaders[renderer->shader_lines];
-                set_material_uniforms_lines(renderer, shader, material, transform);
+                shader_index = renderer->shader_lines;
+                set_material_uniforms_lines(renderer, shader_index, material, transform);
             }
         } break;
 
             //- Points
         case SE_MESH_TYPE_POINT: {
             primitive = GL_POINTS;
-            glPointSize(mesh->point_radius);
-            shader = renderer->user_shaders[renderer->shader_lines]; // I don't bother with assigning this to the generated meshes
-            set_material_uniforms_lines(renderer, shader, material, transform);
+            se_gl_point_size(mesh->point_radius);
+            shader_index = renderer->shader_lines; // I don't bother with assigning this to the generated meshes
+            set_material_uniforms_lines(renderer, shader_index, material, transform);
         } break;
 
             //- Sprites
         case SE_MESH_TYPE_SPRITE: {
-            shader = renderer->user_shaders[renderer->shader_sprite];
-            set_material_uniforms_sprite(renderer, shader, material, transform);
-            glDisable(GL_CULL_FACE);
-            glEnable(GL_BLEND);
+            shader_index = renderer->shader_sprite;
+            set_material_uniforms_sprite(renderer, shader_index, material, transform);
+            se_gl_disable(GL_CULL_FACE);
+            se_gl_enable(GL_BLEND);
         } break;
     }
 
         //- Draw Call
-    glBindVertexArray(mesh->vao);
-    if (mesh->indexed) {
-        glDrawElements(primitive, mesh->element_count, GL_UNSIGNED_INT, 0);
-    } else {
-        glDrawArrays(primitive, 0, mesh->element_count);
-    }
+    mesh_draw(renderer, mesh, primitive, mesh_select_lod(renderer, mesh, transform, renderer->lod_error_threshold), 1);
 
-    glBindVertexArray(0);
     reset_opengl_parameters();
 }
 
+void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform, b8 transparent_pass) {
+    render_mesh_posed(renderer, mesh, transform, transparent_pass, mesh_animator(renderer, mesh, SE_RENDER_NO_ANIMATOR));
+}
+
 // make sure to call serender3d_render_mesh_setup before calling this procedure. Only needs to be done once.
 void se_render_mesh_index(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transform, b8 transparent_pass) {
     SE_Mesh *mesh = renderer->user_meshes[mesh_index];
@@ -311,267 +790,800 @@ void se_render_mesh_index(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transfor
     }
 }
 
+    /// se_render_mesh_index_instanced without the linked meshes. Skinned meshes are posed by "animator".
+static void render_mesh_instanced
+(SE_Renderer3D *renderer, SE_Mesh *mesh, const Mat4 *transforms, u32 count, b8 transparent_pass, const SE_Animator *animator) {
+    SE_Material *material = renderer->user_materials[mesh->material_index];
+
+        //- Shader
+    // only lit meshes have the instancing path, everything else is drawn one transform at a time
+    const SE_Shader_Uniforms *u = NULL;
+    if (mesh->type == SE_MESH_TYPE_NORMAL) {
+        u = &renderer->user_shader_uniforms[material->shader_index];
+    } else
+    if (mesh->type == SE_MESH_TYPE_SKINNED && material->type == SE_MATERIAL_TYPE_LIT) {
+        u = &renderer->user_shader_uniforms[renderer->shader_skinned_mesh];
+    }
+
+    if (count > 1 && renderer->instancing && u != NULL && shader_supports_instancing(u)) {
+            //- OpenGL Parameters
+        reset_opengl_parameters();
+        if (transparent_pass) {
+            se_gl_enable(GL_BLEND);
+        }
+
+            //- Uniforms (the model matrices come from the instance buffer)
+        if (mesh->type == SE_MESH_TYPE_SKINNED) {
+            set_material_uniforms_skinned(renderer, material, transforms[0], animator);
+        } else {
+            set_material_uniforms_lit(renderer, material->shader_index, material, transforms[0]);
+        }
+        set_vertex_format_uniforms(u, mesh);
+
+            //- Draw Calls
+        mesh_draw_instanced(renderer, u, mesh, GL_TRIANGLES, transforms, count, renderer->lod_error_threshold, 1);
+
+        reset_opengl_parameters();
+    } else {
+        for (u32 i = 0; i < count; ++i) {
+            render_mesh_posed(renderer, mesh, transforms[i], transparent_pass, animator);
+        }
+    }
+}
+
+void se_render_mesh_index_instanced(SE_Renderer3D *renderer, u32 mesh_index, const Mat4 *transforms, u32 count, b8 transparent_pass) {
+    if (count == 0) return;
+    SE_Mesh *mesh = renderer->user_meshes[mesh_index];
+    render_mesh_instanced(renderer, mesh, transforms, count, transparent_pass, mesh_animator(renderer, mesh, SE_RENDER_NO_ANIMATOR));
+
+    if (mesh->next_mesh_index > -1) {
+        se_render_mesh_index_instanced(renderer, mesh->next_mesh_index, transforms, count, transparent_pass);
+    }
+}
+
+void se_render3d_submit_mesh(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transform) {
+    se_render3d_submit_animated_mesh(renderer, mesh_index, SE_RENDER_NO_ANIMATOR, transform);
+}
+
+void se_render3d_submit_animated_mesh(SE_Renderer3D *renderer, u32 mesh_index, u32 animator_index, Mat4 transform) {
+    se_assert(animator_index == SE_RENDER_NO_ANIMATOR || animator_index < renderer->user_animators_count);
+    SE_Render_Queue *queue = &renderer->render_queue;
+    u32 transform_index = se_render_queue_add_transform(queue, transform, animator_index);
+    if (transform_index == SE_RENDER_QUEUE_FULL) {
+        printf("ERROR: render queue is full (%u), mesh %u was not drawn\n", queue->capacity, mesh_index);
+        return;
+    }
+
+    Vec3 camera_pos = renderer->current_camera->position;
+    for (i32 index = (i32)mesh_index; index > -1; index = renderer->user_meshes[index]->next_mesh_index) {
+        SE_Mesh *mesh = renderer->user_meshes[index];
+        SE_Material *material = renderer->user_materials[mesh->material_index];
+
+        b8 transparent = material->type == SE_MATERIAL_TYPE_TRANSPARENT;
+        f32 depth = vec3_magnitude(vec3_sub(mesh_world_centre(mesh, transform), camera_pos));
+        u64 key = se_render_key(transparent, mesh_shader_index(renderer, mesh, material), mesh->material_index, index, depth);
+        if (!se_render_queue_push(queue, key, index, transform_index)) {
+            printf("ERROR: render queue is full (%u), mesh %i was not drawn\n", queue->capacity, index);
+            return;
+        }
+    }
+}
+
+void se_render3d_execute_queue(SE_Renderer3D *renderer) {
+    SE_Render_Queue *queue = &renderer->render_queue;
+    se_render_queue_sort(queue);
+
+    u32 i = 0;
+    while (i < queue->items_count) {
+        const SE_Render_Item *item = &queue->items[i];
+        SE_Mesh *mesh = renderer->user_meshes[item->mesh_index];
+        u32 animator_index = queue->animators[item->transform_index];
+        const SE_Animator *animator = mesh_animator(renderer, mesh, animator_index);
+
+        if (se_render_key_is_transparent(item->key)) {
+            render_mesh_posed(renderer, mesh, queue->transforms[item->transform_index], true, animator);
+            i++;
+            continue;
+        }
+
+            // the opaque items of a mesh are next to each other, draw them together.
+            // A skinned mesh has one pose per draw, so items posed by different animators are drawn apart.
+        b8 is_posed = mesh->type == SE_MESH_TYPE_SKINNED || mesh->type == SE_MESH_TYPE_LINE;
+        u32 batch_count = 0;
+        while (i < queue->items_count && queue->items[i].mesh_index == item->mesh_index
+                && !se_render_key_is_transparent(queue->items[i].key)
+                && (!is_posed || queue->animators[queue->items[i].transform_index] == animator_index)) {
+            queue->batch[batch_count++] = queue->transforms[queue->items[i].transform_index];
+            i++;
+        }
+        render_mesh_instanced(renderer, mesh, queue->batch, batch_count, false, animator);
+    }
+
+    se_render_queue_clear(queue);
+}
+
+void se_render3d_update_frame_uniforms(SE_Renderer3D *renderer) {
+    SE_Frame_Uniforms frame = {0};
+    SE_Camera3D *camera = renderer->current_camera;
+
+        //- Camera
+    frame.projection_view = mat4_mul(camera->view, camera->projection);
+    frame.camera_pos = camera->position;
+    frame.time = renderer->time;
+
+        //- Directional Light
+    SE_Light *light = &renderer->light_directional;
+    // the cascades are updated again by se_render_directional_shadow_map
+    memcpy(frame.shadow_cascade_matrices, renderer->shadow_cascade_matrices, sizeof(frame.shadow_cascade_matrices));
+    frame.num_of_shadow_cascades = se_math_max(1, se_math_min(renderer->shadow_cascades_count, SERENDERER3D_MAX_SHADOW_CASCADES));
+    frame.dir_light.direction = vec3_normalised(light->direction);
+    frame.dir_light.intensity = light->intensity;
+    frame.dir_light.ambient   = rgb_to_vec3(light->ambient);
+    frame.dir_light.diffuse   = rgb_to_vec3(light->diffuse);
+    frame.dir_light.specular  = v3f(0, 0, 0);
+
+        //- Point Lights
+    frame.num_of_point_lights = renderer->point_lights_count;
+    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
+        SE_Light_Point *point_light = &renderer->point_lights[i];
+        frame.point_lights[i].position  = point_light->position;
+        frame.point_lights[i].ambient   = rgb_to_vec3(point_light->ambient);
+        frame.point_lights[i].diffuse   = rgb_to_vec3(point_light->diffuse);
+        frame.point_lights[i].specular  = rgb_to_vec3(point_light->specular);
+        frame.point_lights[i].constant  = point_light->constant;
+        frame.point_lights[i].linear    = point_light->linear;
+        frame.point_lights[i].quadratic = point_light->quadratic;
+        frame.point_lights[i].far_plane = se_render3d_point_light_range(point_light);
+        point_light_shadow_matrices(renderer, point_light, &frame.point_light_shadow_matrices[i * 6]);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, renderer->frame_uniform_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SE_Frame_Uniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SE_FRAME_UNIFORMS_BINDING, renderer->frame_uniform_buffer);
+}
+
+void se_render3d_reset_stats(SE_Renderer3D *renderer) {
+    memset(&renderer->stats, 0, sizeof(renderer->stats));
+    se_gl_state_reset_stats();
+}
+
 void se_render_post_process(SE_Renderer3D *renderer, SE_RENDER_POSTPROCESS post_process, const SE_Render_Target *previous_render_pass) {
-    SE_Shader *shader;
+    // the texture units are set in shader_uniforms_resolve
+    u32 shader_index = renderer->shader_post_process_tonemap;
     switch (post_process) {
         case SE_RENDER_POSTPROCESS_TONEMAP: {
-            shader = renderer->user_shaders[renderer->shader_post_process_tonemap];
-        } break;
-        case SE_RENDER_POSTPROCESS_BLUR: {
-            shader = renderer->user_shaders[renderer->shader_post_process_blur];
-            se_shader_use(shader);
-            se_shader_set_uniform_i32(shader, "texture_to_blur", 1); // get the bright colour channel from lit_footer.fsd
+            shader_index = renderer->shader_post_process_tonemap;
         } break;
         case SE_RENDER_POSTPROCESS_DOWNSAMPLE: {
-            shader = renderer->user_shaders[renderer->shader_post_process_downsample];
-            se_shader_use(shader);
-            se_shader_set_uniform_vec2(shader, "src_resolution",
+            shader_index = renderer->shader_post_process_downsample;
+            se_uniform_set_vec2(renderer->user_shader_uniforms[shader_index].src_resolution,
                 v2f(renderer->viewport.w, renderer->viewport.h));
 
         } break;
         case SE_RENDER_POSTPROCESS_UPSAMPLE: {
-            shader = renderer->user_shaders[renderer->shader_post_process_upsample];
-            se_shader_use(shader);
-            se_shader_set_uniform_f32(shader, "src_resolution", 3.0f);
+            shader_index = renderer->shader_post_process_upsample;
+            se_uniform_set_f32(renderer->user_shader_uniforms[shader_index].filter_radius, renderer->bloom_filter_radius);
         } break;
         case SE_RENDER_POSTPROCESS_BLOOM: {
-            shader = renderer->user_shaders[renderer->shader_post_process_bloom];
-            se_shader_use(shader);
-            se_shader_set_uniform_i32(shader, "bloom_texture", 1);
+            shader_index = renderer->shader_post_process_bloom;
         } break;
     }
 
-    se_shader_use(shader);
-    se_shader_set_uniform_i32(shader, "texture_id", 0);
+    se_shader_use(renderer->user_shaders[shader_index]);
 
     for (u32 i = 0; i < previous_render_pass->colour_buffers_count; ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, previous_render_pass->colour_buffers[i]);
+        se_gl_active_texture(GL_TEXTURE0 + i);
+        se_gl_bind_texture(GL_TEXTURE_2D, previous_render_pass->colour_buffers[i]);
     }
 
-    glBindVertexArray(renderer->screen_quad_vao);
+    se_gl_bind_vertex_array(renderer->screen_quad_vao);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 }
 
-void se_render_post_process_gaussian_blur(SE_Renderer3D *renderer, const SE_Render_Target *previous_render_pass, b8 horizontal) {
-    SE_Shader *shader = renderer->user_shaders[renderer->shader_post_process_gaussian_blur];
+    /// (Re)allocates the bloom mips for a scene of the given size if it or bloom_mips_count changed
+static void bloom_mips_update(SE_Renderer3D *renderer, Vec2 scene_size) {
+    u32 mips_count = se_math_min(se_math_max(renderer->bloom_mips_count, 1), SERENDERER3D_MAX_BLOOM_MIPS);
+        // the scene is too small for more once a mip would be less than a pixel. The first one is always there,
+        // clamped to a pixel, so tiny (eg minimised) windows still have something to bloom into
+    for (u32 i = 1, w = (u32)scene_size.x / 2, h = (u32)scene_size.y / 2; i < mips_count; ++i) {
+        w /= 2;
+        h /= 2;
+        if (w < 1 || h < 1) {
+            mips_count = i;
+            break;
+        }
+    }
+    if (renderer->bloom_mips_allocated == mips_count
+        && renderer->bloom_scene_size.x == scene_size.x && renderer->bloom_scene_size.y == scene_size.y) return;
+
+    glDeleteTextures(renderer->bloom_mips_allocated, renderer->bloom_mips);
+    renderer->bloom_mips_allocated = 0;
+    renderer->bloom_scene_size = scene_size;
+
+    i32 w = (i32)scene_size.x;
+    i32 h = (i32)scene_size.y;
+    for (u32 i = 0; i < mips_count; ++i) {
+        w = se_math_max(w / 2, 1);
+        h = se_math_max(h / 2, 1);
+        GLuint mip;
+        glGenTextures(1, &mip);
+        se_gl_bind_texture(GL_TEXTURE_2D, mip);
+            // positive hdr colours only, half the size of RGBA16F
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, w, h, 0, GL_RGB, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        renderer->bloom_mips[i] = mip;
+        renderer->bloom_mip_sizes[i] = v2f(w, h);
+        renderer->bloom_mips_allocated++;
+    }
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 
-    se_shader_use(shader);
-    se_shader_set_uniform_i32(shader, "texture_id", 0); // the BrightColour channel
-    se_shader_set_uniform_i32(shader, "bright_colour_texture", 1); // the BrightColour channel
-    se_shader_set_uniform_i32(shader, "horizontal", (i32)horizontal);
+    if (renderer->bloom_fbo == 0) {
+        glGenFramebuffers(1, &renderer->bloom_fbo);
+    }
+}
 
-    for (u32 i = 0; i < previous_render_pass->colour_buffers_count; ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, previous_render_pass->colour_buffers[i]);
+    /// Draws the screen quad to mip "target" of the bloom with "source" on texture unit 0
+static void bloom_draw_mip(SE_Renderer3D *renderer, u32 target, GLuint source) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderer->bloom_mips[target], 0);
+    glViewport(0, 0, renderer->bloom_mip_sizes[target].x, renderer->bloom_mip_sizes[target].y);
+    se_gl_active_texture(GL_TEXTURE0);
+    se_gl_bind_texture(GL_TEXTURE_2D, source);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void se_render_bloom(SE_Renderer3D *renderer, const SE_Render_Target *scene) {
+    bloom_mips_update(renderer, scene->texture_size);
+    u32 mips_count = renderer->bloom_mips_allocated; // at least 1
+
+        // remember where the result goes
+    GLint target_framebuffer;
+    GLint target_viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, target_viewport);
+
+    se_gl_disable(GL_BLEND);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, renderer->bloom_fbo);
+    se_gl_bind_vertex_array(renderer->screen_quad_vao);
+
+        //- Downsample
+    // the first one keeps the colours over the threshold, the 13 taps keep small bright spots from flickering
+    // the texture units of the bloom shaders are set in shader_uniforms_resolve
+    const SE_Shader_Uniforms *downsample = &renderer->user_shader_uniforms[renderer->shader_post_process_downsample];
+    se_shader_use(renderer->user_shaders[renderer->shader_post_process_downsample]);
+    se_uniform_set_f32(downsample->threshold, renderer->bloom_threshold);
+    se_uniform_set_i32(downsample->apply_threshold, true);
+    se_uniform_set_vec2(downsample->src_resolution, scene->texture_size);
+    bloom_draw_mip(renderer, 0, scene->colour_buffers[0]);
+    se_uniform_set_i32(downsample->apply_threshold, false);
+    for (u32 i = 1; i < mips_count; ++i) {
+        se_uniform_set_vec2(downsample->src_resolution, renderer->bloom_mip_sizes[i - 1]);
+        bloom_draw_mip(renderer, i, renderer->bloom_mips[i - 1]);
     }
 
-    glBindVertexArray(renderer->screen_quad_vao);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+        //- Upsample
+    // from the smallest mip up, each is filtered and added on top of the next bigger one
+    const SE_Shader_Uniforms *upsample = &renderer->user_shader_uniforms[renderer->shader_post_process_upsample];
+    se_shader_use(renderer->user_shaders[renderer->shader_post_process_upsample]);
+    se_uniform_set_f32(upsample->filter_radius, renderer->bloom_filter_radius);
+    se_gl_enable(GL_BLEND);
+    se_gl_blend_func(GL_ONE, GL_ONE);
+    for (u32 i = mips_count - 1; i > 0; --i) {
+        bloom_draw_mip(renderer, i - 1, renderer->bloom_mips[i]);
+    }
+    se_gl_disable(GL_BLEND);
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+
+        //- Combine with the scene
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, target_framebuffer);
+    glViewport(target_viewport[0], target_viewport[1], target_viewport[2], target_viewport[3]);
+    const SE_Shader_Uniforms *bloom = &renderer->user_shader_uniforms[renderer->shader_post_process_bloom];
+    se_shader_use(renderer->user_shaders[renderer->shader_post_process_bloom]);
+    se_uniform_set_f32(bloom->bloom_strength, renderer->bloom_strength);
+    se_gl_active_texture(GL_TEXTURE0);
+    se_gl_bind_texture(GL_TEXTURE_2D, scene->colour_buffers[0]);
+    se_gl_active_texture(GL_TEXTURE1);
+    se_gl_bind_texture(GL_TEXTURE_2D, renderer->bloom_mips[0]);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
+    se_gl_active_texture(GL_TEXTURE0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
+    se_gl_bind_vertex_array(0);
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    /// Grows the shadow scratch memory to fit "casters_count" casters and "meshes_count" meshes
+static void shadow_scratch_reserve(SE_Shadow_Scratch *scratch, u32 casters_count, u32 meshes_count) {
+    if (scratch->casters_capacity < casters_count) {
+        scratch->casters_capacity = casters_count;
+        scratch->static_masks        = realloc(scratch->static_masks, casters_count);
+        scratch->dynamic_masks       = realloc(scratch->dynamic_masks, casters_count);
+        scratch->face_masks          = realloc(scratch->face_masks, casters_count);
+        scratch->found               = realloc(scratch->found, sizeof(u32) * casters_count);
+        scratch->masked_mesh_indices = realloc(scratch->masked_mesh_indices, sizeof(u32) * casters_count);
+        scratch->masked_transforms   = realloc(scratch->masked_transforms, sizeof(Mat4) * casters_count);
+        scratch->masked_animators    = realloc(scratch->masked_animators, sizeof(u32) * casters_count);
+        scratch->grouped_transforms  = realloc(scratch->grouped_transforms, sizeof(Mat4) * casters_count);
+        scratch->grouped_animators   = realloc(scratch->grouped_animators, sizeof(u32) * casters_count);
+    }
+    if (scratch->meshes_capacity < meshes_count) {
+        scratch->meshes_capacity = meshes_count;
+        scratch->mesh_masks   = realloc(scratch->mesh_masks, meshes_count);
+        scratch->mesh_offsets = realloc(scratch->mesh_offsets, sizeof(u32) * (meshes_count + 1));
+    }
 }
 
-void se_render_directional_shadow_map(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, u32 count, AABB3D world_aabb) {
-    SE_Light *light = &renderer->light_directional;
-        // -- shadow mapping
-    /* calculate the matrices */
-    f32 world_aabb_width  = se_math_abs(world_aabb.min.x) + se_math_abs(world_aabb.max.x);
-    f32 world_aabb_height = se_math_abs(world_aabb.min.z) + se_math_abs(world_aabb.max.z);
-    f32 world_aabb_size = se_math_max(world_aabb_width, world_aabb_height);
-    f32 left   = -world_aabb_size;
-    f32 right  = +world_aabb_size;
-    f32 bottom = -world_aabb_size;
-    f32 top    = +world_aabb_size;
-    f32 near   = -world_aabb_size;
-    f32 far    = +world_aabb_size;
+static void shadow_scratch_deinit(SE_Shadow_Scratch *scratch) {
+    free(scratch->static_masks);
+    free(scratch->dynamic_masks);
+    free(scratch->face_masks);
+    free(scratch->found);
+    free(scratch->masked_mesh_indices);
+    free(scratch->masked_transforms);
+    free(scratch->masked_animators);
+    free(scratch->grouped_transforms);
+    free(scratch->grouped_animators);
+    free(scratch->mesh_masks);
+    free(scratch->mesh_offsets);
+    memset(scratch, 0, sizeof(SE_Shadow_Scratch));
+}
+
+    /// Draws the casters whose mask isn't zero to the bound shadow map. The masks are the cascades (directional light) or
+    /// the cube map faces (point light "point_light_index") each caster overlaps. "animator_indices" can be NULL.
+static void render_shadow_casters
+(SE_Renderer3D *renderer, i32 point_light_index, const u32 *mesh_indices, const Mat4 *transforms, const u32 *animator_indices,
+ const ubyte *masks, u32 count) {
+    u32 meshes_count = renderer->user_meshes_count;
+    SE_Shadow_Scratch *scratch = &renderer->shadow_scratch;
+    shadow_scratch_reserve(scratch, count, meshes_count);
+    u32 *masked_mesh_indices = scratch->masked_mesh_indices;
+    Mat4 *masked_transforms = scratch->masked_transforms;
+    u32 *masked_animators = scratch->masked_animators;
+    ubyte *mesh_masks = scratch->mesh_masks;
+    Mat4 *grouped_transforms = scratch->grouped_transforms;
+    u32 *grouped_animators = scratch->grouped_animators;
+    u32 *mesh_offsets = scratch->mesh_offsets;
+
+    // draw every mesh once with all of its transforms
+    u32 masked_count = gather_masked_mesh_transforms(renderer, mesh_indices, transforms, animator_indices, masks, count,
+        masked_mesh_indices, masked_transforms, masked_animators, mesh_masks);
+    group_transforms_by_mesh(renderer, masked_mesh_indices, masked_transforms, masked_animators, masked_count,
+        grouped_transforms, grouped_animators, mesh_offsets);
+
+    for (u32 mesh_index = 0; mesh_index < meshes_count; ++mesh_index) {
+            // a skinned mesh has one pose per draw, so casters posed by different animators are drawn apart (like se_render3d_execute_queue)
+        b8 is_posed = se_render3d_mesh_is_dynamic_shadow_caster(renderer, mesh_index);
+        u32 end = mesh_offsets[mesh_index + 1];
+        u32 i = mesh_offsets[mesh_index];
+        while (i < end) {
+            u32 animator_index = grouped_animators[i];
+            u32 batch_count = 1;
+            while (i + batch_count < end && (!is_posed || grouped_animators[i + batch_count] == animator_index)) {
+                batch_count++;
+            }
+            if (point_light_index < 0) {
+                recursive_render_directional_shadow_map_for_mesh(renderer, mesh_index,
+                    grouped_transforms + i, batch_count, animator_index, mesh_masks[mesh_index]);
+            } else {
+                recursive_render_omnidir_shadow_map_for_mesh(renderer, mesh_index,
+                    grouped_transforms + i, batch_count, animator_index, point_light_index, mesh_masks[mesh_index]);
+            }
+            i += batch_count;
+        }
+    }
+    se_gl_bind_vertex_array(0);
+}
 
+void se_render_directional_shadow_map
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ AABB3D world_aabb) {
+    SE_Light *light = &renderer->light_directional;
     light->calculated_position = v3f(
         -light->direction.x,
         -light->direction.y,
         -light->direction.z
-        // 0
     );
 
-    Mat4 light_proj = mat4_ortho(left, right, bottom, top, near, far);
-    Vec3 light_target = vec3_add(renderer->light_directional.direction, light->calculated_position);
-    Mat4 light_view = mat4_lookat(light->calculated_position, light_target, vec3_up());
-    Mat4 light_space_mat = mat4_mul(light_view, light_proj);
-
-    { // -- visualise the orhto projection
-        f32 left    = -1;
-        f32 right   = +1;
-        f32 bottom  = -1;
-        f32 top     = +1;
-        f32 near    = -1;
-        f32 far     = +1;
-
-        Vec4 poss_4d[8] = {
-            {.x = left,  .y = bottom, .z = near, 1.0}, // 0
-            {.x = right, .y = bottom, .z = near, 1.0}, // 1
-            {.x = right, .y = top,    .z = near, 1.0}, // 2
-            {.x = left,  .y = top,    .z = near, 1.0}, // 3
-            {.x = left,  .y = bottom, .z = far , 1.0}, // 4
-            {.x = right, .y = bottom, .z = far , 1.0}, // 5
-            {.x = right, .y = top,    .z = far , 1.0}, // 6
-            {.x = left,  .y = top,    .z = far , 1.0}  // 7
-        };
+        //- Cascades
+    // the shadow shaders read the cascade matrices from the per frame uniforms
+    i32 cascades_count = directional_shadow_cascade_matrices(renderer, world_aabb, renderer->shadow_cascade_matrices);
+    glBindBuffer(GL_UNIFORM_BUFFER, renderer->frame_uniform_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SE_Frame_Uniforms, shadow_cascade_matrices),
+        sizeof(renderer->shadow_cascade_matrices), renderer->shadow_cascade_matrices);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SE_Frame_Uniforms, num_of_shadow_cascades), sizeof(i32), &cascades_count);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        //- Culling
+    // a bit per cascade that each caster overlaps
+    shadow_scratch_reserve(&renderer->shadow_scratch, count, renderer->user_meshes_count);
+    ubyte *static_masks = renderer->shadow_scratch.static_masks;
+    ubyte *dynamic_masks = renderer->shadow_scratch.dynamic_masks;
+    u32 *found = renderer->shadow_scratch.found;
+    if (casters != NULL) {
+        memset(static_masks, 0, count);
+        for (i32 c = 0; c < cascades_count; ++c) {
+            SE_Frustum cascade_frustum = se_frustum_from_matrix(renderer->shadow_cascade_matrices[c]);
+            u32 found_count = se_bvh_query_frustum(casters, &cascade_frustum, found, count);
+            for (u32 f = 0; f < found_count; ++f) {
+                if (found[f] < count) static_masks[found[f]] |= 1 << c;
+            }
+        }
+    } else {
+        memset(static_masks, (1 << cascades_count) - 1, count);
+    }
+    b8 has_dynamic = split_dynamic_caster_masks(renderer, mesh_indices, static_masks, dynamic_masks, count);
+
+        //- Render
+    // the static casters are only re-rendered when the cascades moved or the cache was invalidated.
+    // the geometry shader sends each triangle to the layers of the cascades the draw call overlaps
+    b8 cascades_moved = (u32)cascades_count != renderer->shadow_cascades_cached_count
+        || memcmp(renderer->shadow_cascades_cached_matrices, renderer->shadow_cascade_matrices, sizeof(Mat4) * cascades_count) != 0;
+    b8 rebuild = renderer->shadow_cascades_static_dirty || cascades_moved;
+
+    se_gl_disable(GL_CULL_FACE); // @TODO what the f investigate
+    se_gl_cull_face(GL_FRONT);
+    glViewport(0, 0, renderer->directional_shadow_map_size, renderer->directional_shadow_map_size);
+    if (rebuild) {
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, renderer->shadow_cascades_static_fbo);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        render_shadow_casters(renderer, -1, mesh_indices, transforms, animator_indices, static_masks, count);
+
+        memcpy(renderer->shadow_cascades_cached_matrices, renderer->shadow_cascade_matrices, sizeof(Mat4) * cascades_count);
+        renderer->shadow_cascades_cached_count = cascades_count;
+        renderer->shadow_cascades_static_dirty = false;
+        renderer->stats.shadow_maps_rebuilt++;
+    }
+    if (rebuild || has_dynamic || renderer->shadow_cascades_had_dynamic) {
+            // start from the static casters and draw the dynamic ones on top
+        GLsizei size = renderer->directional_shadow_map_size;
+        glCopyImageSubData(renderer->shadow_cascades_static_depth_map, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+                           renderer->shadow_cascades_depth_map,        GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+                           size, size, cascades_count);
+        if (has_dynamic) {
+            se_gl_bind_framebuffer(GL_FRAMEBUFFER, renderer->shadow_cascades_fbo);
+            render_shadow_casters(renderer, -1, mesh_indices, transforms, animator_indices, dynamic_masks, count);
+        }
+    } else {
+        renderer->stats.shadow_maps_skipped++;
+    }
+    renderer->shadow_cascades_had_dynamic = has_dynamic;
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    se_gl_cull_face(GL_BACK);
+    se_gl_enable(GL_CULL_FACE); // @remove after fixing whatever this is
+}
 
-        Mat4 inv_light_space_mat = mat4_inverse(light_space_mat);
-        poss_4d[0] = mat4_mul_vec4(inv_light_space_mat, poss_4d[0]);
-        poss_4d[1] = mat4_mul_vec4(inv_light_space_mat, poss_4d[1]);
-        poss_4d[2] = mat4_mul_vec4(inv_light_space_mat, poss_4d[2]);
-        poss_4d[3] = mat4_mul_vec4(inv_light_space_mat, poss_4d[3]);
-        poss_4d[4] = mat4_mul_vec4(inv_light_space_mat, poss_4d[4]);
-        poss_4d[5] = mat4_mul_vec4(inv_light_space_mat, poss_4d[5]);
-        poss_4d[6] = mat4_mul_vec4(inv_light_space_mat, poss_4d[6]);
-        poss_4d[7] = mat4_mul_vec4(inv_light_space_mat, poss_4d[7]);
-
-        Vec3 poss[8] = {
-            {poss_4d[0].x, poss_4d[0].y, poss_4d[0].z},
-            {poss_4d[1].x, poss_4d[1].y, poss_4d[1].z},
-            {poss_4d[2].x, poss_4d[2].y, poss_4d[2].z},
-            {poss_4d[3].x, poss_4d[3].y, poss_4d[3].z},
-            {poss_4d[4].x, poss_4d[4].y, poss_4d[4].z},
-            {poss_4d[5].x, poss_4d[5].y, poss_4d[5].z},
-            {poss_4d[6].x, poss_4d[6].y, poss_4d[6].z},
-            {poss_4d[7].x, poss_4d[7].y, poss_4d[7].z}
-        };
+    /// Draws the casters to the point light's cube map "depth_map" ("fbo" has every face attached). The per face path attaches
+    /// one face at a time to omni_shadow_face_fbo instead, and each face only draws the casters whose mask has its bit.
+static void render_point_light_shadow_casters
+(SE_Renderer3D *renderer, u32 point_light_index, GLuint depth_map, GLuint fbo, b8 clear,
+ const u32 *mesh_indices, const Mat4 *transforms, const u32 *animator_indices, const ubyte *masks, u32 count) {
+    if (renderer->omni_shadow_path != SE_OMNI_SHADOW_PATH_PER_FACE) {
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+        if (clear) glClear(GL_DEPTH_BUFFER_BIT);
+        render_shadow_casters(renderer, point_light_index, mesh_indices, transforms, animator_indices, masks, count);
+        return;
+    }
 
-        SE_Vertex3D verts[8] = {
-            {.position = poss[0]},
-            {.position = poss[1]},
-            {.position = poss[2]},
-            {.position = poss[3]},
-            {.position = poss[4]},
-            {.position = poss[5]},
-            {.position = poss[6]},
-            {.position = poss[7]}
-        };
+    ubyte *face_masks = renderer->shadow_scratch.face_masks; // reserved by se_render_omnidirectional_shadow_map
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, renderer->omni_shadow_face_fbo);
+    for (u32 face = 0; face < 6; ++face) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, depth_map, 0);
+        if (clear) glClear(GL_DEPTH_BUFFER_BIT);
 
-        u32 indices[24] = {
-            0, 1,
-            0, 3,
-            0, 4,
-            5, 1,
-            5, 6,
-            5, 4,
-            2, 6,
-            2, 3,
-            2, 1,
-            7, 3,
-            7, 6,
-            7, 4
-        };
+        b8 has_casters = false;
+        for (u32 i = 0; i < count; ++i) {
+            face_masks[i] = masks[i] & (1 << face);
+            if (face_masks[i]) has_casters = true;
+        }
+        if (has_casters) {
+            render_shadow_casters(renderer, point_light_index, mesh_indices, transforms, animator_indices, face_masks, count);
+        }
     }
+}
 
-    glDisable(GL_CULL_FACE); // @TODO what the f investigate
-    { /* render the scene from the light's point of view */
-        glCullFace(GL_FRONT);
-        /* configure shadow shader */
-        serender_target_use(&renderer->shadow_render_target);
-        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+void se_render_omnidirectional_shadow_map
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count) {
+    shadow_scratch_reserve(&renderer->shadow_scratch, count, renderer->user_meshes_count);
+    ubyte *static_masks = renderer->shadow_scratch.static_masks;
+    ubyte *dynamic_masks = renderer->shadow_scratch.dynamic_masks;
+    u32 *found = renderer->shadow_scratch.found;
 
-        for (u32 i = 0; i < count; ++i) {
-            u32 mesh_index = mesh_indices[i];
-            if (mesh_index >= renderer->user_meshes_count) continue; // this mesh does not exist
-            Mat4 model_mat = transforms[i];
+    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
+        SE_Light_Point *point_light = &renderer->point_lights[i];
+        f32 range = se_render3d_point_light_range(point_light);
+
+            //- Culling
+        // the matrices of each cube face are in the per frame uniforms (see point_light_shadow_matrices)
+        // a bit per cube map face that each caster overlaps, bit 6 marks the casters in range of the light until it's cleared
+        if (casters != NULL) {
+            Mat4 face_matrices[6];
+            point_light_shadow_matrices(renderer, point_light, face_matrices);
+            memset(static_masks, 0, count);
+
+            u32 found_count = se_bvh_query_sphere(casters, point_light->position, range, found, count);
+            for (u32 f = 0; f < found_count; ++f) {
+                if (found[f] < count) static_masks[found[f]] = 1 << 6;
+            }
+            for (u32 face = 0; face < 6 && found_count > 0; ++face) {
+                SE_Frustum face_frustum = se_frustum_from_matrix(face_matrices[face]);
+                u32 face_found_count = se_bvh_query_frustum(casters, &face_frustum, found, count);
+                for (u32 f = 0; f < face_found_count; ++f) {
+                    if (found[f] < count && static_masks[found[f]] != 0) static_masks[found[f]] |= 1 << face;
+                }
+            }
+            for (u32 j = 0; j < count; ++j) {
+                static_masks[j] &= 0x3F;
+            }
+        } else {
+            memset(static_masks, 0x3F, count);
+        }
+        b8 has_dynamic = split_dynamic_caster_masks(renderer, mesh_indices, static_masks, dynamic_masks, count);
+
+            //- Render
+        // the static casters are only re-rendered when the light moved, its range changed or the cache was invalidated
+        b8 light_moved = memcmp(&point_light->position, &point_light->shadow_cached_position, sizeof(Vec3)) != 0
+            || range != point_light->shadow_cached_range;
+        b8 rebuild = point_light->shadow_static_dirty || light_moved;
+
+        glViewport(0, 0, renderer->omnidirectional_shadow_map_size, renderer->omnidirectional_shadow_map_size);
+        if (rebuild) {
+            render_point_light_shadow_casters(renderer, i, point_light->depth_cube_map_static, point_light->depth_map_static_fbo, true,
+                mesh_indices, transforms, animator_indices, static_masks, count);
+
+            point_light->shadow_cached_position = point_light->position;
+            point_light->shadow_cached_range = range;
+            point_light->shadow_static_dirty = false;
+            renderer->stats.shadow_maps_rebuilt++;
+        }
+        if (rebuild || has_dynamic || point_light->shadow_had_dynamic) {
+                // start from the static casters and draw the dynamic ones on top
+            GLsizei size = renderer->omnidirectional_shadow_map_size;
+            glCopyImageSubData(point_light->depth_cube_map_static, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
+                               point_light->depth_cube_map,        GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
+                               size, size, 6);
+            if (has_dynamic) {
+                render_point_light_shadow_casters(renderer, i, point_light->depth_cube_map, point_light->depth_map_fbo, false,
+                    mesh_indices, transforms, animator_indices, dynamic_masks, count);
+            }
+        } else {
+            renderer->stats.shadow_maps_skipped++;
+        }
+        point_light->shadow_had_dynamic = has_dynamic;
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
 
-            recursive_render_directional_shadow_map_for_mesh(renderer, mesh_index, model_mat, light_space_mat);
+void se_render3d_invalidate_shadows(SE_Renderer3D *renderer, AABB3D region) {
+    for (u32 c = 0; c < renderer->shadow_cascades_cached_count; ++c) {
+        SE_Frustum cascade_frustum = se_frustum_from_matrix(renderer->shadow_cascades_cached_matrices[c]);
+        if (se_frustum_overlaps_aabb(&cascade_frustum, region)) {
+            renderer->shadow_cascades_static_dirty = true;
+            break;
+        }
+    }
+    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
+        SE_Light_Point *point_light = &renderer->point_lights[i];
+        if (aabb3d_overlaps_sphere(region, point_light->shadow_cached_position, point_light->shadow_cached_range)) {
+            point_light->shadow_static_dirty = true;
         }
-        glBindVertexArray(0);
+    }
+}
 
-        glCullFace(GL_BACK);
-        glEnable(GL_CULL_FACE); // @remove after fixing whatever this is
+b8 se_render3d_mesh_is_dynamic_shadow_caster(const SE_Renderer3D *renderer, u32 mesh_index) {
+    for (i32 m = mesh_index; m >= 0 && (u32)m < renderer->user_meshes_count; m = renderer->user_meshes[m]->next_mesh_index) {
+        if (renderer->user_meshes[m]->type == SE_MESH_TYPE_SKINNED) return true;
     }
+    return false;
+}
 
-    serender_target_use(NULL);
+void se_render3d_invalidate_all_shadows(SE_Renderer3D *renderer) {
+    renderer->shadow_cascades_static_dirty = true;
+    for (u32 i = 0; i < SERENDERER3D_MAX_POINT_LIGHTS; ++i) {
+        renderer->point_lights[i].shadow_static_dirty = true;
+    }
+}
 
-    renderer->light_space_matrix = light_space_mat;
+f32 se_render3d_point_light_range(const SE_Light_Point *point_light) {
+    // brightness / (constant + linear * d + quadratic * d^2) = SE_POINT_LIGHT_MIN_ATTENUATION
+    f32 brightness = se_math_max(point_light->diffuse.r, se_math_max(point_light->diffuse.g, point_light->diffuse.b)) / 255.0f;
+    f32 c = point_light->constant - brightness / SE_POINT_LIGHT_MIN_ATTENUATION;
+    f32 range;
+    if (c >= 0) {
+        range = 0; // never bright enough
+    } else if (point_light->quadratic > 0) {
+        f32 b = point_light->linear;
+        f32 a = point_light->quadratic;
+        range = (-b + sqrtf(b * b - 4 * a * c)) / (2 * a);
+    } else if (point_light->linear > 0) {
+        range = -c / point_light->linear;
+    } else {
+        range = SE_POINT_LIGHT_MAX_RANGE;
+    }
+        // the far plane has to stay behind the near plane
+    return se_math_min(se_math_max(range, SE_POINT_LIGHT_SHADOW_NEAR_PLANE * 2), SE_POINT_LIGHT_MAX_RANGE);
 }
 
-void se_render_omnidirectional_shadow_map(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, u32 count) {
-    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
-        SE_Light_Point *point_light = &renderer->point_lights[i];
-        glViewport(0, 0, renderer->omnidirectional_shadow_map_size, renderer->omnidirectional_shadow_map_size);
-        glBindFramebuffer(GL_FRAMEBUFFER, point_light->depth_map_fbo);
-            glClear(GL_DEPTH_BUFFER_BIT);
-            Mat4 shadow_transforms[6];
-            f32 far  = 25.0f;
-            { // configure shader and matrices
-                // projection
-                f32 aspect = renderer->omnidirectional_shadow_map_size / (f32)renderer->omnidirectional_shadow_map_size;
-                f32 near = 1.0f;
-                Mat4 shadow_proj = mat4_perspective(SEMATH_DEG2RAD_MULTIPLIER * 90.0f, aspect, near, far);
-                // views for each face
-                shadow_transforms[0] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(1, 0, 0)), vec3_down()),
-                    shadow_proj);
-                shadow_transforms[1] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(-1, 0, 0)), vec3_down()),
-                    shadow_proj);
-                shadow_transforms[2] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 1, 0)), vec3_forward()), // !if it doesn't work it's because I swapped froward and backward in semath.c. change these to vec3_backward()
-                    shadow_proj);
-                shadow_transforms[3] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, -1, 0)), vec3_forward()), // !if it doesn't work it's because I swapped froward and backward in semath.c. change these to vec3_backward()
-                    shadow_proj);
-                shadow_transforms[4] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 0, 1)), vec3_down()),
-                    shadow_proj);
-                shadow_transforms[5] = mat4_mul(
-                    mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 0, -1)), vec3_down()),
-                    shadow_proj);
-            }
-            // render scene
-            for (u32 i = 0; i < count; ++i) {
-                u32 mesh_index = mesh_indices[i];
-                if (mesh_index >= renderer->user_meshes_count) continue; // this mesh does not exist
-                Mat4 model_mat = transforms[i];
-                recursive_render_omnidir_shadow_map_for_mesh(renderer, mesh_index, model_mat, point_light, shadow_transforms, far);
+SE_OMNI_SHADOW_PATH se_render3d_set_omni_shadow_path(SE_Renderer3D *renderer, SE_OMNI_SHADOW_PATH path) {
+    if (path == SE_OMNI_SHADOW_PATH_AUTO) {
+        path = renderer->omni_shadow_vertex_layer_supported ? SE_OMNI_SHADOW_PATH_VERTEX_LAYER : SE_OMNI_SHADOW_PATH_PER_FACE;
+    }
+    if (path == SE_OMNI_SHADOW_PATH_VERTEX_LAYER && !renderer->omni_shadow_vertex_layer_supported) {
+        printf("point light shadows: gl_Layer can't be written from vertex shaders, falling back to one draw call per face\n");
+        path = SE_OMNI_SHADOW_PATH_PER_FACE;
+    }
+    renderer->omni_shadow_path = path;
+    for (u32 i = 0; i < SERENDERER3D_MAX_POINT_LIGHTS; ++i) {
+        renderer->point_lights[i].shadow_static_dirty = true;
+    }
+    return path;
+}
+
+f64 se_render3d_benchmark_omni_shadows
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ u32 iterations) {
+    const char *path_names[SE_OMNI_SHADOW_PATH_COUNT] = {"auto", "geometry shader", "vertex layer", "per face"};
+    SE_OMNI_SHADOW_PATH previous_path = renderer->omni_shadow_path;
+    GLint previous_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+    GLuint query;
+    glGenQueries(1, &query);
+
+    f64 result = 0;
+    for (u32 path = SE_OMNI_SHADOW_PATH_GEOMETRY_SHADER; path < SE_OMNI_SHADOW_PATH_COUNT; ++path) {
+        if (path == SE_OMNI_SHADOW_PATH_VERTEX_LAYER && !renderer->omni_shadow_vertex_layer_supported) continue;
+        se_render3d_set_omni_shadow_path(renderer, path);
+        glFinish();
+
+        u32 draw_calls_start = renderer->stats.draw_calls;
+        u64 start = SDL_GetPerformanceCounter();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (u32 it = 0; it < iterations; ++it) {
+            for (u32 i = 0; i < renderer->point_lights_count; ++i) { // render from scratch every time
+                renderer->point_lights[i].shadow_static_dirty = true;
             }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            se_render_omnidirectional_shadow_map(renderer, mesh_indices, transforms, animator_indices, casters, count);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        u64 cpu_ticks = SDL_GetPerformanceCounter() - start;
+        GLuint64 gpu_ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns); // waits for the gpu
+
+        f64 gpu_ms = gpu_ns / 1000000.0 / iterations;
+        f64 cpu_ms = cpu_ticks * 1000.0 / (f64)SDL_GetPerformanceFrequency() / iterations;
+        printf("point light shadows (%s): %u lights, %.3f ms gpu, %.3f ms cpu, %u draw calls per frame\n",
+                path_names[path], renderer->point_lights_count, gpu_ms, cpu_ms,
+                (renderer->stats.draw_calls - draw_calls_start) / se_math_max(iterations, 1));
+        if (path == previous_path) result = gpu_ms;
+    }
+
+    glDeleteQueries(1, &query);
+    se_render3d_set_omni_shadow_path(renderer, previous_path);
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    return result;
+}
+
+f64 se_render3d_benchmark_directional_shadows
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ AABB3D world_aabb, u32 frames, f32 distance_per_frame) {
+    SE_Camera3D *camera = renderer->current_camera;
+    SE_Camera3D previous_camera = *camera;
+    f32 previous_snap = renderer->shadow_cascade_snap;
+    GLint previous_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+    GLuint query;
+    glGenQueries(1, &query);
+    Vec3 front = se_camera3d_get_front(camera);
+
+        // cascades that follow the camera texel by texel, then the renderer's snapping
+    f32 snaps[2] = {0.0f, previous_snap};
+    f64 result = 0;
+    for (u32 s = 0; s < 2; ++s) {
+        renderer->shadow_cascade_snap = snaps[s];
+        renderer->shadow_cascades_static_dirty = true;
+        glFinish();
+
+        u32 rebuilt_start = renderer->stats.shadow_maps_rebuilt;
+        u64 start = SDL_GetPerformanceCounter();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (u32 frame = 0; frame < frames; ++frame) {
+            camera->position = vec3_add(previous_camera.position, vec3_mul_scalar(front, distance_per_frame * frame));
+            camera->view = se_camera3d_get_view(camera);
+            se_render_directional_shadow_map(renderer, mesh_indices, transforms, animator_indices, casters, count, world_aabb);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        u64 cpu_ticks = SDL_GetPerformanceCounter() - start;
+        GLuint64 gpu_ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns); // waits for the gpu
+
+        f64 gpu_ms = gpu_ns / 1000000.0 / se_math_max(frames, 1);
+        f64 cpu_ms = cpu_ticks * 1000.0 / (f64)SDL_GetPerformanceFrequency() / se_math_max(frames, 1);
+        printf("directional shadows (snap %.3f, camera moving %.3f per frame): static casters re-rendered in %u of %u frames, %.3f ms gpu, %.3f ms cpu\n",
+                snaps[s], distance_per_frame, renderer->stats.shadow_maps_rebuilt - rebuilt_start, frames, gpu_ms, cpu_ms);
+        result = gpu_ms;
     }
+
+    glDeleteQueries(1, &query);
+    *camera = previous_camera;
+    renderer->shadow_cascade_snap = previous_snap;
+    renderer->shadow_cascades_static_dirty = true;
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    return result;
 }
 
 void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
+    se_render3d_init_ext(renderer, current_camera, SE_OMNI_SHADOW_PATH_AUTO);
+}
+
+void se_render3d_init_ext(SE_Renderer3D *renderer, SE_Camera3D *current_camera, SE_OMNI_SHADOW_PATH omni_shadow_path) {
     memset(renderer, 0, sizeof(SE_Renderer3D)); // default everything to zero
     renderer->current_camera = current_camera;
     renderer->light_directional.intensity = 0.5f;
     renderer->gamma = 2.2f;
+    renderer->import_settings = se_mesh_import_settings_default();
+    renderer->lod_error_threshold = 1.0f / 1080.0f; // about a pixel at 1080p
+    renderer->lod_shadow_error_threshold = 4.0f / 1080.0f;
+    renderer->instancing = true;
 
         //- SHADERS
         // lit
-    const char *lit_vertex_files[2] = {shader_filename_lit_header_vsd, shader_filename_lit_vsd};
-    const char *lit_fragment_files[2] = {shader_filename_lit_header_fsd, shader_filename_lit_fsd};
-    const char *skinned_vertex_files[1] = {shader_filename_lit_skinned_vsd};
+    const char *lit_vertex_files[4] = {shader_filename_frame_header, shader_filename_vertex_header_vsd, shader_filename_lit_header_vsd, shader_filename_lit_vsd};
+    const char *lit_fragment_files[3] = {shader_filename_frame_header, shader_filename_lit_header_fsd, shader_filename_lit_fsd};
+    const char *skinned_vertex_files[3] = {shader_filename_frame_header, shader_filename_vertex_header_vsd, shader_filename_lit_skinned_vsd};
 
         // shadow calc
-    const char *shadow_calc_directional_vsd_files[1] = {
+    const char *shadow_calc_directional_vsd_files[3] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
         shader_filename_shadow_calc_directional_vsd
     };
     const char *shadow_calc_directional_fsd_files[1] = {
         shader_filename_shadow_calc_directional_fsd
     };
-    const char *shadow_calc_directional_skinned_vsd_files[1] = {
+    const char *shadow_calc_directional_gsd_files[2] = {
+        shader_filename_frame_header,
+        shader_filename_shadow_calc_directional_gsd
+    };
+    const char *shadow_calc_directional_skinned_vsd_files[3] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
         shader_filename_shadow_calc_directional_skinned_mesh_vsd
     };
-    const char *shadow_calc_omnidir_vsd_files[1] = {
+    const char *shadow_calc_omnidir_vsd_files[3] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
         shader_filename_shadow_calc_omnidir_vsd
     };
-    const char *shadow_calc_omnidir_fsd_files[1] = {
+    const char *shadow_calc_omnidir_fsd_files[2] = {
+        shader_filename_frame_header,
         shader_filename_shadow_calc_omnidir_fsd
     };
-    const char *shadow_calc_omnidir_gsd_files[1] = {
+    const char *shadow_calc_omnidir_gsd_files[2] = {
+        shader_filename_frame_header,
         shader_filename_shadow_calc_omnidir_gsd
     };
-    const char *shadow_calc_omnidir_skinned_vsd_files[1] = {
+    const char *shadow_calc_omnidir_skinned_vsd_files[3] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
         shader_filename_shadow_calc_omnidir_skinned_mesh_vsd
     };
+    const char *shadow_calc_omnidir_layered_vsd_files[4] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
+        shader_filename_shadow_calc_omnidir_layered_header_vsd,
+        shader_filename_shadow_calc_omnidir_layered_vsd
+    };
+    const char *shadow_calc_omnidir_layered_skinned_vsd_files[4] = {
+        shader_filename_frame_header,
+        shader_filename_vertex_header_vsd,
+        shader_filename_shadow_calc_omnidir_layered_header_vsd,
+        shader_filename_shadow_calc_omnidir_layered_skinned_mesh_vsd
+    };
 
         // lines
     const char *lines_vsd_files[1] = {
@@ -612,16 +1624,6 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
         shader_filename_post_process_tonemap
     };
 
-    const char *post_process_blur[2] = {
-        shader_filename_post_process_header_fsd,
-        shader_filename_post_process_blur
-    };
-
-    const char *post_process_gaussian[2] = {
-        shader_filename_post_process_header_fsd,
-        shader_filename_post_process_gaussian
-    };
-
     const char *post_process_downsample[2] = {
         shader_filename_post_process_header_fsd,
         shader_filename_post_process_downsample
@@ -638,29 +1640,39 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
     };
 
     renderer->shader_lit = se_render3d_add_shader(renderer,
-        lit_vertex_files, 2,
-        lit_fragment_files, 2,
+        lit_vertex_files, 4,
+        lit_fragment_files, 3,
         NULL, 0);
 
     renderer->shader_shadow_calc = se_render3d_add_shader(renderer,
-        shadow_calc_directional_vsd_files, 1,
+        shadow_calc_directional_vsd_files, 3,
         shadow_calc_directional_fsd_files, 1,
-        NULL, 0);
+        shadow_calc_directional_gsd_files, 2);
 
     renderer->shader_shadow_calc_skinned_mesh = se_render3d_add_shader(renderer,
-        shadow_calc_directional_skinned_vsd_files, 1,
+        shadow_calc_directional_skinned_vsd_files, 3,
         shadow_calc_directional_fsd_files, 1,
-        NULL, 0);
+        shadow_calc_directional_gsd_files, 2);
 
     renderer->shader_shadow_omnidir_calc = se_render3d_add_shader(renderer,
-        shadow_calc_omnidir_vsd_files, 1,
-        shadow_calc_omnidir_fsd_files, 1,
-        shadow_calc_omnidir_gsd_files, 1);
+        shadow_calc_omnidir_vsd_files, 3,
+        shadow_calc_omnidir_fsd_files, 2,
+        shadow_calc_omnidir_gsd_files, 2);
 
     renderer->shader_shadow_omnidir_calc_skinned_mesh = se_render3d_add_shader(renderer,
-        shadow_calc_omnidir_skinned_vsd_files, 1,
-        shadow_calc_omnidir_fsd_files, 1,
-        shadow_calc_omnidir_gsd_files, 1);
+        shadow_calc_omnidir_skinned_vsd_files, 3,
+        shadow_calc_omnidir_fsd_files, 2,
+        shadow_calc_omnidir_gsd_files, 2);
+
+    renderer->shader_shadow_omnidir_layered_calc = se_render3d_add_shader(renderer,
+        shadow_calc_omnidir_layered_vsd_files, 4,
+        shadow_calc_omnidir_fsd_files, 2,
+        NULL, 0);
+
+    renderer->shader_shadow_omnidir_layered_calc_skinned_mesh = se_render3d_add_shader(renderer,
+        shadow_calc_omnidir_layered_skinned_vsd_files, 4,
+        shadow_calc_omnidir_fsd_files, 2,
+        NULL, 0);
 
     renderer->shader_lines = se_render3d_add_shader(renderer,
         lines_vsd_files, 1,
@@ -678,8 +1690,8 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
         NULL, 0);
 
     renderer->shader_skinned_mesh = se_render3d_add_shader(renderer,
-        skinned_vertex_files, 1,
-        lit_fragment_files, 2,
+        skinned_vertex_files, 3,
+        lit_fragment_files, 3,
         NULL, 0);
 
     renderer->shader_skinned_mesh_skeleton = se_render3d_add_shader(renderer,
@@ -692,11 +1704,6 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
         post_process_tonemap, 2,
         NULL, 0);
 
-    renderer->shader_post_process_blur = se_render3d_add_shader(renderer,
-        post_process_vsd, 1,
-        post_process_blur, 2,
-        NULL, 0);
-
     renderer->shader_post_process_downsample = se_render3d_add_shader(renderer,
         post_process_vsd, 1,
         post_process_downsample, 2,
@@ -712,11 +1719,6 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
         post_process_bloom, 2,
         NULL, 0);
 
-    renderer->shader_post_process_gaussian_blur = se_render3d_add_shader(renderer,
-        post_process_vsd, 1,
-        post_process_gaussian, 2,
-        NULL, 0);
-
         //- MATERIALS
     //! We must have a default material at index zero.
     //! Because by default meshes point to the zero'th material.
@@ -724,56 +1726,92 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
     u32 default_material_index = se_render3d_add_material(renderer);
     se_assert(default_material_index == SE_DEFAULT_MATERIAL_INDEX && "The default material index that was created in the init() of renderer3D did not match what we expected");
     renderer->user_materials[default_material_index]->base_diffuse = (Vec4) {1, 1, 1, 1};
-    se_texture_load(&renderer->user_materials[default_material_index]->texture_diffuse,
-                    default_diffuse_filepath, SE_TEXTURE_LOAD_CONFIG_CONVERT_TO_LINEAR_SPACE);
-    se_texture_load(&renderer->user_materials[default_material_index]->texture_normal,
-                    default_normal_filepath, SE_TEXTURE_LOAD_CONFIG_NULL);
-    se_texture_load(&renderer->user_materials[default_material_index]->texture_specular,
-                    default_specular_filepath, SE_TEXTURE_LOAD_CONFIG_NULL);
+    se_texture_load_role(&renderer->user_materials[default_material_index]->texture_diffuse,
+                         default_diffuse_filepath, SE_TEXTURE_ROLE_ALBEDO);
+    se_texture_load_role(&renderer->user_materials[default_material_index]->texture_normal,
+                         default_normal_filepath, SE_TEXTURE_ROLE_NORMAL);
+    se_texture_load_role(&renderer->user_materials[default_material_index]->texture_specular,
+                         default_specular_filepath, SE_TEXTURE_ROLE_DATA);
     renderer->user_materials[default_material_index]->shader_index = renderer->shader_lit;
     renderer->user_materials[default_material_index]->type = SE_MATERIAL_TYPE_LIT;
 
         //- SHADOW MAPPING
-    renderer->directional_shadow_map_size = 2048;
-    serender_target_init(&renderer->shadow_render_target,
-        v2f(renderer->directional_shadow_map_size, renderer->directional_shadow_map_size), 1, true);
+    renderer->directional_shadow_map_size = 1024;
+    renderer->shadow_cascades_count = SERENDERER3D_MAX_SHADOW_CASCADES;
+    renderer->shadow_cascade_split_lambda = 0.75f;
+    renderer->shadow_distance = 100.0f;
+    renderer->shadow_cascade_snap = 0.25f; // 12.5% bigger cascades, the static casters are re-rendered every quarter of a cascade
     renderer->omnidirectional_shadow_map_size = 1024;
 
+        //- BLOOM
+    renderer->bloom_mips_count = 6;
+    renderer->bloom_threshold = 1.2f;
+    renderer->bloom_filter_radius = 0.005f;
+    renderer->bloom_strength = 1.0f;
+
+    {   //- DIRECTIONAL LIGHT SHADOW CASCADES
+        // every layer is attached, the geometry shader picks one per triangle with gl_Layer
+        shadow_depth_map_init(GL_TEXTURE_2D_ARRAY, renderer->directional_shadow_map_size, SERENDERER3D_MAX_SHADOW_CASCADES,
+            &renderer->shadow_cascades_depth_map, &renderer->shadow_cascades_fbo);
+        shadow_depth_map_init(GL_TEXTURE_2D_ARRAY, renderer->directional_shadow_map_size, SERENDERER3D_MAX_SHADOW_CASCADES,
+            &renderer->shadow_cascades_static_depth_map, &renderer->shadow_cascades_static_fbo);
+        renderer->shadow_cascades_static_dirty = true;
+    }
+
     {   // - POINT LIGHT SHADOW MAPPING
+        // ! note: Normally we'd attach a single face of a cubemap texture to the framebuffer object and render the scene 6 times,
+        // ! each time swiching the depth buffer target of the framebuffer to a different cubemap face. Since we're going to
+        // ! use a geometry shader, that allows us to render to all faces in a single pass, we can directly attach the cubemap
+        // ! as a framebuffer's depth attachment with glFramebufferTexture (- from learnopengl.com)
+        // the vertex layer path renders to every face in a single pass too, without the geometry shader.
+        // the per face path does it the normal way with omni_shadow_face_fbo
+        renderer->omni_shadow_vertex_layer_supported = GLEW_ARB_shader_viewport_layer_array || GLEW_AMD_vertex_shader_layer;
+        se_render3d_set_omni_shadow_path(renderer, omni_shadow_path);
+        glGenFramebuffers(1, &renderer->omni_shadow_face_fbo);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, renderer->omni_shadow_face_fbo);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+
         for (u32 L = 0; L < SERENDERER3D_MAX_POINT_LIGHTS; ++L) {
             SE_Light_Point *point_light = &renderer->point_lights[L];
-            glGenTextures(1, &point_light->depth_cube_map);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, point_light->depth_cube_map);
-            for (u32 i = 0; i < 6; ++i) {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-                    renderer->omnidirectional_shadow_map_size, renderer->omnidirectional_shadow_map_size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-            }
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            // ! note: Normally we'd attach a single face of a cubemap texture to the framebuffer object and render the scene 6 times,
-            // ! each time swiching the depth buffer target of the framebuffer to a different cubemap face. Since we're going to
-            // ! use a geometry shader, that allows us to render to all faces in a single pass, we can directly attach the cubemap
-            // ! as a framebuffer's depth attachment with glFramebufferTexture (- from learnopengl.com)
-            glGenFramebuffers(1, &point_light->depth_map_fbo);
-            glBindFramebuffer(GL_FRAMEBUFFER, point_light->depth_map_fbo);
-            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, point_light->depth_cube_map, 0);
-            glDrawBuffer(GL_NONE);
-            glReadBuffer(GL_NONE);
-
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+            shadow_depth_map_init(GL_TEXTURE_CUBE_MAP, renderer->omnidirectional_shadow_map_size, 6,
+                &point_light->depth_cube_map, &point_light->depth_map_fbo);
+            shadow_depth_map_init(GL_TEXTURE_CUBE_MAP, renderer->omnidirectional_shadow_map_size, 6,
+                &point_light->depth_cube_map_static, &point_light->depth_map_static_fbo);
+            point_light->shadow_static_dirty = true;
         }
     }
 
+    {   //- Per Frame Uniforms
+        glGenBuffers(1, &renderer->frame_uniform_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, renderer->frame_uniform_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(SE_Frame_Uniforms), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, SE_FRAME_UNIFORMS_BINDING, renderer->frame_uniform_buffer);
+    }
+
+    {   //- Instancing
+        glGenBuffers(1, &renderer->instance_buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->instance_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, SERENDERER3D_MAX_INSTANCES * sizeof(Mat4), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        renderer->instance_scratch = malloc(SERENDERER3D_MAX_INSTANCES * sizeof(Mat4));
+    }
+
+        //- Render Queue
+    se_render_queue_init(&renderer->render_queue, SERENDERER3D_RENDER_QUEUE_CAPACITY);
+
+        //- Animation
+    se_job_queue_init(&renderer->animation_jobs, 0);
+    glGenBuffers(1, &renderer->bone_palette_buffer);
+
     {   //- Screen Quad
             // generate buffer
         glGenBuffers(1, &renderer->screen_quad_vbo);
         glGenVertexArrays(1, &renderer->screen_quad_vao);
 
-        glBindVertexArray(renderer->screen_quad_vao);
+        se_gl_bind_vertex_array(renderer->screen_quad_vao);
         glBindBuffer(GL_ARRAY_BUFFER, renderer->screen_quad_vbo);
 
                 // fill it with a quad
@@ -801,7 +1839,7 @@ void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera) {
             glEnableVertexAttribArray(0);
             glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(f32) * 2, 0);
 
-        glBindVertexArray(0);
+        se_gl_bind_vertex_array(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 }
@@ -821,6 +1859,12 @@ void se_render3d_deinit(SE_Renderer3D *renderer) {
     }
     renderer->user_skeletons_count = 0;
 
+        //- User animators
+    for (u32 i = 0; i < renderer->user_animators_count; ++i) {
+        free(renderer->user_animators[i]);
+    }
+    renderer->user_animators_count = 0;
+
         //- User shaders
     for (u32 i = 0; i < renderer->user_shaders_count; ++i) {
         se_shader_deinit(renderer->user_shaders[i]);
@@ -831,6 +1875,29 @@ void se_render3d_deinit(SE_Renderer3D *renderer) {
         //- Screen Quad (Post Process Quad)
     glDeleteBuffers(1, &renderer->screen_quad_vbo);
     glDeleteVertexArrays(1, &renderer->screen_quad_vao);
+    se_gl_state_invalidate();
+
+        //- Per Frame Uniforms
+    glDeleteBuffers(1, &renderer->frame_uniform_buffer);
+
+        //- Instancing
+    glDeleteBuffers(1, &renderer->instance_buffer);
+    free(renderer->instance_scratch);
+    renderer->instance_scratch = NULL;
+
+        //- Render Queue
+    se_render_queue_deinit(&renderer->render_queue);
+
+        //- Shadows
+    shadow_scratch_deinit(&renderer->shadow_scratch);
+
+        //- Animation
+    se_job_queue_deinit(&renderer->animation_jobs);
+    glDeleteBuffers(1, &renderer->bone_palette_buffer);
+    free(renderer->animation_palette);
+    renderer->animation_palette = NULL;
+    renderer->animation_palette_capacity = 0;
+    renderer->animation_palette_count = 0;
 
         //- User materials
     for (u32 i = 0; i < renderer->user_materials_count; ++i) {
@@ -839,11 +1906,22 @@ void se_render3d_deinit(SE_Renderer3D *renderer) {
     renderer->user_materials_count = 0;
 
         //- Shadow mapping
-    serender_target_deinit(&renderer->shadow_render_target);
+    glDeleteTextures(1, &renderer->shadow_cascades_depth_map);
+    glDeleteFramebuffers(1, &renderer->shadow_cascades_fbo);
+    glDeleteTextures(1, &renderer->shadow_cascades_static_depth_map);
+    glDeleteFramebuffers(1, &renderer->shadow_cascades_static_fbo);
     for (u32 L = 0; L < SERENDERER3D_MAX_POINT_LIGHTS; ++L) {
         glDeleteTextures(1, &renderer->point_lights[L].depth_cube_map);
         glDeleteFramebuffers(1, &renderer->point_lights[L].depth_map_fbo);
+        glDeleteTextures(1, &renderer->point_lights[L].depth_cube_map_static);
+        glDeleteFramebuffers(1, &renderer->point_lights[L].depth_map_static_fbo);
     }
+    glDeleteFramebuffers(1, &renderer->omni_shadow_face_fbo);
+
+        //- Bloom
+    glDeleteTextures(renderer->bloom_mips_allocated, renderer->bloom_mips);
+    glDeleteFramebuffers(1, &renderer->bloom_fbo);
+    se_gl_state_invalidate();
 }
 
 u32 se_render3d_add_point_light(SE_Renderer3D *renderer) {
@@ -867,6 +1945,7 @@ u32 se_render3d_add_point_light_ext(SE_Renderer3D *renderer, f32 constant, f32 l
     renderer->point_lights[result].constant  = constant;
     renderer->point_lights[result].linear    = linear;
     renderer->point_lights[result].quadratic = quadratic;
+    renderer->point_lights[result].shadow_static_dirty = true;
 
     return result;
 }
@@ -890,6 +1969,37 @@ u32 se_render3d_add_skeleton(SE_Renderer3D *renderer) {
     return result;
 }
 
+u32 se_render3d_add_animator(SE_Renderer3D *renderer, u32 skeleton_index) {
+    se_assert(renderer->user_animators_count < SERENDERER3D_MAX_ANIMATORS);
+    se_assert(skeleton_index < renderer->user_skeletons_count);
+    u32 result = renderer->user_animators_count;
+    renderer->user_animators_count++;
+    renderer->user_animators[result] = NEW (SE_Animator);
+    se_animator_init(renderer->user_animators[result], skeleton_index, renderer->user_skeletons[skeleton_index]);
+    return result;
+}
+
+void se_render3d_update_animators(SE_Renderer3D *renderer, f32 delta_time) {
+        // room for the biggest skeletons, so the palette only grows when animators are added
+    u32 capacity = renderer->user_animators_count * SE_SKELETON_BONES_CAPACITY;
+    if (renderer->animation_palette_capacity < capacity) {
+        renderer->animation_palette_capacity = capacity;
+        renderer->animation_palette = realloc(renderer->animation_palette, sizeof(Mat4) * capacity);
+    }
+
+    renderer->animation_palette_count = se_animators_update(
+        renderer->user_animators, renderer->user_animators_count, renderer->user_skeletons, delta_time,
+        &renderer->animation_jobs, renderer->animation_palette);
+    if (renderer->animation_palette_count == 0) return;
+
+        // orphan the previous contents so we don't wait on draw calls that are still reading them
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->bone_palette_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, renderer->animation_palette_capacity * sizeof(Mat4), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, renderer->animation_palette_count * sizeof(Mat4), renderer->animation_palette);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SE_BONE_PALETTE_BINDING, renderer->bone_palette_buffer);
+}
+
 u32 se_render3d_add_cube(SE_Renderer3D *renderer) {
     u32 result = renderer->user_meshes_count;
 
@@ -995,5 +2105,6 @@ u32 se_render3d_add_shader(SE_Renderer3D *renderer,
                               fsd_count,
                               gsd_files,
                               gsd_count);
+    shader_uniforms_resolve(&renderer->user_shader_uniforms[result], renderer->user_shaders[result]);
     return result;
 }
\ No newline at end of file
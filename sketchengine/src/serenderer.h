@@ -5,6 +5,11 @@
 /// here's a second attempt at building a graphics library in c
 
 #include "semesh.h"
+#include "sejobs.h"
+#include "semesh_optimise.h"
+#include "serender_queue.h"
+#include "sefrustum.h"
+#include "sebvh.h"
 
 //// Light ////
 
@@ -27,17 +32,156 @@ typedef struct SE_Light_Point {
     f32 quadratic;
 
     /* shadow render target */
-    GLuint depth_cube_map; // a cube map
+    GLuint depth_cube_map; // a cube map, the static casters of depth_cube_map_static with the dynamic ones on top
     GLuint depth_map_fbo;
+    GLuint depth_cube_map_static; // the static casters, only re-rendered when they or the light change
+    GLuint depth_map_static_fbo;
+    Vec3 shadow_cached_position;  // where the light was when the static casters were rendered
+    f32 shadow_cached_range;      // and its range (see se_render3d_point_light_range)
+    b8 shadow_static_dirty;       // the static casters have to be re-rendered (see se_render3d_invalidate_shadows)
+    b8 shadow_had_dynamic;        // dynamic casters were drawn on top of the static ones last time
 } SE_Light_Point;
 
 //// RENDERER ////
 
+    /// What the import pipeline does to meshes after assimp has loaded them. Part of the mesh cache key.
+typedef struct SE_Mesh_Import_Settings {
+    b8 pack_vertices; // if true, normal and skinned meshes use SE_VERTEX_FORMAT_PACKED
+    SE_Mesh_Lod_Settings lods; // how many lods meshes get
+} SE_Mesh_Import_Settings;
+
+SE_Mesh_Import_Settings se_mesh_import_settings_default();
+
 #define SERENDERER3D_MAX_MESHES 10000
 #define SERENDERER3D_MAX_SKELETONS SERENDERER3D_MAX_MESHES
+#define SERENDERER3D_MAX_ANIMATORS SERENDERER3D_MAX_MESHES
 #define SERENDERER3D_MAX_SHADERS 100
 #define SERENDERER3D_MAX_MATERIALS 10000
 #define SERENDERER3D_MAX_POINT_LIGHTS 4
+#define SERENDERER3D_MAX_SHADOW_CASCADES 4 // directional shadow cascades, must match with MAX_NUM_SHADOW_CASCADES in frame_header.glsl
+#define SERENDERER3D_MAX_INSTANCES 4096 // per instanced draw call, bigger batches are split
+#define SERENDERER3D_RENDER_QUEUE_CAPACITY 16384 // draw items per frame
+#define SERENDERER3D_MAX_BLOOM_MIPS 8
+
+    /// Mesh draw call counters. Reset them with se_render3d_reset_stats (eg at the beginning of every frame),
+    /// which also resets the GL state cache counters (see segl_state.h).
+typedef struct SE_Render_Stats {
+    u32 draw_calls;
+    u32 instances; // meshes drawn, an instanced draw call counts all of its instances
+    u32 shadow_maps_rebuilt; // shadow maps (the cascades or a cube map) whose static casters were re-rendered
+    u32 shadow_maps_skipped; // shadow maps that were left as they were
+} SE_Render_Stats;
+
+    /// Every uniform the renderer sets on its shaders per draw call, resolved once when a shader is added
+    /// (see se_render3d_add_shader). Uniforms a shader doesn't have are -1 and setting them does nothing.
+typedef struct SE_Shader_Uniforms {
+    /* vertex_header.vsd */
+    SE_Uniform vertex_is_packed;
+    SE_Uniform vertex_position_offset;
+    SE_Uniform vertex_position_scale;
+    SE_Uniform vertex_uv_offset;
+    SE_Uniform vertex_uv_scale;
+    SE_Uniform is_instanced;
+    SE_Uniform instance_offset;
+
+    /* vertex */
+    SE_Uniform projection_view_model; // lines, skeletons and sprites
+    SE_Uniform model_matrix;
+    SE_Uniform model; // shadow shaders
+    SE_Uniform bone_offset; // skinned meshes and skeletons, see se_render3d_update_animators
+    SE_Uniform bone_count;
+
+    /* material */
+    SE_Uniform material_shininess;
+    SE_Uniform material_diffuse;
+    SE_Uniform material_specular;
+    SE_Uniform material_normal;
+    SE_Uniform material_base_diffuse;
+    SE_Uniform base_diffuse;    // lines, skeletons and sprites
+    SE_Uniform sprite_texture;
+
+    /* shadows */
+    SE_Uniform shadow_map;
+    SE_Uniform point_light_shadow_maps;
+    SE_Uniform light_index; // omnidirectional shadow calculation
+    SE_Uniform face_mask;   // omnidirectional shadow calculation, the cube map faces to render to
+    SE_Uniform cascade_mask; // directional shadow calculation, the cascades to render to
+
+    /* post process */
+    SE_Uniform texture_id;      // the scene or the mip that's being filtered
+    SE_Uniform src_resolution;  // bloom downsample
+    SE_Uniform threshold;
+    SE_Uniform apply_threshold;
+    SE_Uniform filter_radius;   // bloom upsample
+    SE_Uniform bloom_texture;   // bloom combine
+    SE_Uniform bloom_strength;
+} SE_Shader_Uniforms;
+
+    /// Everything that changes once per frame: the camera, the lights and the shadow matrices.
+    /// Uploaded to a uniform buffer by se_render3d_update_frame_uniforms.
+    /// ! THE LAYOUT (std140) MUST MATCH WITH Frame_Uniforms IN frame_header.glsl
+typedef struct SE_Frame_Uniforms {
+    Mat4 projection_view;
+    Mat4 shadow_cascade_matrices[SERENDERER3D_MAX_SHADOW_CASCADES];
+    Mat4 point_light_shadow_matrices[SERENDERER3D_MAX_POINT_LIGHTS * 6];
+    struct {
+        Vec3 direction;
+        f32 intensity;
+        Vec3 ambient;   f32 padding_0;
+        Vec3 diffuse;   f32 padding_1;
+        Vec3 specular;  f32 padding_2;
+    } dir_light;
+    struct {
+        Vec3 position;
+        f32 constant;
+        Vec3 ambient;
+        f32 linear;
+        Vec3 diffuse;
+        f32 quadratic;
+        Vec3 specular;
+        f32 far_plane;
+    } point_lights[SERENDERER3D_MAX_POINT_LIGHTS];
+    Vec3 camera_pos;
+    f32 time;
+    i32 num_of_point_lights;
+    i32 num_of_shadow_cascades;
+    i32 padding[2];
+} SE_Frame_Uniforms;
+
+#define SE_FRAME_UNIFORMS_BINDING 0 // uniform buffer binding point of Frame_Uniforms
+#define SE_BONE_PALETTE_BINDING 1   // shader storage buffer binding point of Bone_Palette (the instance buffer is 0)
+#define SE_POINT_LIGHT_SHADOW_NEAR_PLANE 1.0f
+#define SE_POINT_LIGHT_MIN_ATTENUATION (5.0f / 256.0f) // the light's range ends where it's dimmer than this
+#define SE_POINT_LIGHT_MAX_RANGE 100.0f
+
+    /// How the point lights' shadow cube maps are rendered, picked by se_render3d_init_ext
+typedef enum SE_OMNI_SHADOW_PATH {
+    SE_OMNI_SHADOW_PATH_AUTO,            // vertex layer if the driver supports it, per face otherwise
+    SE_OMNI_SHADOW_PATH_GEOMETRY_SHADER, // one draw call, a geometry shader copies each triangle to the faces it's on
+    SE_OMNI_SHADOW_PATH_VERTEX_LAYER,    // one draw call, instanced once per face, the vertex shader writes gl_Layer
+                                         // (needs GL_ARB_shader_viewport_layer_array or GL_AMD_vertex_shader_layer)
+    SE_OMNI_SHADOW_PATH_PER_FACE,        // a draw call per face, each face only draws the casters it overlaps
+    SE_OMNI_SHADOW_PATH_COUNT
+} SE_OMNI_SHADOW_PATH;
+
+    /// Scratch memory of the shadow passes. Kept between frames and only grown when there are more casters or meshes than before
+typedef struct SE_Shadow_Scratch {
+    u32 casters_capacity;
+    u32 meshes_capacity;
+        // casters_capacity long
+    ubyte *static_masks;        // a bit per cascade or cube map face each caster overlaps
+    ubyte *dynamic_masks;
+    ubyte *face_masks;          // the per face path's masks of the face that's being rendered
+    u32 *found;                 // results of the bvh queries
+    u32 *masked_mesh_indices;   // the casters whose mask isn't zero
+    Mat4 *masked_transforms;
+    u32 *masked_animators;
+    Mat4 *grouped_transforms;   // masked_transforms grouped by mesh
+    u32 *grouped_animators;
+        // meshes_capacity long
+    ubyte *mesh_masks;          // the masks of every caster of a mesh combined
+    u32 *mesh_offsets;          // meshes_capacity + 1, where each mesh's transforms start in grouped_transforms
+} SE_Shadow_Scratch;
 
 typedef struct SE_Renderer3D {
     // ! NOTE THAT EVERYTHING IS SET TO ZERO AT THE BEGINNING OF INIT()
@@ -67,8 +211,14 @@ typedef struct SE_Renderer3D {
     u32 user_skeletons_count;
     SE_Skeleton *user_skeletons[SERENDERER3D_MAX_SKELETONS];
 
+        //- USER ANIMATORS
+        // instances of the skeletons above, each with its own animation, time and pose. Not saved to disk.
+    u32 user_animators_count;
+    SE_Animator *user_animators[SERENDERER3D_MAX_ANIMATORS];
+
     u32 user_shaders_count;
     SE_Shader *user_shaders[SERENDERER3D_MAX_SHADERS];
+    SE_Shader_Uniforms user_shader_uniforms[SERENDERER3D_MAX_SHADERS]; // same index as user_shaders
 
         //- SHADERS
     u32 shader_lit;                      // handles static meshes affected by light and the material system
@@ -81,14 +231,14 @@ typedef struct SE_Renderer3D {
     u32 shader_sprite;                   // handles rendering sprites
     u32 shader_skinned_mesh_skeleton;    // handles rendering the skeleton (lines) of a given mesh with skeleton and animation
     u32 shader_shadow_omnidir_calc_skinned_mesh; // handles point light shadow calculation for skinned meshes
+    u32 shader_shadow_omnidir_layered_calc;      // point light shadows without the geometry shader (see SE_OMNI_SHADOW_PATH)
+    u32 shader_shadow_omnidir_layered_calc_skinned_mesh;
 
         //- Post Process Shaders
     u32 shader_post_process_tonemap;      // applies tone mapping and gamma correction
-    u32 shader_post_process_blur;         // renders the given texture with a blur
     u32 shader_post_process_downsample;
     u32 shader_post_process_upsample;
     u32 shader_post_process_bloom;        // combines 2 textures, the second one being the bloom effect
-    u32 shader_post_process_gaussian_blur;// blurs the BrightColour channel of post process framebuffer
 
     // Generated on init. Used for rendering quads to the screen.
     // Use this by simpling binding the vao
@@ -103,20 +253,78 @@ typedef struct SE_Renderer3D {
     SE_Light_Point point_lights[SERENDERER3D_MAX_POINT_LIGHTS];
 
     /* shadow mapping */
-    // u32 shadow_depth_map_fbo;
-    // u32 shadow_depth_map;
-    SE_Render_Target shadow_render_target;
-    Mat4 light_space_matrix;
-    f32 directional_shadow_map_size;
+    // the directional light's shadow map is split into cascades along the camera's frustum, each is a layer of
+    // shadow_cascades_depth_map and they're all rendered in one pass (see se_render_directional_shadow_map)
+    GLuint shadow_cascades_depth_map; // 2D array texture
+    GLuint shadow_cascades_fbo;
+    u32 shadow_cascades_count;        // 1 to SERENDERER3D_MAX_SHADOW_CASCADES
+    f32 shadow_cascade_split_lambda;  // 0 splits the view evenly, 1 logarithmically (practical split scheme blends the two)
+    f32 shadow_distance;              // how far from the camera the last cascade reaches
+    f32 shadow_cascade_snap;          // the cascades move in steps of this much of their radius (0 for a texel), see se_render_directional_shadow_map
+    Mat4 shadow_cascade_matrices[SERENDERER3D_MAX_SHADOW_CASCADES];
+    f32 directional_shadow_map_size;  // of each cascade
+    // the static casters are cached the same way as the point lights' (see SE_Light_Point)
+    GLuint shadow_cascades_static_depth_map;
+    GLuint shadow_cascades_static_fbo;
+    Mat4 shadow_cascades_cached_matrices[SERENDERER3D_MAX_SHADOW_CASCADES]; // when the static casters were rendered
+    u32 shadow_cascades_cached_count;
+    b8 shadow_cascades_static_dirty;
+    b8 shadow_cascades_had_dynamic;
     f32 omnidirectional_shadow_map_size;
+    SE_OMNI_SHADOW_PATH omni_shadow_path;  // never AUTO, see se_render3d_set_omni_shadow_path
+    b8 omni_shadow_vertex_layer_supported;
+    GLuint omni_shadow_face_fbo;           // the per face path attaches one face of a cube map at a time to this
+    SE_Shadow_Scratch shadow_scratch;
 
     Rect viewport;
 
     f32 gamma;
     f32 time; // the time passed since the beginning (passed into shaders)
+
+        //- Mesh Import
+    SE_Mesh_Import_Settings import_settings; // used for meshes that have to be (re)imported
+
+        //- Level of Detail
+    // the coarsest lod whose error covers less than this fraction of the screen height is drawn
+    f32 lod_error_threshold;
+    f32 lod_shadow_error_threshold; // same for shadow maps, which can get away with coarser lods
+
+        //- Instancing
+    b8 instancing;          // if false, the instanced procedures fall back to one draw call per transform
+    GLuint instance_buffer; // model matrices of the current instanced draw (shader storage buffer, binding 0)
+    Mat4 *instance_scratch; // SERENDERER3D_MAX_INSTANCES model matrices, sorted by lod before uploading
+
+    SE_Render_Stats stats;
+
+        //- Render Queue
+    SE_Render_Queue render_queue; // filled by se_render3d_submit_mesh, drawn by se_render3d_execute_queue
+
+        //- Animation (see se_render3d_update_animators)
+    SE_Job_Queue animation_jobs;
+    u32 animation_palette_count;    // matrices, the sum of the bone counts of every animator
+    u32 animation_palette_capacity;
+    Mat4 *animation_palette;        // the pose of every animator back to back, see SE_Animator.palette_offset
+    GLuint bone_palette_buffer;     // animation_palette on the GPU (shader storage buffer, SE_BONE_PALETTE_BINDING)
+
+        //- Per Frame Uniforms
+    GLuint frame_uniform_buffer; // SE_Frame_Uniforms
+
+        //- Bloom (see se_render_bloom)
+    u32 bloom_mips_count;      // 1 to SERENDERER3D_MAX_BLOOM_MIPS, how many times the bright colours are halved
+    f32 bloom_threshold;       // luminance where the bloom starts
+    f32 bloom_filter_radius;   // of the upsample's tent filter, in uv
+    f32 bloom_strength;        // how much of the bloom is added to the scene
+    GLuint bloom_fbo;
+    GLuint bloom_mips[SERENDERER3D_MAX_BLOOM_MIPS]; // each half the size of the previous, the first is half the scene
+    Vec2 bloom_mip_sizes[SERENDERER3D_MAX_BLOOM_MIPS];
+    u32 bloom_mips_allocated;
+    Vec2 bloom_scene_size;     // the mips are reallocated when the scene's size changes
 } SE_Renderer3D;
 
 void se_render3d_init(SE_Renderer3D *renderer, SE_Camera3D *current_camera);
+    /// Same as se_render3d_init but with the way point light shadows are rendered. Falls back to the per face path
+    /// if the driver doesn't support the requested one.
+void se_render3d_init_ext(SE_Renderer3D *renderer, SE_Camera3D *current_camera, SE_OMNI_SHADOW_PATH omni_shadow_path);
 void se_render3d_deinit(SE_Renderer3D *renderer);
 u32 se_render3d_add_cube(SE_Renderer3D *renderer);
 u32 se_render3d_add_plane(SE_Renderer3D *renderer, Vec3 scale);
@@ -126,10 +334,56 @@ u32 se_render3d_add_line(SE_Renderer3D *renderer, Vec3 pos1, Vec3 pos2, f32 widt
     //- SAVING AND LOADING MESHES
     /// Load a mesh and add it to the renderer. Returns the index of that loaded mesh.
 u32 se_render3d_load_mesh(SE_Renderer3D *renderer, const char *model_filepath, b8 with_animation);
+    /// Imports a model and uploads its meshes "iterations" times in the full vertex format and then in the packed one.
+    /// Prints the bytes per vertex and upload time of both. Returns the average milliseconds of the packed upload.
+f64 se_render3d_benchmark_vertex_formats(const char *model_filepath, u32 iterations);
     /// Generates "SE_Mesh" and adds it to the renderer based on the given save file.
     /// Returns the index of the generated mesh.
 u32 se_save_data_mesh_to_mesh(SE_Renderer3D *renderer, const SE_Save_Data_Meshes *save_data);
 
+    /// Loads several models at once. The import (or .mesh read) and texture decoding of each model runs on worker threads,
+    /// the OpenGL uploads happen on the calling thread when se_render3d_load_meshes_upload is called.
+typedef struct SE_Mesh_Load_Batch {
+    u32 count;
+    struct SE_Mesh_Load_Job *jobs;
+    SE_Job_Queue queue;
+    b8 decoded; // all of the jobs have finished
+    u64 start_ticks;
+} SE_Mesh_Load_Batch;
+    /// Starts importing "model_filepaths" in the background. The filepaths must stay valid until se_render3d_load_meshes_end.
+void se_render3d_load_meshes_begin(SE_Renderer3D *renderer, SE_Mesh_Load_Batch *batch, const char **model_filepaths, u32 count);
+    /// Uploads the model at "index" of the batch and returns its mesh index (-1 if it failed to load).
+    /// Models are added to the renderer in the order this is called, so the mesh indices match the equivalent se_render3d_load_mesh calls.
+u32 se_render3d_load_meshes_upload(SE_Renderer3D *renderer, SE_Mesh_Load_Batch *batch, u32 index);
+void se_render3d_load_meshes_end(SE_Mesh_Load_Batch *batch);
+    /// Same as calling se_render3d_load_mesh for each model in order, but the importing is done in parallel.
+    /// "mesh_indices" must have room for "count" indices.
+void se_render3d_load_meshes(SE_Renderer3D *renderer, const char **model_filepaths, u32 count, u32 *mesh_indices);
+
+    //- MESH CACHE
+    // Imported meshes are cached as .mesh files in SE_MESH_CACHE_DIRECTORY (relative to the working directory).
+    // An entry is named after its content key, a hash of the source file's path and contents, the modified times of the
+    // material libraries it references, the import flags, the import pipeline version, the mesh file version and the import settings.
+    // Editing the source asset changes the key, so stale entries are never loaded and the asset is re-imported automatically.
+    // The textures are only known once the asset has been imported, so an entry also stores a dependencies key
+    // of the textures it references and is re-imported if that doesn't match anymore.
+#define SE_MESH_CACHE_DIRECTORY "cache/meshes"
+    /// Returns the content key of the source asset, or 0 if it could not be read.
+u64 se_mesh_cache_key(const char *model_filepath, const SE_Mesh_Import_Settings *settings);
+    /// Returns the key of the modified times of the textures the meshes in "save_data" reference.
+u64 se_mesh_cache_dependencies_key(const SE_Save_Data_Meshes *save_data);
+    /// Initialises "result" to the filepath of the cache entry for the given key.
+void se_mesh_cache_entry_filepath(SE_String *result, u64 content_key);
+    /// Checks the cache entry of every importable asset in "directory" (recursively) without importing anything.
+    /// Prints the assets that would be re-imported and returns how many there are.
+u32 se_mesh_cache_validate(const char *directory, const SE_Mesh_Import_Settings *settings);
+    /// Deletes the entries no importable asset in "directories" (recursively) maps to anymore, like the ones left behind
+    /// by assets that were edited or removed. Returns how many were deleted.
+u32 se_mesh_cache_prune(const char **directories, u32 directories_count, const SE_Mesh_Import_Settings *settings);
+    /// The offline cooking step. Imports every asset in "directory" (recursively) into the mesh cache and cooks
+    /// their textures into the texture cache (see setexture_cook.h), in parallel. Returns how many failed.
+u32 se_mesh_cache_cook(const char *directory, const SE_Mesh_Import_Settings *settings);
+
     /// Create one of those 3D coordinate gizmos that show the directions
 u32 se_render3d_add_gizmos_coordniates(SE_Renderer3D *renderer);
 u32 se_render3d_add_gizmos_aabb(SE_Renderer3D *renderer, Vec3 min, Vec3 max, f32 line_width);
@@ -142,12 +396,38 @@ void se_render3d_update_gizmos_aabb(SE_Renderer3D *renderer, Vec3 min, Vec3 max,
 u32 se_render3d_add_material(SE_Renderer3D *renderer);
     /// Add an uninitialised skeleton to the renderer
 u32 se_render3d_add_skeleton(SE_Renderer3D *renderer);
+    /// Add an animator playing the skeleton's first animation. Every loaded skinned model gets one and draws
+    /// with it by default (SE_Mesh.animator), add more to draw the same model in different poses.
+u32 se_render3d_add_animator(SE_Renderer3D *renderer, u32 skeleton_index);
+    /// Advances every animator by delta_time and poses it, in parallel on the renderer's worker threads.
+    /// The poses are packed into animation_palette and uploaded to bone_palette_buffer, which every skinned draw
+    /// (camera and shadow passes) reads its pose from. Only the bones of each skeleton are uploaded.
+    /// Call once per frame before rendering. Animators that haven't been through it yet draw in the bind pose.
+void se_render3d_update_animators(SE_Renderer3D *renderer, f32 delta_time);
     /// Add a point light to the renderer
 u32 se_render3d_add_point_light(SE_Renderer3D *renderer);
 u32 se_render3d_add_point_light_ext(SE_Renderer3D *renderer, f32 constant, f32 linear, f32 quadratic);
     /// Setup renderer for rendering (set the configurations to their default values)
 void se_render_mesh_index(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transform, b8 transparent_pass);
 void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform, b8 transparent_pass);
+    /// Renders the mesh (and the meshes linked to it) once for each transform. The material uniforms are set once
+    /// and every lod of the mesh is drawn with a single instanced draw call. Meshes and shaders that don't support
+    /// instancing (lines, sprites, custom shaders that don't use instance_model()) are drawn one transform at a time.
+void se_render_mesh_index_instanced(SE_Renderer3D *renderer, u32 mesh_index, const Mat4 *transforms, u32 count, b8 transparent_pass);
+    /// Adds the mesh (and the meshes linked to it) to the render queue. Nothing is drawn until se_render3d_execute_queue.
+    /// Each mesh goes to the opaque or transparent pass based on its own material.
+void se_render3d_submit_mesh(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transform);
+    /// Same as se_render3d_submit_mesh but the skinned meshes are posed by the given animator instead of their own
+void se_render3d_submit_animated_mesh(SE_Renderer3D *renderer, u32 mesh_index, u32 animator_index, Mat4 transform);
+    /// Sorts and draws everything submitted since the last call, then clears the queue.
+    /// Opaque meshes are drawn first, grouped by shader, material and mesh (one instanced draw per mesh) and front to back.
+    /// Transparent meshes are drawn after, back to front.
+void se_render3d_execute_queue(SE_Renderer3D *renderer);
+void se_render3d_reset_stats(SE_Renderer3D *renderer);
+    /// Uploads the camera, lights and point light shadow matrices to the per frame uniform buffer.
+    /// Call once per frame after the camera and lights are updated, before rendering shadow maps and meshes.
+    /// (The directional light's cascade matrices are updated by se_render_directional_shadow_map.)
+void se_render3d_update_frame_uniforms(SE_Renderer3D *renderer);
 
 
 // @remove
@@ -155,11 +435,52 @@ void se_render_mesh(SE_Renderer3D *renderer, SE_Mesh *mesh, Mat4 transform, b8 t
     /// The uniforms must be setup by the user.
 // void se_render_mesh_with_shader(SE_Renderer3D *renderer, u32 mesh_index, Mat4 transform, u32 user_shader_index);
 
-    /// Render a directional shadow map to the renderer.
+    /// Render the directional light's shadow cascades to the renderer. "world_aabb" bounds the shadow casters, so ones
+    /// outside of the cascades (eg between the light and the camera) still cast shadows into them.
     /// "transforms_count" must be equal to or less than the number of meshes in the renderer.
     /// This procedure will render each mesh based on the given array of transforms.
-void se_render_directional_shadow_map(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, u32 transforms_count, AABB3D world_aabb);
-void se_render_omnidirectional_shadow_map(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, u32 count);
+    /// "animator_indices" poses each skinned caster like se_render3d_submit_animated_mesh, SE_RENDER_NO_ANIMATOR for the
+    /// mesh's own animator. Pass NULL if every caster uses its mesh's animator.
+    /// "casters" holds the world space bounds of each mesh (and the meshes linked to it), the user data of each leaf is
+    /// the mesh's index in "mesh_indices" and "transforms". Each mesh is only drawn to the cascades it overlaps.
+    /// If "casters" is NULL nothing is culled.
+void se_render_directional_shadow_map
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ AABB3D world_aabb);
+    /// Same as the directional version. Meshes out of the range of a point light are culled for that light, and each mesh
+    /// is only drawn to the faces of the cube map it overlaps.
+void se_render_omnidirectional_shadow_map
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count);
+    //- Shadow Caching
+    // Both shadow procedures keep the static casters of each light in a cache that's only re-rendered when the light (or
+    // the cascades, which follow the camera in steps of shadow_cascade_snap) moved or when it's invalidated. Skinned meshes
+    // are dynamic, they're drawn on top of a copy of the cache every frame. A light without dynamic casters whose cache
+    // didn't change is skipped entirely.
+    /// Call when static casters inside "region" move, appear or disappear. The lights that can see it re-render their cache.
+void se_render3d_invalidate_shadows(SE_Renderer3D *renderer, AABB3D region);
+void se_render3d_invalidate_all_shadows(SE_Renderer3D *renderer);
+    /// Skinned meshes (or chains of meshes with one) are animated, so they can't be cached in the static shadow maps.
+    /// Moving them doesn't need se_render3d_invalidate_shadows. False for invalid mesh indices.
+b8 se_render3d_mesh_is_dynamic_shadow_caster(const SE_Renderer3D *renderer, u32 mesh_index);
+    /// The distance at which the light's attenuation (and brightest colour channel) drops below SE_POINT_LIGHT_MIN_ATTENUATION.
+    /// Used as the far plane of its shadow cube map, and casters further away than this are culled.
+f32 se_render3d_point_light_range(const SE_Light_Point *point_light);
+    /// Switches how point light shadows are rendered and invalidates their caches. Returns the path that's used,
+    /// which is the per face path if the driver doesn't support the requested one.
+SE_OMNI_SHADOW_PATH se_render3d_set_omni_shadow_path(SE_Renderer3D *renderer, SE_OMNI_SHADOW_PATH path);
+    /// Renders the point light shadow maps from scratch "iterations" times with each path the driver supports and prints
+    /// the gpu and cpu timings. The arguments are the same as se_render_omnidirectional_shadow_map.
+    /// Returns the average gpu milliseconds of the path in use.
+f64 se_render3d_benchmark_omni_shadows
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ u32 iterations);
+    /// Renders the directional shadows for "frames" frames with the camera moving forwards "distance_per_frame" each frame,
+    /// first with cascades that follow it texel by texel and then with shadow_cascade_snap. Prints how often the static
+    /// casters were re-rendered and the gpu and cpu timings. The other arguments are the same as se_render_directional_shadow_map.
+    /// Returns the average gpu milliseconds of a frame with shadow_cascade_snap.
+f64 se_render3d_benchmark_directional_shadows
+(SE_Renderer3D *renderer, u32 *mesh_indices, Mat4 *transforms, const u32 *animator_indices, const SE_BVH *casters, u32 count,
+ AABB3D world_aabb, u32 frames, f32 distance_per_frame);
 
     /// Adds a custom shader to the renderer and returns its index
 u32 se_render3d_add_shader(SE_Renderer3D *renderer,
@@ -172,7 +493,6 @@ u32 se_render3d_add_shader(SE_Renderer3D *renderer,
 
 typedef enum SE_RENDER_POSTPROCESS {
     SE_RENDER_POSTPROCESS_TONEMAP,
-    SE_RENDER_POSTPROCESS_BLUR,
     SE_RENDER_POSTPROCESS_DOWNSAMPLE,
     SE_RENDER_POSTPROCESS_UPSAMPLE,
     SE_RENDER_POSTPROCESS_BLOOM,
@@ -180,5 +500,9 @@ typedef enum SE_RENDER_POSTPROCESS {
 
     /// Takes the given texture and renders it to the current selected framebuffer with the given post process shader
 void se_render_post_process(SE_Renderer3D *renderer, SE_RENDER_POSTPROCESS post_process, const SE_Render_Target *previous_render_pass);
-void se_render_post_process_gaussian_blur(SE_Renderer3D *renderer, const SE_Render_Target *previous_render_pass, b8 horizontal);
+    /// Adds bloom to the first colour buffer (hdr) of "scene" and draws the result to the bound framebuffer.
+    /// The colours brighter than bloom_threshold are downsampled into a chain of bloom_mips_count mips with a 13 tap filter,
+    /// then each mip is upsampled with a tent filter and added to the one above it. Only the first mip is half the
+    /// size of the scene, so this touches a fraction of the pixels that blurring at full resolution would.
+void se_render_bloom(SE_Renderer3D *renderer, const SE_Render_Target *scene);
 #endif // SERENDERER_OPENGL
\ No newline at end of file
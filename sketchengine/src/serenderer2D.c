@@ -80,8 +80,8 @@ void serender2d_init (SE_Renderer2D *renderer, Rect viewport, f32 min_depth, f32
     glGenBuffers(1,      &renderer->vbo_dynamic);
     glGenVertexArrays(1, &renderer->vao_dynamic);
 
-    glBindVertexArray(                    renderer->vao_dynamic);
-    glBindBuffer(GL_ARRAY_BUFFER,         renderer->vbo_dynamic);
+    se_gl_bind_vertex_array(renderer->vao_dynamic);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->vbo_dynamic);
 
     glBufferData(GL_ARRAY_BUFFER, sizeof(SE_Vertex2D) * SE_SHAPE_POLYGON_VERTEX_MAX_SIZE, NULL, GL_DYNAMIC_DRAW);
 
@@ -94,8 +94,8 @@ void serender2d_init (SE_Renderer2D *renderer, Rect viewport, f32 min_depth, f32
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(SE_Vertex2D), (void*)offsetof(SE_Vertex2D, uv));
 
-    glBindVertexArray(                    0);
-    glBindBuffer(GL_ARRAY_BUFFER,         0);
+    se_gl_bind_vertex_array(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         // viewport
     serender2d_resize(renderer, viewport, min_depth, max_depth);
@@ -110,6 +110,7 @@ void serender2d_deinit (SE_Renderer2D *renderer) {
             // opengl
         glDeleteBuffers(1,      &renderer->vbo_dynamic);
         glDeleteVertexArrays(1, &renderer->vao_dynamic);
+        se_gl_state_invalidate();
     }
 }
 
@@ -131,13 +132,13 @@ void serender2d_clear_shapes (SE_Renderer2D *renderer) {
 
 void serender2d_render (SE_Renderer2D *renderer) {
         // gl config
-    glEnable(GL_BLEND);
-    // glDisable(GL_DEPTH_TEST);
+    se_gl_enable(GL_BLEND);
+    // se_gl_disable(GL_DEPTH_TEST);
         /// untextured shapes
     se_shader_use(&renderer->shader);
     se_shader_set_uniform_mat4(&renderer->shader, "view_projection", renderer->view_projection);
 
-    glBindVertexArray(renderer->vao_dynamic);
+    se_gl_bind_vertex_array(renderer->vao_dynamic);
     glBindBuffer(GL_ARRAY_BUFFER, renderer->vbo_dynamic);
         // rects
     for (u32 i = 0; i < renderer->shape_rect_count; ++i) {
@@ -196,9 +197,9 @@ void serender2d_render (SE_Renderer2D *renderer) {
         vertices[1].colour = shape.colour;
             // update the content of vbo
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glLineWidth(shape.width);
+        se_gl_line_width(shape.width);
         glDrawArrays(GL_LINES, 0, 2);
-        glLineWidth(1);
+        se_gl_line_width(1);
     }
         // textured shapes
     se_shader_use(&renderer->shader_textured);
@@ -245,17 +246,17 @@ void serender2d_render (SE_Renderer2D *renderer) {
         vertices[4].uv = v2f(uv_max.x, uv_max.y);
         vertices[5].uv = v2f(uv_max.x, uv_min.y);
             // texture id
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, shape.texture_id);
+        se_gl_active_texture(GL_TEXTURE0);
+        se_gl_bind_texture(GL_TEXTURE_2D, shape.texture_id);
             // update the content of vbo
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_BLEND);
-    // glEnable(GL_DEPTH_TEST);
+    se_gl_bind_vertex_array(0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
+    se_gl_disable(GL_BLEND);
+    // se_gl_enable(GL_DEPTH_TEST);
 }
 
 void serender2d_add_rect (SE_Renderer2D *renderer, Rect rect, f32 depth, RGBA colour) {
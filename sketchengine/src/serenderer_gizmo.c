@@ -22,6 +22,7 @@ void se_gizmo_renderer_deinit(SE_Gizmo_Renderer *renderer) {
         glDeleteBuffers(1, &renderer->shapes[i].vbo);
         glDeleteBuffers(1, &renderer->shapes[i].ibo);
     }
+    se_gl_state_invalidate();
     renderer->shapes_count = 0;
 }
 
@@ -54,9 +55,9 @@ void se_gizmo_render_index(SE_Gizmo_Renderer *renderer, u32 shape_index, Mat4 tr
 
 void se_gizmo_render(SE_Gizmo_Renderer *renderer, SE_Gizmo_Shape *shape, Mat4 transform) {
         //- Default GL State
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+    se_gl_disable(GL_BLEND);
+    se_gl_enable(GL_CULL_FACE);
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
 
         //- Setup
     i32 primitive = GL_TRIANGLES;
@@ -66,12 +67,12 @@ void se_gizmo_render(SE_Gizmo_Renderer *renderer, SE_Gizmo_Shape *shape, Mat4 tr
     } else
     if (shape->type == SE_GIZMO_TYPE_LINE) {
         primitive = GL_LINES;
-        glLineWidth(shape->line_width);
+        se_gl_line_width(shape->line_width);
         setup_mesh_shader(renderer, shape, transform);
     } else
     if (shape->type == SE_GIZMO_TYPE_POINT) {
         primitive = GL_POINTS;
-        glPointSize(shape->point_size);
+        se_gl_point_size(shape->point_size);
         setup_mesh_shader(renderer, shape, transform);
     } else
     if (shape->type == SE_GIZMO_TYPE_SPRITE) {
@@ -80,7 +81,7 @@ void se_gizmo_render(SE_Gizmo_Renderer *renderer, SE_Gizmo_Shape *shape, Mat4 tr
     }
 
         //- Draw call
-    glBindVertexArray(shape->vao);
+    se_gl_bind_vertex_array(shape->vao);
     if (shape->indexed) {
         glDrawElements(primitive, shape->vert_count, GL_UNSIGNED_INT, 0);
     } else {
@@ -88,9 +89,9 @@ void se_gizmo_render(SE_Gizmo_Renderer *renderer, SE_Gizmo_Shape *shape, Mat4 tr
     }
 
         //- reset
-    glLineWidth(1.0f);
-    glPointSize(1.0f);
-    glBindVertexArray(0);
+    se_gl_line_width(1.0f);
+    se_gl_point_size(1.0f);
+    se_gl_bind_vertex_array(0);
 }
 
 static AABB3D calc_aabb(const SE_Gizmo_Vertex *verts, u32 verts_count) {
@@ -117,7 +118,7 @@ static void generate_shape(SE_Gizmo_Shape *shape, SE_GIZMO_TYPES type, SE_Gizmo_
     glGenVertexArrays(1, &shape->vao);
     glGenBuffers(1, &shape->ibo);
 
-    glBindVertexArray(shape->vao);
+    se_gl_bind_vertex_array(shape->vao);
     glBindBuffer(GL_ARRAY_BUFFER, shape->vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shape->ibo);
 
@@ -139,7 +140,7 @@ static void generate_shape(SE_Gizmo_Shape *shape, SE_GIZMO_TYPES type, SE_Gizmo_
     shape->type = type;
 
         //- unselect
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -11,6 +11,8 @@
 #include "assimp/cimport.h"
 #include "assimp/scene.h"
 #include "sestring.h"
+#include "semesh_optimise.h"
+#include "setexture_cook.h"
 
 #include "seinput.h" // for camera
 #include "stdio.h" // for file management
@@ -19,10 +21,17 @@
 ///     DEFINES
 ///
 
+    /// assimp post processing used when importing meshes. Part of the mesh cache key, so changing it re-imports everything.
+#define mesh_import_flags (aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs | aiProcess_CalcTangentSpace)
+    /// Bump when the steps after the assimp import (optimisation, packing, ...) produce different output
+#define mesh_import_pipeline_version 1
+
 #define default_normal_filepath "core/textures/default_normal.png"
 #define default_diffuse_filepath "core/textures/default_diffuse.png"
 #define default_specular_filepath "core/textures/default_specular.png"
 
+#define shader_filename_frame_header "core/shaders/3D/frame_header.glsl" // #version and the per frame uniforms, goes first
+#define shader_filename_vertex_header_vsd "core/shaders/3D/vertex_header.vsd" // vertex decoding and instancing, goes second
 #define shader_filename_lit_header_vsd "core/shaders/3D/lit_header.vsd"
 #define shader_filename_lit_vsd "core/shaders/3D/lit.vsd"
 #define shader_filename_lit_header_fsd "core/shaders/3D/lit_header.fsd"
@@ -30,11 +39,15 @@
 
 #define shader_filename_shadow_calc_directional_vsd "core/shaders/3D/shadow_calc/shadow_calc.vsd"
 #define shader_filename_shadow_calc_directional_fsd "core/shaders/3D/shadow_calc/shadow_calc.fsd"
+#define shader_filename_shadow_calc_directional_gsd "core/shaders/3D/shadow_calc/shadow_calc.gsd"
 #define shader_filename_shadow_calc_directional_skinned_mesh_vsd "core/shaders/3D/shadow_calc/shadow_calc_skinned_mesh.vsd"
 #define shader_filename_shadow_calc_omnidir_vsd "core/shaders/3D/shadow_calc/shadow_omni_calc.vsd"
 #define shader_filename_shadow_calc_omnidir_fsd "core/shaders/3D/shadow_calc/shadow_omni_calc.fsd"
 #define shader_filename_shadow_calc_omnidir_gsd "core/shaders/3D/shadow_calc/shadow_omni_calc.gsd"
 #define shader_filename_shadow_calc_omnidir_skinned_mesh_vsd "core/shaders/3D/shadow_calc/shadow_omni_calc_skinned_mesh.vsd"
+#define shader_filename_shadow_calc_omnidir_layered_header_vsd "core/shaders/3D/shadow_calc/shadow_omni_layered_header.vsd"
+#define shader_filename_shadow_calc_omnidir_layered_vsd "core/shaders/3D/shadow_calc/shadow_omni_calc_layered.vsd"
+#define shader_filename_shadow_calc_omnidir_layered_skinned_mesh_vsd "core/shaders/3D/shadow_calc/shadow_omni_calc_layered_skinned_mesh.vsd"
 
 #define shader_filename_lines_vsd "core/shaders/3D/lines.vsd"
 #define shader_filename_lines_fsd "core/shaders/3D/lines.fsd"
@@ -48,31 +61,444 @@
 #define shader_filename_post_process_header_vsd "core/shaders/post_process/post_process_header.vsd"
 #define shader_filename_post_process_header_fsd "core/shaders/post_process/post_process_header.fsd"
 #define shader_filename_post_process_tonemap "core/shaders/post_process/post_process_tonemap.fsd"
-#define shader_filename_post_process_blur "core/shaders/post_process/post_process_blur.fsd"
 #define shader_filename_post_process_downsample "core/shaders/post_process/post_process_downsample.fsd"
 #define shader_filename_post_process_upsample "core/shaders/post_process/post_process_upsample.fsd"
 #define shader_filename_post_process_bloom "core/shaders/post_process/post_process_bloom.fsd"
-#define shader_filename_post_process_gaussian "core/shaders/post_process/post_process_gaussian_blur.fsd"
 
-static void set_material_uniforms_lit(SE_Renderer3D *renderer, SE_Shader *shader, const SE_Material *material, Mat4 transform) {
-    se_shader_use(shader);
+static Vec3 rgb_to_vec3(RGB colour) {
+    return v3f(colour.r / 255.0f, colour.g / 255.0f, colour.b / 255.0f);
+}
 
-    Mat4 pvm = mat4_mul(transform, renderer->current_camera->view);
-    pvm = mat4_mul(pvm, renderer->current_camera->projection);
+    /// The view projection matrix of each face of the point light's shadow cube map
+static void point_light_shadow_matrices(const SE_Renderer3D *renderer, const SE_Light_Point *point_light, Mat4 result[6]) {
+    f32 aspect = renderer->omnidirectional_shadow_map_size / (f32)renderer->omnidirectional_shadow_map_size;
+    Mat4 shadow_proj = mat4_perspective(SEMATH_DEG2RAD_MULTIPLIER * 90.0f, aspect,
+        SE_POINT_LIGHT_SHADOW_NEAR_PLANE, se_render3d_point_light_range(point_light));
+    // views for each face
+    result[0] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(1, 0, 0)), vec3_down()),
+        shadow_proj);
+    result[1] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(-1, 0, 0)), vec3_down()),
+        shadow_proj);
+    result[2] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 1, 0)), vec3_forward()), // !if it doesn't work it's because I swapped froward and backward in semath.c. change these to vec3_backward()
+        shadow_proj);
+    result[3] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, -1, 0)), vec3_forward()), // !if it doesn't work it's because I swapped froward and backward in semath.c. change these to vec3_backward()
+        shadow_proj);
+    result[4] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 0, 1)), vec3_down()),
+        shadow_proj);
+    result[5] = mat4_mul(
+        mat4_lookat(point_light->position, vec3_add(point_light->position, v3f(0, 0, -1)), vec3_down()),
+        shadow_proj);
+}
 
-    // the good old days when debugging:
-    // material->texture_diffuse.width = 100;
-    /* vertex */
-    se_shader_set_uniform_mat4(shader, "projection_view_model", pvm);
-    se_shader_set_uniform_mat4(shader, "model_matrix", transform);
-    se_shader_set_uniform_vec3(shader, "camera_pos", renderer->current_camera->position);
-    se_shader_set_uniform_mat4(shader, "light_space_matrix", renderer->light_space_matrix);
+    /// Fits a cascade to each slice of the current camera's frustum (practical split scheme) and returns how many there are.
+    /// A cascade is an orthographic projection around the bounding sphere of its slice, so its size doesn't change as the
+    /// camera turns. It's anchored to a grid in light space with steps of shadow_cascade_snap of its radius (whole texels,
+    /// so the shadows don't shimmer), and made bigger by half a step so the slice stays inside of it. The matrices only
+    /// change when the camera crosses a step, which is when the cached static casters have to be re-rendered.
+    /// The depth range covers "world_aabb" (snapped outwards to the same steps) so the casters outside of a slice still
+    /// cast shadows into it.
+static u32 directional_shadow_cascade_matrices
+(const SE_Renderer3D *renderer, AABB3D world_aabb, Mat4 result[SERENDERER3D_MAX_SHADOW_CASCADES]) {
+    const SE_Camera3D *camera = renderer->current_camera;
+    u32 cascades_count = se_math_max(1, se_math_min(renderer->shadow_cascades_count, SERENDERER3D_MAX_SHADOW_CASCADES));
+
+        //- Camera Frustum
+    // the near and far planes come out of the perspective matrix, the corners out of unprojecting the ndc cube.
+    // The corners are in view space, so the slices' sizes only depend on the projection and don't jitter as the camera moves
+    const f32 *p = camera->projection.data;
+    f32 camera_near = p[14] / (p[10] - 1.0f);
+    f32 camera_far  = p[14] / (p[10] + 1.0f);
+    f32 shadow_far  = se_math_min(camera_far, renderer->shadow_distance);
+
+    Mat4 inverse_projection = mat4_inverse(camera->projection);
+    Mat4 inverse_view = mat4_inverse(camera->view);
+    Vec3 near_corners[4];
+    Vec3 far_corners[4];
+    for (u32 i = 0; i < 4; ++i) {
+        f32 x = (i & 1) ? 1 : -1;
+        f32 y = (i & 2) ? 1 : -1;
+        Vec4 n = mat4_mul_vec4(inverse_projection, (Vec4) {x, y, -1, 1});
+        Vec4 f = mat4_mul_vec4(inverse_projection, (Vec4) {x, y, +1, 1});
+        near_corners[i] = v3f(n.x / n.w, n.y / n.w, n.z / n.w);
+        far_corners[i]  = v3f(f.x / f.w, f.y / f.w, f.z / f.w);
+    }
+
+        //- Light View
+    // the same for every cascade, looking along the light. The cascades only move within it
+    Vec3 light_direction = vec3_normalised(renderer->light_directional.direction);
+    Vec3 up = se_math_abs(light_direction.y) > 0.99f ? vec3_forward() : vec3_up();
+    Mat4 light_view = mat4_lookat(vec3_zero(), light_direction, up);
+
+    f32 world_min_z = +SEMATH_INFINITY;
+    f32 world_max_z = -SEMATH_INFINITY;
+    for (u32 i = 0; i < 8; ++i) {
+        Vec4 corner = {
+            (i & 1) ? world_aabb.max.x : world_aabb.min.x,
+            (i & 2) ? world_aabb.max.y : world_aabb.min.y,
+            (i & 4) ? world_aabb.max.z : world_aabb.min.z,
+            1
+        };
+        f32 z = mat4_mul_vec4(light_view, corner).z;
+        world_min_z = se_math_min(world_min_z, z);
+        world_max_z = se_math_max(world_max_z, z);
+    }
+
+        //- Cascades
+    f32 split_near = camera_near;
+    for (u32 c = 0; c < cascades_count; ++c) {
+        f32 fraction = (c + 1) / (f32)cascades_count;
+        f32 split_logarithmic = camera_near * se_math_power(shadow_far / camera_near, fraction);
+        f32 split_uniform = camera_near + (shadow_far - camera_near) * fraction;
+        f32 split_far = renderer->shadow_cascade_split_lambda * split_logarithmic
+                      + (1.0f - renderer->shadow_cascade_split_lambda) * split_uniform;
+
+            // bounding sphere of the slice. The corners on a frustum edge are linear in view depth
+        f32 t_near = (split_near - camera_near) / (camera_far - camera_near);
+        f32 t_far  = (split_far  - camera_near) / (camera_far - camera_near);
+        Vec3 corners[8];
+        Vec3 centre = vec3_zero();
+        for (u32 i = 0; i < 4; ++i) {
+            corners[i]     = vec3_lerp(near_corners[i], far_corners[i], t_near);
+            corners[i + 4] = vec3_lerp(near_corners[i], far_corners[i], t_far);
+            centre = vec3_add(centre, vec3_add(corners[i], corners[i + 4]));
+        }
+        centre = vec3_mul_scalar(centre, 1.0f / 8.0f);
+        f32 radius = 0;
+        for (u32 i = 0; i < 8; ++i) {
+            radius = se_math_max(radius, vec3_magnitude(vec3_sub(corners[i], centre)));
+        }
+        radius = (i32)(radius * 16.0f + 1.0f) / 16.0f; // rounded up
+        Vec4 world_centre = mat4_mul_vec4(inverse_view, (Vec4) {centre.x, centre.y, centre.z, 1});
+
+            // the step is a whole number of texels (at least one) no bigger than the margin, so the snapped cascade covers the slice
+        f32 snap = se_math_max(renderer->shadow_cascade_snap, 0.0f);
+        f32 extent = radius * (1.0f + snap * 0.5f);
+        f32 texel_size = 2.0f * extent / renderer->directional_shadow_map_size;
+        f32 step = se_math_max(1, (i32)(radius * snap / texel_size)) * texel_size;
+
+            // snap the centre to the grid in light space
+        Vec4 light_centre = mat4_mul_vec4(light_view, world_centre);
+        f32 x = se_math_round(light_centre.x / step) * step;
+        f32 y = se_math_round(light_centre.y / step) * step;
+        f32 z = se_math_round(light_centre.z / step) * step;
+
+            // the view looks down -z, the near and far planes are distances along it
+        f32 max_z = se_math_max(se_math_round(world_max_z / step + 0.5f) * step, z + extent);
+        f32 min_z = se_math_min(se_math_round(world_min_z / step - 0.5f) * step, z - extent);
+        Mat4 light_proj = mat4_ortho(x - extent, x + extent, y - extent, y + extent, -max_z, -min_z);
+        result[c] = mat4_mul(light_view, light_proj);
+
+        split_near = split_far;
+    }
+    return cascades_count;
+}
+
+    /// Creates a depth texture (2D array or cube map) and a framebuffer with every layer of it attached, so a geometry
+    /// shader can pick the layer of each triangle with gl_Layer
+static void shadow_depth_map_init(GLenum target, u32 size, u32 layers, GLuint *depth_map, GLuint *fbo) {
+    glGenTextures(1, depth_map);
+    se_gl_bind_texture(target, *depth_map);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (u32 i = 0; i < 6; ++i) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
+                size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    } else {
+        glTexImage3D(target, 0, GL_DEPTH_COMPONENT32F, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    }
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, fbo);
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, *fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, *depth_map, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    se_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    se_gl_bind_texture(target, 0);
+}
+
+    /// Looks up every uniform in SE_Shader_Uniforms once, and sets the ones that never change (texture units)
+static void shader_uniforms_resolve(SE_Shader_Uniforms *u, const SE_Shader *shader) {
+    u->vertex_is_packed         = se_shader_get_uniform(shader, "vertex_is_packed");
+    u->vertex_position_offset   = se_shader_get_uniform(shader, "vertex_position_offset");
+    u->vertex_position_scale    = se_shader_get_uniform(shader, "vertex_position_scale");
+    u->vertex_uv_offset         = se_shader_get_uniform(shader, "vertex_uv_offset");
+    u->vertex_uv_scale          = se_shader_get_uniform(shader, "vertex_uv_scale");
+    u->is_instanced             = se_shader_get_uniform(shader, "is_instanced");
+    u->instance_offset          = se_shader_get_uniform(shader, "instance_offset");
+
+    u->projection_view_model    = se_shader_get_uniform(shader, "projection_view_model");
+    u->model_matrix             = se_shader_get_uniform(shader, "model_matrix");
+    u->model                    = se_shader_get_uniform(shader, "model");
+    u->bone_offset              = se_shader_get_uniform(shader, "bone_offset");
+    u->bone_count               = se_shader_get_uniform(shader, "bone_count");
+
+    u->material_shininess       = se_shader_get_uniform(shader, "material.shininess");
+    u->material_diffuse         = se_shader_get_uniform(shader, "material.diffuse");
+    u->material_specular        = se_shader_get_uniform(shader, "material.specular");
+    u->material_normal          = se_shader_get_uniform(shader, "material.normal");
+    u->material_base_diffuse    = se_shader_get_uniform(shader, "material.base_diffuse");
+    u->base_diffuse             = se_shader_get_uniform(shader, "base_diffuse");
+    u->sprite_texture           = se_shader_get_uniform(shader, "sprite_texture");
+
+    u->shadow_map               = se_shader_get_uniform(shader, "shadow_map");
+    u->point_light_shadow_maps  = se_shader_get_uniform(shader, "point_light_shadow_maps");
+    u->light_index              = se_shader_get_uniform(shader, "light_index");
+    u->face_mask                = se_shader_get_uniform(shader, "face_mask");
+    u->cascade_mask             = se_shader_get_uniform(shader, "cascade_mask");
+
+    u->texture_id               = se_shader_get_uniform(shader, "texture_id");
+    u->src_resolution           = se_shader_get_uniform(shader, "src_resolution");
+    u->threshold                = se_shader_get_uniform(shader, "threshold");
+    u->apply_threshold          = se_shader_get_uniform(shader, "apply_threshold");
+    u->filter_radius            = se_shader_get_uniform(shader, "filter_radius");
+    u->bloom_texture            = se_shader_get_uniform(shader, "bloom_texture");
+    u->bloom_strength           = se_shader_get_uniform(shader, "bloom_strength");
+
+        // texture units
+    se_uniform_set_i32(u->material_diffuse, 0);
+    se_uniform_set_i32(u->material_specular, 1);
+    se_uniform_set_i32(u->material_normal, 2);
+    se_uniform_set_i32(u->shadow_map, 3);
+    i32 point_light_shadow_map_units[SERENDERER3D_MAX_POINT_LIGHTS];
+    for (u32 i = 0; i < SERENDERER3D_MAX_POINT_LIGHTS; ++i) {
+        point_light_shadow_map_units[i] = 4+i;
+    }
+    se_uniform_set_i32_array(u->point_light_shadow_maps, point_light_shadow_map_units, SERENDERER3D_MAX_POINT_LIGHTS);
+    se_uniform_set_i32(u->sprite_texture, 0);
+    se_uniform_set_i32(u->texture_id, 0);
+    se_uniform_set_i32(u->bloom_texture, 1);
+}
+
+    /// Uploads what the vertex shaders need to decode SE_VERTEX_FORMAT_PACKED vertices (see vertex_header.vsd)
+static void set_vertex_format_uniforms(const SE_Shader_Uniforms *u, const SE_Mesh *mesh) {
+    b8 is_packed = mesh->vertex_format == SE_VERTEX_FORMAT_PACKED;
+    se_uniform_set_i32(u->vertex_is_packed, is_packed);
+    if (is_packed) {
+        se_uniform_set_vec3(u->vertex_position_offset, mesh->quantisation.position_offset);
+        se_uniform_set_vec3(u->vertex_position_scale, mesh->quantisation.position_scale);
+        se_uniform_set_vec2(u->vertex_uv_offset, mesh->quantisation.uv_offset);
+        se_uniform_set_vec2(u->vertex_uv_scale, mesh->quantisation.uv_scale);
+    }
+}
+
+    /// Centre of the mesh's aabb in world space
+static Vec3 mesh_world_centre(const SE_Mesh *mesh, Mat4 transform) {
+    const f32 *m = transform.data;
+    Vec3 centre = vec3_mul_scalar(vec3_add(mesh->aabb.min, mesh->aabb.max), 0.5f);
+    return (Vec3) {
+        m[0] * centre.x + m[4] * centre.y + m[8]  * centre.z + m[12],
+        m[1] * centre.x + m[5] * centre.y + m[9]  * centre.z + m[13],
+        m[2] * centre.x + m[6] * centre.y + m[10] * centre.z + m[14],
+    };
+}
 
+    /// Picks the coarsest lod whose simplification error, seen from the current camera, covers less than
+    /// "error_threshold" of the screen height. Uses the bounding box of the mesh to estimate its size and distance.
+static u32 mesh_select_lod(const SE_Renderer3D *renderer, const SE_Mesh *mesh, Mat4 transform, f32 error_threshold) {
+    if (mesh->lods_count <= 1) return 0;
+    const f32 *m = transform.data;
+
+    Vec3 world_centre = mesh_world_centre(mesh, transform);
+    f32 scale = se_math_max(vec3_magnitude(v3f(m[0], m[1], m[2])),
+                se_math_max(vec3_magnitude(v3f(m[4], m[5], m[6])), vec3_magnitude(v3f(m[8], m[9], m[10]))));
+
+    Vec3 size = vec3_sub(mesh->aabb.max, mesh->aabb.min);
+    f32 extent = se_math_max(size.x, se_math_max(size.y, size.z)) * scale; // lod errors are relative to this
+    f32 radius = vec3_magnitude(size) * 0.5f * scale;
+    f32 distance = vec3_magnitude(vec3_sub(world_centre, renderer->current_camera->position));
+    if (distance <= radius) return 0; // the camera is inside the mesh
+
+        // fraction of the screen height a world unit covers at that distance
+    f32 screen_per_unit = renderer->current_camera->projection.data[5] / (2.0f * distance);
+
+    u32 lod = 0;
+    for (u32 i = 1; i < mesh->lods_count; ++i) {
+        if (mesh->lods[i].error * extent * screen_per_unit > error_threshold) break;
+        lod = i;
+    }
+    return lod;
+}
+
+    /// The shader se_render_mesh uses for the mesh, used to group draws by shader
+static u32 mesh_shader_index(const SE_Renderer3D *renderer, const SE_Mesh *mesh, const SE_Material *material) {
+    switch (mesh->type) {
+        case SE_MESH_TYPE_NORMAL:  return material->shader_index;
+        case SE_MESH_TYPE_SKINNED: return renderer->shader_skinned_mesh;
+        case SE_MESH_TYPE_LINE:    return mesh->skeleton && mesh->skeleton->animations_count > 0
+                                        ? renderer->shader_skinned_mesh_skeleton : renderer->shader_lines;
+        case SE_MESH_TYPE_POINT:   return renderer->shader_lines;
+        case SE_MESH_TYPE_SPRITE:  return renderer->shader_sprite;
+    }
+    return material->shader_index;
+}
+
+    /// Issues the draw call for the given lod of the mesh. Meshes without lods are drawn whole.
+static void mesh_draw(SE_Renderer3D *renderer, const SE_Mesh *mesh, GLenum primitive, u32 lod, u32 instance_count) {
+    se_gl_bind_vertex_array(mesh->vao);
+    if (mesh->indexed) {
+        if (mesh->lods_count > 0) {
+            const SE_Mesh_Lod *mesh_lod = &mesh->lods[se_math_min(lod, mesh->lods_count - 1)];
+            glDrawElementsInstanced(primitive, mesh_lod->index_count, GL_UNSIGNED_INT, (void*)((u64)mesh_lod->index_offset * sizeof(u32)), instance_count);
+        } else {
+            glDrawElementsInstanced(primitive, mesh->element_count, GL_UNSIGNED_INT, 0, instance_count);
+        }
+    } else {
+        glDrawArraysInstanced(primitive, 0, mesh->element_count, instance_count);
+    }
+
+    renderer->stats.draw_calls++;
+    renderer->stats.instances += instance_count;
+}
+
+    /// Returns true if the given shader reads its model matrix through instance_model() (see vertex_header.vsd)
+static b8 shader_supports_instancing(const SE_Shader_Uniforms *u) {
+    return u->is_instanced.location != -1;
+}
+
+    /// Draws the mesh once for each transform with as few draw calls as possible. The shader must be in use
+    /// with every other uniform set. The transforms are sorted by lod, uploaded to the instance buffer, and
+    /// each lod is drawn with one instanced draw call. Each transform is drawn "repeat" times in a row
+    /// (eg once per cube map face), the shader works out which transform an instance is.
+static void mesh_draw_instanced
+(SE_Renderer3D *renderer, const SE_Shader_Uniforms *u, const SE_Mesh *mesh, GLenum primitive, const Mat4 *transforms, u32 count, f32 error_threshold, u32 repeat) {
+    se_uniform_set_i32(u->is_instanced, true);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, renderer->instance_buffer);
+
+    ubyte lods[SERENDERER3D_MAX_INSTANCES];
+    for (u32 batch_start = 0; batch_start < count; batch_start += SERENDERER3D_MAX_INSTANCES) {
+        u32 batch_count = se_math_min(count - batch_start, SERENDERER3D_MAX_INSTANCES);
+        const Mat4 *batch = transforms + batch_start;
+
+            // counting sort by lod
+        u32 lod_counts[SE_MESH_LODS_MAX] = {0};
+        for (u32 i = 0; i < batch_count; ++i) {
+            lods[i] = (ubyte)se_math_min(mesh_select_lod(renderer, mesh, batch[i], error_threshold), SE_MESH_LODS_MAX - 1);
+            lod_counts[lods[i]]++;
+        }
+        u32 lod_offsets[SE_MESH_LODS_MAX];
+        u32 offset = 0;
+        for (u32 lod = 0; lod < SE_MESH_LODS_MAX; ++lod) {
+            lod_offsets[lod] = offset;
+            offset += lod_counts[lod];
+        }
+        for (u32 i = 0; i < batch_count; ++i) {
+            renderer->instance_scratch[lod_offsets[lods[i]]++] = batch[i];
+        }
+
+            // orphan the previous contents so we don't wait on draw calls that are still reading them
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer->instance_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, SERENDERER3D_MAX_INSTANCES * sizeof(Mat4), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, batch_count * sizeof(Mat4), renderer->instance_scratch);
+
+        offset = 0;
+        for (u32 lod = 0; lod < SE_MESH_LODS_MAX; ++lod) {
+            if (lod_counts[lod] == 0) continue;
+            se_uniform_set_i32(u->instance_offset, offset);
+            mesh_draw(renderer, mesh, primitive, lod, lod_counts[lod] * repeat);
+            offset += lod_counts[lod];
+        }
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    se_uniform_set_i32(u->is_instanced, false); // the rest of the renderer draws one mesh at a time
+}
+
+    /// Draws the mesh "repeat" times for each transform. Uses mesh_draw_instanced if the renderer and the shader allow it,
+    /// otherwise sets the "model" uniform and draws each transform on its own.
+static void mesh_draw_transforms
+(SE_Renderer3D *renderer, const SE_Shader_Uniforms *u, const SE_Mesh *mesh, const Mat4 *transforms, u32 count, f32 error_threshold, u32 repeat) {
+    if (count > 1 && renderer->instancing && shader_supports_instancing(u)) {
+        mesh_draw_instanced(renderer, u, mesh, GL_TRIANGLES, transforms, count, error_threshold, repeat);
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        se_uniform_set_mat4(u->model, transforms[i]);
+        mesh_draw(renderer, mesh, GL_TRIANGLES, mesh_select_lod(renderer, mesh, transforms[i], error_threshold), repeat);
+    }
+}
+
+    /// Copies the mesh indices, transforms and animator indices whose mask isn't zero (eg the shadow cascades or cube map
+    /// faces they overlap) and ORs the masks of each mesh's transforms into "mesh_masks" (user_meshes_count masks), as the
+    /// transforms of a mesh are drawn with one draw call. "animator_indices" can be NULL, every caster is then posed by its
+    /// mesh's own animator (SE_RENDER_NO_ANIMATOR). Invalid mesh indices are skipped. Returns the number of copied transforms.
+static u32 gather_masked_mesh_transforms
+(const SE_Renderer3D *renderer, const u32 *mesh_indices, const Mat4 *transforms, const u32 *animator_indices, const ubyte *masks,
+ u32 count, u32 *result_mesh_indices, Mat4 *result_transforms, u32 *result_animator_indices, ubyte *mesh_masks) {
+    u32 meshes_count = renderer->user_meshes_count;
+    memset(mesh_masks, 0, meshes_count);
+    u32 result_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (masks[i] == 0 || mesh_indices[i] >= meshes_count) continue;
+        mesh_masks[mesh_indices[i]] |= masks[i];
+        result_mesh_indices[result_count] = mesh_indices[i];
+        result_transforms[result_count] = transforms[i];
+        result_animator_indices[result_count] = animator_indices != NULL ? animator_indices[i] : SE_RENDER_NO_ANIMATOR;
+        result_count++;
+    }
+    return result_count;
+}
+
+    /// Moves the masks of the dynamic casters from "masks" to "dynamic_masks" (zero for the static ones).
+    /// Returns true if any dynamic caster is left with a mask.
+static b8 split_dynamic_caster_masks
+(const SE_Renderer3D *renderer, const u32 *mesh_indices, ubyte *masks, ubyte *dynamic_masks, u32 count) {
+    b8 has_dynamic = false;
+    for (u32 i = 0; i < count; ++i) {
+        dynamic_masks[i] = 0;
+        if (masks[i] == 0 || !se_render3d_mesh_is_dynamic_shadow_caster(renderer, mesh_indices[i])) continue;
+        dynamic_masks[i] = masks[i];
+        masks[i] = 0;
+        has_dynamic = true;
+    }
+    return has_dynamic;
+}
+
+    /// Groups the transforms by mesh index (counting sort) so each mesh can be drawn instanced. Invalid mesh indices are skipped.
+    /// The transforms of mesh "m" end up in result[offsets[m]] to result[offsets[m + 1]], in the order they were given,
+    /// and their animator indices in the same place of "result_animator_indices".
+    /// The results must have room for "count" transforms and "offsets" for user_meshes_count + 1 offsets.
+static void group_transforms_by_mesh
+(const SE_Renderer3D *renderer, const u32 *mesh_indices, const Mat4 *transforms, const u32 *animator_indices, u32 count,
+ Mat4 *result, u32 *result_animator_indices, u32 *offsets) {
+    u32 meshes_count = renderer->user_meshes_count;
+    memset(offsets, 0, sizeof(u32) * (meshes_count + 1));
+    for (u32 i = 0; i < count; ++i) {
+        if (mesh_indices[i] >= meshes_count) continue; // this mesh does not exist
+        offsets[mesh_indices[i] + 1]++;
+    }
+    for (u32 m = 0; m < meshes_count; ++m) {
+        offsets[m + 1] += offsets[m];
+    }
+    for (u32 i = 0; i < count; ++i) {
+        if (mesh_indices[i] >= meshes_count) continue;
+        u32 slot = offsets[mesh_indices[i]]++;
+        result[slot] = transforms[i];
+        result_animator_indices[slot] = animator_indices[i];
+    }
+        // the fill above moved each offset to the start of the next mesh, shift them back
+    for (u32 m = meshes_count; m > 0; --m) {
+        offsets[m] = offsets[m - 1];
+    }
+    offsets[0] = 0;
+}
+
+    /// Sets the material uniforms and binds the textures and shadow maps of the lit workflow (lit, skinned and custom lit shaders).
+    /// The camera and lights come from the per frame uniform buffer.
+static void set_lighting_uniforms(SE_Renderer3D *renderer, const SE_Shader_Uniforms *u, const SE_Material *material) {
     /* material uniforms */
-    se_shader_set_uniform_f32 (shader, "material.shininess", 0.1f);
-    se_shader_set_uniform_i32 (shader, "material.diffuse", 0);
-    se_shader_set_uniform_i32 (shader, "material.specular", 1);
-    se_shader_set_uniform_i32 (shader, "material.normal", 2);
+    se_uniform_set_f32 (u->material_shininess, 0.1f);
 
     Vec4 base_diffuse_linear_space = {
         se_math_power(material->base_diffuse.x, renderer->gamma),
@@ -80,45 +506,11 @@ static void set_material_uniforms_lit(SE_Renderer3D *renderer, SE_Shader *shader
         se_math_power(material->base_diffuse.z, renderer->gamma),
         se_math_power(material->base_diffuse.w, renderer->gamma)
     };
-    se_shader_set_uniform_vec4(shader, "material.base_diffuse", base_diffuse_linear_space);
-
-    // misc uniforms
-    se_shader_set_uniform_f32(shader, "time", renderer->time);
-
-    // directional light uniforms
-    Vec3 light_direction = vec3_normalised(renderer->light_directional.direction);
-    se_shader_set_uniform_vec3(shader, "dir_light.direction", light_direction);
-    se_shader_set_uniform_rgb (shader, "dir_light.ambient", renderer->light_directional.ambient);
-    se_shader_set_uniform_rgb (shader, "dir_light.diffuse", renderer->light_directional.diffuse);
-    se_shader_set_uniform_rgb (shader, "dir_light.specular", (RGB) {0, 0, 0});
-    se_shader_set_uniform_f32 (shader, "dir_light.intensity", renderer->light_directional.intensity);
-    se_shader_set_uniform_i32 (shader, "shadow_map", 3);
-
-    // point light uniforms
-    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
-        char buf[100];
-        SDL_snprintf(buf, 100, "point_lights[%i].position", i);
-        se_shader_set_uniform_vec3(shader, buf, renderer->point_lights[i].position);
-        SDL_snprintf(buf, 100, "point_lights[%i].ambient", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].ambient);
-        SDL_snprintf(buf, 100, "point_lights[%i].diffuse", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].diffuse);
-        SDL_snprintf(buf, 100, "point_lights[%i].specular", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].specular);
-        SDL_snprintf(buf, 100, "point_lights[%i].constant", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].constant);
-        SDL_snprintf(buf, 100, "point_lights[%i].linear", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].linear);
-        SDL_snprintf(buf, 100, "point_lights[%i].quadratic", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].quadratic);
-        SDL_snprintf(buf, 100, "point_lights[%i].far_plane", i);
-        se_shader_set_uniform_f32 (shader, buf, 25.0f); // @temp magic value set to the projection far plane when calculating the shadow maps (cube texture)
-    }
-    se_shader_set_uniform_i32 (shader, "num_of_point_lights", renderer->point_lights_count);
+    se_uniform_set_vec4(u->material_base_diffuse, base_diffuse_linear_space);
 
     /* textures */
     // Note that by defaut meshes point to SE_DEFAULT_MATERIAL_INDEX, so by default it'll have
-    // the default textures.
+    // the default textures. The texture units are set in shader_uniforms_resolve.
     if (material->texture_diffuse.loaded) {
         se_texture_bind(&material->texture_diffuse, 0);
     } else {
@@ -138,53 +530,79 @@ static void set_material_uniforms_lit(SE_Renderer3D *renderer, SE_Shader *shader
     }
 
         // - Directional Shadow Map
-    glActiveTexture(GL_TEXTURE0 + 3); // shadow map
-    glBindTexture(GL_TEXTURE_2D, renderer->shadow_render_target.colour_buffers[0]); // @TODO maybe change to depth buffer
+    se_gl_active_texture(GL_TEXTURE0 + 3); // shadow map, a layer per cascade
+    se_gl_bind_texture(GL_TEXTURE_2D_ARRAY, renderer->shadow_cascades_depth_map);
 
         //- Omnidirectional Shadow Map
-    for (u32 i = 0; i < SERENDERER3D_MAX_POINT_LIGHTS; ++i) {
-        char buf[100];
-        SDL_snprintf(buf, 100, "point_lights[%i].shadow_map", i);
-        se_shader_set_uniform_i32 (shader, buf, 4+i);
-    }
-        // ! NOTE: Might want to consider merging the below for loop with the above. I'm not sure which one
-        // ! has what kind of a performance impact.
     for (u32 i = 0; i < renderer->point_lights_count; ++i) {
-        glActiveTexture(GL_TEXTURE0 + 4+i); // shadow map
-        glBindTexture(GL_TEXTURE_CUBE_MAP, renderer->point_lights[i].depth_cube_map);
+        se_gl_active_texture(GL_TEXTURE0 + 4+i); // shadow map
+        se_gl_bind_texture(GL_TEXTURE_CUBE_MAP, renderer->point_lights[i].depth_cube_map);
     }
 }
 
+static void set_material_uniforms_lit(SE_Renderer3D *renderer, u32 shader_index, const SE_Material *material, Mat4 transform) {
+    const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
+    se_shader_use(renderer->user_shaders[shader_index]);
+
+    // the good old days when debugging:
+    // material->texture_diffuse.width = 100;
+    /* vertex */
+    se_uniform_set_mat4(u->model_matrix, transform);
+
+    set_lighting_uniforms(renderer, u, material);
+}
+
+    /// The animator a skinned mesh is posed by, the given one or the mesh's own for SE_RENDER_NO_ANIMATOR.
+    /// NULL if the mesh has no animator.
+static const SE_Animator* mesh_animator(const SE_Renderer3D *renderer, const SE_Mesh *mesh, u32 animator_index) {
+    if (animator_index != SE_RENDER_NO_ANIMATOR) {
+        se_assert(animator_index < renderer->user_animators_count);
+        return renderer->user_animators[animator_index];
+    }
+    return mesh->animator;
+}
+
+    /// Points the skinning of the shader at the animator's pose in the bone palette (see se_render3d_update_animators).
+    /// Without an animator, or before its pose is in the palette, the mesh is drawn in its bind pose.
+static void set_bone_palette_uniforms(const SE_Shader_Uniforms *u, const SE_Animator *animator) {
+    b8 is_in_palette = animator != NULL && animator->palette_offset != SE_ANIMATOR_NO_PALETTE;
+    se_uniform_set_i32(u->bone_offset, is_in_palette ? animator->palette_offset : 0);
+    se_uniform_set_i32(u->bone_count,  is_in_palette ? animator->palette_count : 0);
+}
+
 static void set_material_uniforms_skeleton
-(SE_Renderer3D *renderer, SE_Shader *shader, const SE_Material *material, Mat4 transform, Mat4 *final_pose) {
-    se_shader_use(shader);
+(SE_Renderer3D *renderer, u32 shader_index, const SE_Material *material, Mat4 transform, const SE_Animator *animator) {
+    const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
+    se_shader_use(renderer->user_shaders[shader_index]);
 
     Mat4 pvm = mat4_mul(transform, renderer->current_camera->view);
     pvm = mat4_mul(pvm, renderer->current_camera->projection);
 
      /* vertex */
-    se_shader_set_uniform_mat4(shader, "projection_view_model", pvm);
-    se_shader_set_uniform_mat4(shader, "model_matrix", transform);
+    se_uniform_set_mat4(u->projection_view_model, pvm);
+    se_uniform_set_mat4(u->model_matrix, transform);
 
     /* material uniforms */
-    se_shader_set_uniform_vec3 (shader, "base_diffuse", v3f(1, 0, 0));
-    se_shader_set_uniform_mat4_array(shader, "bones", final_pose, SE_SKELETON_BONES_CAPACITY);
+    se_uniform_set_vec3 (u->base_diffuse, v3f(1, 0, 0));
+    set_bone_palette_uniforms(u, animator);
 }
 
 static void set_material_uniforms_lines
-(SE_Renderer3D *renderer, SE_Shader *shader, const SE_Material *material, Mat4 transform) {
-    se_shader_use(shader);
+(SE_Renderer3D *renderer, u32 shader_index, const SE_Material *material, Mat4 transform) {
+    const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
+    se_shader_use(renderer->user_shaders[shader_index]);
 
     Mat4 pvm = mat4_mul(transform, renderer->current_camera->view);
     pvm = mat4_mul(pvm, renderer->current_camera->projection);
 
     /* vertex */
-    se_shader_set_uniform_mat4(shader, "projection_view_model", pvm);
+    se_uniform_set_mat4(u->projection_view_model, pvm);
 }
 
 static void set_material_uniforms_sprite
-(SE_Renderer3D *renderer, SE_Shader *shader, const SE_Material *material, Mat4 transform) {
-    se_shader_use(shader);
+(SE_Renderer3D *renderer, u32 shader_index, const SE_Material *material, Mat4 transform) {
+    const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
+    se_shader_use(renderer->user_shaders[shader_index]);
 
     /* always look at the camera */
     // Mat4 look_at_camera = mat4_lookat(mat4_get_translation(transform), renderer->current_camera->position, renderer->current_camera->up);
@@ -194,7 +612,7 @@ static void set_material_uniforms_sprite
     pvm = mat4_mul(pvm, renderer->current_camera->projection);
 
     /* vertex */
-    se_shader_set_uniform_mat4(shader, "projection_view_model", pvm);
+    se_uniform_set_mat4(u->projection_view_model, pvm);
 
     /* material */
     Vec4 base_diffuse_linear_space = {
@@ -204,8 +622,7 @@ static void set_material_uniforms_sprite
         se_math_power(material->base_diffuse.w, renderer->gamma)
     };
 
-    se_shader_set_uniform_vec4(shader, "base_diffuse", base_diffuse_linear_space);
-    se_shader_set_uniform_i32(shader, "sprite_texture", 0);
+    se_uniform_set_vec4(u->base_diffuse, base_diffuse_linear_space);
 
     /* textures */
     if (material->sprite.texture.loaded) {
@@ -231,174 +648,86 @@ static void load_animation_from_file(SE_Skeleton *skeleton, const char *model_fi
 
 static void
 set_material_uniforms_skinned
-(SE_Renderer3D *renderer, const SE_Material *material, Mat4 transform, Mat4 *final_pose) {
-    SE_Shader *shader = renderer->user_shaders[renderer->shader_skinned_mesh];
-    se_shader_use(shader);
-
-    Mat4 pvm = mat4_mul(transform, renderer->current_camera->view);
-    pvm = mat4_mul(pvm, renderer->current_camera->projection);
+(SE_Renderer3D *renderer, const SE_Material *material, Mat4 transform, const SE_Animator *animator) {
+    const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[renderer->shader_skinned_mesh];
+    se_shader_use(renderer->user_shaders[renderer->shader_skinned_mesh]);
 
      /* vertex */
-    se_shader_set_uniform_mat4(shader, "projection_view_model", pvm);
-    se_shader_set_uniform_mat4(shader, "model_matrix", transform);
-    se_shader_set_uniform_vec3(shader, "camera_pos", renderer->current_camera->position);
-    se_shader_set_uniform_mat4(shader, "light_space_matrix", renderer->light_space_matrix);
-
-    /* material uniforms */
-    se_shader_set_uniform_f32 (shader, "material.shininess", 0.1f);
-    se_shader_set_uniform_i32 (shader, "material.diffuse", 0);
-    se_shader_set_uniform_i32 (shader, "material.specular", 1);
-    se_shader_set_uniform_i32 (shader, "material.normal", 2);
-
-    Vec4 base_diffuse_linear_space = {
-        se_math_power(material->base_diffuse.x, renderer->gamma),
-        se_math_power(material->base_diffuse.y, renderer->gamma),
-        se_math_power(material->base_diffuse.z, renderer->gamma),
-        se_math_power(material->base_diffuse.w, renderer->gamma)
-    };
-    se_shader_set_uniform_vec4(shader, "material.base_diffuse", base_diffuse_linear_space);
-
-    // directional light uniforms
-    se_shader_set_uniform_vec3(shader, "dir_light.direction", renderer->light_directional.direction);
-    se_shader_set_uniform_rgb (shader, "dir_light.ambient", renderer->light_directional.ambient);
-    se_shader_set_uniform_rgb (shader, "dir_light.diffuse", renderer->light_directional.diffuse);
-    se_shader_set_uniform_rgb (shader, "dir_light.specular", (RGB) {0, 0, 0});
-    se_shader_set_uniform_f32 (shader, "dir_light.intensity", renderer->light_directional.intensity);
-    se_shader_set_uniform_i32 (shader, "shadow_map", 3);
+    se_uniform_set_mat4(u->model_matrix, transform);
 
-    // point light uniforms
-    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
-        char buf[100];
-        SDL_snprintf(buf, 100, "point_lights[%i].position", i);
-        se_shader_set_uniform_vec3(shader, buf, renderer->point_lights[i].position);
-        SDL_snprintf(buf, 100, "point_lights[%i].ambient", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].ambient);
-        SDL_snprintf(buf, 100, "point_lights[%i].diffuse", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].diffuse);
-        SDL_snprintf(buf, 100, "point_lights[%i].specular", i);
-        se_shader_set_uniform_rgb (shader, buf, renderer->point_lights[i].specular);
-        SDL_snprintf(buf, 100, "point_lights[%i].constant", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].constant);
-        SDL_snprintf(buf, 100, "point_lights[%i].linear", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].linear);
-        SDL_snprintf(buf, 100, "point_lights[%i].quadratic", i);
-        se_shader_set_uniform_f32 (shader, buf, renderer->point_lights[i].quadratic);
-        SDL_snprintf(buf, 100, "point_lights[%i].far_plane", i);
-        se_shader_set_uniform_f32 (shader, buf, 25.0f); // @temp magic value set to the projection far plane when calculating the shadow maps (cube texture)
-    }
-    se_shader_set_uniform_i32 (shader, "num_of_point_lights", renderer->point_lights_count);
-
-    /* textures */
-    // Note that by defaut meshes point to SE_DEFAULT_MATERIAL_INDEX, so by default it'll have
-    // the default textures.
-    if (material->texture_diffuse.loaded) {
-        se_texture_bind(&material->texture_diffuse, 0);
-    } else {
-        se_texture_bind(&renderer->user_materials[SE_DEFAULT_MATERIAL_INDEX]->texture_diffuse, 0);
-    }
+    set_lighting_uniforms(renderer, u, material);
 
-    if (material->texture_specular.loaded) {
-        se_texture_bind(&material->texture_specular, 1);
-    } else {
-        se_texture_bind(&renderer->user_materials[SE_DEFAULT_MATERIAL_INDEX]->texture_specular, 1);
-    }
-
-    if (material->texture_normal.loaded) {
-        se_texture_bind(&material->texture_normal, 2);
-    } else {
-        se_texture_bind(&renderer->user_materials[SE_DEFAULT_MATERIAL_INDEX]->texture_normal, 2);
-    }
-
-    glActiveTexture(GL_TEXTURE0 + 3); // shadow map
-    glBindTexture(GL_TEXTURE_2D, renderer->shadow_render_target.colour_buffers[0]); // @TODO maybe change to depth buffer
-
-       //- Omnidirectional Shadow Map
-    for (u32 i = 0; i < SERENDERER3D_MAX_POINT_LIGHTS; ++i) {
-        char buf[100];
-        SDL_snprintf(buf, 100, "point_lights[%i].shadow_map", i);
-        se_shader_set_uniform_i32 (shader, buf, 4+i);
-    }
-        // ! NOTE: Might want to consider merging the below for loop with the above. I'm not sure which one
-        // ! has what kind of a performance impact.
-    for (u32 i = 0; i < renderer->point_lights_count; ++i) {
-        glActiveTexture(GL_TEXTURE0 + 4+i); // shadow map
-        glBindTexture(GL_TEXTURE_CUBE_MAP, renderer->point_lights[i].depth_cube_map);
-    }
-
-    se_shader_set_uniform_mat4_array(shader, "bones", final_pose, SE_SKELETON_BONES_CAPACITY);
+    set_bone_palette_uniforms(u, animator);
 }
 
 static void recursive_render_directional_shadow_map_for_mesh
-(SE_Renderer3D *renderer, u32 mesh_index, Mat4 model_mat, Mat4 light_space_mat) {
+(SE_Renderer3D *renderer, u32 mesh_index, const Mat4 *model_mats, u32 count, u32 animator_index, u32 cascade_mask) {
     SE_Mesh *mesh = renderer->user_meshes[mesh_index];
 
-    if (mesh->should_cast_shadow) {
-        if (mesh->type == SE_MESH_TYPE_NORMAL) {
-            se_shader_use(renderer->user_shaders[renderer->shader_shadow_calc]);
-            se_shader_set_uniform_mat4(renderer->user_shaders[renderer->shader_shadow_calc], "light_space_matrix", light_space_mat);
-            se_shader_set_uniform_mat4(renderer->user_shaders[renderer->shader_shadow_calc], "model", model_mat);
-        } else
+    if (mesh->should_cast_shadow && (mesh->type == SE_MESH_TYPE_NORMAL || mesh->type == SE_MESH_TYPE_SKINNED)) {
+        u32 shader_index = renderer->shader_shadow_calc;
         if (mesh->type == SE_MESH_TYPE_SKINNED) {
-            se_shader_use(renderer->user_shaders[renderer->shader_shadow_calc_skinned_mesh]);
-            se_shader_set_uniform_mat4(renderer->user_shaders[renderer->shader_shadow_calc_skinned_mesh], "light_space_matrix", light_space_mat);
-            se_shader_set_uniform_mat4(renderer->user_shaders[renderer->shader_shadow_calc_skinned_mesh], "model", model_mat);
-            se_shader_set_uniform_mat4_array(renderer->user_shaders[renderer->shader_shadow_calc_skinned_mesh], "bones", mesh->skeleton->final_pose, SE_SKELETON_BONES_CAPACITY);
+            shader_index = renderer->shader_shadow_calc_skinned_mesh;
         }
+        const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
 
-        glBindVertexArray(mesh->vao);
-        if (mesh->indexed) {
-            glDrawElements(GL_TRIANGLES, mesh->element_count, GL_UNSIGNED_INT, 0);
-        } else {
-            glDrawArrays(GL_TRIANGLES, 0, mesh->element_count);
+        se_shader_use(renderer->user_shaders[shader_index]);
+        se_uniform_set_i32(u->cascade_mask, cascade_mask); // the cascade matrices are in the per frame uniforms
+        set_vertex_format_uniforms(u, mesh);
+        if (mesh->type == SE_MESH_TYPE_SKINNED) {
+            // shadows are cast in the same pose the caster is drawn in
+            set_bone_palette_uniforms(u, mesh_animator(renderer, mesh, animator_index));
         }
+
+        mesh_draw_transforms(renderer, u, mesh, model_mats, count, renderer->lod_shadow_error_threshold, 1);
     }
 
         // continue for children meshes if they exist
     if (mesh->next_mesh_index >= 0) {
-        recursive_render_directional_shadow_map_for_mesh(renderer, mesh->next_mesh_index, model_mat, light_space_mat);
+        recursive_render_directional_shadow_map_for_mesh(renderer, mesh->next_mesh_index, model_mats, count, animator_index, cascade_mask);
     }
 }
 
 static void recursive_render_omnidir_shadow_map_for_mesh
-(SE_Renderer3D *renderer, u32 mesh_index, Mat4 model_mat, SE_Light_Point *point_light, Mat4 shadow_transforms[6], f32 far) {
+(SE_Renderer3D *renderer, u32 mesh_index, const Mat4 *model_mats, u32 count, u32 animator_index, u32 light_index, u32 face_mask) {
     SE_Mesh *mesh = renderer->user_meshes[mesh_index];
 
     if (mesh->should_cast_shadow) {
         // configure shader
-        SE_Shader *shader = renderer->user_shaders[renderer->shader_shadow_omnidir_calc];
+        // without the geometry shader each transform is drawn once for each face in the mask (see shadow_omni_layered_header.vsd)
+        u32 repeat = 1;
+        u32 shader_index = renderer->shader_shadow_omnidir_calc;
         if (mesh->type == SE_MESH_TYPE_SKINNED) {
-            shader = renderer->user_shaders[renderer->shader_shadow_omnidir_calc_skinned_mesh];
+            shader_index = renderer->shader_shadow_omnidir_calc_skinned_mesh;
+        }
+        if (renderer->omni_shadow_path != SE_OMNI_SHADOW_PATH_GEOMETRY_SHADER) {
+            shader_index = renderer->shader_shadow_omnidir_layered_calc;
+            if (mesh->type == SE_MESH_TYPE_SKINNED) {
+                shader_index = renderer->shader_shadow_omnidir_layered_calc_skinned_mesh;
+            }
+            repeat = 0;
+            for (u32 face = 0; face < 6; ++face) {
+                if (face_mask & (1 << face)) repeat++;
+            }
         }
+        const SE_Shader_Uniforms *u = &renderer->user_shader_uniforms[shader_index];
 
-        se_shader_use(shader);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, point_light->depth_cube_map);
-        se_shader_set_uniform_f32 (shader, "far_plane", far);
-        se_shader_set_uniform_vec3(shader, "light_pos", point_light->position);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[0]", shadow_transforms[0]);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[1]", shadow_transforms[1]);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[2]", shadow_transforms[2]);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[3]", shadow_transforms[3]);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[4]", shadow_transforms[4]);
-        se_shader_set_uniform_mat4(shader, "shadow_matrices[5]", shadow_transforms[5]);
-        se_shader_set_uniform_mat4(shader, "model", model_mat);
+        se_shader_use(renderer->user_shaders[shader_index]);
+        se_uniform_set_i32(u->light_index, light_index); // the shadow matrices are in the per frame uniforms
+        se_uniform_set_i32(u->face_mask, face_mask);
+        set_vertex_format_uniforms(u, mesh);
 
         if (mesh->type == SE_MESH_TYPE_SKINNED) {
-            se_shader_set_uniform_mat4(renderer->user_shaders[renderer->shader_shadow_omnidir_calc_skinned_mesh], "model", model_mat);
-            se_shader_set_uniform_mat4_array(renderer->user_shaders[renderer->shader_shadow_omnidir_calc_skinned_mesh], "bones", mesh->skeleton->final_pose, SE_SKELETON_BONES_CAPACITY);
+            // shadows are cast in the same pose the caster is drawn in
+            set_bone_palette_uniforms(u, mesh_animator(renderer, mesh, animator_index));
         }
 
-        glBindVertexArray(mesh->vao);
-        if (mesh->indexed) {
-            glDrawElements(GL_TRIANGLES, mesh->element_count, GL_UNSIGNED_INT, 0);
-        } else {
-            glDrawArrays(GL_TRIANGLES, 0, mesh->element_count);
-        }
+        mesh_draw_transforms(renderer, u, mesh, model_mats, count, renderer->lod_shadow_error_threshold, repeat);
     }
 
         // continue for children meshes if they exist
     if (mesh->next_mesh_index >= 0) {
-        recursive_render_omnidir_shadow_map_for_mesh(renderer, mesh->next_mesh_index, model_mat, point_light, shadow_transforms, far);
+        recursive_render_omnidir_shadow_map_for_mesh(renderer, mesh->next_mesh_index, model_mats, count, animator_index, light_index, face_mask);
     }
 }
 
@@ -2,9 +2,13 @@
 #include <stdio.h> // for loading file as string
 #include "sestring.h"
 
+static void shader_reflect_uniforms(SE_Shader *shader);
+static void shader_free_uniforms(SE_Shader *shader);
+
 void se_shader_init_from_string(SE_Shader *sp, const char *vertex_src, const char *frag_src, const char* vertex_shader_name, const char *fragment_shader_name) {
     sp->loaded_successfully = true; // set to false later on if errors occure
     sp->has_geometry = false;
+    sp->uniforms = NULL;
 
     sp->vertex_shader = glCreateShader(GL_VERTEX_SHADER);
     sp->fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -55,6 +59,7 @@ void se_shader_init_from_string(SE_Shader *sp, const char *vertex_src, const cha
 
     if (sp->loaded_successfully) {
         printf ("Shaders compiled and linked successfully.\n");
+        shader_reflect_uniforms(sp);
     } else {
         // if there was a problem, tell OpenGL that we don't need those resources after all
         glDeleteShader(sp->vertex_shader);
@@ -69,88 +74,201 @@ void se_shader_deinit(SE_Shader *shader) {
         glDeleteShader(shader->fragment_shader);
         if (shader->has_geometry) glDeleteShader(shader->geometry_shader);
         glDeleteProgram(shader->shader_program);
+        se_gl_state_invalidate();
     }
+    shader_free_uniforms(shader);
 }
 
 void se_shader_use(const SE_Shader *shader) {
     if (shader) {
-        glUseProgram(shader->shader_program);
+        se_gl_use_program(shader->shader_program);
     }
 }
 
 GLint se_shader_get_uniform_loc(SE_Shader *shader, const char *uniform_name) {
-    return glGetUniformLocation(shader->shader_program, uniform_name);
+    return se_shader_get_uniform(shader, uniform_name).location;
+}
+
+SE_Uniform se_shader_get_uniform(const SE_Shader *shader, const char *uniform_name) {
+    SE_Uniform result = { shader->shader_program, -1, 0 };
+    if (shader->uniforms == NULL) return result;
+
+    khint_t it = kh_get(se_shader_uniforms, shader->uniforms, uniform_name);
+    if (it != kh_end(shader->uniforms)) result = kh_value(shader->uniforms, it);
+    return result;
+}
+
+    /// Adds "name" to the uniform table of the shader. The key is copied.
+static void shader_add_uniform(SE_Shader *shader, const char *name, SE_Uniform uniform) {
+    int ret;
+    khint_t it = kh_put(se_shader_uniforms, shader->uniforms, name, &ret);
+    if (ret > 0) kh_key(shader->uniforms, it) = SDL_strdup(name);
+    kh_value(shader->uniforms, it) = uniform;
+}
+
+    /// Enumerates the active uniforms of the linked program into the uniform table of the shader
+static void shader_reflect_uniforms(SE_Shader *shader) {
+    shader->uniforms = kh_init(se_shader_uniforms);
+
+    GLint uniforms_count = 0;
+    GLint name_capacity = 0;
+    glGetProgramiv(shader->shader_program, GL_ACTIVE_UNIFORMS, &uniforms_count);
+    glGetProgramiv(shader->shader_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &name_capacity);
+    if (uniforms_count <= 0) return;
+
+    char *name = malloc(sizeof(char) * (name_capacity + 1));
+    for (GLint i = 0; i < uniforms_count; ++i) {
+        GLsizei name_length = 0;
+        GLint array_size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(shader->shader_program, (GLuint)i, name_capacity + 1, &name_length, &array_size, &type, name);
+
+        SE_Uniform uniform = { shader->shader_program, glGetUniformLocation(shader->shader_program, name), type };
+        if (uniform.location == -1) continue; // members of uniform blocks don't have locations
+
+        shader_add_uniform(shader, name, uniform);
+            // arrays are reported as "name[0]", also make them available as "name"
+        if (name_length > 3 && SDL_strcmp(name + name_length - 3, "[0]") == 0) {
+            name[name_length - 3] = '\0';
+            shader_add_uniform(shader, name, uniform);
+        }
+    }
+    free(name);
+}
+
+static void shader_free_uniforms(SE_Shader *shader) {
+    if (shader->uniforms == NULL) return;
+    for (khint_t it = kh_begin(shader->uniforms); it != kh_end(shader->uniforms); ++it) {
+        if (kh_exist(shader->uniforms, it)) SDL_free((char*)kh_key(shader->uniforms, it));
+    }
+    kh_destroy(se_shader_uniforms, shader->uniforms);
+    shader->uniforms = NULL;
+}
+
+void se_uniform_set_f32(SE_Uniform uniform, f32 value) {
+    if (uniform.location == -1) return;
+    se_assert(uniform.type == GL_FLOAT);
+    glProgramUniform1f(uniform.program, uniform.location, value);
+}
+
+void se_uniform_set_i32(SE_Uniform uniform, i32 value) {
+    if (uniform.location == -1) return;
+    glProgramUniform1i(uniform.program, uniform.location, value); // ints, bools and samplers
 }
 
+void se_uniform_set_i32_array(SE_Uniform uniform, const i32 *value, u32 count) {
+    if (uniform.location == -1) return;
+    glProgramUniform1iv(uniform.program, uniform.location, count, value);
+}
+
+void se_uniform_set_vec2(SE_Uniform uniform, Vec2 value) {
+    if (uniform.location == -1) return;
+    se_assert(uniform.type == GL_FLOAT_VEC2);
+    glProgramUniform2f(uniform.program, uniform.location, value.x, value.y);
+}
+
+void se_uniform_set_vec3(SE_Uniform uniform, Vec3 value) {
+    if (uniform.location == -1) return;
+    se_assert(uniform.type == GL_FLOAT_VEC3);
+    glProgramUniform3f(uniform.program, uniform.location, value.x, value.y, value.z);
+}
+
+void se_uniform_set_vec4(SE_Uniform uniform, Vec4 value) {
+    if (uniform.location == -1) return;
+    se_assert(uniform.type == GL_FLOAT_VEC4);
+    glProgramUniform4f(uniform.program, uniform.location, value.x, value.y, value.z, value.w);
+}
+
+void se_uniform_set_rgb(SE_Uniform uniform, RGB value) {
+    se_uniform_set_vec3(uniform, v3f(value.r / 255.0f, value.g / 255.0f, value.b / 255.0f));
+}
+
+void se_uniform_set_rgba(SE_Uniform uniform, RGBA value) {
+    se_uniform_set_vec4(uniform, (Vec4) {value.r / 255.0f, value.g / 255.0f, value.b / 255.0f, value.a / 255.0f});
+}
+
+void se_uniform_set_mat4(SE_Uniform uniform, Mat4 value) {
+    se_uniform_set_mat4_array(uniform, &value, 1);
+}
+
+void se_uniform_set_mat4_array(SE_Uniform uniform, const Mat4 *value, u32 count) {
+    if (uniform.location == -1) return;
+    se_assert(uniform.type == GL_FLOAT_MAT4);
+    glProgramUniformMatrix4fv(uniform.program, uniform.location, count, GL_FALSE, (const GLfloat*)value);
+}
+
+    // The setters by name look the uniform up in the uniform table and bind the shader, so they still work with
+    // code that draws right after setting uniforms. Prefer resolving an SE_Uniform once for anything per frame.
+
 void se_shader_set_uniform_f32  (SE_Shader *shader, const char *uniform_name, f32 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform1f(var_loc, value);
+        se_uniform_set_f32(uniform, value);
     }
 }
 
 void se_shader_set_uniform_i32  (SE_Shader *shader, const char *uniform_name, i32 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform1i(var_loc, value);
+        se_uniform_set_i32(uniform, value);
     }
 }
 
 void se_shader_set_uniform_vec3 (SE_Shader *shader, const char *uniform_name, Vec3 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform3f(var_loc, value.x, value.y, value.z);
+        se_uniform_set_vec3(uniform, value);
     }
 }
 
 void se_shader_set_uniform_vec4 (SE_Shader *shader, const char *uniform_name, Vec4 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform4f(var_loc, value.x, value.y, value.z, value.w);
+        se_uniform_set_vec4(uniform, value);
     }
 }
 
 void se_shader_set_uniform_vec2 (SE_Shader *shader, const char *uniform_name, Vec2 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform2f(var_loc, value.x, value.y);
+        se_uniform_set_vec2(uniform, value);
     }
 }
 
 void se_shader_set_uniform_rgb (SE_Shader *shader, const char *uniform_name, RGB value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform3f(var_loc, value.r / 255.0f, value.g / 255.0f, value.b / 255.0f);
+        se_uniform_set_rgb(uniform, value);
     }
 }
 
 void se_shader_set_uniform_rgba (SE_Shader *shader, const char *uniform_name, RGBA value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniform4f(var_loc, value.r / 255.0f, value.g / 255.0f, value.b / 255.0f, value.a / 255.0f);
+        se_uniform_set_rgba(uniform, value);
     }
 }
 
 void se_shader_set_uniform_mat4 (SE_Shader *shader, const char *uniform_name, Mat4 value) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniformMatrix4fv(var_loc, 1, GL_FALSE, (const GLfloat*)&value);
+        se_uniform_set_mat4(uniform, value);
     }
 }
 
 void se_shader_set_uniform_mat4_array (SE_Shader *shader, const char *uniform_name, Mat4 *value, u32 count) {
-    GLint var_loc = glGetUniformLocation(shader->shader_program, uniform_name);
-    if (var_loc != -1) {
+    SE_Uniform uniform = se_shader_get_uniform(shader, uniform_name);
+    if (uniform.location != -1) {
         se_shader_use(shader);
-        glUniformMatrix4fv(var_loc, count, GL_FALSE, (const GLfloat*)value);
+        se_uniform_set_mat4_array(uniform, value, count);
     }
 }
 
@@ -219,6 +337,7 @@ void se_shader_init_from_files (SE_Shader *sp,
                                 u32 geometry_count) {
     // create a shader from the given files
     sp->loaded_successfully = true;
+    sp->uniforms = NULL;
     if (geometry_count > 0) sp->has_geometry = true;
     else                    sp->has_geometry = false;
 
@@ -252,7 +371,7 @@ void se_shader_init_from_files (SE_Shader *sp,
         printf ("source was:\n%s\n", vertex_src);
         sp->loaded_successfully = false;
     } else {
-        printf ("\\%s\\ compiled successfully.\n", vertex_files[0]);
+        printf ("\\%s\\ compiled successfully.\n", vertex_files[vertex_count - 1]);
     }
 
     // fragment
@@ -267,7 +386,7 @@ void se_shader_init_from_files (SE_Shader *sp,
         printf ("source was:\n%s\n", fragment_src);
         sp->loaded_successfully = false;
     } else {
-        printf ("\\%s\\ compiled successfully.\n", fragment_files[0]);
+        printf ("\\%s\\ compiled successfully.\n", fragment_files[fragment_count - 1]);
     }
 
     if (sp->has_geometry) { // geometry
@@ -282,7 +401,7 @@ void se_shader_init_from_files (SE_Shader *sp,
             printf ("source was:\n%s\n", geometry_src);
             sp->loaded_successfully = false;
         } else {
-            printf ("\\%s\\ compiled successfully.\n", geometry_files[0]);
+            printf ("\\%s\\ compiled successfully.\n", geometry_files[geometry_count - 1]);
         }
     }
 
@@ -294,9 +413,9 @@ void se_shader_init_from_files (SE_Shader *sp,
 
     if (!success) { // error linking
         if (sp->has_geometry) {
-            printf ("Error linking shaders \\ %s \\ %s \\ %s \n", vertex_files[0], fragment_files[0], geometry_files[0]);
+            printf ("Error linking shaders \\ %s \\ %s \\ %s \n", vertex_files[vertex_count - 1], fragment_files[fragment_count - 1], geometry_files[geometry_count - 1]);
         } else {
-            printf ("Error linking shaders \\ %s \\ %s \n", vertex_files[0], fragment_files[0]);
+            printf ("Error linking shaders \\ %s \\ %s \n", vertex_files[vertex_count - 1], fragment_files[fragment_count - 1]);
         }
 
         glGetProgramInfoLog(sp->shader_program, 512, NULL, error_log);
@@ -307,6 +426,7 @@ void se_shader_init_from_files (SE_Shader *sp,
     // print result
     if (sp->loaded_successfully) {
         printf ("Shaders compiled and linked successfully.\n");
+        shader_reflect_uniforms(sp);
     } else {
         // if there was a problem, tell OpenGL that we don't need those resources after all
         glDeleteShader(sp->vertex_shader);
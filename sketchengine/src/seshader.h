@@ -3,7 +3,25 @@
 
 #include "sedefines.h"
 #include "GL/glew.h"
+#include "segl_state.h"
 #include "semath.h"
+#include "khash.h"
+
+///
+/// Uniform handles
+///
+
+    /// A uniform resolved by name once (see se_shader_get_uniform). Setting it is a single glProgramUniform call,
+    /// so it doesn't need the shader to be in use. Uniforms the shader doesn't have (or the compiler
+    /// removed) have a location of -1 and setting them does nothing.
+typedef struct SE_Uniform {
+    GLuint program;
+    GLint location;
+    GLenum type; // GL_FLOAT, GL_FLOAT_VEC3, GL_SAMPLER_2D, ...
+} SE_Uniform;
+
+    /// name -> SE_Uniform of every active uniform in a program
+KHASH_MAP_INIT_STR(se_shader_uniforms, SE_Uniform)
 
 ///
 /// Shader program info
@@ -17,6 +35,7 @@ typedef struct SE_Shader {
     GLuint shader_program;
     b8 loaded_successfully;
     b8 has_geometry;
+    khash_t(se_shader_uniforms) *uniforms; // filled after linking, the keys are owned by the shader
 } SE_Shader;
 
     /// Compile the given source codes. For better error reporting, give each src code a name
@@ -37,6 +56,22 @@ void se_shader_deinit(SE_Shader *shader);
 void se_shader_use(const SE_Shader *shader);
 /// Get the address of a uniform
 GLint se_shader_get_uniform_loc(SE_Shader *shader, const char *uniform_name);
+/// Resolves a uniform by name. Arrays can be looked up by their name with or without "[0]".
+/// Do this once (eg after loading the shader) and keep the handle around instead of setting uniforms by name every frame.
+SE_Uniform se_shader_get_uniform(const SE_Shader *shader, const char *uniform_name);
+
+/// Set a uniform through its handle
+void se_uniform_set_f32  (SE_Uniform uniform, f32 value);
+void se_uniform_set_i32  (SE_Uniform uniform, i32 value);
+void se_uniform_set_i32_array (SE_Uniform uniform, const i32 *value, u32 count);
+void se_uniform_set_vec2 (SE_Uniform uniform, Vec2 value);
+void se_uniform_set_vec3 (SE_Uniform uniform, Vec3 value);
+void se_uniform_set_vec4 (SE_Uniform uniform, Vec4 value);
+void se_uniform_set_rgb  (SE_Uniform uniform, RGB value);
+void se_uniform_set_rgba (SE_Uniform uniform, RGBA value);
+void se_uniform_set_mat4 (SE_Uniform uniform, Mat4 value);
+void se_uniform_set_mat4_array (SE_Uniform uniform, const Mat4 *value, u32 count);
+
 /// Set a shader uniform
 void se_shader_set_uniform_f32  (SE_Shader *shader, const char *uniform_name, f32 value);
 /// Set a shader uniform
@@ -1,5 +1,6 @@
 #include "sesprite.h"
 #include "GL/glew.h"
+#include "segl_state.h"
 #include "stb_image.h"
 #include <stdio.h> // for saving file to disk
 
@@ -23,7 +24,7 @@ void se_texture_load_data(SE_Texture *texture, ubyte *image_data, SE_TEXTURE_LOA
     texture->loaded = true;
     glGenTextures(1, &texture->id);
 
-    glBindTexture(GL_TEXTURE_2D, texture->id);
+    se_gl_bind_texture(GL_TEXTURE_2D, texture->id);
     if (texture->channel_count == 3) {
         GLint internal_format = GL_RGB;
 
@@ -45,16 +46,15 @@ void se_texture_load_data(SE_Texture *texture, ubyte *image_data, SE_TEXTURE_LOA
         texture->loaded = false;
     }
 
-    // @TODO
-    // glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Instead of generating mipmaps we can set the texture param to not use mipmaps. We have to do one of these or our texture won't appear
+    // No mipmaps, this path is for sprites and ui that are drawn at their own size. Material textures are cooked with
+    // their mips and uploaded with se_texture_load_cooked (see setexture_cook.h).
+    // We have to set the texture param to not use mipmaps or our texture won't appear
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // GL_NEAREST
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 
     stbi_image_free(image_data);
 }
@@ -62,17 +62,18 @@ void se_texture_load_data(SE_Texture *texture, ubyte *image_data, SE_TEXTURE_LOA
 void se_texture_unload(SE_Texture *texture) {
     if (texture->loaded) {
         glDeleteTextures(1, &texture->id);
+        se_gl_state_invalidate();
     }
 }
 
 void se_texture_bind(const SE_Texture *texture, u32 index) { // @TODO change index to an enum of different texture types that map to an index internally
     se_assert(texture->loaded == true && "texture was not loaded so we can't bind");
-    glActiveTexture(GL_TEXTURE0 + index);
-    glBindTexture(GL_TEXTURE_2D, texture->id);
+    se_gl_active_texture(GL_TEXTURE0 + index);
+    se_gl_bind_texture(GL_TEXTURE_2D, texture->id);
 }
 
 void se_texture_unbind() {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 }
 
 ///
@@ -95,7 +96,7 @@ void se_image_load_ext(SE_Image *image, const char *filepath, i32 channels_to_lo
     if (image->data != NULL) {
         // seimage_load_data(image, image->data);
         // image loaded successfully
-        if (channels_to_load < image->channel_count) image->channel_count = channels_to_load;
+        if (channels_to_load != 0) image->channel_count = channels_to_load; // stbi reports the channels in the file, not the ones it gave us
     } else {
         printf("ERROR: cannot load %s (%s)\n", filepath, stbi_failure_reason());
         image->loaded = false;
@@ -36,7 +36,7 @@ static void setup_text_opengl_data(SE_Text *text) {
     // we only have one quad (6 vertices and each vertex has 4 floats to represent pos and uv)
     glGenVertexArrays(1, &text->vao);
     glGenBuffers(1, &text->vbo);
-    glBindVertexArray(text->vao);
+    se_gl_bind_vertex_array(text->vao);
     glBindBuffer(GL_ARRAY_BUFFER, text->vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(SE_Text_Vertex) * 6, NULL, GL_DYNAMIC_DRAW);
 
@@ -48,7 +48,7 @@ static void setup_text_opengl_data(SE_Text *text) {
     glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(SE_Text_Vertex), (void*)offsetof(SE_Text_Vertex, depth));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    se_gl_bind_vertex_array(0);
 }
 
 static b8 load_glyphs_to_atlas(SE_Text *text, const char *fontpath, u32 fontsize) {
@@ -57,7 +57,7 @@ static b8 load_glyphs_to_atlas(SE_Text *text, const char *fontpath, u32 fontsize
     se_image_load_empty(&image, texture_size.x, texture_size.y, 1);
 
     glGenTextures(1, &text->glyph_atlas);
-    glBindTexture(GL_TEXTURE_2D, text->glyph_atlas);
+    se_gl_bind_texture(GL_TEXTURE_2D, text->glyph_atlas);
 
     // set texture options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -121,7 +121,7 @@ static b8 load_glyphs_to_atlas(SE_Text *text, const char *fontpath, u32 fontsize
             image.width, image.height,
             0, GL_RED, GL_UNSIGNED_BYTE, image.data);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
     se_image_unload(&image);
     return true;
 }
@@ -185,6 +185,7 @@ void se_text_deinit(SE_Text *text) {
         /* opengl */
         glDeleteBuffers(1, &text->vbo);
         glDeleteVertexArrays(1, &text->vao);
+        se_gl_state_invalidate();
 
         /* ft library */
         FT_Done_Face(text->face); // use this to free faces after using them
@@ -194,23 +195,23 @@ void se_text_deinit(SE_Text *text) {
 
 /// Render to the screen
 void se_render_text(SE_Text *text) {
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
+    se_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // default blend mode
 
         // gl config
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
+    se_gl_disable(GL_CULL_FACE);
+    se_gl_enable(GL_BLEND);
 
     /* shader */
     se_shader_use(&text->shader_program);
     se_shader_set_uniform_mat4(&text->shader_program, "projection", text->shader_projection_matrix);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(text->vao);
+    se_gl_active_texture(GL_TEXTURE0);
+    se_gl_bind_vertex_array(text->vao);
 
-    glBindTexture(GL_TEXTURE_2D, text->glyph_atlas);
+    se_gl_bind_texture(GL_TEXTURE_2D, text->glyph_atlas);
     se_shader_set_uniform_i32(&text->shader_program, "atlas", 0);
 
-    glEnable(GL_SCISSOR_TEST);
+    se_gl_enable(GL_SCISSOR_TEST);
 
     for (u32 q = 0; q < text->render_queue_size; ++q) { // go through every queue item
         SE_Text_Render_Queue queue = text->render_queue[q];
@@ -274,12 +275,12 @@ void se_render_text(SE_Text *text) {
         }
     }
         // reset gl config
-    glEnable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
+    se_gl_enable(GL_CULL_FACE);
+    se_gl_disable(GL_BLEND);
 
-    glDisable(GL_SCISSOR_TEST);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    se_gl_disable(GL_SCISSOR_TEST);
+    se_gl_bind_vertex_array(0);
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
 }
 
 void se_text_reset_config(SE_Text *text) {
@@ -0,0 +1,736 @@
+#include "setexture_cook.h"
+#include "GL/glew.h"
+#include "segl_state.h"
+#include "stb_image.h"
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SE_TEXTURE_MAX_ANISOTROPY 16.0f
+
+//// FORMATS ////
+
+SE_TEXTURE_FORMAT se_texture_role_format(SE_TEXTURE_ROLE role, b8 has_alpha) {
+    switch (role) {
+        case SE_TEXTURE_ROLE_ALBEDO: return SE_TEXTURE_FORMAT_BC7;
+        case SE_TEXTURE_ROLE_NORMAL: return SE_TEXTURE_FORMAT_BC5;
+        default: return has_alpha ? SE_TEXTURE_FORMAT_BC3 : SE_TEXTURE_FORMAT_BC1;
+    }
+}
+
+const char* se_texture_format_name(SE_TEXTURE_FORMAT format) {
+    static const char *names[SE_TEXTURE_FORMATS_COUNT] = { "BC1", "BC3", "BC5", "BC7" };
+    return format < SE_TEXTURE_FORMATS_COUNT ? names[format] : "unknown";
+}
+
+static u32 texture_format_block_bytes(SE_TEXTURE_FORMAT format) {
+    return format == SE_TEXTURE_FORMAT_BC1 ? 8 : 16;
+}
+
+u64 se_texture_format_size(SE_TEXTURE_FORMAT format, u32 width, u32 height) {
+    u64 blocks_x = (width  + 3) / 4;
+    u64 blocks_y = (height + 3) / 4;
+    return blocks_x * blocks_y * texture_format_block_bytes(format);
+}
+
+u32 se_texture_mips_count(u32 width, u32 height) {
+    u32 count = 1;
+    u32 size = se_math_max(width, height);
+    while (size > 1 && count < SE_TEXTURE_MAX_MIPS) {
+        size /= 2;
+        count++;
+    }
+    return count;
+}
+
+//// BLOCK ENCODING ////
+// Every block is fitted the same way: the endpoints start at the pixels furthest apart along the principal axis
+// of the block's colours, every pixel picks its closest palette entry, then the endpoints are refitted to those
+// indices with least squares and kept if the error went down.
+
+    /// Copies a 4x4 block, pixels past the edge of the image repeat the last row or column
+static void block_fetch(f32 pixels[16][4], const ubyte *rgba, u32 width, u32 height, u32 block_x, u32 block_y) {
+    for (u32 y = 0; y < 4; ++y) {
+        u32 pixel_y = se_math_min(block_y * 4 + y, height - 1);
+        for (u32 x = 0; x < 4; ++x) {
+            u32 pixel_x = se_math_min(block_x * 4 + x, width - 1);
+            const ubyte *pixel = &rgba[((u64)pixel_x + (u64)pixel_y * width) * 4];
+            for (u32 c = 0; c < 4; ++c) {
+                pixels[x + y * 4][c] = pixel[c];
+            }
+        }
+    }
+}
+
+    /// The first "channels" of the endpoints of the block, the pixels with the smallest and largest projection
+    /// onto the principal axis of the block (power iteration on the covariance)
+static void block_initial_endpoints(f32 pixels[16][4], u32 channels, f32 endpoints[2][4]) {
+    f32 mean[4] = {0};
+    for (u32 i = 0; i < 16; ++i) {
+        for (u32 c = 0; c < channels; ++c) mean[c] += pixels[i][c] / 16.0f;
+    }
+
+    f32 covariance[4][4] = {0};
+    for (u32 i = 0; i < 16; ++i) {
+        for (u32 a = 0; a < channels; ++a) {
+            for (u32 b = 0; b < channels; ++b) {
+                covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+            }
+        }
+    }
+
+        // start from the channel that varies the most
+    u32 largest = 0;
+    for (u32 c = 1; c < channels; ++c) {
+        if (covariance[c][c] > covariance[largest][largest]) largest = c;
+    }
+    f32 axis[4] = {0};
+    for (u32 c = 0; c < channels; ++c) axis[c] = covariance[largest][c];
+
+    for (u32 iteration = 0; iteration < 8; ++iteration) {
+        f32 next[4] = {0};
+        f32 length = 0;
+        for (u32 a = 0; a < channels; ++a) {
+            for (u32 b = 0; b < channels; ++b) next[a] += covariance[a][b] * axis[b];
+            length = se_math_max(length, fabsf(next[a]));
+        }
+        if (length <= FLT_EPSILON) break;
+        for (u32 c = 0; c < channels; ++c) axis[c] = next[c] / length;
+    }
+
+    f32 t_min = FLT_MAX;
+    f32 t_max = -FLT_MAX;
+    u32 i_min = 0;
+    u32 i_max = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        f32 t = 0;
+        for (u32 c = 0; c < channels; ++c) t += (pixels[i][c] - mean[c]) * axis[c];
+        if (t < t_min) { t_min = t; i_min = i; }
+        if (t > t_max) { t_max = t; i_max = i; }
+    }
+    memcpy(endpoints[0], pixels[i_max], sizeof(f32) * 4);
+    memcpy(endpoints[1], pixels[i_min], sizeof(f32) * 4);
+}
+
+    /// Picks the closest palette entry for each pixel, returns the squared error of the block
+static f32 block_fit_indices
+(f32 pixels[16][4], u32 first_channel, u32 channels, f32 palette[16][4], u32 palette_count, u32 indices[16]) {
+    f32 error = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        f32 best = FLT_MAX;
+        for (u32 p = 0; p < palette_count; ++p) {
+            f32 distance = 0;
+            for (u32 c = first_channel; c < first_channel + channels; ++c) {
+                f32 d = pixels[i][c] - palette[p][c];
+                distance += d * d;
+            }
+            if (distance < best) {
+                best = distance;
+                indices[i] = p;
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+    /// Least squares endpoints for the given indices, where "weights" is how far along from endpoint 0 to 1
+    /// each index is. Returns false if every pixel uses the same weight.
+static b8 block_refit_endpoints
+(f32 pixels[16][4], u32 channels, const u32 indices[16], const f32 *weights, f32 endpoints[2][4]) {
+    f32 alpha_alpha = 0, beta_beta = 0, alpha_beta = 0;
+    f32 alpha_x[4] = {0};
+    f32 beta_x[4]  = {0};
+    for (u32 i = 0; i < 16; ++i) {
+        f32 beta  = weights[indices[i]];
+        f32 alpha = 1.0f - beta;
+        alpha_alpha += alpha * alpha;
+        beta_beta   += beta * beta;
+        alpha_beta  += alpha * beta;
+        for (u32 c = 0; c < channels; ++c) {
+            alpha_x[c] += alpha * pixels[i][c];
+            beta_x[c]  += beta * pixels[i][c];
+        }
+    }
+
+    f32 determinant = alpha_alpha * beta_beta - alpha_beta * alpha_beta;
+    if (fabsf(determinant) < FLT_EPSILON) return false;
+
+    for (u32 c = 0; c < channels; ++c) {
+        f32 a = (alpha_x[c] * beta_beta - beta_x[c] * alpha_beta) / determinant;
+        f32 b = (beta_x[c] * alpha_alpha - alpha_x[c] * alpha_beta) / determinant;
+        endpoints[0][c] = se_math_clamp(a, 0.0f, 255.0f);
+        endpoints[1][c] = se_math_clamp(b, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+//- BC1
+
+static u16 bc1_quantise(const f32 colour[4]) {
+    u32 r = (u32)(colour[0] * 31.0f / 255.0f + 0.5f);
+    u32 g = (u32)(colour[1] * 63.0f / 255.0f + 0.5f);
+    u32 b = (u32)(colour[2] * 31.0f / 255.0f + 0.5f);
+    return (u16)((se_math_min(r, 31) << 11) | (se_math_min(g, 63) << 5) | se_math_min(b, 31));
+}
+
+static void bc1_expand(u16 colour, f32 result[4]) {
+    u32 r = (colour >> 11) & 31;
+    u32 g = (colour >> 5) & 63;
+    u32 b = colour & 31;
+    result[0] = (f32)((r << 3) | (r >> 2));
+    result[1] = (f32)((g << 2) | (g >> 4));
+    result[2] = (f32)((b << 3) | (b >> 2));
+    result[3] = 255;
+}
+
+    /// The four colour mode, colour_0 must be greater than colour_1
+static void bc1_palette(u16 colour_0, u16 colour_1, f32 palette[16][4]) {
+    bc1_expand(colour_0, palette[0]);
+    bc1_expand(colour_1, palette[1]);
+    for (u32 c = 0; c < 4; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3.0f;
+    }
+}
+
+    /// 8 bytes, the rgb of the pixels. Always uses the four colour mode so it can be the colour half of BC3.
+static void bc1_encode_block(ubyte *result, f32 pixels[16][4]) {
+    static const f32 weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    f32 endpoints[2][4];
+    block_initial_endpoints(pixels, 3, endpoints);
+
+    u16 best_colours[2] = {0};
+    u32 best_indices[16] = {0};
+    f32 best_error = FLT_MAX;
+    for (u32 iteration = 0; iteration < 2; ++iteration) {
+        u16 colour_0 = bc1_quantise(endpoints[0]);
+        u16 colour_1 = bc1_quantise(endpoints[1]);
+        if (colour_0 < colour_1) {
+            u16 temp = colour_0;
+            colour_0 = colour_1;
+            colour_1 = temp;
+        }
+
+        f32 palette[16][4];
+        bc1_palette(colour_0, colour_1, palette);
+        u32 indices[16];
+        f32 error = block_fit_indices(pixels, 0, 3, palette, 4, indices);
+        if (colour_0 == colour_1) {
+                // that's the three colour mode, but every index pointing at colour_0 is the same in both modes
+            memset(indices, 0, sizeof(indices));
+        }
+        if (error < best_error) {
+            best_error = error;
+            best_colours[0] = colour_0;
+            best_colours[1] = colour_1;
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+
+        if (colour_0 == colour_1 || !block_refit_endpoints(pixels, 3, indices, weights, endpoints)) break;
+    }
+
+    result[0] = best_colours[0] & 0xFF;
+    result[1] = best_colours[0] >> 8;
+    result[2] = best_colours[1] & 0xFF;
+    result[3] = best_colours[1] >> 8;
+    u32 bits = 0;
+    for (u32 i = 0; i < 16; ++i) bits |= best_indices[i] << (i * 2);
+    for (u32 i = 0; i < 4; ++i) result[4 + i] = (bits >> (i * 8)) & 0xFF;
+}
+
+//- BC4 (the alpha of BC3 and each channel of BC5)
+
+    /// 8 bytes, a single channel of the pixels. Uses the eight value mode.
+static void bc4_encode_block(ubyte *result, f32 pixels[16][4], u32 channel) {
+    f32 min = 255;
+    f32 max = 0;
+    for (u32 i = 0; i < 16; ++i) {
+        min = se_math_min(min, pixels[i][channel]);
+        max = se_math_max(max, pixels[i][channel]);
+    }
+    u32 value_0 = (u32)(max + 0.5f);
+    u32 value_1 = (u32)(min + 0.5f);
+
+        // when value_0 == value_1 the decoder uses the six value mode, where index 0 is still value_0
+    f32 palette[16][4];
+    palette[0][channel] = (f32)value_0;
+    palette[1][channel] = (f32)value_1;
+    for (u32 i = 1; i < 7; ++i) {
+        palette[i + 1][channel] = ((7 - i) * value_0 + i * value_1) / 7.0f;
+    }
+
+    u32 indices[16];
+    block_fit_indices(pixels, channel, 1, palette, value_0 == value_1 ? 1 : 8, indices);
+
+    result[0] = (ubyte)value_0;
+    result[1] = (ubyte)value_1;
+    u64 bits = 0;
+    for (u32 i = 0; i < 16; ++i) bits |= (u64)indices[i] << (i * 3);
+    for (u32 i = 0; i < 6; ++i) result[2 + i] = (bits >> (i * 8)) & 0xFF;
+}
+
+//- BC7
+
+typedef struct Bit_Writer {
+    ubyte *data; // zeroed
+    u32 offset;
+} Bit_Writer;
+
+static void bit_writer_write(Bit_Writer *writer, u32 value, u32 count) {
+    for (u32 i = 0; i < count; ++i, ++writer->offset) {
+        if ((value >> i) & 1) writer->data[writer->offset / 8] |= 1 << (writer->offset % 8);
+    }
+}
+
+    /// 7 bits per channel and a p-bit shared by the channels, picks the p-bit with the smaller error
+static void bc7_quantise_endpoint(const f32 endpoint[4], u32 quantised[4], u32 *p_bit) {
+    f32 best_error = FLT_MAX;
+    for (u32 p = 0; p < 2; ++p) {
+        u32 candidate[4];
+        f32 error = 0;
+        for (u32 c = 0; c < 4; ++c) {
+            i32 value = (i32)floorf((endpoint[c] - p) / 2.0f + 0.5f);
+            candidate[c] = (u32)se_math_clamp(value, 0, 127);
+            f32 d = (f32)((candidate[c] << 1) | p) - endpoint[c];
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            memcpy(quantised, candidate, sizeof(candidate));
+            *p_bit = p;
+        }
+    }
+}
+
+    /// 16 bytes, mode 6: one subset, rgba endpoints with p-bits and 4 bit indices. It's the mode that suits
+    /// smooth albedo the best, and the only one worth searching for without a full BC7 compressor.
+static void bc7_encode_block(ubyte *result, f32 pixels[16][4]) {
+    static const u32 mode_6_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    f32 weights[16];
+    for (u32 i = 0; i < 16; ++i) weights[i] = mode_6_weights[i] / 64.0f;
+
+    f32 endpoints[2][4];
+    block_initial_endpoints(pixels, 4, endpoints);
+
+    u32 best_quantised[2][4] = {0};
+    u32 best_p_bits[2] = {0};
+    u32 best_indices[16] = {0};
+    f32 best_error = FLT_MAX;
+    for (u32 iteration = 0; iteration < 2; ++iteration) {
+        u32 quantised[2][4];
+        u32 p_bits[2];
+        bc7_quantise_endpoint(endpoints[0], quantised[0], &p_bits[0]);
+        bc7_quantise_endpoint(endpoints[1], quantised[1], &p_bits[1]);
+
+        f32 palette[16][4];
+        for (u32 i = 0; i < 16; ++i) {
+            for (u32 c = 0; c < 4; ++c) {
+                u32 value_0 = (quantised[0][c] << 1) | p_bits[0];
+                u32 value_1 = (quantised[1][c] << 1) | p_bits[1];
+                palette[i][c] = (f32)(((64 - mode_6_weights[i]) * value_0 + mode_6_weights[i] * value_1 + 32) >> 6);
+            }
+        }
+        u32 indices[16];
+        f32 error = block_fit_indices(pixels, 0, 4, palette, 16, indices);
+        if (error < best_error) {
+            best_error = error;
+            memcpy(best_quantised, quantised, sizeof(quantised));
+            memcpy(best_p_bits, p_bits, sizeof(p_bits));
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+
+        if (!block_refit_endpoints(pixels, 4, indices, weights, endpoints)) break;
+    }
+
+        // the first index is stored without its top bit, so it must be below 8
+    if (best_indices[0] >= 8) {
+        for (u32 c = 0; c < 4; ++c) {
+            u32 temp = best_quantised[0][c];
+            best_quantised[0][c] = best_quantised[1][c];
+            best_quantised[1][c] = temp;
+        }
+        u32 temp = best_p_bits[0];
+        best_p_bits[0] = best_p_bits[1];
+        best_p_bits[1] = temp;
+        for (u32 i = 0; i < 16; ++i) best_indices[i] = 15 - best_indices[i];
+    }
+
+    memset(result, 0, 16);
+    Bit_Writer writer = {result, 0};
+    bit_writer_write(&writer, 1 << 6, 7); // mode 6
+    for (u32 c = 0; c < 4; ++c) {
+        bit_writer_write(&writer, best_quantised[0][c], 7);
+        bit_writer_write(&writer, best_quantised[1][c], 7);
+    }
+    bit_writer_write(&writer, best_p_bits[0], 1);
+    bit_writer_write(&writer, best_p_bits[1], 1);
+    bit_writer_write(&writer, best_indices[0], 3);
+    for (u32 i = 1; i < 16; ++i) bit_writer_write(&writer, best_indices[i], 4);
+}
+
+void se_texture_encode(SE_TEXTURE_FORMAT format, const ubyte *rgba, u32 width, u32 height, ubyte *result) {
+    u32 blocks_x = (width  + 3) / 4;
+    u32 blocks_y = (height + 3) / 4;
+    u32 block_bytes = texture_format_block_bytes(format);
+
+    for (u32 block_y = 0; block_y < blocks_y; ++block_y) {
+        for (u32 block_x = 0; block_x < blocks_x; ++block_x) {
+            f32 pixels[16][4];
+            block_fetch(pixels, rgba, width, height, block_x, block_y);
+            ubyte *block = &result[((u64)block_x + (u64)block_y * blocks_x) * block_bytes];
+
+            switch (format) {
+                case SE_TEXTURE_FORMAT_BC1: {
+                    bc1_encode_block(block, pixels);
+                } break;
+                case SE_TEXTURE_FORMAT_BC3: {
+                    bc4_encode_block(block, pixels, 3);
+                    bc1_encode_block(block + 8, pixels);
+                } break;
+                case SE_TEXTURE_FORMAT_BC5: {
+                    bc4_encode_block(block, pixels, 0);
+                    bc4_encode_block(block + 8, pixels, 1);
+                } break;
+                case SE_TEXTURE_FORMAT_BC7: {
+                    bc7_encode_block(block, pixels);
+                } break;
+                default: se_assert(false && "unknown texture format");
+            }
+        }
+    }
+}
+
+//// MIPS ////
+
+static f32 srgb_to_linear(f32 value) {
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static f32 linear_to_srgb(f32 value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+void se_texture_downsample(ubyte *result, const ubyte *rgba, u32 width, u32 height, SE_TEXTURE_ROLE role) {
+    u32 result_width  = se_math_max(width / 2, 1);
+    u32 result_height = se_math_max(height / 2, 1);
+
+    f32 to_linear[256];
+    if (role == SE_TEXTURE_ROLE_ALBEDO) {
+        for (u32 i = 0; i < 256; ++i) to_linear[i] = srgb_to_linear(i / 255.0f);
+    }
+
+    for (u32 y = 0; y < result_height; ++y) {
+        u32 y0 = se_math_min(y * 2, height - 1);
+        u32 y1 = se_math_min(y * 2 + 1, height - 1);
+        for (u32 x = 0; x < result_width; ++x) {
+            u32 x0 = se_math_min(x * 2, width - 1);
+            u32 x1 = se_math_min(x * 2 + 1, width - 1);
+            const ubyte *samples[4] = {
+                &rgba[((u64)x0 + (u64)y0 * width) * 4],
+                &rgba[((u64)x1 + (u64)y0 * width) * 4],
+                &rgba[((u64)x0 + (u64)y1 * width) * 4],
+                &rgba[((u64)x1 + (u64)y1 * width) * 4],
+            };
+            ubyte *pixel = &result[((u64)x + (u64)y * result_width) * 4];
+
+            if (role == SE_TEXTURE_ROLE_ALBEDO) {
+                for (u32 c = 0; c < 3; ++c) {
+                    f32 sum = 0;
+                    for (u32 s = 0; s < 4; ++s) sum += to_linear[samples[s][c]];
+                    pixel[c] = (ubyte)(linear_to_srgb(sum / 4.0f) * 255.0f + 0.5f);
+                }
+            } else
+            if (role == SE_TEXTURE_ROLE_NORMAL) {
+                f32 normal[3] = {0};
+                for (u32 s = 0; s < 4; ++s) {
+                    for (u32 c = 0; c < 3; ++c) normal[c] += samples[s][c] / 255.0f * 2.0f - 1.0f;
+                }
+                f32 length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                if (length <= FLT_EPSILON) {
+                    normal[0] = 0; normal[1] = 0; normal[2] = 1; length = 1;
+                }
+                for (u32 c = 0; c < 3; ++c) {
+                    pixel[c] = (ubyte)se_math_clamp((normal[c] / length * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f, 255.0f);
+                }
+            } else {
+                for (u32 c = 0; c < 3; ++c) {
+                    pixel[c] = (ubyte)((samples[0][c] + samples[1][c] + samples[2][c] + samples[3][c] + 2) / 4);
+                }
+            }
+            pixel[3] = (ubyte)((samples[0][3] + samples[1][3] + samples[2][3] + samples[3][3] + 2) / 4);
+        }
+    }
+}
+
+//// CACHE ////
+
+u64 se_texture_cache_key(const char *filepath, SE_TEXTURE_ROLE role) {
+    u32 versions[2] = { SE_TEXTURE_FILE_VERSION, role };
+    u64 key = se_hash_bytes(versions, sizeof(versions), SE_HASH_SEED);
+    if (!se_file_hash(filepath, key, &key)) {
+        return 0;
+    }
+    return key == 0 ? 1 : key; // 0 means "no key"
+}
+
+void se_texture_cache_entry_filepath(SE_String *result, u64 content_key) {
+    char filename[32];
+    snprintf(filename, sizeof(filename), "/%016llx.tex", (unsigned long long)content_key);
+    se_string_init(result, SE_TEXTURE_CACHE_DIRECTORY);
+    se_string_append(result, filename);
+}
+
+    /// Pads the file with zeros so the next write starts at a SE_TEXTURE_FILE_ALIGNMENT aligned offset.
+    /// Returns the aligned offset.
+static u64 texture_file_write_padding(FILE *file) {
+    static const ubyte zeros[SE_TEXTURE_FILE_ALIGNMENT] = {0};
+    u64 offset = (u64)ftell(file);
+    u64 padding = (SE_TEXTURE_FILE_ALIGNMENT - (offset % SE_TEXTURE_FILE_ALIGNMENT)) % SE_TEXTURE_FILE_ALIGNMENT;
+    fwrite(zeros, 1, padding, file);
+    return offset + padding;
+}
+
+b8 se_texture_cook(const char *filepath, SE_TEXTURE_ROLE role, u64 content_key, const char *cooked_filepath) {
+    i32 width, height, channel_count;
+    ubyte *image = stbi_load(filepath, &width, &height, &channel_count, 4);
+    if (image == NULL) {
+        printf("ERROR: cannot load %s (%s)\n", filepath, stbi_failure_reason());
+        return false;
+    }
+    u64 start_ticks = SDL_GetPerformanceCounter();
+
+    b8 has_alpha = false;
+    if (channel_count == 2 || channel_count == 4) {
+        for (u64 i = 0; i < (u64)width * height; ++i) {
+            if (image[i * 4 + 3] != 255) {
+                has_alpha = true;
+                break;
+            }
+        }
+    }
+
+    SE_Texture_File_Header header = {0};
+    header.magic = SE_TEXTURE_FILE_MAGIC;
+    header.version = SE_TEXTURE_FILE_VERSION;
+    header.content_key = content_key;
+    header.format = se_texture_role_format(role, has_alpha);
+    header.is_srgb = role == SE_TEXTURE_ROLE_ALBEDO;
+    header.width = width;
+    header.height = height;
+    header.mips_count = se_texture_mips_count(width, height);
+    header.source_channel_count = channel_count;
+
+        // written to a temporary file first, so a texture shared by models that are cooking
+        // on different threads is never read half written
+    char temp_filepath[512];
+    snprintf(temp_filepath, sizeof(temp_filepath), "%s.%lu.tmp", cooked_filepath, (unsigned long)SDL_ThreadID());
+    FILE *file = fopen(temp_filepath, "wb"); // write binary
+    if (file == NULL) {
+        printf("ERROR: could not open %s for writing\n", temp_filepath);
+        stbi_image_free(image);
+        return false;
+    }
+        // reserve space, the real header is written once we know the offsets
+    fwrite(&header, sizeof(SE_Texture_File_Header), 1, file);
+
+        //- Each mip is filtered from the one before it, ping ponging between two scratch images
+    u64 scratch_size = (u64)se_math_max(width / 2, 1) * se_math_max(height / 2, 1) * 4;
+    ubyte *scratch[2] = { malloc(scratch_size), malloc(scratch_size) };
+    ubyte *blocks = malloc(se_texture_format_size(header.format, width, height));
+
+    const ubyte *mip = image;
+    u32 mip_width  = width;
+    u32 mip_height = height;
+    for (u32 i = 0; i < header.mips_count; ++i) {
+        if (i > 0) {
+            ubyte *next_mip = scratch[i % 2];
+            se_texture_downsample(next_mip, mip, mip_width, mip_height, role);
+            mip = next_mip;
+            mip_width  = se_math_max(mip_width / 2, 1);
+            mip_height = se_math_max(mip_height / 2, 1);
+        }
+        se_texture_encode(header.format, mip, mip_width, mip_height, blocks);
+        header.mip_sizes[i] = se_texture_format_size(header.format, mip_width, mip_height);
+        header.mip_offsets[i] = texture_file_write_padding(file);
+        fwrite(blocks, 1, header.mip_sizes[i], file);
+    }
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(SE_Texture_File_Header), 1, file);
+    b8 result = ferror(file) == 0;
+    fclose(file);
+
+    free(blocks);
+    free(scratch[0]);
+    free(scratch[1]);
+    stbi_image_free(image);
+
+    if (!result) {
+        printf("ERROR: could not write %s\n", temp_filepath);
+        remove(temp_filepath);
+        return false;
+    }
+    if (rename(temp_filepath, cooked_filepath) != 0) {
+            // another thread has already cooked the same content over it
+        remove(temp_filepath);
+    }
+
+    u64 cooked_bytes = 0;
+    for (u32 i = 0; i < header.mips_count; ++i) cooked_bytes += header.mip_sizes[i];
+    f64 cook_ms = (f64)(SDL_GetPerformanceCounter() - start_ticks) * 1000.0 / (f64)SDL_GetPerformanceFrequency();
+    printf("texture: cooked %s as %s %ix%i with %u mips in %.1f ms, %.2f mb (%.2f mb as rgba without mips)\n",
+            filepath, se_texture_format_name(header.format), width, height, header.mips_count, cook_ms,
+            cooked_bytes / (1024.0 * 1024.0), (f64)width * height * 4 / (1024.0 * 1024.0));
+    return true;
+}
+
+b8 se_texture_cooked_read(SE_Texture_Cooked *cooked, const char *cooked_filepath, u64 content_key) {
+    memset(cooked, 0, sizeof(SE_Texture_Cooked));
+    if (!se_file_map_open(&cooked->file_map, cooked_filepath)) {
+        return false;
+    }
+
+    const ubyte *data = cooked->file_map.data;
+    u64 size = cooked->file_map.size;
+    const SE_Texture_File_Header *header = (const SE_Texture_File_Header*)data;
+
+    if (size < sizeof(SE_Texture_File_Header)
+        || header->magic != SE_TEXTURE_FILE_MAGIC || header->version != SE_TEXTURE_FILE_VERSION) {
+        printf("WARNING: %s was written by a different version of the engine\n", cooked_filepath);
+        se_file_map_close(&cooked->file_map);
+        return false;
+    }
+    if (header->content_key != content_key) {
+        se_file_map_close(&cooked->file_map);
+        return false;
+    }
+
+    b8 is_valid = header->format < SE_TEXTURE_FORMATS_COUNT && header->width > 0 && header->height > 0
+               && header->mips_count > 0 && header->mips_count <= SE_TEXTURE_MAX_MIPS;
+    u32 mip_width  = header->width;
+    u32 mip_height = header->height;
+    for (u32 i = 0; i < header->mips_count && is_valid; ++i) {
+        is_valid = header->mip_sizes[i] == se_texture_format_size(header->format, mip_width, mip_height)
+                && header->mip_offsets[i] <= size && header->mip_sizes[i] <= size - header->mip_offsets[i];
+        cooked->mips[i] = data + header->mip_offsets[i];
+        cooked->mip_sizes[i] = header->mip_sizes[i];
+        mip_width  = se_math_max(mip_width / 2, 1);
+        mip_height = se_math_max(mip_height / 2, 1);
+    }
+    if (!is_valid) {
+        printf("WARNING: %s is not a valid texture file\n", cooked_filepath);
+        se_file_map_close(&cooked->file_map);
+        memset(cooked, 0, sizeof(SE_Texture_Cooked));
+        return false;
+    }
+
+    cooked->loaded = true;
+    cooked->format = header->format;
+    cooked->is_srgb = header->is_srgb;
+    cooked->width = header->width;
+    cooked->height = header->height;
+    cooked->channel_count = header->source_channel_count;
+    cooked->mips_count = header->mips_count;
+    return true;
+}
+
+b8 se_texture_cooked_load_or_cook(SE_Texture_Cooked *cooked, const char *filepath, SE_TEXTURE_ROLE role) {
+    memset(cooked, 0, sizeof(SE_Texture_Cooked));
+
+    u64 key = se_texture_cache_key(filepath, role);
+    if (key == 0) {
+        printf("ERROR: could not read %s\n", filepath);
+        return false;
+    }
+
+    SE_String cooked_filepath;
+    se_texture_cache_entry_filepath(&cooked_filepath, key);
+
+    b8 result = se_texture_cooked_read(cooked, cooked_filepath.buffer, key);
+    if (!result) {
+        printf("file: %s has NOT been cooked (or is out of date). So we're cooking it.\n", filepath);
+        result = se_file_make_directory(SE_TEXTURE_CACHE_DIRECTORY)
+              && se_texture_cook(filepath, role, key, cooked_filepath.buffer)
+              && se_texture_cooked_read(cooked, cooked_filepath.buffer, key);
+    }
+    se_string_deinit(&cooked_filepath);
+    return result;
+}
+
+void se_texture_cooked_unload(SE_Texture_Cooked *cooked) {
+    if (cooked->loaded) {
+        se_file_map_close(&cooked->file_map);
+    }
+    memset(cooked, 0, sizeof(SE_Texture_Cooked));
+}
+
+//// UPLOADING ////
+
+static GLenum texture_format_to_gl(SE_TEXTURE_FORMAT format, b8 is_srgb) {
+    switch (format) {
+        case SE_TEXTURE_FORMAT_BC1: return is_srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case SE_TEXTURE_FORMAT_BC3: return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case SE_TEXTURE_FORMAT_BC5: return GL_COMPRESSED_RG_RGTC2;
+        case SE_TEXTURE_FORMAT_BC7: return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM    : GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: return 0;
+    }
+}
+
+    /// Queried once, the context doesn't change while the engine runs
+static f32 texture_max_anisotropy() {
+    static f32 max_anisotropy = -1;
+    if (max_anisotropy < 0) {
+        max_anisotropy = 1;
+        if (GLEW_ARB_texture_filter_anisotropic || GLEW_EXT_texture_filter_anisotropic) {
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+            max_anisotropy = se_math_min(max_anisotropy, SE_TEXTURE_MAX_ANISOTROPY);
+        }
+    }
+    return max_anisotropy;
+}
+
+void se_texture_load_cooked(SE_Texture *texture, const SE_Texture_Cooked *cooked) {
+    texture->loaded = false;
+    if (!cooked->loaded) return;
+
+    texture->loaded = true;
+    texture->width = cooked->width;
+    texture->height = cooked->height;
+    texture->channel_count = cooked->channel_count;
+    glGenTextures(1, &texture->id);
+    se_gl_bind_texture(GL_TEXTURE_2D, texture->id);
+
+    GLenum internal_format = texture_format_to_gl(cooked->format, cooked->is_srgb);
+    u32 mip_width  = cooked->width;
+    u32 mip_height = cooked->height;
+    for (u32 i = 0; i < cooked->mips_count; ++i) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, mip_width, mip_height, 0, (GLsizei)cooked->mip_sizes[i], cooked->mips[i]);
+        mip_width  = se_math_max(mip_width / 2, 1);
+        mip_height = se_math_max(mip_height / 2, 1);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked->mips_count - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // trilinear
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    f32 anisotropy = texture_max_anisotropy();
+    if (anisotropy > 1) {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+    }
+
+    se_gl_bind_texture(GL_TEXTURE_2D, 0);
+}
+
+void se_texture_load_role(SE_Texture *texture, const char *filepath, SE_TEXTURE_ROLE role) {
+    SE_Texture_Cooked cooked;
+    texture->loaded = false;
+    if (se_texture_cooked_load_or_cook(&cooked, filepath, role)) {
+        se_texture_load_cooked(texture, &cooked);
+        se_texture_cooked_unload(&cooked);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef SE_TEXTURE_COOK_H
+#define SE_TEXTURE_COOK_H
+
+#include "sedefines.h"
+#include "sefile.h"
+#include "sestring.h"
+#include "sesprite.h"
+
+///
+/// TEXTURE COOKING
+/// Offline conversion of source images (png, jpg, ...) into block compressed textures with their whole mip chain.
+/// Cooked textures are cached as .tex files in SE_TEXTURE_CACHE_DIRECTORY (relative to the working directory),
+/// named after a content key like the mesh cache. At runtime the mips are uploaded straight from the mapped file,
+/// so there's no image decoding or mip generation when the game starts.
+///
+
+    /// What the texture is used for, decides its format
+typedef enum SE_TEXTURE_ROLE {
+    SE_TEXTURE_ROLE_ALBEDO, // colour in sRGB space with optional alpha. BC7
+    SE_TEXTURE_ROLE_DATA,   // linear values eg specular, roughness, metallic or height. BC1, or BC3 if it has alpha
+    SE_TEXTURE_ROLE_NORMAL, // tangent space normal map. BC5, only x and y are kept and the shader rebuilds z
+
+    SE_TEXTURE_ROLES_COUNT
+} SE_TEXTURE_ROLE;
+
+typedef enum SE_TEXTURE_FORMAT {
+    SE_TEXTURE_FORMAT_BC1, // rgb, 8 bytes per 4x4 block
+    SE_TEXTURE_FORMAT_BC3, // rgb + alpha, 16 bytes per block
+    SE_TEXTURE_FORMAT_BC5, // two channels, 16 bytes per block
+    SE_TEXTURE_FORMAT_BC7, // rgba, 16 bytes per block (only mode 6 is encoded)
+
+    SE_TEXTURE_FORMATS_COUNT
+} SE_TEXTURE_FORMAT;
+
+//- TEXTURE FILE
+// [SE_Texture_File_Header][mip blobs ...], biggest mip first. Every blob starts at a SE_TEXTURE_FILE_ALIGNMENT
+// aligned offset. Bump SE_TEXTURE_FILE_VERSION whenever the layout or the encoders change, older files are
+// rejected and cooked again.
+
+#define SE_TEXTURE_FILE_MAGIC 0x58455453 // "STEX"
+#define SE_TEXTURE_FILE_VERSION 1
+#define SE_TEXTURE_FILE_ALIGNMENT 16
+#define SE_TEXTURE_MAX_MIPS 16
+#define SE_TEXTURE_CACHE_DIRECTORY "cache/textures"
+
+typedef struct SE_Texture_File_Header {
+    u32 magic;
+    u32 version;
+    u64 content_key;
+    u32 format;      // SE_TEXTURE_FORMAT
+    u32 is_srgb;
+    u32 width;       // of the first mip
+    u32 height;
+    u32 mips_count;
+    u32 source_channel_count;
+    u64 mip_offsets[SE_TEXTURE_MAX_MIPS]; // from the beginning of the file
+    u64 mip_sizes[SE_TEXTURE_MAX_MIPS];
+} SE_Texture_File_Header;
+
+    /// A cooked texture mapped into memory. Filled without touching OpenGL, so it can be read on a worker thread.
+typedef struct SE_Texture_Cooked {
+    b8 loaded;
+    SE_File_Map file_map;
+    SE_TEXTURE_FORMAT format;
+    b8 is_srgb;
+    u32 width;
+    u32 height;
+    u32 channel_count; // of the source image
+    u32 mips_count;
+    const ubyte *mips[SE_TEXTURE_MAX_MIPS]; // point into file_map
+    u64 mip_sizes[SE_TEXTURE_MAX_MIPS];
+} SE_Texture_Cooked;
+
+SE_TEXTURE_FORMAT se_texture_role_format(SE_TEXTURE_ROLE role, b8 has_alpha);
+const char* se_texture_format_name(SE_TEXTURE_FORMAT format);
+    /// Bytes of a "width" by "height" image in "format", partial blocks are rounded up
+u64 se_texture_format_size(SE_TEXTURE_FORMAT format, u32 width, u32 height);
+    /// Number of mips down to 1x1
+u32 se_texture_mips_count(u32 width, u32 height);
+
+    /// Block compresses an rgba image (4 bytes per pixel). "result" must have se_texture_format_size bytes.
+    /// BC5 takes the red and green channels.
+void se_texture_encode(SE_TEXTURE_FORMAT format, const ubyte *rgba, u32 width, u32 height, ubyte *result);
+    /// Box filters an rgba image into one half its size (at least 1x1). sRGB colours are averaged in linear space
+    /// and normals are renormalised. "result" must have room for the smaller image.
+void se_texture_downsample(ubyte *result, const ubyte *rgba, u32 width, u32 height, SE_TEXTURE_ROLE role);
+
+    //- Cache
+    /// Returns the content key of the source image, a hash of its contents, the role and the file version.
+    /// Returns 0 if it could not be read. Textures shared by several models share their cache entry.
+u64 se_texture_cache_key(const char *filepath, SE_TEXTURE_ROLE role);
+    /// Initialises "result" to the filepath of the cache entry for the given key.
+void se_texture_cache_entry_filepath(SE_String *result, u64 content_key);
+    /// Decodes "filepath", builds its mips, compresses them and writes them to "cooked_filepath".
+b8 se_texture_cook(const char *filepath, SE_TEXTURE_ROLE role, u64 content_key, const char *cooked_filepath);
+    /// Maps a cooked texture, returns false if it is missing, corrupt or doesn't match "content_key".
+b8 se_texture_cooked_read(SE_Texture_Cooked *cooked, const char *cooked_filepath, u64 content_key);
+    /// Reads the cache entry of "filepath", cooking it first if it's missing or out of date. Doesn't touch OpenGL.
+b8 se_texture_cooked_load_or_cook(SE_Texture_Cooked *cooked, const char *filepath, SE_TEXTURE_ROLE role);
+void se_texture_cooked_unload(SE_Texture_Cooked *cooked);
+
+    //- Uploading
+    /// Uploads every mip of the cooked texture with trilinear and anisotropic filtering
+void se_texture_load_cooked(SE_Texture *texture, const SE_Texture_Cooked *cooked);
+    /// se_texture_cooked_load_or_cook followed by se_texture_load_cooked
+void se_texture_load_role(SE_Texture *texture, const char *filepath, SE_TEXTURE_ROLE role);
+
+#endif // SE_TEXTURE_COOK_H
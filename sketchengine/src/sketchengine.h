@@ -10,9 +10,14 @@ extern "C" {
 #include "semath.h"
 #include "seinput.h"
 #include "serenderer.h"
+#include "serender_graph.h"
 #include "setext.h"
 #include "seui_ctx.h"
 #include "sestring.h"
+#include "sefile.h"
+#include "sejobs.h"
+#include "semesh_optimise.h"
+#include "setexture_cook.h"
 #include "seanimation.h"
 #include "serenderer_gizmo.h"
 